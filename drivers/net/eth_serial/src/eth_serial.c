@@ -1,21 +1,39 @@
 /*******************************************************************************
  *  @file: eth_serial.c
  *  
- *  @brief: Source for uart-pipe based ethernet device.
+ *  @brief: Source for serial (uart) based ethernet device.
 *******************************************************************************/
 #include <zephyr/kernel.h>
 #include <zephyr/sys/util.h>    // for CONTAINER_OF() macro
 #include <zephyr/net/net_core.h>
 #include <zephyr/net/ethernet.h>
-#include <zephyr/drivers/uart_pipe.h>
 #include <zephyr/random/random.h>
 #include "eth_serial.h"
 
+#if defined(CONFIG_ETH_SERIAL_CRC32)
+#include <zephyr/sys/byteorder.h>
+#include "Crc32.h"
+#define TRAILER_SIZE    CRC32_SIZE
+#else
+#define TRAILER_SIZE    0
+#endif
+
+#if defined(CONFIG_ETH_SERIAL_COMPRESS)
+#include "FrameCompress.h"
+#define COMPRESS_HDR_SIZE   FRAMECOMPRESS_HDR_SIZE
+#else
+#define COMPRESS_HDR_SIZE   0
+#endif
+
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(eth_serial, CONFIG_ETH_SERIAL_LOG_LEVEL);
 
 #define ETH_SERIAL_MTU  1500
 #define MAX_ETHERNET_FRAME_SIZE     (1500 + 18)
+/** @brief Bytes added to an ethernet frame on the wire (before framing). */
+#define WIRE_OVERHEAD               (COMPRESS_HDR_SIZE + TRAILER_SIZE)
+/** @brief Largest deframed payload on the wire. */
+#define MAX_WIRE_FRAME_SIZE         (MAX_ETHERNET_FRAME_SIZE + WIRE_OVERHEAD)
 
 #if defined(CONFIG_ETH_SERIAL_SLIP)
 #include "slip.h"
@@ -26,13 +44,29 @@ static slip_deframer_ctx deframer_state;
 static Cobs_Deframer deframer_state;
 #endif
 
-/** @brief Maximum buffer size for inbound deframed ethernet packet. */
-static uint8_t buf_deframed[MAX_ETHERNET_FRAME_SIZE];
-/** @brief Max framed/byte stuffed buffer to serial port. */
-static uint8_t buf_framed[2*MAX_ETHERNET_FRAME_SIZE];
+/** @brief Worst-case framed size of a frame (SLIP escapes every byte). */
+#define MAX_FRAMED_SIZE(len)        (2*(len) + 2)
 
-static uint8_t pktbuf_aggregate[MAX_ETHERNET_FRAME_SIZE];
-static int packet_count = 0;
+/** @brief Framed/byte stuffed output to serial port. Several frames may be
+    coalesced into one write. Owned by tx_thread.
+*/
+static uint8_t buf_framed[CONFIG_ETH_SERIAL_TX_COALESCE_SIZE];
+BUILD_ASSERT(CONFIG_ETH_SERIAL_TX_COALESCE_SIZE >=
+    MAX_FRAMED_SIZE(MAX_WIRE_FRAME_SIZE),
+    "ETH_SERIAL_TX_COALESCE_SIZE must hold one framed ethernet frame.");
+
+/** @brief Contiguous copy of a tx packet for the framer. Owned by tx_thread. */
+static uint8_t pktbuf_aggregate[MAX_WIRE_FRAME_SIZE];
+
+#if defined(CONFIG_ETH_SERIAL_COMPRESS)
+/** @brief Compression link state (peer capability is learned on rx). */
+static FrameCompress_Link compress_link;
+/** @brief Compressor scratch and output. Owned by tx_thread. */
+static FrameCompress_Work compress_work;
+static uint8_t pktbuf_compressed[MAX_WIRE_FRAME_SIZE];
+/** @brief Deframed rx bytes ahead of decompression into the rx packet. */
+static uint8_t rx_wire[MAX_WIRE_FRAME_SIZE];
+#endif
 
 #define THREAD_PRIORITY K_PRIO_PREEMPT(8)
 
@@ -40,115 +74,349 @@ static int packet_count = 0;
 static K_THREAD_STACK_DEFINE(rx_stack, 1024);
 static struct k_thread rx_thread_data;
 
-struct fifo_data_item {
-    void *fifo_rsvd;
-    uint16_t len;
-    uint8_t msg[sizeof(buf_deframed)];
+/* TX thread */
+static K_THREAD_STACK_DEFINE(tx_stack, 1024);
+static struct k_thread tx_thread_data;
+
+/** @brief Tx queue entry. Carries the enqueue time for the tx latency
+    histogram.
+*/
+struct tx_entry {
+    void *fifo_reserved;
+    struct net_pkt *pkt;
+    uint32_t stamp;
 };
 
-/* Memory slab for received data:  block size                  num align */
-K_MEM_SLAB_DEFINE_STATIC(rx_pool, sizeof(struct fifo_data_item), 10, 4);
-/* RX data fifo */
+/* TX queue entries; the slab bounds the queue depth. */
+K_MEM_SLAB_DEFINE_STATIC(tx_slab, sizeof(struct tx_entry),
+    CONFIG_ETH_SERIAL_TX_QUEUE_DEPTH, 4);
+
+/* TX fifo (tx_entry items queued by eth_serial_send) */
+K_FIFO_DEFINE(tx_fifo);
+
+/* RX packet fifo (deframed net_pkts handed to rx_thread) */
 K_FIFO_DEFINE(rx_fifo);
 
+/* The rx latency stamp rides in the rx net_buf user data until handoff. */
+BUILD_ASSERT(CONFIG_NET_BUF_USER_DATA_SIZE >= sizeof(uint32_t),
+    "eth_serial needs 4 bytes of net_buf user data.");
+
 /******************************************************************************
-    recv_cb
+    lat_record
 *//**
-    @brief Callback for uart-pipe receive data.
-    @param[in] buf  Buffer holding received data.
-    @param[out] off  Running buffer pointer offset. 
+    @brief Adds the time elapsed since stamp to a latency histogram.
+    @param[in] hist  Histogram (ETH_SERIAL_LAT_BUCKETS entries).
+    @param[in] stamp  Start time, k_cycle_get_32().
 ******************************************************************************/
-static uint8_t *
-recv_cb(uint8_t *buf, size_t *off)
+static void
+lat_record(uint32_t *hist, uint32_t stamp)
 {
-    struct eth_serial_context *ctx =
-        CONTAINER_OF(buf, struct eth_serial_context, serial_buf[0]);
-    uint32_t len = *off;
-    struct fifo_data_item *item;
-    int size, ret;
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - stamp);
+    uint32_t idx = 0;
 
-    /* We always consume all the data, reset the offset for the next call.*/
-    *off = 0;
+    us /= ETH_SERIAL_LAT_BUCKET0_US;
+    if (us > 0)
+    {
+        idx = MIN(32 - __builtin_clz(us), ETH_SERIAL_LAT_BUCKETS - 1);
+    }
+    hist[idx]++;
+}
 
-    if (!ctx->init_done)
+/******************************************************************************
+    rx_pkt_alloc
+*//**
+    @brief Allocates the rx packet the deframer decodes into. The frame is
+    written straight into the packet buffer, so it must be a single contiguous
+    net_buf (CONFIG_NET_BUF_VARIABLE_DATA_SIZE or a large enough
+    CONFIG_NET_BUF_DATA_SIZE).
+    @return Returns the packet, NULL on allocation failure.
+******************************************************************************/
+static struct net_pkt *
+rx_pkt_alloc(struct eth_serial_context *ctx)
+{
+    struct net_pkt *pkt;
+
+    pkt = net_pkt_rx_alloc_with_buffer(
+        ctx->iface,
+        MAX_WIRE_FRAME_SIZE,
+        AF_UNSPEC,
+        0,
+        K_NO_WAIT);
+    if (!pkt)
+    {
+        ctx->stats.rx_alloc_failures++;
+        return NULL;
+    }
+
+    if (pkt->buffer->frags ||
+        net_buf_tailroom(pkt->buffer) < MAX_WIRE_FRAME_SIZE)
     {
-        goto done;
+        LOG_ERR("Rx net_buf is not contiguous (%u bytes).",
+            (unsigned int)net_buf_tailroom(pkt->buffer));
+        net_pkt_unref(pkt);
+        return NULL;
     }
 
-    /** @brief Push received byte into the deframer. */
-    size = ctx->deframer(
-        ctx->deframer_state,
-        buf, len,
-        buf_deframed, sizeof(buf_deframed));
+    return pkt;
+}
 
-    if (size > 0)
+/******************************************************************************
+    rx_unwrap
+*//**
+    @brief Checks and strips the wire overhead of a deframed frame, leaving
+    the ethernet frame in the rx packet. Bad frames are dropped here, before
+    any allocation, and the rx packet is reused.
+    @param[in] ctx  Driver context.
+    @param[in] wire  Deframed bytes.
+    @param[in] size  Number of deframed bytes.
+    @return Returns the ethernet frame size, negative if dropped.
+******************************************************************************/
+static int
+rx_unwrap(struct eth_serial_context *ctx, uint8_t *wire, int size)
+{
+#if defined(CONFIG_ETH_SERIAL_CRC32)
+    if (size < TRAILER_SIZE)
+    {
+        ctx->stats.rx_runts++;
+        return -EBADMSG;
+    }
+
+    size -= TRAILER_SIZE;
+    if (Crc32_compute(wire, size) != sys_get_le32(&wire[size]))
+    {
+        LOG_DBG("Dropping frame with bad CRC (%d bytes).", size);
+        ctx->stats.rx_crc_errors++;
+        return -EBADMSG;
+    }
+#endif
+
+#if defined(CONFIG_ETH_SERIAL_COMPRESS)
+    if (!ctx->rx_pkt)
+    {
+        /* Counted as rx_alloc_failures. */
+        return -ENOMEM;
+    }
+
+    size = FrameCompress_decode(&compress_link, wire, size,
+        ctx->rx_pkt->buffer->data, MAX_ETHERNET_FRAME_SIZE);
+    if (size < 0)
     {
-        if ((ret = k_mem_slab_alloc(&rx_pool, (void **)&item, K_NO_WAIT)) < 0)
+        ctx->stats.rx_decompress_errors++;
+    }
+#endif
+
+    return size;
+}
+
+/******************************************************************************
+    rx_deliver
+*//**
+    @brief Hands a deframed frame to rx_thread in the rx packet. Dropped
+    frames leave the rx packet for the next frame.
+    @param[in] ctx  Driver context.
+    @param[in] wire  Deframed bytes.
+    @param[in] size  Number of deframed bytes.
+******************************************************************************/
+static void
+rx_deliver(struct eth_serial_context *ctx, uint8_t *wire, int size)
+{
+    size = rx_unwrap(ctx, wire, size);
+    if (size < 0)
+    {
+        /* Counted by rx_unwrap(); rx_pkt is kept for the next frame. */
+        return;
+    }
+
+    if (size < (int)sizeof(struct net_eth_hdr))
+    {
+        /* Runt frame, keep the packet for the next one. */
+        LOG_ERR("Dropping runt frame (%d bytes).", size);
+        ctx->stats.rx_runts++;
+        return;
+    }
+
+    net_buf_add(ctx->rx_pkt->buffer, size);
+    *(uint32_t *)net_buf_user_data(ctx->rx_pkt->buffer) = k_cycle_get_32();
+    k_fifo_put(&rx_fifo, ctx->rx_pkt);
+    ctx->stats.rx_bytes += size;
+    ctx->stats.rx_packets++;
+    ctx->rx_pkt = NULL;
+}
+
+/******************************************************************************
+    [docimport eth_serial_rx]
+*//**
+    @brief Backend receive hook. Deframes directly into the pre-allocated rx
+    packet and hands completed packets to rx_thread. May be called from ISR.
+    @param[in] ctx  Driver context.
+    @param[in] buf  Buffer holding received data.
+    @param[in] len  Number of bytes received.
+******************************************************************************/
+void
+eth_serial_rx(struct eth_serial_context *ctx, uint8_t *buf, uint32_t len)
+{
+    uint8_t *buf_out;
+    uint32_t buf_out_max;
+    int size;
+
+    if (!ctx->init_done)
+    {
+        return;
+    }
+
+    /*  The deframer returns one frame per call. A chunk often holds several
+        small frames (ACKs, ARP), so push it once, then call again without
+        new bytes until no frame is left.
+    */
+    do
+    {
+        /* Also allocates the packet for the next frame after a delivery. */
+        if (!ctx->rx_pkt)
         {
-            LOG_ERR("Error allocating from slab (size %u bytes): %d", size, ret);
-            goto done; 
+            ctx->rx_pkt = rx_pkt_alloc(ctx);
         }
 
-        item->len = size;
-        memcpy(item->msg, buf_deframed, size);
+#if defined(CONFIG_ETH_SERIAL_COMPRESS)
+        buf_out = rx_wire;
+        buf_out_max = sizeof(rx_wire);
+#else
+        /*  Without a packet to decode into (pool exhausted), the deframer
+            overflows on the first data byte and resyncs, dropping the frame.
+        */
+        buf_out = ctx->rx_pkt ? ctx->rx_pkt->buffer->data : NULL;
+        buf_out_max = ctx->rx_pkt ? MAX_WIRE_FRAME_SIZE : 0;
+#endif
+
+        /** @brief Push received bytes into the deframer. */
+        size = ctx->deframer(
+            ctx->deframer_state,
+            buf, len,
+            buf_out, buf_out_max);
+        len = 0;
 
-        k_fifo_put(&rx_fifo, item);
-    }
-    
-done:
-    return buf;
+        if (size < 0)
+        {
+            ctx->stats.rx_deframe_errors++;
+        }
+        else if (size > 0)
+        {
+            rx_deliver(ctx, buf_out, size);
+        }
+    } while (size != 0);
 }
 
 /******************************************************************************
     [docimport eth_serial_send]
 *//**
-    @brief Sends raw ethernet packet via uart pipe.
+    @brief Queues a raw ethernet packet for tx_thread and returns. The packet
+    is referenced until it has been framed.
 ******************************************************************************/
 int
 eth_serial_send(const struct device *dev, struct net_pkt *pkt)
 {
     struct eth_serial_context *ctx = dev->data;
-    struct net_buf *buf;
-    uint16_t k = 0;
-
-    ARG_UNUSED(dev);
+    struct tx_entry *entry;
+    atomic_val_t depth;
 
     if (!pkt->buffer)
     {
         return -ENODATA;
     }
 
-    for (buf = pkt->buffer; buf; buf = buf->frags)
+    if (net_pkt_get_len(pkt) > MAX_ETHERNET_FRAME_SIZE)
+    {
+        return -EMSGSIZE;
+    }
+
+    if (k_mem_slab_alloc(&tx_slab, (void **)&entry, K_NO_WAIT) != 0)
+    {
+        atomic_inc(&ctx->tx_queue_drops);
+        return -ENOBUFS;
+    }
+
+    entry->pkt = net_pkt_ref(pkt);
+    entry->stamp = k_cycle_get_32();
+
+    /* Racy high water update is fine for a diagnostic counter. */
+    depth = k_mem_slab_num_used_get(&tx_slab);
+    if (depth > atomic_get(&ctx->tx_queue_high_water))
     {
-        uint16_t i;
-        uint8_t *ptr = buf->data;
+        atomic_set(&ctx->tx_queue_high_water, depth);
+    }
+
+    k_fifo_put(&tx_fifo, entry);
+    return 0;
+}
+
+/******************************************************************************
+    tx_frame_entry
+*//**
+    @brief Frames a queued packet into buf_framed at offset and releases the
+    queue entry.
+    @return Returns the framed size, or <= 0 on framer error.
+******************************************************************************/
+static int
+tx_frame_entry(struct eth_serial_context *ctx, struct tx_entry *entry,
+    uint32_t offset)
+{
+    struct net_buf *buf;
+    uint8_t *wire = pktbuf_aggregate;
+    uint32_t wire_len;
+    uint16_t k = 0;
+    int size;
 
+    for (buf = entry->pkt->buffer; buf; buf = buf->frags)
+    {
         LOG_DBG("Send fragment buffer %u bytes.", buf->len);
-        for (i = 0; i < buf->len; i++)
-        {
-            pktbuf_aggregate[k++] = *ptr++;
-        }
+        memcpy(&pktbuf_aggregate[k], buf->data, buf->len);
+        k += buf->len;
     }
+    wire_len = k;
 
-    int size = ctx->framer(pktbuf_aggregate, k, buf_framed, sizeof(buf_framed));
+    lat_record(ctx->stats.tx_latency, entry->stamp);
+    net_pkt_unref(entry->pkt);
+    k_mem_slab_free(&tx_slab, entry);
+
+#if defined(CONFIG_ETH_SERIAL_COMPRESS)
+    size = FrameCompress_encode(&compress_link, &compress_work,
+        pktbuf_aggregate, k, pktbuf_compressed, sizeof(pktbuf_compressed));
+    if (size < 0)
+    {
+        LOG_ERR("Compress error (%u bytes): %d", k, size);
+        return size;
+    }
+    wire = pktbuf_compressed;
+    wire_len = size;
+#endif
+
+#if defined(CONFIG_ETH_SERIAL_CRC32)
+    sys_put_le32(Crc32_compute(wire, wire_len), &wire[wire_len]);
+    wire_len += TRAILER_SIZE;
+#endif
+
+    ctx->stats.tx_wire_bytes += wire_len;
+    size = ctx->framer(wire, wire_len,
+        &buf_framed[offset], sizeof(buf_framed) - offset);
     if (size <= 0)
     {
-        return 0;
+        LOG_ERR("Framer error (%u bytes).", k);
+        ctx->stats.tx_framer_overflows++;
+        return size;
     }
 
-    LOG_DBG("Wrote framed %u bytes.", size);
-    uart_pipe_send(buf_framed, size);
-    
-    return 0;
+    ctx->stats.tx_bytes += k;
+    ctx->stats.tx_packets++;
+    return size;
 }
 
 /******************************************************************************
-    rx_thread
+    tx_thread
 *//**
-    @brief Thread which handles processing received raw ethernet frames.
+    @brief Thread which drains the tx queue. Frames queued behind the first
+    one are coalesced into the same uart write while they fit.
 ******************************************************************************/
 static void
-rx_thread(void *p1, void *p2, void *p3)
+tx_thread(void *p1, void *p2, void *p3)
 {
     struct eth_serial_context *ctx = (struct eth_serial_context *)p1;
 
@@ -157,54 +425,241 @@ rx_thread(void *p1, void *p2, void *p3)
 
     while (1)
     {
-        struct fifo_data_item *item;
-        struct net_pkt *pkt;
-        struct net_buf *pkt_buf;
-        struct net_eth_hdr *hdr;
-        uint8_t *ip;
+        struct tx_entry *entry;
+        uint32_t len = 0;
+        int size;
         int ret;
 
-        /* Wait for new data to arrive. */
-        item = k_fifo_get(&rx_fifo, K_FOREVER);
-
-        LOG_DBG("Received frame %d bytes (%u).", item->len, packet_count++);
-        //LOG_HEXDUMP_DBG(buf_deframed, size, "deframed");
+        entry = k_fifo_get(&tx_fifo, K_FOREVER);
 
-        pkt = net_pkt_rx_alloc_on_iface(ctx->iface, K_NO_WAIT);
-        if (!pkt)
+        do
+        {
+            size = tx_frame_entry(ctx, entry, len);
+            if (size > 0)
+            {
+                if (len > 0)
+                {
+                    ctx->stats.tx_coalesced++;
+                }
+                len += size;
+            }
+
+            /* Peek ahead: only take the next packet if it surely fits. */
+            entry = k_fifo_peek_head(&tx_fifo);
+            if (!entry || len + MAX_FRAMED_SIZE(net_pkt_get_len(entry->pkt) +
+                WIRE_OVERHEAD) > sizeof(buf_framed))
+            {
+                break;
+            }
+            entry = k_fifo_get(&tx_fifo, K_NO_WAIT);
+        } while (entry);
+
+        if (len == 0)
         {
-            LOG_ERR("Error allocating network packet.");
             continue;
         }
 
-        pkt_buf = net_pkt_get_frag(pkt, ETH_SERIAL_MTU, K_NO_WAIT);
-        if (!pkt_buf)
+        LOG_DBG("Writing framed %u bytes.", len);
+        ctx->stats.tx_writes++;
+        if ((ret = eth_serial_backend_send(ctx, buf_framed, len)) < 0)
         {
-            LOG_ERR("Error allocating network buffer from packet.");
-            net_pkt_unref(pkt);
-            continue;
+            LOG_ERR("Backend send error: %d", ret);
+            ctx->stats.tx_backend_errors++;
         }
+    }
+}
+
+/******************************************************************************
+    [docimport eth_serial_stats_get]
+*//**
+    @brief Reads the link statistics.
+    @param[in] dev  Pointer to the eth_serial device.
+    @param[out] stats  Counter snapshot.
+******************************************************************************/
+void
+eth_serial_stats_get(const struct device *dev, struct eth_serial_stats *stats)
+{
+    struct eth_serial_context *ctx = dev->data;
+    const uint32_t *base = (const uint32_t *)&ctx->stats_base;
+    uint32_t *count = (uint32_t *)stats;
+    unsigned int key;
+    size_t i;
+
+    BUILD_ASSERT(sizeof(struct eth_serial_stats) % sizeof(uint32_t) == 0,
+        "eth_serial_stats must only hold uint32_t counters");
+
+    /*  The counters are bumped from the UART ISR and the rx/tx threads;
+        copy them in one go, then count from the last reset.
+    */
+    key = irq_lock();
+    *stats = ctx->stats;
+#if defined(CONFIG_ETH_SERIAL_COMPRESS)
+    stats->tx_compressed = compress_link.tx_compressed;
+#endif
+    for (i = 0; i < sizeof(*stats) / sizeof(uint32_t); i++)
+    {
+        count[i] -= base[i];
+    }
+    irq_unlock(key);
 
-        net_pkt_append_buffer(pkt, pkt_buf);
+    stats->tx_queue_drops = (uint32_t)atomic_get(&ctx->tx_queue_drops);
+    stats->tx_queued = k_mem_slab_num_used_get(&tx_slab);
+    stats->tx_queue_high_water =
+        (uint32_t)atomic_get(&ctx->tx_queue_high_water);
+}
+
+/******************************************************************************
+    [docimport eth_serial_stats_reset]
+*//**
+    @brief Clears the link statistics (the current tx queue depth is kept).
+    @param[in] dev  Pointer to the eth_serial device.
+******************************************************************************/
+void
+eth_serial_stats_reset(const struct device *dev)
+{
+    struct eth_serial_context *ctx = dev->data;
+    unsigned int key;
+
+    /* Record a baseline rather than writing the live counters. */
+    key = irq_lock();
+    ctx->stats_base = ctx->stats;
+#if defined(CONFIG_ETH_SERIAL_COMPRESS)
+    ctx->stats_base.tx_compressed = compress_link.tx_compressed;
+#endif
+    irq_unlock(key);
+    atomic_clear(&ctx->tx_queue_drops);
+    atomic_set(&ctx->tx_queue_high_water, k_mem_slab_num_used_get(&tx_slab));
+}
 
-        /* Load L2 header */
-        hdr = NET_ETH_HDR(pkt);
-        memcpy(hdr, item->msg, sizeof(struct net_eth_hdr));
+#if defined(CONFIG_NET_STATISTICS_ETHERNET)
+#if defined(CONFIG_NET_STATISTICS_ETHERNET_VENDOR)
+/** @brief Driver specific counters shown by "net stats". */
+enum {
+    VENDOR_RX_RUNTS,
+    VENDOR_RX_STACK_ERRORS,
+    VENDOR_TX_QUEUED,
+    VENDOR_TX_QUEUE_HIGH_WATER,
+    VENDOR_TX_FRAMER_OVERFLOWS,
+    VENDOR_TX_BACKEND_ERRORS,
+    VENDOR_TX_WRITES,
+    VENDOR_TX_COALESCED,
+    VENDOR_TX_WIRE_BYTES,
+    VENDOR_TX_COMPRESSED,
+    VENDOR_RX_DECOMPRESS_ERRORS,
+    VENDOR_RX_LATENCY,
+    VENDOR_TX_LATENCY = VENDOR_RX_LATENCY + ETH_SERIAL_LAT_BUCKETS,
+    VENDOR_NUM = VENDOR_TX_LATENCY + ETH_SERIAL_LAT_BUCKETS,
+};
+
+#define LAT_KEY(i, pfx)     { pfx "_lat_" STRINGIFY(i), 0 }
+
+static struct net_stats_eth_vendor vendor_stats[VENDOR_NUM + 1] = {
+    [VENDOR_RX_RUNTS]               = { "rx_runts", 0 },
+    [VENDOR_RX_STACK_ERRORS]        = { "rx_stack_errors", 0 },
+    [VENDOR_TX_QUEUED]              = { "tx_queued", 0 },
+    [VENDOR_TX_QUEUE_HIGH_WATER]    = { "tx_queue_high_water", 0 },
+    [VENDOR_TX_FRAMER_OVERFLOWS]    = { "tx_framer_overflows", 0 },
+    [VENDOR_TX_BACKEND_ERRORS]      = { "tx_backend_errors", 0 },
+    [VENDOR_TX_WRITES]              = { "tx_writes", 0 },
+    [VENDOR_TX_COALESCED]           = { "tx_coalesced", 0 },
+    [VENDOR_TX_WIRE_BYTES]          = { "tx_wire_bytes", 0 },
+    [VENDOR_TX_COMPRESSED]          = { "tx_compressed", 0 },
+    [VENDOR_RX_DECOMPRESS_ERRORS]   = { "rx_decompress_errors", 0 },
+    LISTIFY(ETH_SERIAL_LAT_BUCKETS, LAT_KEY, (,), "rx"),
+    LISTIFY(ETH_SERIAL_LAT_BUCKETS, LAT_KEY, (,), "tx"),
+    [VENDOR_NUM]                    = { NULL, 0 },
+};
+#endif
+
+/******************************************************************************
+    eth_serial_get_stats
+*//**
+    @brief ethernet_api get_stats. Refreshes the net_stats_eth view of the
+    link statistics ("net stats").
+******************************************************************************/
+static struct net_stats_eth *
+eth_serial_get_stats(const struct device *dev)
+{
+    struct eth_serial_context *ctx = dev->data;
+    struct net_stats_eth *eth = &ctx->eth_stats;
+    struct eth_serial_stats st;
+
+    eth_serial_stats_get(dev, &st);
+
+    eth->bytes.received = st.rx_bytes;
+    eth->bytes.sent = st.tx_bytes;
+    eth->pkts.rx = st.rx_packets;
+    eth->pkts.tx = st.tx_packets;
+    eth->errors.rx = st.rx_deframe_errors + st.rx_crc_errors + st.rx_runts +
+        st.rx_decompress_errors + st.rx_alloc_failures + st.rx_stack_errors;
+    eth->errors.tx = st.tx_framer_overflows + st.tx_backend_errors;
+    eth->error_details.rx_frame_errors = st.rx_deframe_errors;
+    eth->error_details.rx_crc_errors = st.rx_crc_errors;
+    eth->error_details.rx_short_length_errors = st.rx_runts;
+    eth->error_details.rx_buf_alloc_failed = st.rx_alloc_failures;
+    eth->error_details.tx_fifo_errors = st.tx_framer_overflows;
+    eth->error_details.tx_aborted_errors = st.tx_backend_errors;
+    eth->tx_dropped = st.tx_queue_drops;
+
+#if defined(CONFIG_NET_STATISTICS_ETHERNET_VENDOR)
+    vendor_stats[VENDOR_RX_RUNTS].value = st.rx_runts;
+    vendor_stats[VENDOR_RX_STACK_ERRORS].value = st.rx_stack_errors;
+    vendor_stats[VENDOR_TX_QUEUED].value = st.tx_queued;
+    vendor_stats[VENDOR_TX_QUEUE_HIGH_WATER].value = st.tx_queue_high_water;
+    vendor_stats[VENDOR_TX_FRAMER_OVERFLOWS].value = st.tx_framer_overflows;
+    vendor_stats[VENDOR_TX_BACKEND_ERRORS].value = st.tx_backend_errors;
+    vendor_stats[VENDOR_TX_WRITES].value = st.tx_writes;
+    vendor_stats[VENDOR_TX_COALESCED].value = st.tx_coalesced;
+    vendor_stats[VENDOR_TX_WIRE_BYTES].value = st.tx_wire_bytes;
+    vendor_stats[VENDOR_TX_COMPRESSED].value = st.tx_compressed;
+    vendor_stats[VENDOR_RX_DECOMPRESS_ERRORS].value = st.rx_decompress_errors;
+    for (int i = 0; i < ETH_SERIAL_LAT_BUCKETS; i++)
+    {
+        vendor_stats[VENDOR_RX_LATENCY + i].value = st.rx_latency[i];
+        vendor_stats[VENDOR_TX_LATENCY + i].value = st.tx_latency[i];
+    }
+    eth->vendor = vendor_stats;
+#endif
+
+    return eth;
+}
+#endif
+
+/******************************************************************************
+    rx_thread
+*//**
+    @brief Thread which handles processing received raw ethernet frames.
+******************************************************************************/
+static void
+rx_thread(void *p1, void *p2, void *p3)
+{
+    struct eth_serial_context *ctx = (struct eth_serial_context *)p1;
+
+    ARG_UNUSED(p2);
+    ARG_UNUSED(p3);
+
+    while (1)
+    {
+        struct net_pkt *pkt;
+        int ret;
+
+        /* Wait for new data to arrive. */
+        pkt = k_fifo_get(&rx_fifo, K_FOREVER);
+
+        LOG_DBG("Received frame %u bytes.",
+            (unsigned int)net_pkt_get_len(pkt));
+
+        lat_record(ctx->stats.rx_latency,
+            *(uint32_t *)net_buf_user_data(pkt->buffer));
 
-        /* Load remaining packet */
-        ip = (uint8_t *)net_pkt_data(pkt) + sizeof(struct net_eth_hdr);
-        memcpy(ip, item->msg + sizeof(struct net_eth_hdr),
-            item->len - sizeof(struct net_eth_hdr));
-        
         /* Push packet into the stack. */
-        pkt->buffer->len = item->len;
+        net_pkt_cursor_init(pkt);
         if ((ret = net_recv_data(ctx->iface, pkt)) < 0)
         {
             LOG_ERR("Network layer error: %d", ret);
+            ctx->stats.rx_stack_errors++;
             net_pkt_unref(pkt);
         }
-
-        k_mem_slab_free(&rx_pool, (void *)item);
     }
 }
 
@@ -224,6 +679,16 @@ eth_serial_init(const struct device *dev)
 
     ctx->deframer_state = &deframer_state;
 
+#if defined(CONFIG_ETH_SERIAL_CRC32)
+    LOG_INF("Using CRC-32 frame trailer.");
+    Crc32_init();
+#endif
+
+#if defined(CONFIG_ETH_SERIAL_COMPRESS)
+    LOG_INF("Using LZ4 frame compression (when the peer supports it).");
+    FrameCompress_linkInit(&compress_link);
+#endif
+
 #if defined(CONFIG_ETH_SERIAL_SLIP)
     LOG_INF("Using SLIP framing.");
     ctx->framer         = slip_framer;
@@ -244,12 +709,23 @@ eth_serial_init(const struct device *dev)
     }
 #endif
 
-    uart_pipe_register(ctx->serial_buf, sizeof(ctx->serial_buf), recv_cb);
+    if ((ret = eth_serial_backend_init(ctx)) < 0)
+    {
+        LOG_ERR("Error initializing uart backend: %d", ret);
+        return -1;
+    }
 
     k_thread_create(&rx_thread_data, rx_stack,
                     K_THREAD_STACK_SIZEOF(rx_stack),
                     rx_thread,
                     ctx, NULL, NULL, THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&rx_thread_data, "eth_serial_rx");
+
+    k_thread_create(&tx_thread_data, tx_stack,
+                    K_THREAD_STACK_SIZEOF(tx_stack),
+                    tx_thread,
+                    ctx, NULL, NULL, THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&tx_thread_data, "eth_serial_tx");
 
     return 0;
 }
@@ -303,6 +779,9 @@ static const struct ethernet_api eth_serial_api = {
 
 	.get_capabilities = eth_capabilities,
 	.send = eth_serial_send,
+#if defined(CONFIG_NET_STATISTICS_ETHERNET)
+	.get_stats = eth_serial_get_stats,
+#endif
 };
 
 /** @brief The initialization level is set to be after
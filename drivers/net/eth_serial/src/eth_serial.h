@@ -8,21 +8,93 @@
 
 #include <stdbool.h>
 #include <zephyr/device.h>
+#include <zephyr/sys/atomic.h>
 #include <zephyr/net_buf.h>
 #include <zephyr/net/net_pkt.h>
 #include <zephyr/net/net_if.h>
+#include <zephyr/net/net_stats.h>
 
 #define ETH_SERIAL_BUFFER_SIZE  64
 
+/** @brief Number of latency histogram buckets. Bucket i counts frames with
+    latency below (ETH_SERIAL_LAT_BUCKET0_US << i); the last bucket counts the
+    rest.
+*/
+#define ETH_SERIAL_LAT_BUCKETS      16
+#define ETH_SERIAL_LAT_BUCKET0_US   32
+
+/** @brief Link statistics. */
+struct eth_serial_stats {
+    /** @brief Ethernet bytes/frames handed to the stack. */
+    uint32_t rx_bytes;
+    uint32_t rx_packets;
+    /** @brief Frames rejected by the deframer (overflow, bad escape or COBS
+        encoding). */
+    uint32_t rx_deframe_errors;
+    /** @brief Frames dropped on a CRC-32 trailer mismatch. */
+    uint32_t rx_crc_errors;
+    /** @brief Frames shorter than an ethernet header. */
+    uint32_t rx_runts;
+    /** @brief Rx net_pkt allocation failures (frames lost). */
+    uint32_t rx_alloc_failures;
+    /** @brief Frames rejected by net_recv_data(). */
+    uint32_t rx_stack_errors;
+    /** @brief Frames with a bad compression header or LZ4 block. */
+    uint32_t rx_decompress_errors;
+    /** @brief Ethernet bytes/frames framed and passed to the backend. */
+    uint32_t tx_bytes;
+    uint32_t tx_packets;
+    /** @brief Bytes passed to the framer (after compression and CRC). */
+    uint32_t tx_wire_bytes;
+    /** @brief Frames sent compressed. */
+    uint32_t tx_compressed;
+    /** @brief Frames dropped because the tx queue was full. */
+    uint32_t tx_queue_drops;
+    /** @brief Frames currently queued, and the max seen. */
+    uint32_t tx_queued;
+    uint32_t tx_queue_high_water;
+    /** @brief Frames the framer could not fit in the output buffer. */
+    uint32_t tx_framer_overflows;
+    /** @brief Failed backend writes. */
+    uint32_t tx_backend_errors;
+    /** @brief Backend writes issued. */
+    uint32_t tx_writes;
+    /** @brief Frames merged into a preceding frame's backend write. */
+    uint32_t tx_coalesced;
+    /** @brief Frame deframed -> handed to net_recv_data(). */
+    uint32_t rx_latency[ETH_SERIAL_LAT_BUCKETS];
+    /** @brief eth_serial_send() -> framed for the backend. */
+    uint32_t tx_latency[ETH_SERIAL_LAT_BUCKETS];
+};
+
 /** @brief Driver context object (modeled after drivers/net/slip.h)*/
 struct eth_serial_context {
     bool init_done;
+#if defined(CONFIG_ETH_SERIAL_BACKEND_UART_PIPE)
     uint8_t serial_buf[ETH_SERIAL_BUFFER_SIZE];
+#endif
     uint8_t mac_addr[6];
     struct net_if *iface;
     int (*framer)(uint8_t *buf_in, uint32_t buf_in_len, uint8_t *enc_out, uint32_t max_enc_len);
     int (*deframer)(void *self, uint8_t *buf_in, uint32_t buf_in_len, uint8_t *buf_out, uint32_t max_buf_out);
     void *deframer_state;
+    /** @brief Pre-allocated rx packet the deframer writes into. */
+    struct net_pkt *rx_pkt;
+    /** @brief Link statistics. Each field has a single writer, except the
+        tx queue counters below which are updated from any sending thread.
+    */
+    struct eth_serial_stats stats;
+    /** @brief Counters at the last eth_serial_stats_reset(). The live
+        counters are only written by their owners (ISR, rx and tx threads),
+        so a reset cannot be undone by a concurrent increment.
+    */
+    struct eth_serial_stats stats_base;
+    atomic_t tx_queue_drops;
+    atomic_t tx_queue_high_water;
+#if defined(CONFIG_NET_STATISTICS_ETHERNET)
+    /** @brief Stats returned to the stack by get_stats. */
+    struct net_stats_eth eth_stats;
+#endif
 };
 
 /******************************************************************************
@@ -41,4 +113,63 @@ eth_serial_init(const struct device *dev);
 ******************************************************************************/
 void
 eth_serial_iface_init(struct net_if *iface);
+
+/******************************************************************************
+    [docexport eth_serial_stats_get]
+*//**
+    @brief Reads the link statistics.
+    @param[in] dev  Pointer to the eth_serial device.
+    @param[out] stats  Counter snapshot.
+******************************************************************************/
+void
+eth_serial_stats_get(const struct device *dev, struct eth_serial_stats *stats);
+
+/******************************************************************************
+    [docexport eth_serial_stats_reset]
+*//**
+    @brief Clears the link statistics (the current tx queue depth is kept).
+    @param[in] dev  Pointer to the eth_serial device.
+******************************************************************************/
+void
+eth_serial_stats_reset(const struct device *dev);
+
+/******************************************************************************
+    [docexport eth_serial_rx]
+*//**
+    @brief Backend receive hook. Deframes directly into the pre-allocated rx
+    packet and hands completed packets to rx_thread. May be called from ISR.
+    @param[in] ctx  Driver context.
+    @param[in] buf  Buffer holding received data.
+    @param[in] len  Number of bytes received.
+******************************************************************************/
+void
+eth_serial_rx(struct eth_serial_context *ctx, uint8_t *buf, uint32_t len);
+
+/** @brief UART backend interface, implemented by one of
+    eth_serial_uart_pipe.c or eth_serial_uart_async.c.
+*/
+
+/******************************************************************************
+    [docexport eth_serial_backend_init]
+*//**
+    @brief Initializes the uart backend and starts reception. Received bytes
+    are passed to eth_serial_rx().
+    @param[in] ctx  Driver context.
+    @return Returns 0 on success, negative on error.
+******************************************************************************/
+int
+eth_serial_backend_init(struct eth_serial_context *ctx);
+
+/******************************************************************************
+    [docexport eth_serial_backend_send]
+*//**
+    @brief Sends a framed buffer. The buffer may be reused on return.
+    @param[in] ctx  Driver context.
+    @param[in] data  Framed bytes.
+    @param[in] len  Number of bytes.
+    @return Returns 0 on success, negative on error.
+******************************************************************************/
+int
+eth_serial_backend_send(struct eth_serial_context *ctx, uint8_t *data,
+    uint32_t len);
 #endif
@@ -0,0 +1,166 @@
+/*******************************************************************************
+ *  @file: eth_serial_rpc.c
+ *
+ *  @brief: Handlers for the eth_serial RPC callset (proto/EthSerialRpc).
+*******************************************************************************/
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/logging/log.h>
+#include "eth_serial.h"
+#include "eth_serial_rpc.h"
+
+LOG_MODULE_DECLARE(eth_serial, CONFIG_ETH_SERIAL_LOG_LEVEL);
+
+CallsetInfo ethserial_Callset_info = {
+    .ver_major = ethserial_CallsetVersion_MAJOR,
+    .ver_minor = ethserial_CallsetVersion_MINOR,
+    .ver_patch = ethserial_CallsetVersion_PATCH,
+    .name = "ethserial",
+};
+
+/* Defined by ETH_NET_DEVICE_INIT() in eth_serial.c */
+DEVICE_DECLARE(eth_serial);
+#define ETH_SERIAL_DEV      DEVICE_GET(eth_serial)
+
+/******************************************************************************
+    getstats
+
+    Call params:
+    Reply params:
+        reply->rx_bytes: uint32
+        reply->rx_packets: uint32
+        reply->rx_deframe_errors: uint32
+        reply->rx_runts: uint32
+        reply->rx_alloc_failures: uint32
+        reply->rx_stack_errors: uint32
+        reply->tx_bytes: uint32
+        reply->tx_packets: uint32
+        reply->tx_queue_drops: uint32
+        reply->tx_queued: uint32
+        reply->tx_queue_high_water: uint32
+        reply->tx_framer_overflows: uint32
+        reply->tx_backend_errors: uint32
+        reply->tx_writes: uint32
+        reply->tx_coalesced: uint32
+        reply->lat_bucket0_us: uint32
+        reply->rx_latency: uint32 [repeated]
+        reply->tx_latency: uint32 [repeated]
+        reply->rx_crc_errors: uint32
+        reply->rx_decompress_errors: uint32
+        reply->tx_wire_bytes: uint32
+        reply->tx_compressed: uint32
+*//**
+    @brief Implements the RPC getstats handler.
+******************************************************************************/
+static void
+getstats(void *call_frame, void *reply_frame, StatusEnum *status)
+{
+    ethserial_Callset *call_msg = (ethserial_Callset *)call_frame;
+    ethserial_Callset *reply_msg = (ethserial_Callset *)reply_frame;
+    ethserial_GetStats_call *call = &call_msg->msg.getstats_call;
+    ethserial_GetStats_reply *reply = &reply_msg->msg.getstats_reply;
+    struct eth_serial_stats st;
+    int i;
+
+    (void)call;
+
+    LOG_DBG("In getstats handler");
+
+    reply_msg->which_msg = ethserial_Callset_getstats_reply_tag;
+    *status = StatusEnum_RPC_SUCCESS;
+
+    eth_serial_stats_get(ETH_SERIAL_DEV, &st);
+
+    reply->rx_bytes = st.rx_bytes;
+    reply->rx_packets = st.rx_packets;
+    reply->rx_deframe_errors = st.rx_deframe_errors;
+    reply->rx_crc_errors = st.rx_crc_errors;
+    reply->rx_runts = st.rx_runts;
+    reply->rx_alloc_failures = st.rx_alloc_failures;
+    reply->rx_stack_errors = st.rx_stack_errors;
+    reply->rx_decompress_errors = st.rx_decompress_errors;
+    reply->tx_bytes = st.tx_bytes;
+    reply->tx_packets = st.tx_packets;
+    reply->tx_wire_bytes = st.tx_wire_bytes;
+    reply->tx_compressed = st.tx_compressed;
+    reply->tx_queue_drops = st.tx_queue_drops;
+    reply->tx_queued = st.tx_queued;
+    reply->tx_queue_high_water = st.tx_queue_high_water;
+    reply->tx_framer_overflows = st.tx_framer_overflows;
+    reply->tx_backend_errors = st.tx_backend_errors;
+    reply->tx_writes = st.tx_writes;
+    reply->tx_coalesced = st.tx_coalesced;
+
+    reply->lat_bucket0_us = ETH_SERIAL_LAT_BUCKET0_US;
+    reply->rx_latency_count = MIN(ETH_SERIAL_LAT_BUCKETS,
+        PROTORPC_ARRAY_LENGTH(reply->rx_latency));
+    reply->tx_latency_count = reply->rx_latency_count;
+    for (i = 0; i < reply->rx_latency_count; i++)
+    {
+        reply->rx_latency[i] = st.rx_latency[i];
+        reply->tx_latency[i] = st.tx_latency[i];
+    }
+}
+
+/******************************************************************************
+    resetstats
+
+    Call params:
+    Reply params:
+*//**
+    @brief Implements the RPC resetstats handler.
+******************************************************************************/
+static void
+resetstats(void *call_frame, void *reply_frame, StatusEnum *status)
+{
+    ethserial_Callset *call_msg = (ethserial_Callset *)call_frame;
+    ethserial_Callset *reply_msg = (ethserial_Callset *)reply_frame;
+    ethserial_ResetStats_call *call = &call_msg->msg.resetstats_call;
+    ethserial_ResetStats_reply *reply = &reply_msg->msg.resetstats_reply;
+
+    (void)call;
+    (void)reply;
+
+    LOG_DBG("In resetstats handler");
+
+    reply_msg->which_msg = ethserial_Callset_resetstats_reply_tag;
+    *status = StatusEnum_RPC_SUCCESS;
+
+    eth_serial_stats_reset(ETH_SERIAL_DEV);
+}
+
+
+static ProtoRpc_Handler_Entry handlers[] = {
+    PROTORPC_ADD_HANDLER(ethserial_Callset_getstats_call_tag, getstats),
+    PROTORPC_ADD_HANDLER(ethserial_Callset_resetstats_call_tag, resetstats),
+};
+
+#define NUM_HANDLERS    PROTORPC_ARRAY_LENGTH(handlers)
+
+/******************************************************************************
+    [docimport EthSerialRpc_resolver]
+*//**
+    @brief Resolver function for EthSerialRpc.
+    @param[in] call_frame  Pointer to the unpacked call frame object.
+    @param[out] which_msg  Output which_msg was requested.
+******************************************************************************/
+ProtoRpc_handler *
+EthSerialRpc_resolver(void *call_frame, uint32_t *which_msg)
+{
+    ethserial_Callset *this = (ethserial_Callset *)call_frame;
+    unsigned int i;
+
+    *which_msg = this->which_msg;
+
+    /** @brief Handler lookup */
+    for (i = 0; i < NUM_HANDLERS; i++)
+    {
+        ProtoRpc_Handler_Entry *entry = &handlers[i];
+        if (entry->tag == this->which_msg)
+        {
+            return entry->handler;
+        }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,25 @@
+/*******************************************************************************
+ *  @file: eth_serial_rpc.h
+ *
+ *  @brief: Header for the eth_serial RPC callset.
+*******************************************************************************/
+#ifndef ETH_SERIAL_RPC_H
+#define ETH_SERIAL_RPC_H
+
+#include <stdint.h>
+#include "ProtoRpc.h"
+#include "ProtoRpcHeader.pb.h"
+#include "EthSerialRpc.pb.h"
+
+extern CallsetInfo ethserial_Callset_info;
+
+/******************************************************************************
+    [docexport EthSerialRpc_resolver]
+*//**
+    @brief Resolver function for EthSerialRpc.
+    @param[in] call_frame  Pointer to the unpacked call frame object.
+    @param[out] which_msg  Output which_msg was requested.
+******************************************************************************/
+ProtoRpc_handler *
+EthSerialRpc_resolver(void *call_frame, uint32_t *which_msg);
+#endif
@@ -0,0 +1,239 @@
+/*******************************************************************************
+ *  @file: eth_serial_uart_async.c
+ *
+ *  @brief: uart_async (DMA) backend for the eth_serial driver.
+ *
+ *  Rx runs continuously into two DMA buffers which the driver swaps on
+ *  UART_RX_BUF_REQUEST. Tx copies framed bytes into a ring buffer and returns;
+ *  the ring is drained by chained uart_tx() calls from UART_TX_DONE.
+ *
+ *  Uses the device chosen as zephyr,uart-pipe.
+*******************************************************************************/
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/uart.h>
+#include <zephyr/sys/ring_buffer.h>
+#include "eth_serial.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(eth_serial, CONFIG_ETH_SERIAL_LOG_LEVEL);
+
+#define RX_BUF_SIZE     CONFIG_ETH_SERIAL_ASYNC_RX_BUF_SIZE
+#define RX_TIMEOUT_US   CONFIG_ETH_SERIAL_ASYNC_RX_TIMEOUT_US
+#define TX_BUF_SIZE     CONFIG_ETH_SERIAL_ASYNC_TX_BUF_SIZE
+#define TX_TIMEOUT_MS   CONFIG_ETH_SERIAL_ASYNC_TX_TIMEOUT_MS
+
+static const struct device *const uart_dev =
+    DEVICE_DT_GET(DT_CHOSEN(zephyr_uart_pipe));
+
+/** @brief Rx double buffer. */
+static uint8_t rx_bufs[2][RX_BUF_SIZE];
+/** @brief Index of the buffer handed out on the next UART_RX_BUF_REQUEST. */
+static uint8_t rx_next;
+
+/** @brief Tx queue. */
+RING_BUF_DECLARE(tx_ring, TX_BUF_SIZE);
+static struct k_spinlock tx_lock;
+/** @brief Tx in progress and its length (claimed from tx_ring). */
+static bool tx_busy;
+static uint32_t tx_inflight;
+/** @brief Signaled whenever tx_ring space is released. */
+static K_SEM_DEFINE(tx_space, 0, 1);
+
+/******************************************************************************
+    tx_kick
+*//**
+    @brief Starts a transfer of the next contiguous chunk of tx_ring if the
+    uart is idle. uart_tx() is called outside the lock since some drivers
+    complete synchronously.
+******************************************************************************/
+static void
+tx_kick(void)
+{
+    k_spinlock_key_t key;
+    uint8_t *data;
+    uint32_t len;
+    int ret;
+
+    key = k_spin_lock(&tx_lock);
+    if (tx_busy)
+    {
+        k_spin_unlock(&tx_lock, key);
+        return;
+    }
+
+    len = ring_buf_get_claim(&tx_ring, &data, TX_BUF_SIZE);
+    if (len == 0)
+    {
+        k_spin_unlock(&tx_lock, key);
+        return;
+    }
+    tx_busy = true;
+    tx_inflight = len;
+    k_spin_unlock(&tx_lock, key);
+
+    ret = uart_tx(uart_dev, data, len, SYS_FOREVER_US);
+    if (ret < 0)
+    {
+        LOG_ERR("uart_tx error, dropping %u bytes: %d", len, ret);
+        key = k_spin_lock(&tx_lock);
+        ring_buf_get_finish(&tx_ring, len);
+        tx_busy = false;
+        k_spin_unlock(&tx_lock, key);
+        k_sem_give(&tx_space);
+    }
+}
+
+/******************************************************************************
+    uart_cb
+*//**
+    @brief uart_async event callback (ISR context).
+******************************************************************************/
+static void
+uart_cb(const struct device *dev, struct uart_event *evt, void *user_data)
+{
+    struct eth_serial_context *ctx = (struct eth_serial_context *)user_data;
+    k_spinlock_key_t key;
+    int ret;
+
+    switch (evt->type)
+    {
+    case UART_TX_DONE:
+    case UART_TX_ABORTED:
+        if (evt->type == UART_TX_ABORTED)
+        {
+            LOG_WRN("Tx aborted after %u of %u bytes.",
+                (unsigned int)evt->data.tx.len, tx_inflight);
+        }
+        key = k_spin_lock(&tx_lock);
+        ring_buf_get_finish(&tx_ring, tx_inflight);
+        tx_busy = false;
+        k_spin_unlock(&tx_lock, key);
+        k_sem_give(&tx_space);
+        tx_kick();
+        break;
+
+    case UART_RX_RDY:
+        eth_serial_rx(ctx,
+            evt->data.rx.buf + evt->data.rx.offset,
+            evt->data.rx.len);
+        break;
+
+    case UART_RX_BUF_REQUEST:
+        ret = uart_rx_buf_rsp(dev, rx_bufs[rx_next], RX_BUF_SIZE);
+        if (ret < 0)
+        {
+            LOG_ERR("uart_rx_buf_rsp error: %d", ret);
+        }
+        rx_next ^= 1;
+        break;
+
+    case UART_RX_BUF_RELEASED:
+        break;
+
+    case UART_RX_STOPPED:
+        LOG_ERR("Rx stopped: reason %d", evt->data.rx_stop.reason);
+        break;
+
+    case UART_RX_DISABLED:
+        /* Restart reception (e.g. after an rx error). */
+        rx_next = 1;
+        ret = uart_rx_enable(dev, rx_bufs[0], RX_BUF_SIZE, RX_TIMEOUT_US);
+        if (ret < 0)
+        {
+            LOG_ERR("uart_rx_enable error: %d", ret);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/******************************************************************************
+    [docimport eth_serial_backend_init]
+*//**
+    @brief Initializes the uart backend and starts reception. Received bytes
+    are passed to eth_serial_rx().
+    @param[in] ctx  Driver context.
+    @return Returns 0 on success, negative on error.
+******************************************************************************/
+int
+eth_serial_backend_init(struct eth_serial_context *ctx)
+{
+    int ret;
+
+    LOG_INF("Using uart_async backend (%s).", uart_dev->name);
+
+    if (!device_is_ready(uart_dev))
+    {
+        LOG_ERR("uart device not ready.");
+        return -ENODEV;
+    }
+
+    ret = uart_callback_set(uart_dev, uart_cb, ctx);
+    if (ret < 0)
+    {
+        LOG_ERR("uart_callback_set error: %d", ret);
+        return ret;
+    }
+
+    rx_next = 1;
+    ret = uart_rx_enable(uart_dev, rx_bufs[0], RX_BUF_SIZE, RX_TIMEOUT_US);
+    if (ret < 0)
+    {
+        LOG_ERR("uart_rx_enable error: %d", ret);
+        return ret;
+    }
+
+    return 0;
+}
+
+/******************************************************************************
+    [docimport eth_serial_backend_send]
+*//**
+    @brief Sends a framed buffer. The buffer may be reused on return.
+    @param[in] ctx  Driver context.
+    @param[in] data  Framed bytes.
+    @param[in] len  Number of bytes.
+    @return Returns 0 on success, negative on error.
+******************************************************************************/
+int
+eth_serial_backend_send(struct eth_serial_context *ctx, uint8_t *data,
+    uint32_t len)
+{
+    k_spinlock_key_t key;
+
+    ARG_UNUSED(ctx);
+
+    if (len > TX_BUF_SIZE)
+    {
+        LOG_ERR("Frame too large for tx queue (%u bytes).", len);
+        return -EMSGSIZE;
+    }
+
+    /*  Queue the frame and return. Only wait when the queue is full, i.e. when
+        the stack produces faster than the line rate.
+    */
+    while (1)
+    {
+        key = k_spin_lock(&tx_lock);
+        if (ring_buf_space_get(&tx_ring) >= len)
+        {
+            ring_buf_put(&tx_ring, data, len);
+            k_spin_unlock(&tx_lock, key);
+            break;
+        }
+        k_spin_unlock(&tx_lock, key);
+
+        if (k_sem_take(&tx_space, K_MSEC(TX_TIMEOUT_MS)) != 0)
+        {
+            LOG_ERR("Tx queue full, dropping frame (%u bytes).", len);
+            return -ENOBUFS;
+        }
+    }
+
+    tx_kick();
+    return 0;
+}
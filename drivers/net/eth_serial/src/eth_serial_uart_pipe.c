@@ -0,0 +1,68 @@
+/*******************************************************************************
+ *  @file: eth_serial_uart_pipe.c
+ *  
+ *  @brief: uart_pipe backend for the eth_serial driver.
+*******************************************************************************/
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>    // for CONTAINER_OF() macro
+#include <zephyr/drivers/uart_pipe.h>
+#include "eth_serial.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(eth_serial, CONFIG_ETH_SERIAL_LOG_LEVEL);
+
+/******************************************************************************
+    recv_cb
+*//**
+    @brief Callback for uart-pipe receive data.
+    @param[in] buf  Buffer holding received data.
+    @param[out] off  Running buffer pointer offset. 
+******************************************************************************/
+static uint8_t *
+recv_cb(uint8_t *buf, size_t *off)
+{
+    struct eth_serial_context *ctx =
+        CONTAINER_OF(buf, struct eth_serial_context, serial_buf[0]);
+    uint32_t len = *off;
+
+    /* We always consume all the data, reset the offset for the next call.*/
+    *off = 0;
+
+    eth_serial_rx(ctx, buf, len);
+    return buf;
+}
+
+/******************************************************************************
+    [docimport eth_serial_backend_init]
+*//**
+    @brief Initializes the uart backend and starts reception. Received bytes
+    are passed to eth_serial_rx().
+    @param[in] ctx  Driver context.
+    @return Returns 0 on success, negative on error.
+******************************************************************************/
+int
+eth_serial_backend_init(struct eth_serial_context *ctx)
+{
+    LOG_INF("Using uart_pipe backend.");
+    uart_pipe_register(ctx->serial_buf, sizeof(ctx->serial_buf), recv_cb);
+    return 0;
+}
+
+/******************************************************************************
+    [docimport eth_serial_backend_send]
+*//**
+    @brief Sends a framed buffer. The buffer may be reused on return.
+    @param[in] ctx  Driver context.
+    @param[in] data  Framed bytes.
+    @param[in] len  Number of bytes.
+    @return Returns 0 on success, negative on error.
+******************************************************************************/
+int
+eth_serial_backend_send(struct eth_serial_context *ctx, uint8_t *data,
+    uint32_t len)
+{
+    ARG_UNUSED(ctx);
+
+    /* Blocks until all bytes are written. */
+    return uart_pipe_send(data, len);
+}
@@ -0,0 +1,119 @@
+/*******************************************************************************
+ *  @file: Backoff.h
+ *
+ *  @brief: Header for the reconnect backoff policy.
+*******************************************************************************/
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Reconnect states. */
+typedef enum Backoff_State
+{
+    /** @brief Waiting for the next attempt (also the initial state). */
+    BACKOFF_STATE_WAITING = 0,
+    /** @brief Attempt in progress. */
+    BACKOFF_STATE_CONNECTING,
+    /** @brief Last attempt succeeded. */
+    BACKOFF_STATE_CONNECTED,
+} Backoff_State;
+
+/** @brief Reconnect policy. The delay after the n-th consecutive failure is
+    drawn from [cap/2, cap], cap = min(max_ms, base_ms * 2^(n-1)). After a
+    connection loss the first attempt is drawn from [0, base_ms].
+    Updated by the owning thread only; other threads may read the fields for
+    reporting.
+*/
+typedef struct Backoff
+{
+    /** @brief Configuration. */
+    uint32_t base_ms;
+    uint32_t max_ms;
+    /** @brief Current state. */
+    Backoff_State state;
+    /** @brief Consecutive failures since the last success. */
+    uint32_t failures;
+    /** @brief Last chosen delay and the uptime, ms, of the next attempt. */
+    uint32_t delay_ms;
+    int64_t next_ms;
+    /** @brief Error passed with the last failure. */
+    int last_err;
+    /** @brief Counters. */
+    uint32_t attempts;
+    uint32_t successes;
+    uint32_t losses;
+} Backoff;
+
+/******************************************************************************
+    [docexport Backoff_init]
+*//**
+    @brief Initializes a policy. The first attempt is due immediately.
+    @param[in] b  Pointer to Backoff instance.
+    @param[in] base_ms  Delay cap after the first failure.
+    @param[in] max_ms  Upper bound of the delay cap.
+******************************************************************************/
+void
+Backoff_init(Backoff *b, uint32_t base_ms, uint32_t max_ms);
+
+/******************************************************************************
+    [docexport Backoff_attempt]
+*//**
+    @brief Records the start of a connection attempt.
+    @param[in] b  Pointer to Backoff instance.
+******************************************************************************/
+void
+Backoff_attempt(Backoff *b);
+
+/******************************************************************************
+    [docexport Backoff_fail]
+*//**
+    @brief Records a failed attempt and schedules the next one.
+    @param[in] b  Pointer to Backoff instance.
+    @param[in] err  Error of the attempt, kept for reporting.
+    @return Returns the delay, ms, until the next attempt.
+******************************************************************************/
+uint32_t
+Backoff_fail(Backoff *b, int err);
+
+/******************************************************************************
+    [docexport Backoff_success]
+*//**
+    @brief Records a successful attempt and resets the delay.
+    @param[in] b  Pointer to Backoff instance.
+******************************************************************************/
+void
+Backoff_success(Backoff *b);
+
+/******************************************************************************
+    [docexport Backoff_lost]
+*//**
+    @brief Records the loss of an established connection and schedules the
+    first reconnect attempt within base_ms.
+    @param[in] b  Pointer to Backoff instance.
+    @return Returns the delay, ms, until the next attempt.
+******************************************************************************/
+uint32_t
+Backoff_lost(Backoff *b);
+
+/******************************************************************************
+    [docexport Backoff_remainingMs]
+*//**
+    @brief Gets the time left until the next attempt is due.
+    @param[in] b  Pointer to Backoff instance.
+    @return Returns ms until the next attempt, 0 when due.
+******************************************************************************/
+uint32_t
+Backoff_remainingMs(const Backoff *b);
+
+/******************************************************************************
+    [docexport Backoff_stateStr]
+*//**
+    @brief Gets a printable name for a state.
+    @param[in] state  State.
+******************************************************************************/
+const char *
+Backoff_stateStr(Backoff_State state);
+
+#endif
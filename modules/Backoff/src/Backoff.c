@@ -0,0 +1,180 @@
+/*******************************************************************************
+ *  @file: Backoff.c
+ *
+ *  @brief: Reconnect policy: exponential backoff with jitter.
+*******************************************************************************/
+#include <zephyr/kernel.h>
+#include <zephyr/random/random.h>
+#include "Backoff.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(Backoff, CONFIG_BACKOFF_LOG_LEVEL);
+
+/******************************************************************************
+    rand_range
+*//**
+    @brief Returns a random value in [lo, hi].
+******************************************************************************/
+static uint32_t
+rand_range(uint32_t lo, uint32_t hi)
+{
+    if (hi <= lo)
+    {
+        return lo;
+    }
+    return lo + (sys_rand32_get() % (hi - lo + 1));
+}
+
+/******************************************************************************
+    schedule
+*//**
+    @brief Sets the next attempt delay_ms from now.
+******************************************************************************/
+static uint32_t
+schedule(Backoff *b, uint32_t delay_ms)
+{
+    b->delay_ms = delay_ms;
+    b->next_ms = k_uptime_get() + delay_ms;
+    b->state = BACKOFF_STATE_WAITING;
+    return delay_ms;
+}
+
+/******************************************************************************
+    [docimport Backoff_init]
+*//**
+    @brief Initializes a policy. The first attempt is due immediately.
+    @param[in] b  Pointer to Backoff instance.
+    @param[in] base_ms  Delay cap after the first failure.
+    @param[in] max_ms  Upper bound of the delay cap.
+******************************************************************************/
+void
+Backoff_init(Backoff *b, uint32_t base_ms, uint32_t max_ms)
+{
+    b->base_ms = MAX(base_ms, 1);
+    b->max_ms = MAX(max_ms, b->base_ms);
+    b->state = BACKOFF_STATE_WAITING;
+    b->failures = 0;
+    b->delay_ms = 0;
+    b->next_ms = 0;
+    b->last_err = 0;
+    b->attempts = 0;
+    b->successes = 0;
+    b->losses = 0;
+}
+
+/******************************************************************************
+    [docimport Backoff_attempt]
+*//**
+    @brief Records the start of a connection attempt.
+    @param[in] b  Pointer to Backoff instance.
+******************************************************************************/
+void
+Backoff_attempt(Backoff *b)
+{
+    b->state = BACKOFF_STATE_CONNECTING;
+    b->attempts++;
+}
+
+/******************************************************************************
+    [docimport Backoff_fail]
+*//**
+    @brief Records a failed attempt and schedules the next one.
+    @param[in] b  Pointer to Backoff instance.
+    @param[in] err  Error of the attempt, kept for reporting.
+    @return Returns the delay, ms, until the next attempt.
+******************************************************************************/
+uint32_t
+Backoff_fail(Backoff *b, int err)
+{
+    uint32_t cap = b->base_ms;
+    uint32_t i;
+
+    b->last_err = err;
+    b->failures++;
+
+    /* Double per failure, stopping at max_ms (and before overflowing). */
+    for (i = 1; i < b->failures && cap < b->max_ms; i++)
+    {
+        cap = (cap > b->max_ms / 2) ? b->max_ms : cap * 2;
+    }
+    cap = MIN(cap, b->max_ms);
+
+    LOG_DBG("Attempt %u failed (%d), %u consecutive.",
+        b->attempts, err, b->failures);
+
+    /* Equal jitter: keeps half the backoff, randomizes the other half. */
+    return schedule(b, rand_range(cap / 2, cap));
+}
+
+/******************************************************************************
+    [docimport Backoff_success]
+*//**
+    @brief Records a successful attempt and resets the delay.
+    @param[in] b  Pointer to Backoff instance.
+******************************************************************************/
+void
+Backoff_success(Backoff *b)
+{
+    b->state = BACKOFF_STATE_CONNECTED;
+    b->failures = 0;
+    b->delay_ms = 0;
+    b->last_err = 0;
+    b->successes++;
+}
+
+/******************************************************************************
+    [docimport Backoff_lost]
+*//**
+    @brief Records the loss of an established connection and schedules the
+    first reconnect attempt within base_ms.
+    @param[in] b  Pointer to Backoff instance.
+    @return Returns the delay, ms, until the next attempt.
+******************************************************************************/
+uint32_t
+Backoff_lost(Backoff *b)
+{
+    b->failures = 0;
+    b->losses++;
+
+    /*  Full jitter on the first attempt: a server restart drops every client
+        at once, and they should not all come back in the same instant.
+    */
+    return schedule(b, rand_range(0, b->base_ms));
+}
+
+/******************************************************************************
+    [docimport Backoff_remainingMs]
+*//**
+    @brief Gets the time left until the next attempt is due.
+    @param[in] b  Pointer to Backoff instance.
+    @return Returns ms until the next attempt, 0 when due.
+******************************************************************************/
+uint32_t
+Backoff_remainingMs(const Backoff *b)
+{
+    int64_t left = b->next_ms - k_uptime_get();
+
+    return (left > 0) ? (uint32_t)left : 0;
+}
+
+/******************************************************************************
+    [docimport Backoff_stateStr]
+*//**
+    @brief Gets a printable name for a state.
+    @param[in] state  State.
+******************************************************************************/
+const char *
+Backoff_stateStr(Backoff_State state)
+{
+    switch (state)
+    {
+    case BACKOFF_STATE_WAITING:
+        return "waiting";
+    case BACKOFF_STATE_CONNECTING:
+        return "connecting";
+    case BACKOFF_STATE_CONNECTED:
+        return "connected";
+    default:
+        return "unknown";
+    }
+}
@@ -8,6 +8,7 @@
 
 #include <stdint.h>
 #include <zephyr/kernel.h>
+#include <zephyr/sys/atomic.h>
 
 typedef struct CircBuffer
 {
@@ -16,10 +17,29 @@ typedef struct CircBuffer
     uint32_t buf_size;
     int wr_idx;
     int rd_idx;
+    /** @brief Running byte counts for cursors (wrapping). wr_head is
+        published before a write copies its data, wr_tail after. */
+    atomic_t wr_head;
+    atomic_t wr_tail;
+    /** @brief wr_tail at the last flush. */
+    atomic_t flush_pos;
     struct k_mutex mtx;
 
 } CircBuffer;
 
+/** @brief Read position of a cursor reader. A cursor reads the buffer
+    without consuming it and without taking the lock, so it never blocks
+    the writer; the writer in turn never waits for it and overwrites what
+    the cursor did not read in time.
+  */
+typedef struct CircBuffer_Cursor
+{
+    /** @brief Running byte count of the next byte to read. */
+    uint32_t pos;
+    /** @brief Buffer index of the next byte to read. */
+    int idx;
+} CircBuffer_Cursor;
+
 /** @brief Macro for obtaining the proper memory allocation size for a
       CircBuffer when statically allocating memory.
     Ex: static uint8_t buf[CircBuffer_getMemAllocSize(15)];
@@ -68,6 +88,40 @@ CircBuffer_getCount(CircBuffer *circ);
 int
 CircBuffer_read(CircBuffer *circ, uint8_t *buf, uint32_t req_size);
 
+/******************************************************************************
+    [docexport CircBuffer_cursorInit]
+*//**
+    @brief Positions a cursor at the current end of the buffer, so it reads
+    what is written from now on.
+    @param[in] circ  Pointer to CircBuffer instance.
+    @param[out] cur  Pointer to the cursor.
+******************************************************************************/
+void
+CircBuffer_cursorInit(CircBuffer *circ, CircBuffer_Cursor *cur);
+
+/******************************************************************************
+    [docexport CircBuffer_cursorRead]
+*//**
+    @brief Reads the next bytes at a cursor and advances it, leaving the
+    buffer contents in place. The writer may run concurrently: bytes it
+    overwrites before they are read are skipped and counted in dropped, as
+    are bytes discarded by CircBuffer_flush. Only one thread may read at a
+    given cursor.
+    @param[in] circ  Pointer to CircBuffer instance.
+    @param[in,out] cur  Pointer to the cursor.
+    @param[in] buf  Pointer to buffer to write to.
+    @param[in] req_size  Requested size to read from buffer.
+    @param[out] dropped  Bytes skipped by this call.
+    @return Returns the number read.
+******************************************************************************/
+int
+CircBuffer_cursorRead(
+    CircBuffer *circ,
+    CircBuffer_Cursor *cur,
+    uint8_t *buf,
+    uint32_t req_size,
+    uint32_t *dropped);
+
 /******************************************************************************
     [docexport CircBuffer_lock]
 *//**
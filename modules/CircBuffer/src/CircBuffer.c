@@ -8,6 +8,7 @@
 *******************************************************************************/
 #include <stdbool.h>
 #include <zephyr/kernel.h>
+#include <zephyr/sys/barrier.h>
 #include "CircBuffer.h"
 
 #include <zephyr/logging/log.h>
@@ -54,6 +55,9 @@ do {                                       \
 
 #define CIRC_MIN(a, b)  ((a < b) ? (a) : (b))
 
+/** @brief Running byte counts wrap, compare them by difference. */
+#define pos_before(a, b)    ((int32_t)((uint32_t)(a) - (uint32_t)(b)) < 0)
+
 /******************************************************************************
     circ_write
 *//**
@@ -92,16 +96,16 @@ circ_write(CircBuffer *circ, void *data, uint32_t size)
     @brief Reads data from circular array.
 ******************************************************************************/
 static void
-circ_read(CircBuffer *circ, void *data, uint32_t num)
+circ_read_at(CircBuffer *circ, int idx, void *data, uint32_t num)
 {
     uint32_t numToWrap;
-    uint8_t *p = getMemPtr_rd(circ);
+    uint8_t *p = circ->buf + idx;
 
     /* Check if the write is expected to wrap. */
-    if (circ->rd_idx + num > circ->buf_size)
+    if (idx + num > circ->buf_size)
     {
         /* Number of reads to get to the address just prior to wrap. */
-        numToWrap = circ->buf_size - circ->rd_idx + 1;
+        numToWrap = circ->buf_size - idx + 1;
         /* Read up to the last avail memory location prior to wrap. */
         memcpy(data, p, numToWrap);
         /* Complete the read from the beginning of the circular mem. */
@@ -114,6 +118,31 @@ circ_read(CircBuffer *circ, void *data, uint32_t num)
     }
 }
 
+/******************************************************************************
+    circ_read
+*//**
+    @brief Reads data from circular array at the read index.
+******************************************************************************/
+static void
+circ_read(CircBuffer *circ, void *data, uint32_t num)
+{
+    circ_read_at(circ, circ->rd_idx, data, num);
+}
+
+/******************************************************************************
+    cursor_advance
+*//**
+    @brief Moves a cursor forward by num bytes, with circular wrap.
+******************************************************************************/
+static void
+cursor_advance(CircBuffer *circ, CircBuffer_Cursor *cur, uint32_t num)
+{
+    uint32_t slots = circ->buf_size + 1;
+
+    cur->pos += num;
+    cur->idx = (int)(((uint32_t)cur->idx + num % slots) % slots);
+}
+
 /******************************************************************************
     [docimport CircBuffer_flush]
 *//**
@@ -124,8 +153,9 @@ void
 CircBuffer_flush(CircBuffer *circ)
 {
     lock(circ);
-    circ->wr_idx = 0;
-    circ->rd_idx = 0;
+    /* Empty in place, cursors keep their buffer indices. */
+    circ->rd_idx = circ->wr_idx;
+    atomic_set(&circ->flush_pos, atomic_get(&circ->wr_tail));
     unlock(circ);
 }
 
@@ -142,10 +172,13 @@ int
 CircBuffer_write(CircBuffer *circ, uint8_t *data, uint16_t size)
 {
     int ret = 0;
-    uint32_t avail_space = avail(circ);
+    uint32_t avail_space;
+    uint32_t tail;
 
     lock(circ);
 
+    avail_space = avail(circ);
+
     //LOG_DBG("Write %4u bytes: wr_idx: %4u; rd_idx: %4u; count: %4u; avail: %4u",
     //        size, circ->wr_idx, circ->rd_idx, count(circ), avail_space);
 
@@ -154,12 +187,20 @@ CircBuffer_write(CircBuffer *circ, uint8_t *data, uint16_t size)
         inc_rd_idx(circ, size - avail_space);
     }
 
+    /* Tell cursor readers which bytes are about to be overwritten. */
+    tail = (uint32_t)atomic_get(&circ->wr_tail);
+    atomic_set(&circ->wr_head, (atomic_val_t)(tail + size));
+    barrier_dmem_fence_full();
+
     /* Now copy the data to memory at the current wr_idx location */
     circ_write(circ, data, size);
 
     /* Advance the write index, accounting for wrap. */
     inc_wr_idx(circ, size);
 
+    barrier_dmem_fence_full();
+    atomic_set(&circ->wr_tail, (atomic_val_t)(tail + size));
+
     unlock(circ);
     return ret;
 }
@@ -225,6 +266,97 @@ exit:
     return ret;
 }
 
+/******************************************************************************
+    [docimport CircBuffer_cursorInit]
+*//**
+    @brief Positions a cursor at the current end of the buffer, so it reads
+    what is written from now on.
+    @param[in] circ  Pointer to CircBuffer instance.
+    @param[out] cur  Pointer to the cursor.
+******************************************************************************/
+void
+CircBuffer_cursorInit(CircBuffer *circ, CircBuffer_Cursor *cur)
+{
+    lock(circ);
+    cur->pos = (uint32_t)atomic_get(&circ->wr_tail);
+    cur->idx = circ->wr_idx;
+    unlock(circ);
+}
+
+/******************************************************************************
+    [docimport CircBuffer_cursorRead]
+*//**
+    @brief Reads the next bytes at a cursor and advances it, leaving the
+    buffer contents in place. The writer may run concurrently: bytes it
+    overwrites before they are read are skipped and counted in dropped, as
+    are bytes discarded by CircBuffer_flush. Only one thread may read at a
+    given cursor.
+    @param[in] circ  Pointer to CircBuffer instance.
+    @param[in,out] cur  Pointer to the cursor.
+    @param[in] buf  Pointer to buffer to write to.
+    @param[in] req_size  Requested size to read from buffer.
+    @param[out] dropped  Bytes skipped by this call.
+    @return Returns the number read.
+******************************************************************************/
+int
+CircBuffer_cursorRead(
+    CircBuffer *circ,
+    CircBuffer_Cursor *cur,
+    uint8_t *buf,
+    uint32_t req_size,
+    uint32_t *dropped)
+{
+    uint32_t flushed;
+    uint32_t tail;
+    uint32_t head;
+    uint32_t skip = 0;
+    uint32_t num;
+    uint32_t over;
+
+    /* flush_pos first, so it is never past the tail read after it. */
+    flushed = (uint32_t)atomic_get(&circ->flush_pos);
+    tail = (uint32_t)atomic_get(&circ->wr_tail);
+    barrier_dmem_fence_full();
+
+    /* Skip what was flushed or overwritten since the last read. */
+    if (pos_before(cur->pos, flushed))
+    {
+        skip = flushed - cur->pos;
+    }
+    if (tail - cur->pos - skip > circ->buf_size)
+    {
+        skip = tail - cur->pos - circ->buf_size;
+    }
+    cursor_advance(circ, cur, skip);
+
+    num = CIRC_MIN(req_size, tail - cur->pos);
+    if (num > 0)
+    {
+        circ_read_at(circ, cur->idx, buf, num);
+    }
+
+    /* Drop the front of the copy if a write reached it meanwhile. */
+    barrier_dmem_fence_full();
+    head = (uint32_t)atomic_get(&circ->wr_head);
+    if (pos_before(cur->pos, head - circ->buf_size))
+    {
+        over = CIRC_MIN(num, head - circ->buf_size - cur->pos);
+        memmove(buf, buf + over, num - over);
+        num -= over;
+        skip += over;
+        cursor_advance(circ, cur, over);
+    }
+    cursor_advance(circ, cur, num);
+
+    if (skip > 0)
+    {
+        LOG_DBG("Cursor dropped %u bytes.", skip);
+    }
+
+    *dropped = skip;
+    return num;
+}
+
 /******************************************************************************
     [docimport CircBuffer_lock]
 *//**
@@ -290,7 +422,11 @@ CircBuffer_init(
     }
 
     circ->buf_size = depth;
-    CircBuffer_flush(circ);
+    circ->wr_idx = 0;
+    circ->rd_idx = 0;
+    atomic_set(&circ->wr_head, 0);
+    atomic_set(&circ->wr_tail, 0);
+    atomic_set(&circ->flush_pos, 0);
 
     return 0;
 }
@@ -35,7 +35,8 @@ Cobs_encode(
     @param[in] enc_in_len  Length of the input stream.
     @param[in] buf_out  Pointer to decoded output buffer.
     @param[in] max_buf_out  Maximum decoded output buffer length.
-    @return Returns the length of the encoded output.
+    @return Returns the length of the decoded output, -1 if it does not fit
+    in buf_out or enc_in is not a valid encoding.
 ******************************************************************************/
 int
 Cobs_decode(
@@ -53,7 +53,10 @@ Cobs_framer(
     @param[in] buf_out  Pointer to output buffer where deframed data will be
     written.
     @param[in] max_buf_out  Max size of buf_out.
-    @return Returns the size of the deframed buffer on success, -1 on error.
+    @return Returns the size of the deframed buffer on success, 0 while no
+    frame is complete, negative errno if a frame was dropped: -ENOBUFS (fifo
+    full), -EOVERFLOW (frame larger than the work buffer) or -EINVAL (bad
+    COBS encoding, or the frame does not fit in buf_out).
 ******************************************************************************/
 int
 Cobs_deframer(
@@ -74,4 +77,13 @@ Cobs_deframer(
 ******************************************************************************/
 int
 Cobs_deframer_init(void *self, uint16_t buf_depth);
+
+/******************************************************************************
+    [docexport Cobs_deframer_reset]
+*//**
+    @brief Discards any partially received frame (e.g. on a new connection).
+    @param[in] self  Pointer to initialized Cobs_Deframer object.
+******************************************************************************/
+void
+Cobs_deframer_reset(void *self);
 #endif
@@ -92,7 +92,8 @@ Cobs_encode(
     @param[in] enc_in_len  Length of the input stream.
     @param[in] buf_out  Pointer to decoded output buffer.
     @param[in] max_buf_out  Maximum decoded output buffer length.
-    @return Returns the length of the encoded output.
+    @return Returns the length of the decoded output, -1 if it does not fit
+    in buf_out or enc_in is not a valid encoding.
 ******************************************************************************/
 int
 Cobs_decode(
@@ -103,12 +104,22 @@ Cobs_decode(
 {
     uint8_t *pCode = enc_in;
     uint8_t *pData = enc_in + 1;
+    uint8_t *pEnd = enc_in + enc_in_len;
     uint8_t *pBuf = buf_out;
     uint8_t count;
     int num_out = 0;
     
     while (1)
     {
+        /*  Each code byte must point inside the input, the last one exactly
+            at its end. A zero code byte can not occur in an encoding.
+        */
+        if (pCode >= pEnd || *pCode == 0 || *pCode > pEnd - pCode)
+        {
+            LOG_ERR("Invalid code byte at %d.", (int)(pCode - enc_in));
+            return -1;
+        }
+
         for (count = 1; count < *pCode; count++)
         {
             CHECK_OVERFLOW(num_out == max_buf_out);
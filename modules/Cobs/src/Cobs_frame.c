@@ -18,8 +18,7 @@ enum {
     INIT = 0,
     FIND_SOF,
     FIND_EOF,
-    DECODE,
-    ERROR
+    DECODE
 };
 
 /******************************************************************************
@@ -64,7 +63,10 @@ Cobs_framer(
     @param[in] buf_out  Pointer to output buffer where deframed data will be
     written.
     @param[in] max_buf_out  Max size of buf_out.
-    @return Returns the size of the deframed buffer on success, -1 on error.
+    @return Returns the size of the deframed buffer on success, 0 while no
+    frame is complete, negative errno if a frame was dropped: -ENOBUFS (fifo
+    full), -EOVERFLOW (frame larger than the work buffer) or -EINVAL (bad
+    COBS encoding, or the frame does not fit in buf_out).
 ******************************************************************************/
 int
 Cobs_deframer(
@@ -87,7 +89,7 @@ Cobs_deframer(
             (unsigned int)buf_in_len);
         SwFifo_flush(fifo);
         deframer->state = INIT;
-        return 0;
+        return -ENOBUFS;
     }
 
     LOG_DBG("Wrote %u bytes into deframer fifo.",
@@ -113,7 +115,7 @@ Cobs_deframer(
             avail = SwFifo_getCount(fifo);
             if (avail == 0)
             {
-                LOG_ERR("FIND_SOF: Fifo is empty (buf_in_len was %u).", 
+                LOG_DBG("FIND_SOF: Fifo is empty (buf_in_len was %u).", 
                     buf_in_len);
                 deframer->state = INIT;
                 return 0;
@@ -161,8 +163,9 @@ Cobs_deframer(
                 {
                     LOG_ERR("FIND_EOF: work buffer overflow (size=%u; buf_in_len=%u).",
                         deframer->count, buf_in_len);
-                    deframer->state = ERROR;
-                    break;
+                    SwFifo_flush(fifo);
+                    deframer->state = INIT;
+                    return -EOVERFLOW;
                 }
 
                 SwFifo_read(fifo, (void *)(work + deframer->count), 1);
@@ -170,6 +173,15 @@ Cobs_deframer(
                 LOG_DBG("work[%u]=0x%02x", (unsigned int)deframer->count,
                     (unsigned int)work[deframer->count]);
 
+                /*  Two framing bytes in a row: the first one ended the last
+                    frame (or was noise), the second one starts this frame.
+                */
+                if (work[deframer->count] == FRAMING_BYTE &&
+                    deframer->count == 0)
+                {
+                    continue;
+                }
+
                 /* Was the byte just read the FRAMING_BYTE? */
                 if (work[deframer->count] == FRAMING_BYTE)
                 {
@@ -196,19 +208,14 @@ Cobs_deframer(
             if (num < 0)
             {
                 LOG_ERR("DECODE: Error during COBS decode :%d", num);
-                deframer->state = ERROR;
-                break;
+                deframer->state = INIT;
+                return -EINVAL;
             }
             LOG_DBG("DECODE: Decoded size is %u bytes (avail=%u).",
                 num, (unsigned int)SwFifo_getCount(fifo));
             deframer->state = INIT;
             return num;
 
-        case ERROR:
-            SwFifo_flush(fifo);
-            deframer->state = INIT;
-            return 0;
-
         default:
             break;
         }
@@ -251,3 +258,18 @@ Cobs_deframer_init(void *self, uint16_t buf_depth)
 
     return 0;
 }
+
+/******************************************************************************
+    [docimport Cobs_deframer_reset]
+*//**
+    @brief Discards any partially received frame (e.g. on a new connection).
+    @param[in] self  Pointer to initialized Cobs_Deframer object.
+******************************************************************************/
+void
+Cobs_deframer_reset(void *self)
+{
+    Cobs_Deframer *deframer = (Cobs_Deframer *)self;
+
+    SwFifo_flush(&deframer->fifo);
+    deframer->state = INIT;
+}
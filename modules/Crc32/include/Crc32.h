@@ -0,0 +1,48 @@
+/*******************************************************************************
+ *  @file: Crc32.h
+ *   
+ *  @brief: Header for the slicing-by-8 CRC-32 library.
+*******************************************************************************/
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+
+/** @brief Size of a CRC-32 trailer, bytes. */
+#define CRC32_SIZE      4
+
+/******************************************************************************
+    [docexport Crc32_init]
+*//**
+    @brief Builds the lookup tables. Must be called before any other Crc32
+    function; repeated calls are no-ops.
+******************************************************************************/
+void
+Crc32_init(void);
+
+/******************************************************************************
+    [docexport Crc32_update]
+*//**
+    @brief Continues a CRC-32 over more data.
+    @param[in] crc  CRC of the preceding data (0 to start).
+    @param[in] data  Pointer to the data.
+    @param[in] len  Number of bytes.
+    @return Returns the CRC of all data so far.
+******************************************************************************/
+uint32_t
+Crc32_update(uint32_t crc, const uint8_t *data, uint32_t len);
+
+/******************************************************************************
+    [docexport Crc32_compute]
+*//**
+    @brief Computes the CRC-32 of a buffer.
+    @param[in] data  Pointer to the data.
+    @param[in] len  Number of bytes.
+    @return Returns the CRC.
+******************************************************************************/
+static inline uint32_t
+Crc32_compute(const uint8_t *data, uint32_t len)
+{
+    return Crc32_update(0, data, len);
+}
+#endif
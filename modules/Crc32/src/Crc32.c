@@ -0,0 +1,108 @@
+/*******************************************************************************
+ *  @file: Crc32.c
+ *  
+ *  @brief: CRC-32 (reflected polynomial 0xEDB88320) using slicing-by-8: eight
+    table lookups consume 8 input bytes per iteration instead of one.
+*******************************************************************************/
+#include <stdbool.h>
+#include <zephyr/sys/byteorder.h>
+#include "Crc32.h"
+
+#define POLY    0xEDB88320u
+
+/** @brief table[0] is the classic byte table; table[k][i] is the CRC of byte
+    i followed by k zero bytes.
+*/
+static uint32_t table[8][256];
+static bool table_ready = false;
+
+/******************************************************************************
+    [docimport Crc32_init]
+*//**
+    @brief Builds the lookup tables. Must be called before any other Crc32
+    function; repeated calls are no-ops.
+******************************************************************************/
+void
+Crc32_init(void)
+{
+    uint32_t i;
+    int k;
+
+    if (table_ready)
+    {
+        return;
+    }
+
+    for (i = 0; i < 256; i++)
+    {
+        uint32_t c = i;
+
+        for (k = 0; k < 8; k++)
+        {
+            c = (c & 1) ? (c >> 1) ^ POLY : (c >> 1);
+        }
+        table[0][i] = c;
+    }
+
+    for (i = 0; i < 256; i++)
+    {
+        for (k = 1; k < 8; k++)
+        {
+            table[k][i] = (table[k-1][i] >> 8) ^ table[0][table[k-1][i] & 0xff];
+        }
+    }
+
+    table_ready = true;
+}
+
+/******************************************************************************
+    [docimport Crc32_update]
+*//**
+    @brief Continues a CRC-32 over more data.
+    @param[in] crc  CRC of the preceding data (0 to start).
+    @param[in] data  Pointer to the data.
+    @param[in] len  Number of bytes.
+    @return Returns the CRC of all data so far.
+******************************************************************************/
+uint32_t
+Crc32_update(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+    crc = ~crc;
+
+    /* Byte at a time up to a word boundary. */
+    while (len > 0 && ((uintptr_t)data & 3))
+    {
+        crc = table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+        len--;
+    }
+
+    while (len >= 8)
+    {
+#if defined(CONFIG_LITTLE_ENDIAN)
+        uint32_t one = *(const uint32_t *)data ^ crc;
+        uint32_t two = *(const uint32_t *)(data + 4);
+#else
+        uint32_t one = sys_get_le32(data) ^ crc;
+        uint32_t two = sys_get_le32(data + 4);
+#endif
+
+        crc = table[7][one & 0xff] ^
+              table[6][(one >> 8) & 0xff] ^
+              table[5][(one >> 16) & 0xff] ^
+              table[4][one >> 24] ^
+              table[3][two & 0xff] ^
+              table[2][(two >> 8) & 0xff] ^
+              table[1][(two >> 16) & 0xff] ^
+              table[0][two >> 24];
+        data += 8;
+        len -= 8;
+    }
+
+    while (len > 0)
+    {
+        crc = table[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+        len--;
+    }
+
+    return ~crc;
+}
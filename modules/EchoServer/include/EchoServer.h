@@ -7,6 +7,7 @@
 #define ECHOSERVER_H
 
 #include <stdint.h>
+#include <zephyr/sys/atomic.h>
 #include "TcpServer.h"
 #include "UdpServer.h"
 
@@ -19,8 +20,8 @@ typedef struct EchoServer
         TcpServer tcp_svr;
         UdpServer udp_svr;
     } svr;
-    /** @brief Total byte count. */
-    uint32_t byte_count;
+    /** @brief Total byte count, updated from the connection workers. */
+    atomic_t byte_count;
     
 } EchoServer;
 
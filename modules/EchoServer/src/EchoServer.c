@@ -45,8 +45,9 @@ echo_callback(void *server, int sock, uint8_t *data, uint16_t len, int *finished
 #endif
     if (num > 0)
     {
-        echo->byte_count += num;
-        LOG_DBG("Echo'd %d bytes (total: %u).", num, echo->byte_count);
+        atomic_val_t total = atomic_add(&echo->byte_count, num) + num;
+
+        LOG_DBG("Echo'd %d bytes (total: %u).", num, (unsigned int)total);
     }
     else if (num < 0)
     {
@@ -81,7 +82,7 @@ EchoServer_init(
     uint8_t prio)
 {
     int ret;
-    echo->byte_count = 0;
+    atomic_clear(&echo->byte_count);
 
 #if CONFIG_ECHOSERVER_TRANSPORT_TCP
     LOG_INF("Echo server using TCP.");
@@ -93,7 +94,8 @@ EchoServer_init(
         stack_size,
         name,
         prio,
-        echo_callback);
+        echo_callback,
+        NULL);
 #else
     LOG_INF("Echo server using UDP.");
     ret = UdpServer_init(
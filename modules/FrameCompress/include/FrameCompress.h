@@ -0,0 +1,154 @@
+/*******************************************************************************
+ *  @file: FrameCompress.h
+ *   
+ *  @brief: Header for the FrameCompress library.
+ *
+ *  Each frame is prefixed with a header byte:
+ *      bit 7  FRAMECOMPRESS_HDR_CAPS  sender can decompress.
+ *      bit 0  FRAMECOMPRESS_HDR_LZ4   payload is an LZ4 block.
+ *  A link only sends compressed frames after it has received a frame with
+ *  FRAMECOMPRESS_HDR_CAPS set, and only when compression saves bytes.
+ *  Links set up with FrameCompress_linkInitDetect fall back to bare frames
+ *  when the peer's first frame does not advertise FRAMECOMPRESS_HDR_CAPS.
+*******************************************************************************/
+#ifndef FRAMECOMPRESS_H
+#define FRAMECOMPRESS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define FRAMECOMPRESS_HDR_SIZE      1
+#define FRAMECOMPRESS_HDR_LZ4       0x01
+#define FRAMECOMPRESS_HDR_CAPS      0x80
+
+/** @brief Worst-case encoded size of a len byte frame (sent raw). */
+#define FRAMECOMPRESS_MAX_SIZE(len) ((len) + FRAMECOMPRESS_HDR_SIZE)
+
+/** @brief Compressor scratch. May be shared between links used from one
+    thread at a time.
+*/
+typedef struct FrameCompress_Work
+{
+    uint16_t hash[1 << CONFIG_FRAMECOMPRESS_HASH_LOG];
+
+} FrameCompress_Work;
+
+/** @brief Per-link state. */
+typedef struct FrameCompress_Link
+{
+    /** @brief Peer advertised FRAMECOMPRESS_HDR_CAPS. */
+    bool peer_caps;
+    /** @brief Next received frame decides between headers and bare. */
+    bool detect;
+    /** @brief Peer sends bare frames: no header either way. */
+    bool bare;
+    /** @brief Frame bytes before/after encoding (incl. header). */
+    uint32_t tx_raw_bytes;
+    uint32_t tx_wire_bytes;
+    /** @brief Frames sent compressed. */
+    uint32_t tx_compressed;
+    /** @brief Received frames with a bad header or LZ4 block. */
+    uint32_t rx_errors;
+
+} FrameCompress_Link;
+
+/******************************************************************************
+    [docexport FrameCompress_linkInit]
+*//**
+    @brief Initializes (or resets, e.g. on reconnect) a link. Compression is
+    off until the peer advertises it.
+    @param[in] link  Pointer to the link.
+******************************************************************************/
+void
+FrameCompress_linkInit(FrameCompress_Link *link);
+
+/******************************************************************************
+    [docexport FrameCompress_linkInitDetect]
+*//**
+    @brief Initializes a link whose peer may not use FrameCompress headers.
+    The first received frame decides: a peer that speaks FrameCompress sets
+    FRAMECOMPRESS_HDR_CAPS in it, anything else is taken as a bare frame and
+    the link passes frames through without a header from then on.
+    @param[in] link  Pointer to the link.
+******************************************************************************/
+void
+FrameCompress_linkInitDetect(FrameCompress_Link *link);
+
+/******************************************************************************
+    [docexport FrameCompress_encode]
+*//**
+    @brief Encodes a frame for the link: header plus LZ4 block when the peer
+    supports it and the block is smaller, else header plus the raw frame.
+    @param[in] link  Pointer to the link.
+    @param[in] work  Compressor scratch.
+    @param[in] in  Frame to send.
+    @param[in] len  Frame length.
+    @param[out] out  Output buffer.
+    @param[in] max_out  Size of out, at least FRAMECOMPRESS_MAX_SIZE(len).
+    @return Returns the encoded size on success, negative on error.
+******************************************************************************/
+int
+FrameCompress_encode(
+    FrameCompress_Link *link,
+    FrameCompress_Work *work,
+    const uint8_t *in,
+    uint32_t len,
+    uint8_t *out,
+    uint32_t max_out);
+
+/******************************************************************************
+    [docexport FrameCompress_decode]
+*//**
+    @brief Decodes a received frame and records the peer's capability.
+    @param[in] link  Pointer to the link.
+    @param[in] in  Received (deframed) bytes, header first.
+    @param[in] len  Number of bytes.
+    @param[out] out  Output buffer.
+    @param[in] max_out  Size of out.
+    @return Returns the decoded frame size on success, negative on error.
+******************************************************************************/
+int
+FrameCompress_decode(
+    FrameCompress_Link *link,
+    const uint8_t *in,
+    uint32_t len,
+    uint8_t *out,
+    uint32_t max_out);
+
+/******************************************************************************
+    [docexport FrameCompress_lz4Compress]
+*//**
+    @brief Compresses a buffer into a single LZ4 block (no frame header).
+    @param[in] work  Compressor scratch.
+    @param[in] in  Input buffer (at most 65535 bytes).
+    @param[in] len  Input length.
+    @param[out] out  Output buffer.
+    @param[in] max_out  Size of out.
+    @return Returns the block size, negative if it does not fit in out.
+******************************************************************************/
+int
+FrameCompress_lz4Compress(
+    FrameCompress_Work *work,
+    const uint8_t *in,
+    uint32_t len,
+    uint8_t *out,
+    uint32_t max_out);
+
+/******************************************************************************
+    [docexport FrameCompress_lz4Decompress]
+*//**
+    @brief Decompresses a single LZ4 block.
+    @param[in] in  LZ4 block.
+    @param[in] len  Block length.
+    @param[out] out  Output buffer.
+    @param[in] max_out  Size of out.
+    @return Returns the decompressed size, negative on a malformed block or
+    overflow.
+******************************************************************************/
+int
+FrameCompress_lz4Decompress(
+    const uint8_t *in,
+    uint32_t len,
+    uint8_t *out,
+    uint32_t max_out);
+#endif
@@ -0,0 +1,466 @@
+/*******************************************************************************
+ *  @file: FrameCompress.c
+ *  
+ *  @brief: Per-frame LZ4 block compression for serial links.
+ *
+ *  The compressor is a greedy single-probe LZ4 (block format compatible with
+ *  lz4.block on the host). Frames are compressed independently so a dropped
+ *  frame never desynchronizes the peer.
+*******************************************************************************/
+#include <errno.h>
+#include <string.h>
+#include <zephyr/sys/util.h>
+#include "FrameCompress.h"
+#include <zephyr/logging/log.h>
+
+/** @brief Initialize the logging module. */
+LOG_MODULE_REGISTER(FrameCompress, CONFIG_FRAMECOMPRESS_LOG_LEVEL);
+
+/* LZ4 block format limits. */
+#define MINMATCH        4
+#define LASTLITERALS    5
+#define MFLIMIT         12
+#define MAX_OFFSET      0xffff
+#define RUN_MASK        15
+
+#define HASH_LOG        CONFIG_FRAMECOMPRESS_HASH_LOG
+
+/******************************************************************************
+    read32
+*//**
+    @brief Unaligned 32-bit load.
+******************************************************************************/
+static inline uint32_t
+read32(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+/******************************************************************************
+    hash4
+*//**
+    @brief Hashes 4 input bytes to a match table index.
+******************************************************************************/
+static inline uint32_t
+hash4(uint32_t v)
+{
+    return (v * 2654435761u) >> (32 - HASH_LOG);
+}
+
+/******************************************************************************
+    put_len
+*//**
+    @brief Writes the length extension bytes of a literal or match run.
+******************************************************************************/
+static inline uint8_t *
+put_len(uint8_t *op, uint32_t n)
+{
+    while (n >= 255)
+    {
+        *op++ = 255;
+        n -= 255;
+    }
+    *op++ = (uint8_t)n;
+    return op;
+}
+
+/******************************************************************************
+    get_len
+*//**
+    @brief Reads the length extension bytes of a literal or match run.
+    @return Returns 0 on success, -1 when the input ends first.
+******************************************************************************/
+static inline int
+get_len(const uint8_t **ip, const uint8_t *iend, uint32_t *n)
+{
+    uint8_t b;
+
+    do
+    {
+        if (*ip >= iend)
+        {
+            return -1;
+        }
+        b = *(*ip)++;
+        *n += b;
+    } while (b == 255);
+
+    return 0;
+}
+
+/******************************************************************************
+    [docimport FrameCompress_lz4Compress]
+*//**
+    @brief Compresses a buffer into a single LZ4 block (no frame header).
+    @param[in] work  Compressor scratch.
+    @param[in] in  Input buffer (at most 65535 bytes).
+    @param[in] len  Input length.
+    @param[out] out  Output buffer.
+    @param[in] max_out  Size of out.
+    @return Returns the block size, negative if it does not fit in out.
+******************************************************************************/
+int
+FrameCompress_lz4Compress(
+    FrameCompress_Work *work,
+    const uint8_t *in,
+    uint32_t len,
+    uint8_t *out,
+    uint32_t max_out)
+{
+    const uint8_t *ip = in;
+    const uint8_t *anchor = in;
+    const uint8_t *iend = in + len;
+    uint8_t *op = out;
+    uint8_t *oend = out + max_out;
+    uint8_t *token;
+    uint32_t lit;
+
+    if (len > MAX_OFFSET)
+    {
+        return -EINVAL;
+    }
+
+    if (len > MFLIMIT)
+    {
+        const uint8_t *mflimit = iend - MFLIMIT;
+        const uint8_t *matchlimit = iend - LASTLITERALS;
+
+        /*  Empty slots read as position 0, which is just another candidate:
+            every candidate is verified against the input.
+        */
+        memset(work->hash, 0, sizeof(work->hash));
+        ip++;
+
+        while (ip < mflimit)
+        {
+            uint32_t seq = read32(ip);
+            uint32_t h = hash4(seq);
+            const uint8_t *ref = in + work->hash[h];
+            const uint8_t *mp;
+            uint32_t mlen;
+            uint32_t offset;
+
+            work->hash[h] = (uint16_t)(ip - in);
+
+            if (read32(ref) != seq || ref >= ip)
+            {
+                ip++;
+                continue;
+            }
+
+            for (mp = ip + MINMATCH; mp < matchlimit; mp++)
+            {
+                if (*mp != ref[mp - ip])
+                {
+                    break;
+                }
+            }
+
+            lit = (uint32_t)(ip - anchor);
+            mlen = (uint32_t)(mp - ip) - MINMATCH;
+            offset = (uint32_t)(ip - ref);
+
+            if ((uint32_t)(oend - op) <
+                1 + (lit / 255 + 1) + lit + 2 + (mlen / 255 + 1))
+            {
+                return -ENOBUFS;
+            }
+
+            token = op++;
+            *token = (uint8_t)((MIN(lit, RUN_MASK) << 4) | MIN(mlen, RUN_MASK));
+            if (lit >= RUN_MASK)
+            {
+                op = put_len(op, lit - RUN_MASK);
+            }
+            memcpy(op, anchor, lit);
+            op += lit;
+
+            *op++ = (uint8_t)offset;
+            *op++ = (uint8_t)(offset >> 8);
+            if (mlen >= RUN_MASK)
+            {
+                op = put_len(op, mlen - RUN_MASK);
+            }
+
+            ip = mp;
+            anchor = ip;
+        }
+    }
+
+    /* Last literals. */
+    lit = (uint32_t)(iend - anchor);
+    if ((uint32_t)(oend - op) < 1 + (lit / 255 + 1) + lit)
+    {
+        return -ENOBUFS;
+    }
+
+    token = op++;
+    *token = (uint8_t)(MIN(lit, RUN_MASK) << 4);
+    if (lit >= RUN_MASK)
+    {
+        op = put_len(op, lit - RUN_MASK);
+    }
+    memcpy(op, anchor, lit);
+    op += lit;
+
+    return (int)(op - out);
+}
+
+/******************************************************************************
+    [docimport FrameCompress_lz4Decompress]
+*//**
+    @brief Decompresses a single LZ4 block.
+    @param[in] in  LZ4 block.
+    @param[in] len  Block length.
+    @param[out] out  Output buffer.
+    @param[in] max_out  Size of out.
+    @return Returns the decompressed size, negative on a malformed block or
+    overflow.
+******************************************************************************/
+int
+FrameCompress_lz4Decompress(
+    const uint8_t *in,
+    uint32_t len,
+    uint8_t *out,
+    uint32_t max_out)
+{
+    const uint8_t *ip = in;
+    const uint8_t *iend = in + len;
+    uint8_t *op = out;
+    uint8_t *oend = out + max_out;
+
+    while (ip < iend)
+    {
+        uint8_t token = *ip++;
+        uint32_t lit = token >> 4;
+        uint32_t mlen = token & RUN_MASK;
+        uint32_t offset;
+        const uint8_t *ref;
+
+        if (lit == RUN_MASK && get_len(&ip, iend, &lit) < 0)
+        {
+            return -EINVAL;
+        }
+        if (lit > (uint32_t)(iend - ip))
+        {
+            return -EINVAL;
+        }
+        if (lit > (uint32_t)(oend - op))
+        {
+            return -ENOBUFS;
+        }
+        memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+
+        /* The block ends with a literal-only sequence. */
+        if (ip == iend)
+        {
+            break;
+        }
+
+        if (iend - ip < 2)
+        {
+            return -EINVAL;
+        }
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (uint32_t)(op - out))
+        {
+            return -EINVAL;
+        }
+
+        if (mlen == RUN_MASK && get_len(&ip, iend, &mlen) < 0)
+        {
+            return -EINVAL;
+        }
+        mlen += MINMATCH;
+        if (mlen > (uint32_t)(oend - op))
+        {
+            return -ENOBUFS;
+        }
+
+        /* Byte copy: the match may overlap the output being written. */
+        ref = op - offset;
+        while (mlen--)
+        {
+            *op++ = *ref++;
+        }
+    }
+
+    return (int)(op - out);
+}
+
+/******************************************************************************
+    [docimport FrameCompress_linkInit]
+*//**
+    @brief Initializes (or resets, e.g. on reconnect) a link. Compression is
+    off until the peer advertises it.
+    @param[in] link  Pointer to the link.
+******************************************************************************/
+void
+FrameCompress_linkInit(FrameCompress_Link *link)
+{
+    memset(link, 0, sizeof(*link));
+}
+
+/******************************************************************************
+    [docimport FrameCompress_linkInitDetect]
+*//**
+    @brief Initializes a link whose peer may not use FrameCompress headers.
+    The first received frame decides: a peer that speaks FrameCompress sets
+    FRAMECOMPRESS_HDR_CAPS in it, anything else is taken as a bare frame and
+    the link passes frames through without a header from then on.
+    @param[in] link  Pointer to the link.
+******************************************************************************/
+void
+FrameCompress_linkInitDetect(FrameCompress_Link *link)
+{
+    FrameCompress_linkInit(link);
+    link->detect = true;
+}
+
+/******************************************************************************
+    [docimport FrameCompress_encode]
+*//**
+    @brief Encodes a frame for the link: header plus LZ4 block when the peer
+    supports it and the block is smaller, else header plus the raw frame.
+    @param[in] link  Pointer to the link.
+    @param[in] work  Compressor scratch.
+    @param[in] in  Frame to send.
+    @param[in] len  Frame length.
+    @param[out] out  Output buffer.
+    @param[in] max_out  Size of out, at least FRAMECOMPRESS_MAX_SIZE(len).
+    @return Returns the encoded size on success, negative on error.
+******************************************************************************/
+int
+FrameCompress_encode(
+    FrameCompress_Link *link,
+    FrameCompress_Work *work,
+    const uint8_t *in,
+    uint32_t len,
+    uint8_t *out,
+    uint32_t max_out)
+{
+    int size;
+
+    if (max_out < FRAMECOMPRESS_MAX_SIZE(len))
+    {
+        return -ENOBUFS;
+    }
+
+    link->tx_raw_bytes += len;
+
+    if (link->bare)
+    {
+        memcpy(out, in, len);
+        link->tx_wire_bytes += len;
+        return (int)len;
+    }
+
+    if (link->peer_caps && len > 1)
+    {
+        /* Keep the block only if it is smaller than the raw frame. */
+        size = FrameCompress_lz4Compress(work, in, len,
+            &out[FRAMECOMPRESS_HDR_SIZE], len - 1);
+        if (size > 0)
+        {
+            out[0] = FRAMECOMPRESS_HDR_CAPS | FRAMECOMPRESS_HDR_LZ4;
+            size += FRAMECOMPRESS_HDR_SIZE;
+            link->tx_compressed++;
+            link->tx_wire_bytes += size;
+            return size;
+        }
+    }
+
+    out[0] = FRAMECOMPRESS_HDR_CAPS;
+    memcpy(&out[FRAMECOMPRESS_HDR_SIZE], in, len);
+    size = len + FRAMECOMPRESS_HDR_SIZE;
+    link->tx_wire_bytes += size;
+    return size;
+}
+
+/******************************************************************************
+    [docimport FrameCompress_decode]
+*//**
+    @brief Decodes a received frame and records the peer's capability.
+    @param[in] link  Pointer to the link.
+    @param[in] in  Received (deframed) bytes, header first.
+    @param[in] len  Number of bytes.
+    @param[out] out  Output buffer.
+    @param[in] max_out  Size of out.
+    @return Returns the decoded frame size on success, negative on error.
+******************************************************************************/
+int
+FrameCompress_decode(
+    FrameCompress_Link *link,
+    const uint8_t *in,
+    uint32_t len,
+    uint8_t *out,
+    uint32_t max_out)
+{
+    uint8_t hdr;
+    int size;
+
+    if (link->detect && len >= FRAMECOMPRESS_HDR_SIZE)
+    {
+        link->detect = false;
+        link->bare = (in[0] & ~(FRAMECOMPRESS_HDR_CAPS | FRAMECOMPRESS_HDR_LZ4))
+            || !(in[0] & FRAMECOMPRESS_HDR_CAPS);
+        if (link->bare)
+        {
+            LOG_INF("Peer sends bare frames, compression off.");
+        }
+    }
+
+    if (link->bare)
+    {
+        if (len > max_out)
+        {
+            link->rx_errors++;
+            return -ENOBUFS;
+        }
+        memcpy(out, in, len);
+        return (int)len;
+    }
+
+    if (len < FRAMECOMPRESS_HDR_SIZE)
+    {
+        link->rx_errors++;
+        return -EINVAL;
+    }
+
+    hdr = in[0];
+    if (hdr & ~(FRAMECOMPRESS_HDR_CAPS | FRAMECOMPRESS_HDR_LZ4))
+    {
+        LOG_WRN("Unknown frame header 0x%02x.", hdr);
+        link->rx_errors++;
+        return -EINVAL;
+    }
+
+    link->peer_caps = (hdr & FRAMECOMPRESS_HDR_CAPS) != 0;
+    in += FRAMECOMPRESS_HDR_SIZE;
+    len -= FRAMECOMPRESS_HDR_SIZE;
+
+    if (hdr & FRAMECOMPRESS_HDR_LZ4)
+    {
+        size = FrameCompress_lz4Decompress(in, len, out, max_out);
+        if (size < 0)
+        {
+            LOG_WRN("Bad LZ4 block (%u bytes): %d", len, size);
+            link->rx_errors++;
+        }
+        return size;
+    }
+
+    if (len > max_out)
+    {
+        link->rx_errors++;
+        return -ENOBUFS;
+    }
+    memcpy(out, in, len);
+    return (int)len;
+}
@@ -9,8 +9,14 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include <zephyr/kernel.h>
 #include <zephyr/net/socket.h>
 #include <zephyr/net/mqtt.h>
+#include "MqttClientSub.h"
+#include "Backoff.h"
+#if defined(CONFIG_MQTTCLIENT_STORE)
+#include "MqttClientStore.h"
+#endif
 
 #if !defined(CONFIG_MQTTCLIENT_SERVER_PORT)
 #define MQTTCLIENT_SERVER_PORT      1883
@@ -48,13 +54,134 @@
 #define MQTTCLIENT_TX_BUFFER_SIZE   CONFIG_MQTTCLIENT_TX_BUFFER_SIZE
 #endif
 
+#if !defined(CONFIG_MQTTCLIENT_PUBQ_DEPTH)
+#define MQTTCLIENT_PUBQ_DEPTH       16
+#else
+#define MQTTCLIENT_PUBQ_DEPTH       CONFIG_MQTTCLIENT_PUBQ_DEPTH
+#endif
+
+#if !defined(CONFIG_MQTTCLIENT_PUBQ_PAYLOAD_SIZE)
+#define MQTTCLIENT_PUBQ_PAYLOAD_SIZE    128
+#else
+#define MQTTCLIENT_PUBQ_PAYLOAD_SIZE    CONFIG_MQTTCLIENT_PUBQ_PAYLOAD_SIZE
+#endif
+
+#if !defined(CONFIG_MQTTCLIENT_PUBQ_TOPIC_SIZE)
+#define MQTTCLIENT_PUBQ_TOPIC_SIZE      64
+#else
+#define MQTTCLIENT_PUBQ_TOPIC_SIZE      CONFIG_MQTTCLIENT_PUBQ_TOPIC_SIZE
+#endif
+
+#if !defined(CONFIG_MQTTCLIENT_PUBQ_BATCH)
+#define MQTTCLIENT_PUBQ_BATCH       8
+#else
+#define MQTTCLIENT_PUBQ_BATCH       CONFIG_MQTTCLIENT_PUBQ_BATCH
+#endif
+
+#if !defined(CONFIG_MQTTCLIENT_INFLIGHT_WINDOW)
+#define MQTTCLIENT_INFLIGHT_WINDOW      8
+#else
+#define MQTTCLIENT_INFLIGHT_WINDOW      CONFIG_MQTTCLIENT_INFLIGHT_WINDOW
+#endif
+
+#if !defined(CONFIG_MQTTCLIENT_INFLIGHT_TIMEOUT_MS)
+#define MQTTCLIENT_INFLIGHT_TIMEOUT_MS  5000
+#else
+#define MQTTCLIENT_INFLIGHT_TIMEOUT_MS  CONFIG_MQTTCLIENT_INFLIGHT_TIMEOUT_MS
+#endif
+
+#if !defined(CONFIG_MQTTCLIENT_INFLIGHT_RETRIES)
+#define MQTTCLIENT_INFLIGHT_RETRIES     3
+#else
+#define MQTTCLIENT_INFLIGHT_RETRIES     CONFIG_MQTTCLIENT_INFLIGHT_RETRIES
+#endif
+
+#if !defined(CONFIG_MQTTCLIENT_RECONNECT_BASE_MS)
+#define MQTTCLIENT_RECONNECT_BASE_MS    500
+#else
+#define MQTTCLIENT_RECONNECT_BASE_MS    CONFIG_MQTTCLIENT_RECONNECT_BASE_MS
+#endif
+
+#if !defined(CONFIG_MQTTCLIENT_RECONNECT_MAX_MS)
+#define MQTTCLIENT_RECONNECT_MAX_MS     60000
+#else
+#define MQTTCLIENT_RECONNECT_MAX_MS     CONFIG_MQTTCLIENT_RECONNECT_MAX_MS
+#endif
+
+#if !defined(CONFIG_MQTTCLIENT_SUB_MAX)
+#define MQTTCLIENT_SUB_MAX              8
+#else
+#define MQTTCLIENT_SUB_MAX              CONFIG_MQTTCLIENT_SUB_MAX
+#endif
+
+struct MqttClient;
+
+/** @brief Publish completion callback, called from the client thread.
+    result is 0 when delivered (PUBACK/PUBCOMP received, or QoS 0 written),
+    -ETIMEDOUT when retransmissions were exhausted or another negative error
+    when dropped. A publish moved to the store-and-forward ring keeps its
+    callback: it completes once replayed, or with -ENOBUFS (msg_id 0) when
+    the full ring drops it. Publishes reloaded from flash after a reboot
+    have no callback.
+*/
+typedef void (*MqttClient_PubDoneCb)(
+    struct MqttClient *mqc,
+    uint16_t msg_id,
+    int result,
+    void *arg);
+
+/** @brief Subscription callback, called from the client thread for each
+    received PUBLISH matching the subscription's filter. The payload is not
+    buffered: read it with MqttClient_readPayload from within the callback.
+    Unread payload is discarded on return.
+*/
+typedef void (*MqttClient_SubCb)(
+    struct MqttClient *mqc,
+    const struct mqtt_publish_param *pub,
+    void *arg);
+
+/** @brief Subscription slot. The filter is copied. */
+typedef struct MqttClient_Sub
+{
+    MqttClient_SubCb cb;
+    void *arg;
+    uint16_t filter_len;
+    uint8_t qos;
+    /** @brief Sync state with the broker. */
+    uint8_t state;
+    uint8_t filter[MQTTCLIENT_PUBQ_TOPIC_SIZE];
+} MqttClient_Sub;
+
 typedef struct MqttClient_PubTopic
 {
     struct mqtt_topic topic;
     struct mqtt_binstr payload;
-    uint16_t msg_id;
 } MqttClient_PubTopic;
 
+/** @brief Queued or in-flight publish. Topic and payload are copied. The
+    entry is freed once the publish completes.
+*/
+typedef struct MqttClient_PubEntry
+{
+    /** @brief Reserved for k_fifo. */
+    void *fifo_reserved;
+    /** @brief Completion callback and argument. */
+    MqttClient_PubDoneCb done_cb;
+    void *done_arg;
+    /** @brief Uptime, ms, of the last (re)transmission. */
+    uint32_t sent_ms;
+    /** @brief Message id, allocated when first sent. */
+    uint16_t msg_id;
+    uint16_t topic_len;
+    uint16_t payload_len;
+    uint8_t qos;
+    /** @brief In-flight state and number of retransmissions. */
+    uint8_t state;
+    uint8_t retries;
+    uint8_t topic[MQTTCLIENT_PUBQ_TOPIC_SIZE];
+    uint8_t payload[MQTTCLIENT_PUBQ_PAYLOAD_SIZE];
+} __aligned(4) MqttClient_PubEntry;
+
 struct client_task
 {
     /** @brief Task stack size. */
@@ -80,19 +207,59 @@ typedef struct MqttClient
     struct sockaddr_storage broker;
     /** @brief Bool indicating connection status. */
     bool connected;
-    /** @brief File descriptor for tcp polling. */
-    struct pollfd fds[1];
+    /** @brief Reconnect policy and its state (client thread). */
+    Backoff reconnect;
+    /** @brief Poll set: the mqtt socket and the wakeup eventfd. */
+    struct pollfd fds[2];
+    /** @brief eventfd written to wake the client thread. */
+    int wake_fd;
+    /** @brief Set by MqttClient_stop. */
+    atomic_t stop;
     /** @brief Poll timeout (ms). */
     uint16_t poll_timeout_ms;
-    /** @brief Buffer to store recieved publish payload. */
+    /** @brief Scratch for received payloads shared by overlapping
+        subscriptions, and for discarding unread payload. */
     uint8_t publish_rx_buffer[MQTTCLIENT_PUBLISH_RX_BUFFER_SIZE];
-    /** @brief Flag indicating publish payload received. */
-    bool publish_rx_ready;
+    /** @brief Subscriptions and their filter trie, under sub_lock. */
+    MqttClient_Sub subs[MQTTCLIENT_SUB_MAX];
+    MqttClientSub_Trie sub_trie;
+    RTOS_MUTEX sub_lock;
+    /** @brief Payload of the PUBLISH being dispatched: bytes left in the
+        stream, or the buffered copy and the current callback's cursor. */
+    uint32_t rx_left;
+    uint32_t rx_buffered;
+    uint32_t rx_cursor;
     /** @brief Internal thread task. */
     struct client_task task;
     /** @brief Buffers. */
     uint8_t rx_buffer[MQTTCLIENT_RX_BUFFER_SIZE];
     uint8_t tx_buffer[MQTTCLIENT_TX_BUFFER_SIZE];
+    /** @brief Outbound publish queue, drained by the client thread. */
+    struct k_fifo pubq;
+    struct k_mem_slab pubq_slab;
+    uint8_t __aligned(4)
+        pubq_slab_buf[MQTTCLIENT_PUBQ_DEPTH * sizeof(MqttClient_PubEntry)];
+    /** @brief Publishes rejected because the queue was full. */
+    atomic_t pub_dropped;
+    /** @brief QoS 1/2 publishes awaiting acknowledgement, oldest first. */
+    MqttClient_PubEntry *inflight[MQTTCLIENT_INFLIGHT_WINDOW];
+    uint16_t inflight_count;
+    /** @brief Last allocated message id. */
+    uint16_t last_msg_id;
+    /** @brief Counters (client thread). */
+    uint32_t pub_sent;
+    uint32_t pub_errors;
+    uint32_t pub_acked;
+    uint32_t pub_retransmits;
+    uint32_t pub_timeouts;
+#if defined(CONFIG_MQTTCLIENT_STORE)
+    /** @brief Store-and-forward ring for publishes made while disconnected. */
+    MqttClientStore store;
+    /** @brief Settings subtree for the store, "mqttsf/<client id hash>". */
+    char store_key[16];
+    /** @brief Uptime, ms, of the next replay batch. */
+    int64_t replay_next_ms;
+#endif
 
 } MqttClient;
 
@@ -116,11 +283,15 @@ MqttClient_setTopic(
 /******************************************************************************
     [docexport MqttClient_publish]
 *//**
-    @brief Publish data to a topic.
+    @brief Queues a publish to a topic and returns without blocking. Topic
+    and payload are copied. The client thread sends queued publishes in order
+    once connected.
     @param[in] mqc  Pointer to MqttClient instance.
     @param[in] topic  Pointer to MqttClient_PubTopic instance.
     @param[in] payload  Payload data buffer.
     @param[in] payload_len  Length of the payload to publish.
+    @return Returns 0 when queued, -ENOBUFS when the queue is full or
+    -EMSGSIZE when the topic or payload does not fit a queue entry.
 ******************************************************************************/
 int
 MqttClient_publish(
@@ -129,6 +300,100 @@ MqttClient_publish(
     uint8_t *payload,
     uint32_t payload_len);
 
+/******************************************************************************
+    [docexport MqttClient_publishCb]
+*//**
+    @brief As MqttClient_publish, with a completion callback. QoS 1/2
+    publishes stay in the in-flight window until acknowledged and are
+    retransmitted with DUP set every MQTTCLIENT_INFLIGHT_TIMEOUT_MS, up to
+    MQTTCLIENT_INFLIGHT_RETRIES times.
+    @param[in] mqc  Pointer to MqttClient instance.
+    @param[in] topic  Pointer to MqttClient_PubTopic instance.
+    @param[in] payload  Payload data buffer.
+    @param[in] payload_len  Length of the payload to publish.
+    @param[in] cb  Completion callback, may be NULL.
+    @param[in] arg  Callback argument.
+    @return Returns 0 when queued, -ENOBUFS when the queue is full or
+    -EMSGSIZE when the topic or payload does not fit a queue entry.
+******************************************************************************/
+int
+MqttClient_publishCb(
+    MqttClient *mqc,
+    MqttClient_PubTopic *tp,
+    uint8_t *payload,
+    uint32_t payload_len,
+    MqttClient_PubDoneCb cb,
+    void *arg);
+
+/******************************************************************************
+    [docexport MqttClient_publishSpace]
+*//**
+    @brief Returns the number of free publish queue slots.
+    @param[in] mqc  Pointer to MqttClient instance.
+******************************************************************************/
+uint32_t
+MqttClient_publishSpace(MqttClient *mqc);
+
+/******************************************************************************
+    [docexport MqttClient_subscribe]
+*//**
+    @brief Subscribes to a topic filter ('+' and '#' wildcards allowed). The
+    SUBSCRIBE is sent by the client thread now or on the next connect, and
+    again after every reconnect. Subscribing to an existing filter replaces
+    its callback and QoS.
+    @param[in] mqc  Pointer to MqttClient instance.
+    @param[in] filter  Topic filter, copied.
+    @param[in] qos  Max QoS (use enum mqtt_qos).
+    @param[in] cb  Callback for matching PUBLISH messages.
+    @param[in] arg  Callback argument.
+    @return Returns 0 on success, -EINVAL for an invalid filter, -EMSGSIZE
+    for a filter longer than MQTTCLIENT_PUBQ_TOPIC_SIZE or -ENOMEM when out
+    of subscription slots or trie nodes.
+******************************************************************************/
+int
+MqttClient_subscribe(
+    MqttClient *mqc,
+    const char *filter,
+    uint8_t qos,
+    MqttClient_SubCb cb,
+    void *arg);
+
+/******************************************************************************
+    [docexport MqttClient_unsubscribe]
+*//**
+    @brief Removes a subscription. The UNSUBSCRIBE is sent by the client
+    thread.
+    @param[in] mqc  Pointer to MqttClient instance.
+    @param[in] filter  Topic filter as passed to MqttClient_subscribe.
+    @return Returns 0 on success, -ENOENT if not subscribed.
+******************************************************************************/
+int
+MqttClient_unsubscribe(MqttClient *mqc, const char *filter);
+
+/******************************************************************************
+    [docexport MqttClient_readPayload]
+*//**
+    @brief Reads the payload of the PUBLISH being delivered. Only valid
+    inside a MqttClient_SubCb. Reads straight from the socket into buf unless
+    the payload was buffered for overlapping subscriptions.
+    @param[in] mqc  Pointer to MqttClient instance.
+    @param[out] buf  Destination.
+    @param[in] len  Size of buf.
+    @return Returns the number of bytes read, 0 at the end of the payload or
+    negative error.
+******************************************************************************/
+int
+MqttClient_readPayload(MqttClient *mqc, void *buf, uint32_t len);
+
+/******************************************************************************
+    [docexport MqttClient_stop]
+*//**
+    @brief Disconnects from the broker and stops the client thread.
+    @param[in] mqc  Pointer to MqttClient instance.
+******************************************************************************/
+void
+MqttClient_stop(MqttClient *mqc);
+
 /******************************************************************************
     [docexport MqttClient_connect]
 *//**
@@ -0,0 +1,129 @@
+/*******************************************************************************
+ *  @file: MqttClientStore.h
+ *
+ *  @brief: Header for the MqttClient store-and-forward ring.
+*******************************************************************************/
+#ifndef MQTTCLIENTSTORE_H
+#define MQTTCLIENTSTORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <zephyr/net/mqtt.h>
+
+#if !defined(CONFIG_MQTTCLIENT_STORE_DEPTH)
+#define MQTTCLIENTSTORE_DEPTH           32
+#else
+#define MQTTCLIENTSTORE_DEPTH           CONFIG_MQTTCLIENT_STORE_DEPTH
+#endif
+
+#if !defined(CONFIG_MQTTCLIENT_PUBQ_TOPIC_SIZE)
+#define MQTTCLIENTSTORE_TOPIC_SIZE      64
+#else
+#define MQTTCLIENTSTORE_TOPIC_SIZE      CONFIG_MQTTCLIENT_PUBQ_TOPIC_SIZE
+#endif
+
+#if !defined(CONFIG_MQTTCLIENT_PUBQ_PAYLOAD_SIZE)
+#define MQTTCLIENTSTORE_PAYLOAD_SIZE    128
+#else
+#define MQTTCLIENTSTORE_PAYLOAD_SIZE    CONFIG_MQTTCLIENT_PUBQ_PAYLOAD_SIZE
+#endif
+
+struct MqttClient;
+
+/** @brief Completion callback of a stored publish, as MqttClient_PubDoneCb. */
+typedef void (*MqttClientStore_DoneCb)(
+    struct MqttClient *mqc,
+    uint16_t msg_id,
+    int result,
+    void *arg);
+
+/** @brief Stored publish. Topic and payload are copied. */
+typedef struct MqttClientStore_Rec
+{
+    /** @brief Store sequence number, oldest first. */
+    uint32_t seq;
+    uint16_t topic_len;
+    uint16_t payload_len;
+    uint8_t qos;
+    uint8_t topic[MQTTCLIENTSTORE_TOPIC_SIZE];
+    uint8_t payload[MQTTCLIENTSTORE_PAYLOAD_SIZE];
+    /** @brief Completion callback and argument. RAM only, after the persisted
+        bytes: records reloaded from settings have none. */
+    MqttClientStore_DoneCb done_cb;
+    void *done_arg;
+} MqttClientStore_Rec;
+
+/** @brief Bounded ring of publishes waiting for a connection. When full, the
+    oldest record is dropped. Not thread safe, owned by the client thread.
+*/
+typedef struct MqttClientStore
+{
+    MqttClientStore_Rec recs[MQTTCLIENTSTORE_DEPTH];
+    /** @brief Index of the oldest record and number of records. */
+    uint16_t head;
+    uint16_t count;
+    /** @brief Sequence number of the next stored record. */
+    uint32_t next_seq;
+    /** @brief Settings subtree for flash backing (NULL for RAM only). */
+    const char *key;
+    /** @brief Counters. */
+    uint32_t stored;
+    uint32_t replayed;
+    uint32_t dropped;
+} MqttClientStore;
+
+/******************************************************************************
+    [docexport MqttClientStore_put]
+*//**
+    @brief Appends a publish, dropping the oldest record when full.
+    @param[in] st  Pointer to MqttClientStore instance.
+    @param[in] topic  Topic and QoS.
+    @param[in] payload  Payload data.
+    @param[in] payload_len  Payload length.
+    @param[in] done_cb  Completion callback kept with the record, may be NULL.
+    @param[in] done_arg  Callback argument.
+    @return Returns 0 on success, -EMSGSIZE if the topic or payload does not fit
+    a record.
+******************************************************************************/
+int
+MqttClientStore_put(
+    MqttClientStore *st,
+    const struct mqtt_topic *topic,
+    const uint8_t *payload,
+    uint32_t payload_len,
+    MqttClientStore_DoneCb done_cb,
+    void *done_arg);
+
+/******************************************************************************
+    [docexport MqttClientStore_peek]
+*//**
+    @brief Returns the oldest record, NULL if empty.
+    @param[in] st  Pointer to MqttClientStore instance.
+******************************************************************************/
+MqttClientStore_Rec *
+MqttClientStore_peek(MqttClientStore *st);
+
+/******************************************************************************
+    [docexport MqttClientStore_pop]
+*//**
+    @brief Removes the oldest record, e.g. once sent.
+    @param[in] st  Pointer to MqttClientStore instance.
+******************************************************************************/
+void
+MqttClientStore_pop(MqttClientStore *st);
+
+/******************************************************************************
+    [docexport MqttClientStore_init]
+*//**
+    @brief Initializes the store. With CONFIG_MQTTCLIENT_STORE_SETTINGS and a
+    key, records are mirrored to the settings (NVS) backend under
+    "<key>/<seq>" and records left from a previous run are reloaded.
+    @param[in] st  Pointer to MqttClientStore instance.
+    @param[in] key  Settings subtree, or NULL for RAM only.
+    @return Returns 0 on success, -ENAMETOOLONG if the key leaves no room for
+    the record names, negative error on settings failure.
+******************************************************************************/
+int
+MqttClientStore_init(MqttClientStore *st, const char *key);
+#endif
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ *  @file: MqttClientSub.h
+ *
+ *  @brief: Header for the MqttClient topic filter trie.
+*******************************************************************************/
+#ifndef MQTTCLIENTSUB_H
+#define MQTTCLIENTSUB_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if !defined(CONFIG_MQTTCLIENT_SUB_NODES)
+#define MQTTCLIENTSUB_NODES     32
+#else
+#define MQTTCLIENTSUB_NODES     CONFIG_MQTTCLIENT_SUB_NODES
+#endif
+
+/** @brief Trie node, one per topic filter level. Level strings point into
+    the subscription's filter, which must outlive the trie.
+*/
+typedef struct MqttClientSub_Node
+{
+    const uint8_t *level;
+    uint16_t len;
+    /** @brief First child and next sibling node, -1 for none. */
+    int16_t child;
+    int16_t sibling;
+    /** @brief Subscription whose filter ends here, -1 for none. */
+    int16_t sub;
+} MqttClientSub_Node;
+
+/** @brief Topic filter trie. Node 0 is the root (no level). */
+typedef struct MqttClientSub_Trie
+{
+    MqttClientSub_Node nodes[MQTTCLIENTSUB_NODES];
+    uint16_t used;
+} MqttClientSub_Trie;
+
+/** @brief Called once per subscription matching a topic. */
+typedef void (*MqttClientSub_MatchFn)(int16_t sub, void *arg);
+
+/******************************************************************************
+    [docexport MqttClientSub_filterValid]
+*//**
+    @brief Checks a topic filter: non-empty, '+' and '#' only as whole
+    levels and '#' only as the last level.
+    @param[in] filter  Topic filter.
+    @param[in] len  Filter length.
+******************************************************************************/
+bool
+MqttClientSub_filterValid(const uint8_t *filter, uint16_t len);
+
+/******************************************************************************
+    [docexport MqttClientSub_trieInit]
+*//**
+    @brief Empties the trie.
+    @param[in] trie  Pointer to MqttClientSub_Trie instance.
+******************************************************************************/
+void
+MqttClientSub_trieInit(MqttClientSub_Trie *trie);
+
+/******************************************************************************
+    [docexport MqttClientSub_trieInsert]
+*//**
+    @brief Adds a (valid) topic filter.
+    @param[in] trie  Pointer to MqttClientSub_Trie instance.
+    @param[in] filter  Topic filter, referenced by the trie.
+    @param[in] len  Filter length.
+    @param[in] sub  Subscription index reported on match.
+    @return Returns 0 on success, -EEXIST if the filter is already present or
+    -ENOMEM when out of nodes.
+******************************************************************************/
+int
+MqttClientSub_trieInsert(
+    MqttClientSub_Trie *trie,
+    const uint8_t *filter,
+    uint16_t len,
+    int16_t sub);
+
+/******************************************************************************
+    [docexport MqttClientSub_trieMatch]
+*//**
+    @brief Finds the filters matching a topic name. Cost depends on the
+    number of topic levels and wildcard branches, not on the number of
+    subscriptions. Wildcards do not match a leading '$' level.
+    @param[in] trie  Pointer to MqttClientSub_Trie instance.
+    @param[in] topic  Topic name.
+    @param[in] len  Topic length.
+    @param[in] fn  Called with each matching subscription.
+    @param[in] arg  Argument for fn.
+    @return Returns the number of matches.
+******************************************************************************/
+int
+MqttClientSub_trieMatch(
+    MqttClientSub_Trie *trie,
+    const uint8_t *topic,
+    uint16_t len,
+    MqttClientSub_MatchFn fn,
+    void *arg);
+#endif
@@ -5,17 +5,432 @@
     client.
 *******************************************************************************/
 #include <string.h>
+#include <stdio.h>
 #include <errno.h>
 
 #include <zephyr/kernel.h>
 #include <zephyr/net/socket.h>
 #include <zephyr/net/mqtt.h>
+#include <zephyr/posix/sys/eventfd.h>
 #include "RtosUtils.h"
 #include "MqttClient.h"
 
 #include <zephyr/logging/log.h>
 LOG_MODULE_REGISTER(MqttClient, CONFIG_MQTTCLIENT_LOG_LEVEL);
 
+/** @brief Indexes into MqttClient fds. */
+#define POLL_IDX_SOCK           0
+#define POLL_IDX_WAKE           1
+
+/** @brief Subscription states. */
+#define SUB_STATE_FREE          0
+#define SUB_STATE_PENDING       1   /* SUBSCRIBE to be sent. */
+#define SUB_STATE_ACTIVE        2
+#define SUB_STATE_UNSUB         3   /* UNSUBSCRIBE to be sent. */
+
+/** @brief In-flight states of a publish entry. */
+#define PUB_STATE_QUEUED        0
+#define PUB_STATE_WAIT_PUBACK   1
+#define PUB_STATE_WAIT_PUBREC   2
+#define PUB_STATE_WAIT_PUBCOMP  3
+
+BUILD_ASSERT(MQTTCLIENT_INFLIGHT_WINDOW < MQTTCLIENT_PUBQ_DEPTH,
+    "In-flight window must leave room in the publish queue.");
+
+/******************************************************************************
+    pub_done
+*//**
+    @brief Completes a publish: calls its callback and frees the entry.
+******************************************************************************/
+static void
+pub_done(MqttClient *mqc, MqttClient_PubEntry *entry, int result)
+{
+    if (entry->done_cb != NULL)
+    {
+        entry->done_cb(mqc, entry->msg_id, result, entry->done_arg);
+    }
+    k_mem_slab_free(&mqc->pubq_slab, entry);
+}
+
+/******************************************************************************
+    pub_send
+*//**
+    @brief Sends (or resends, with DUP set) a PUBLISH for an entry.
+******************************************************************************/
+static int
+pub_send(MqttClient *mqc, MqttClient_PubEntry *entry)
+{
+    struct mqtt_publish_param param;
+
+    param.message.topic.qos        = entry->qos;
+    param.message.topic.topic.utf8 = entry->topic;
+    param.message.topic.topic.size = entry->topic_len;
+    param.message.payload.data     = entry->payload;
+    param.message.payload.len      = entry->payload_len;
+    param.message_id               = entry->msg_id;
+    param.dup_flag                 = (entry->retries > 0);
+    param.retain_flag              = 0;
+
+    return mqtt_publish(&mqc->mclient, &param);
+}
+
+/******************************************************************************
+    inflight_find
+*//**
+    @brief Returns the in-flight index of a message id, -1 if not in flight.
+******************************************************************************/
+static int
+inflight_find(MqttClient *mqc, uint16_t msg_id)
+{
+    int i;
+
+    for (i = 0; i < mqc->inflight_count; i++)
+    {
+        if (mqc->inflight[i]->msg_id == msg_id)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/******************************************************************************
+    msg_id_alloc
+*//**
+    @brief Allocates a message id, skipping 0 and ids still in flight.
+******************************************************************************/
+static uint16_t
+msg_id_alloc(MqttClient *mqc)
+{
+    do
+    {
+        mqc->last_msg_id++;
+    } while (mqc->last_msg_id == 0 || inflight_find(mqc, mqc->last_msg_id) >= 0);
+
+    return mqc->last_msg_id;
+}
+
+/******************************************************************************
+    inflight_complete
+*//**
+    @brief Removes a message from the in-flight window and completes it.
+******************************************************************************/
+static void
+inflight_complete(MqttClient *mqc, uint16_t msg_id, int result)
+{
+    MqttClient_PubEntry *entry;
+    int i = inflight_find(mqc, msg_id);
+
+    if (i < 0)
+    {
+        LOG_WRN("Ack for message id %u not in flight.", msg_id);
+        return;
+    }
+
+    entry = mqc->inflight[i];
+    mqc->inflight_count--;
+    memmove(&mqc->inflight[i], &mqc->inflight[i + 1],
+        (mqc->inflight_count - i) * sizeof(mqc->inflight[0]));
+
+    if (result == 0)
+    {
+        mqc->pub_acked++;
+    }
+    pub_done(mqc, entry, result);
+}
+
+/******************************************************************************
+    inflight_pubrec
+*//**
+    @brief QoS 2 PUBREC: the broker has the message, now wait for PUBCOMP.
+******************************************************************************/
+static void
+inflight_pubrec(MqttClient *mqc, uint16_t msg_id)
+{
+    int i = inflight_find(mqc, msg_id);
+
+    if (i < 0)
+    {
+        LOG_WRN("PUBREC for message id %u not in flight.", msg_id);
+        return;
+    }
+    mqc->inflight[i]->state   = PUB_STATE_WAIT_PUBCOMP;
+    mqc->inflight[i]->sent_ms = k_uptime_get_32();
+}
+
+/******************************************************************************
+    inflight_resend
+*//**
+    @brief Retransmits an in-flight message: PUBLISH with DUP set while
+    waiting for PUBACK/PUBREC, PUBREL while waiting for PUBCOMP.
+******************************************************************************/
+static void
+inflight_resend(MqttClient *mqc, MqttClient_PubEntry *entry)
+{
+    int ret;
+
+    entry->retries++;
+    entry->sent_ms = k_uptime_get_32();
+    mqc->pub_retransmits++;
+
+    if (entry->state == PUB_STATE_WAIT_PUBCOMP)
+    {
+        const struct mqtt_pubrel_param rel_param = {
+            .message_id = entry->msg_id
+        };
+        ret = mqtt_publish_qos2_release(&mqc->mclient, &rel_param);
+    }
+    else
+    {
+        ret = pub_send(mqc, entry);
+    }
+
+    if (ret < 0)
+    {
+        LOG_ERR("Retransmit of message id %u error: %d", entry->msg_id, ret);
+    }
+}
+
+/******************************************************************************
+    inflight_check
+*//**
+    @brief Retransmits in-flight messages whose ack timed out and completes
+    those out of retries with -ETIMEDOUT.
+******************************************************************************/
+static void
+inflight_check(MqttClient *mqc)
+{
+    MqttClient_PubEntry *entry;
+    uint32_t now = k_uptime_get_32();
+    int i = 0;
+
+    while (i < mqc->inflight_count)
+    {
+        entry = mqc->inflight[i];
+        if ((now - entry->sent_ms) < MQTTCLIENT_INFLIGHT_TIMEOUT_MS)
+        {
+            i++;
+            continue;
+        }
+
+        if (entry->retries >= MQTTCLIENT_INFLIGHT_RETRIES)
+        {
+            LOG_WRN("Message id %u not acknowledged, giving up.",
+                entry->msg_id);
+            mqc->pub_timeouts++;
+            inflight_complete(mqc, entry->msg_id, -ETIMEDOUT);
+            continue;
+        }
+
+        inflight_resend(mqc, entry);
+        i++;
+    }
+}
+
+/******************************************************************************
+    inflight_resend_all
+*//**
+    @brief Retransmits every in-flight message, e.g. after a reconnect.
+******************************************************************************/
+static void
+inflight_resend_all(MqttClient *mqc)
+{
+    int i;
+
+    for (i = 0; i < mqc->inflight_count; i++)
+    {
+        inflight_resend(mqc, mqc->inflight[i]);
+    }
+}
+
+/******************************************************************************
+    pub_start
+*//**
+    @brief Sends a publish taken from the queue or the store. QoS 0 publishes
+    complete once written. QoS 1/2 publishes enter the in-flight window even
+    if the write fails, so they are retransmitted.
+    @return Returns the mqtt_publish result.
+******************************************************************************/
+static int
+pub_start(MqttClient *mqc, MqttClient_PubEntry *entry)
+{
+    int ret;
+
+    entry->retries = 0;
+    entry->msg_id  = 0;
+    if (entry->qos != MQTT_QOS_0_AT_MOST_ONCE)
+    {
+        entry->msg_id = msg_id_alloc(mqc);
+    }
+
+    ret = pub_send(mqc, entry);
+    if (ret < 0)
+    {
+        LOG_ERR("mqtt_publish error: %d", ret);
+        mqc->pub_errors++;
+    }
+    else
+    {
+        mqc->pub_sent++;
+    }
+
+    if (entry->qos == MQTT_QOS_0_AT_MOST_ONCE)
+    {
+        pub_done(mqc, entry, ret);
+        return ret;
+    }
+
+    entry->state = (entry->qos == MQTT_QOS_1_AT_LEAST_ONCE) ?
+        PUB_STATE_WAIT_PUBACK : PUB_STATE_WAIT_PUBREC;
+    entry->sent_ms = k_uptime_get_32();
+    mqc->inflight[mqc->inflight_count++] = entry;
+    return ret;
+}
+
+/** @brief Matches collected for one received PUBLISH. */
+typedef struct
+{
+    int16_t subs[MQTTCLIENT_SUB_MAX];
+    int count;
+} SubMatches;
+
+/******************************************************************************
+    sub_collect
+*//**
+    @brief MqttClientSub_trieMatch callback.
+******************************************************************************/
+static void
+sub_collect(int16_t sub, void *arg)
+{
+    SubMatches *m = (SubMatches *)arg;
+
+    if (m->count < MQTTCLIENT_SUB_MAX)
+    {
+        m->subs[m->count++] = sub;
+    }
+}
+
+/******************************************************************************
+    sub_rebuild
+*//**
+    @brief Rebuilds the trie from the live subscriptions. Called with sub_lock
+    held after a subscription is removed or an insert failed part way.
+******************************************************************************/
+static void
+sub_rebuild(MqttClient *mqc)
+{
+    MqttClient_Sub *sub;
+    int i;
+
+    MqttClientSub_trieInit(&mqc->sub_trie);
+    for (i = 0; i < MQTTCLIENT_SUB_MAX; i++)
+    {
+        sub = &mqc->subs[i];
+        if (sub->state == SUB_STATE_PENDING || sub->state == SUB_STATE_ACTIVE)
+        {
+            /* Fits: the trie held these nodes before the removal. */
+            MqttClientSub_trieInsert(&mqc->sub_trie, sub->filter,
+                sub->filter_len, i);
+        }
+    }
+}
+
+/******************************************************************************
+    sub_dispatch
+*//**
+    @brief Delivers a received PUBLISH to every matching subscription. A
+    single match reads the payload straight from the socket. Several matches
+    share a copy in publish_rx_buffer when it fits, otherwise only the first
+    callback gets the payload. Unread payload is discarded.
+******************************************************************************/
+static void
+sub_dispatch(MqttClient *mqc, const struct mqtt_publish_param *pub)
+{
+    const struct mqtt_utf8 *topic = &pub->message.topic.topic;
+    MqttClient_Sub *sub;
+    SubMatches m;
+    uint32_t n;
+    int ret;
+    int i;
+
+    m.count = 0;
+    mqc->rx_left     = pub->message.payload.len;
+    mqc->rx_buffered = 0;
+
+    RTOS_MUTEX_GET(&mqc->sub_lock);
+
+    MqttClientSub_trieMatch(&mqc->sub_trie, topic->utf8, topic->size,
+        sub_collect, &m);
+    if (m.count == 0)
+    {
+        LOG_WRN("No subscription for topic %.*s",
+            (int)topic->size, topic->utf8);
+    }
+
+    if (m.count > 1 && mqc->rx_left <= sizeof(mqc->publish_rx_buffer))
+    {
+        ret = mqtt_readall_publish_payload(&mqc->mclient,
+            mqc->publish_rx_buffer, mqc->rx_left);
+        if (ret < 0)
+        {
+            LOG_ERR("mqtt_readall_publish_payload error: %d", ret);
+            m.count = 0;
+        }
+        mqc->rx_buffered = mqc->rx_left;
+        mqc->rx_left = 0;
+    }
+
+    for (i = 0; i < m.count; i++)
+    {
+        sub = &mqc->subs[m.subs[i]];
+        mqc->rx_cursor = 0;
+        sub->cb(mqc, pub, sub->arg);
+    }
+
+    RTOS_MUTEX_PUT(&mqc->sub_lock);
+
+    /* Discard what the callbacks left unread. */
+    while (mqc->rx_left > 0)
+    {
+        n = MIN(mqc->rx_left, sizeof(mqc->publish_rx_buffer));
+        ret = mqtt_readall_publish_payload(&mqc->mclient,
+            mqc->publish_rx_buffer, n);
+        if (ret < 0)
+        {
+            LOG_ERR("Discarding payload error: %d", ret);
+            break;
+        }
+        mqc->rx_left -= n;
+    }
+    mqc->rx_buffered = 0;
+}
+
+/******************************************************************************
+    sub_connack
+*//**
+    @brief Marks all subscriptions for (re)sending after a CONNACK. Pending
+    unsubscribes are dropped, the new (clean) session has no subscriptions.
+******************************************************************************/
+static void
+sub_connack(MqttClient *mqc)
+{
+    int i;
+
+    RTOS_MUTEX_GET(&mqc->sub_lock);
+    for (i = 0; i < MQTTCLIENT_SUB_MAX; i++)
+    {
+        if (mqc->subs[i].state == SUB_STATE_ACTIVE)
+        {
+            mqc->subs[i].state = SUB_STATE_PENDING;
+        }
+        else if (mqc->subs[i].state == SUB_STATE_UNSUB)
+        {
+            mqc->subs[i].state = SUB_STATE_FREE;
+        }
+    }
+    RTOS_MUTEX_PUT(&mqc->sub_lock);
+}
+
 /******************************************************************************
     event_handler
 *//**
@@ -42,11 +457,23 @@ event_handler(struct mqtt_client *const client, const struct mqtt_evt *event)
         
         mqc->connected = true;
         LOG_INF("MQTT client connected.");
+        /* Resend unacknowledged publishes right away. */
+        inflight_resend_all(mqc);
+        sub_connack(mqc);
+#if defined(CONFIG_MQTTCLIENT_STORE)
+        /* Start replaying stored publishes right away. */
+        mqc->replay_next_ms = 0;
+        if (mqc->store.count > 0)
+        {
+            LOG_INF("Replaying %u stored publishes.", mqc->store.count);
+        }
+#endif
         break;
 
     case MQTT_EVT_DISCONNECT:
         LOG_INF("MQTT client disconnected.");
         mqc->connected = false;
+        break;
 
     case MQTT_EVT_SUBACK:
         if (event->result != 0)
@@ -72,11 +499,13 @@ event_handler(struct mqtt_client *const client, const struct mqtt_evt *event)
         if (event->result != 0)
         {
             LOG_ERR("MQTT PUBREC QoS 2 error %d", event->result);
+            inflight_complete(mqc, event->param.pubrec.message_id, -EIO);
             break;
         }
 
-        LOG_INF("MQTT PUBREC QoS 2 message id: %u",
+        LOG_DBG("MQTT PUBREC QoS 2 message id: %u",
             event->param.pubrec.message_id);
+        inflight_pubrec(mqc, event->param.pubrec.message_id);
 
         const struct mqtt_pubrel_param rel_param = {
             .message_id = event->param.pubrec.message_id
@@ -95,10 +524,12 @@ event_handler(struct mqtt_client *const client, const struct mqtt_evt *event)
         if (event->result != 0)
         {
             LOG_ERR("MQTT PUBACK (QoS 1) error %d", event->result);
+            inflight_complete(mqc, event->param.puback.message_id, -EIO);
             break;
         }
-        LOG_INF("MQTT PUBACK (QoS 1) packet id: %u",
+        LOG_DBG("MQTT PUBACK (QoS 1) packet id: %u",
             event->param.puback.message_id);
+        inflight_complete(mqc, event->param.puback.message_id, 0);
         break;
 
     case MQTT_EVT_PUBLISH:
@@ -108,24 +539,27 @@ event_handler(struct mqtt_client *const client, const struct mqtt_evt *event)
             LOG_ERR("MQTT PUBLISH error %d", event->result);
             break;
         }
-        LOG_INF("MQTT PUBLISH msg recv'd: id=%u",
-            event->param.publish.message_id);
-        LOG_INF("MQTT PUBLISH topic: %s",
+        LOG_DBG("MQTT PUBLISH msg recv'd: id=%u topic: %.*s",
+            event->param.publish.message_id,
+            (int)event->param.publish.message.topic.topic.size,
             event->param.publish.message.topic.topic.utf8);
 
-        /* Get the payload. */
-        int num = mqtt_read_publish_payload(
-            client,
-            mqc->publish_rx_buffer, 
-            sizeof(mqc->publish_rx_buffer));
-        if (num <= 0)
+        sub_dispatch(mqc, &event->param.publish);
+
+        /* QoS 1 and 2 must be acknowledged. */
+        if (event->param.publish.message.topic.qos == MQTT_QOS_1_AT_LEAST_ONCE)
         {
-            LOG_ERR("MQTT mqtt_read_publish_payload error: %d", num);
-            break;
+            const struct mqtt_puback_param param = {
+                .message_id = event->param.publish.message_id
+            };
+            err = mqtt_publish_qos1_ack(client, &param);
+            if (err < 0)
+            {
+                LOG_ERR("MQTT PUBLISH QoS1 ack error: %d", err);
+            }
         }
-
-        /* If QoS2, must send acknowledment. */
-        if (event->param.publish.message.topic.qos == MQTT_QOS_2_EXACTLY_ONCE)
+        else if (event->param.publish.message.topic.qos ==
+            MQTT_QOS_2_EXACTLY_ONCE)
         {
             const struct mqtt_pubrec_param param = {
                 .message_id = event->param.publish.message_id
@@ -138,8 +572,6 @@ event_handler(struct mqtt_client *const client, const struct mqtt_evt *event)
             LOG_DBG("MQTT PUBLISH QoS2 ack id: %u",
                 event->param.publish.message_id);
         }
-
-        LOG_HEXDUMP_DBG(mqc->publish_rx_buffer, num, "PUBLISH rx payload");
         break;
 
     case MQTT_EVT_PUBREL:
@@ -158,10 +590,12 @@ event_handler(struct mqtt_client *const client, const struct mqtt_evt *event)
         if (event->result != 0)
         {
             LOG_ERR("MQTT PUBCOMP (QoS 2) error %d", event->result);
+            inflight_complete(mqc, event->param.pubcomp.message_id, -EIO);
             break;
         }
-        LOG_INF("MQTT PUBCOMP (QoS 2) message id: %u",
+        LOG_DBG("MQTT PUBCOMP (QoS 2) message id: %u",
             event->param.pubcomp.message_id);
+        inflight_complete(mqc, event->param.pubcomp.message_id, 0);
         break;
 
     case MQTT_EVT_PINGRESP:
@@ -193,23 +627,27 @@ call_mqtt_input(struct mqtt_client *client)
 /******************************************************************************
     wait_poll_input
 *//**
-    @brief Waits for data from server.
+    @brief Waits for data from server or, with nfds = 2, a wakeup. Aborts the
+    connection on hangup or socket error.
     @param[in] mqc  Pointer to MqttClient instance.
-    @return Return 0 on successful read, -1 on error.
+    @param[in] nfds  1 to poll the socket only, 2 to include the wakeup fd.
+    @param[in] timeout_ms  Poll timeout, -1 to wait forever.
+    @return Return 0 on successful read or wakeup, -1 on error or timeout.
 ******************************************************************************/
 static int
-wait_poll_input(MqttClient *mqc)
+wait_poll_input(MqttClient *mqc, int nfds, int timeout_ms)
 {
     struct pollfd *pfds = mqc->fds;
     struct mqtt_client *client = &mqc->mclient;
     int ready;
+    int ret = -1;
 
     /* poll():
          0 : timeout waiting for fd ready.
         <0 : errno
         >0 : number of elements in pollfds whose revents are nonzero
     */
-    if ((ready = poll(pfds, 1, (int)mqc->poll_timeout_ms)) < 0)
+    if ((ready = poll(pfds, nfds, timeout_ms)) < 0)
     {
         LOG_ERR("wait_poll_input error: %d", errno);
         return -1;
@@ -217,87 +655,446 @@ wait_poll_input(MqttClient *mqc)
 
     if (ready == 0)
     {
-        goto ret_err;
+        return -1;
+    }
+
+    if (nfds > POLL_IDX_WAKE && (pfds[POLL_IDX_WAKE].revents & POLLIN))
+    {
+        eventfd_t val;
+        eventfd_read(mqc->wake_fd, &val);
+        ret = 0;
     }
 
-    /* There is only one fd to check. */
-    if (pfds[0].revents & POLLIN)
+    if (pfds[POLL_IDX_SOCK].revents & POLLIN)
     {
         /* Data received, let mqtt lib handle it. */
         LOG_DBG("MQTT packet received.");
         return call_mqtt_input(client);
     }
-    if (pfds[0].revents & POLLHUP)
+    if (pfds[POLL_IDX_SOCK].revents & POLLHUP)
     {
         /* Hangup received. */
         LOG_WRN("MQTT POLLHUP.");
-        goto ret_err;
+        mqtt_abort(client);
+        return -1;
     }
-    if (pfds[0].revents & POLLERR)
+    if (pfds[POLL_IDX_SOCK].revents & POLLERR)
     {
         /* Error */
         LOG_WRN("MQTT POLLERR.");
+        mqtt_abort(client);
+        return -1;
     }
 
-ret_err:
-    return -1;
+    return ret;
 }
 
 /******************************************************************************
-    client_thread
+    client_wake
 *//**
-    @brief Main task loop for client.
+    @brief Wakes the client thread from poll.
 ******************************************************************************/
 static void
-client_thread(void *p, void *arg1, void *arg2)
+client_wake(MqttClient *mqc)
 {
-    MqttClient *mqc = (MqttClient *)p;
-    struct client_task *task = &mqc->task;
-    struct mqtt_client *client = &mqc->mclient;
-
-    (void)arg1;
-    (void)arg2;
+    eventfd_write(mqc->wake_fd, 1);
+}
 
-    LOG_INF("Starting mqtt client thread: %s.", task->name);
+#if defined(CONFIG_MQTTCLIENT_STORE)
+/******************************************************************************
+    store_key_hash
+*//**
+    @brief FNV-1a hash of the client id, so any id gives a settings key of
+    the same length.
+******************************************************************************/
+static uint32_t
+store_key_hash(const char *client_id)
+{
+    uint32_t hash = 2166136261u;
 
-    while (1)
+    while (*client_id != '\0')
     {
-        int ret;
-
-        if (mqc->connected)
-        {
-            /* Poll for input data. */
-            wait_poll_input(mqc);
-
-            //ret = mqtt_ping(client);
-            //if (ret < 0)
-            //{
-            //    LOG_ERR("mqtt_ping failed: %d", ret);
-            //}
-
-            mqtt_live(client);
-            wait_poll_input(mqc);
-        }
-        else
-        {
-            LOG_INF("Attempting client connect: %s", client->client_id.utf8);
-            MqttClient_connect(mqc);
-        }
-
-        RTOS_TASK_SLEEP_ms(1000);
+        hash = (hash ^ (uint8_t)*client_id++) * 16777619u;
     }
+    return hash;
 }
 
 /******************************************************************************
-    [docimport MqttClient_setTopic]
+    store_put
 *//**
-    @brief Creates a publish topic. Use for calls to MqttClient_publish.
-    @param[in] topic  Pointer to MqttClient_PubTopic instance.
-    @param[in] topic_str  Topic string.
-    @param[in] qos  QoS for message (use enum mqtt_qos).
-    MQTT_QOS_0_AT_MOST_ONCE
-    MQTT_QOS_1_AT_LEAST_ONCE
-    MQTT_QOS_2_EXACTLY_ONCE
+    @brief Moves a queued publish to the store and frees the entry. Its
+    callback moves with it and is called once the publish is replayed and
+    acknowledged, or with -ENOBUFS if the full store drops it. QoS 0
+    publishes are dropped (-ENOTCONN).
+******************************************************************************/
+static void
+store_put(MqttClient *mqc, MqttClient_PubEntry *entry)
+{
+    MqttClientStore_Rec *oldest;
+    struct mqtt_topic topic;
+    int rc;
+
+    if (entry->qos == MQTT_QOS_0_AT_MOST_ONCE)
+    {
+        mqc->store.dropped++;
+        pub_done(mqc, entry, -ENOTCONN);
+        return;
+    }
+
+    /* A full store drops its oldest record to make room. */
+    oldest = MqttClientStore_peek(&mqc->store);
+    if (mqc->store.count == MQTTCLIENTSTORE_DEPTH && oldest->done_cb != NULL)
+    {
+        oldest->done_cb(mqc, 0, -ENOBUFS, oldest->done_arg);
+    }
+
+    topic.qos        = entry->qos;
+    topic.topic.utf8 = entry->topic;
+    topic.topic.size = entry->topic_len;
+    rc = MqttClientStore_put(&mqc->store, &topic, entry->payload,
+        entry->payload_len, entry->done_cb, entry->done_arg);
+    if (rc < 0)
+    {
+        pub_done(mqc, entry, rc);
+        return;
+    }
+    k_mem_slab_free(&mqc->pubq_slab, entry);
+}
+
+/******************************************************************************
+    pubq_store
+*//**
+    @brief Moves all queued publishes to the store while disconnected.
+******************************************************************************/
+static void
+pubq_store(MqttClient *mqc)
+{
+    MqttClient_PubEntry *entry;
+
+    while ((entry = k_fifo_get(&mqc->pubq, K_NO_WAIT)) != NULL)
+    {
+        store_put(mqc, entry);
+    }
+}
+
+/******************************************************************************
+    store_replay
+*//**
+    @brief Sends up to MQTTCLIENT_STORE_REPLAY_BATCH stored publishes, oldest
+    first, once per MQTTCLIENT_STORE_REPLAY_INTERVAL_MS so a reconnect does
+    not flood the broker. Replayed publishes go through the in-flight window
+    like queued ones.
+******************************************************************************/
+static void
+store_replay(MqttClient *mqc)
+{
+    MqttClient_PubEntry *entry;
+    MqttClientStore_Rec *rec;
+    int64_t now = k_uptime_get();
+    int n;
+
+    if (mqc->store.count == 0 || now < mqc->replay_next_ms)
+    {
+        return;
+    }
+    mqc->replay_next_ms = now + CONFIG_MQTTCLIENT_STORE_REPLAY_INTERVAL_MS;
+
+    for (n = 0; n < CONFIG_MQTTCLIENT_STORE_REPLAY_BATCH; n++)
+    {
+        rec = MqttClientStore_peek(&mqc->store);
+        if (rec == NULL)
+        {
+            LOG_INF("Stored publishes replayed.");
+            break;
+        }
+        if (mqc->inflight_count == MQTTCLIENT_INFLIGHT_WINDOW ||
+            k_mem_slab_alloc(&mqc->pubq_slab, (void **)&entry, K_NO_WAIT) != 0)
+        {
+            break;
+        }
+
+        entry->done_cb     = rec->done_cb;
+        entry->done_arg    = rec->done_arg;
+        entry->qos         = rec->qos;
+        entry->topic_len   = rec->topic_len;
+        entry->payload_len = rec->payload_len;
+        memcpy(entry->topic, rec->topic, rec->topic_len);
+        memcpy(entry->payload, rec->payload, rec->payload_len);
+        MqttClientStore_pop(&mqc->store);
+        mqc->store.replayed++;
+
+        pub_start(mqc, entry);
+    }
+}
+#endif
+
+/******************************************************************************
+    pubq_drain
+*//**
+    @brief Sends up to MQTTCLIENT_PUBQ_BATCH queued publishes. Stops early when
+    the in-flight window is full, leaving the rest queued. Only called from
+    the client thread, which owns the mqtt client and its tx buffer.
+    @param[in] mqc  Pointer to MqttClient instance.
+    @return Returns the number of publishes taken from the queue.
+******************************************************************************/
+static int
+pubq_drain(MqttClient *mqc)
+{
+    MqttClient_PubEntry *entry;
+    int count;
+
+    for (count = 0; count < MQTTCLIENT_PUBQ_BATCH && mqc->connected; count++)
+    {
+        entry = k_fifo_peek_head(&mqc->pubq);
+        if (entry == NULL)
+        {
+            break;
+        }
+        if (entry->qos != MQTT_QOS_0_AT_MOST_ONCE &&
+            mqc->inflight_count == MQTTCLIENT_INFLIGHT_WINDOW)
+        {
+            break;
+        }
+        (void)k_fifo_get(&mqc->pubq, K_NO_WAIT);
+
+#if defined(CONFIG_MQTTCLIENT_STORE)
+        /*  QoS 1/2 publishes wait behind stored ones so they are delivered
+            in order.
+        */
+        if (entry->qos != MQTT_QOS_0_AT_MOST_ONCE && mqc->store.count > 0)
+        {
+            store_put(mqc, entry);
+            continue;
+        }
+#endif
+
+        if (pub_start(mqc, entry) < 0)
+        {
+            count++;
+            break;
+        }
+    }
+
+    return count;
+}
+
+/******************************************************************************
+    sub_sync
+*//**
+    @brief Sends pending SUBSCRIBE/UNSUBSCRIBE messages. A failed SUBSCRIBE
+    stays pending and is retried on the next pass.
+******************************************************************************/
+static void
+sub_sync(MqttClient *mqc)
+{
+    struct mqtt_subscription_list list;
+    struct mqtt_topic topic;
+    MqttClient_Sub *sub;
+    int ret;
+    int i;
+
+    RTOS_MUTEX_GET(&mqc->sub_lock);
+    for (i = 0; i < MQTTCLIENT_SUB_MAX && mqc->connected; i++)
+    {
+        sub = &mqc->subs[i];
+        if (sub->state != SUB_STATE_PENDING && sub->state != SUB_STATE_UNSUB)
+        {
+            continue;
+        }
+
+        topic.topic.utf8 = sub->filter;
+        topic.topic.size = sub->filter_len;
+        topic.qos        = sub->qos;
+        list.list        = &topic;
+        list.list_count  = 1;
+        list.message_id  = msg_id_alloc(mqc);
+
+        if (sub->state == SUB_STATE_PENDING)
+        {
+            ret = mqtt_subscribe(&mqc->mclient, &list);
+            if (ret == 0)
+            {
+                sub->state = SUB_STATE_ACTIVE;
+            }
+        }
+        else
+        {
+            ret = mqtt_unsubscribe(&mqc->mclient, &list);
+            sub->state = SUB_STATE_FREE;
+        }
+
+        if (ret < 0)
+        {
+            LOG_ERR("(Un)subscribe %.*s error: %d",
+                (int)sub->filter_len, sub->filter, ret);
+        }
+    }
+    RTOS_MUTEX_PUT(&mqc->sub_lock);
+}
+
+/******************************************************************************
+    next_timeout_ms
+*//**
+    @brief Returns how long the client thread may block in poll: until the
+    next keepalive, in-flight retransmit or store replay, whichever comes
+    first. Returns 0 when queued publishes are ready to send, -1 to block
+    until input or a wakeup.
+    @param[in] mqc  Pointer to MqttClient instance.
+    @param[in] pubq_ready  Queued publishes are waiting for the next batch.
+******************************************************************************/
+static int
+next_timeout_ms(MqttClient *mqc, bool pubq_ready)
+{
+    uint32_t now = k_uptime_get_32();
+    int timeout;
+    int t;
+    int i;
+
+    if (pubq_ready)
+    {
+        return 0;
+    }
+
+    timeout = mqtt_keepalive_time_left(&mqc->mclient);
+
+    for (i = 0; i < mqc->inflight_count; i++)
+    {
+        t = MQTTCLIENT_INFLIGHT_TIMEOUT_MS -
+            (int)(now - mqc->inflight[i]->sent_ms);
+        t = MAX(t, 0);
+        if (timeout < 0 || t < timeout)
+        {
+            timeout = t;
+        }
+    }
+
+#if defined(CONFIG_MQTTCLIENT_STORE)
+    if (mqc->store.count > 0 &&
+        mqc->inflight_count < MQTTCLIENT_INFLIGHT_WINDOW)
+    {
+        t = (int)MAX(mqc->replay_next_ms - k_uptime_get(), 0);
+        if (timeout < 0 || t < timeout)
+        {
+            timeout = t;
+        }
+    }
+#endif
+
+    return timeout;
+}
+
+/******************************************************************************
+    reconnect
+*//**
+    @brief Disconnected step of the client thread: makes a connect attempt
+    when the backoff allows, else blocks until it does or a wakeup (new
+    publish or stop).
+    @param[in] mqc  Pointer to MqttClient instance.
+******************************************************************************/
+static void
+reconnect(MqttClient *mqc)
+{
+    struct mqtt_client *client = &mqc->mclient;
+    uint32_t wait_ms;
+    int ret;
+
+#if defined(CONFIG_MQTTCLIENT_STORE)
+    pubq_store(mqc);
+#endif
+
+    if (mqc->reconnect.state == BACKOFF_STATE_CONNECTED)
+    {
+        wait_ms = Backoff_lost(&mqc->reconnect);
+        LOG_INF("Connection lost, reconnecting in %u ms.", wait_ms);
+    }
+
+    wait_ms = Backoff_remainingMs(&mqc->reconnect);
+    if (wait_ms > 0)
+    {
+        /* Only the wakeup fd, the socket is closed. */
+        if (poll(&mqc->fds[POLL_IDX_WAKE], 1, wait_ms) > 0)
+        {
+            eventfd_t val;
+            eventfd_read(mqc->wake_fd, &val);
+        }
+        return;
+    }
+
+    LOG_INF("Attempting client connect: %s", client->client_id.utf8);
+    Backoff_attempt(&mqc->reconnect);
+    ret = MqttClient_connect(mqc);
+    if (ret == 0)
+    {
+        Backoff_success(&mqc->reconnect);
+        return;
+    }
+
+    wait_ms = Backoff_fail(&mqc->reconnect, ret);
+    LOG_WRN("Connect attempt %u failed (%d), retry in %u ms.",
+        mqc->reconnect.failures, ret, wait_ms);
+}
+
+/******************************************************************************
+    client_thread
+*//**
+    @brief Main task loop for client.
+******************************************************************************/
+static void
+client_thread(void *p, void *arg1, void *arg2)
+{
+    MqttClient *mqc = (MqttClient *)p;
+    struct client_task *task = &mqc->task;
+    struct mqtt_client *client = &mqc->mclient;
+
+    (void)arg1;
+    (void)arg2;
+
+    LOG_INF("Starting mqtt client thread: %s.", task->name);
+
+    while (!atomic_get(&mqc->stop))
+    {
+        if (mqc->connected)
+        {
+            bool pubq_ready;
+
+            /*  Send pending (un)subscribes, retransmit timed out publishes
+                and send queued ones, then
+                block until socket input, a wakeup (new publish or stop) or
+                the next timer (keepalive, retransmit, replay).
+            */
+            sub_sync(mqc);
+            inflight_check(mqc);
+#if defined(CONFIG_MQTTCLIENT_STORE)
+            store_replay(mqc);
+#endif
+            pubq_ready = (pubq_drain(mqc) == MQTTCLIENT_PUBQ_BATCH);
+            wait_poll_input(mqc, 2, next_timeout_ms(mqc, pubq_ready));
+
+            mqtt_live(client);
+        }
+        else
+        {
+            reconnect(mqc);
+        }
+    }
+
+    if (mqc->connected)
+    {
+        mqtt_disconnect(client);
+    }
+    LOG_INF("Stopped mqtt client thread: %s.", task->name);
+}
+
+/******************************************************************************
+    [docimport MqttClient_setTopic]
+*//**
+    @brief Creates a publish topic. Use for calls to MqttClient_publish.
+    @param[in] topic  Pointer to MqttClient_PubTopic instance.
+    @param[in] topic_str  Topic string.
+    @param[in] qos  QoS for message (use enum mqtt_qos).
+    MQTT_QOS_0_AT_MOST_ONCE
+    MQTT_QOS_1_AT_LEAST_ONCE
+    MQTT_QOS_2_EXACTLY_ONCE
 ******************************************************************************/
 void
 MqttClient_setTopic(
@@ -308,17 +1105,20 @@ MqttClient_setTopic(
     tp->topic.qos = qos;
     tp->topic.topic.utf8 = (uint8_t *)topic_str;
     tp->topic.topic.size = strlen(topic_str);
-    tp->msg_id = 0;
 }
 
 /******************************************************************************
     [docimport MqttClient_publish]
 *//**
-    @brief Publish data to a topic.
+    @brief Queues a publish to a topic and returns without blocking. Topic
+    and payload are copied. The client thread sends queued publishes in order
+    once connected.
     @param[in] mqc  Pointer to MqttClient instance.
     @param[in] topic  Pointer to MqttClient_PubTopic instance.
     @param[in] payload  Payload data buffer.
     @param[in] payload_len  Length of the payload to publish.
+    @return Returns 0 when queued, -ENOBUFS when the queue is full or
+    -EMSGSIZE when the topic or payload does not fit a queue entry.
 ******************************************************************************/
 int
 MqttClient_publish(
@@ -327,25 +1127,281 @@ MqttClient_publish(
     uint8_t *payload,
     uint32_t payload_len)
 {
-    struct mqtt_publish_param param;
+    return MqttClient_publishCb(mqc, tp, payload, payload_len, NULL, NULL);
+}
 
-    if (!mqc->connected)
+/******************************************************************************
+    [docimport MqttClient_publishCb]
+*//**
+    @brief As MqttClient_publish, with a completion callback. QoS 1/2
+    publishes stay in the in-flight window until acknowledged and are
+    retransmitted with DUP set every MQTTCLIENT_INFLIGHT_TIMEOUT_MS, up to
+    MQTTCLIENT_INFLIGHT_RETRIES times.
+    @param[in] mqc  Pointer to MqttClient instance.
+    @param[in] topic  Pointer to MqttClient_PubTopic instance.
+    @param[in] payload  Payload data buffer.
+    @param[in] payload_len  Length of the payload to publish.
+    @param[in] cb  Completion callback, may be NULL.
+    @param[in] arg  Callback argument.
+    @return Returns 0 when queued, -ENOBUFS when the queue is full or
+    -EMSGSIZE when the topic or payload does not fit a queue entry.
+******************************************************************************/
+int
+MqttClient_publishCb(
+    MqttClient *mqc,
+    MqttClient_PubTopic *tp,
+    uint8_t *payload,
+    uint32_t payload_len,
+    MqttClient_PubDoneCb cb,
+    void *arg)
+{
+    MqttClient_PubEntry *entry;
+
+    if (payload_len > MQTTCLIENT_PUBQ_PAYLOAD_SIZE ||
+        tp->topic.topic.size > MQTTCLIENT_PUBQ_TOPIC_SIZE)
+    {
+        LOG_ERR("Publish too large (topic %u, payload %u bytes).",
+            (unsigned int)tp->topic.topic.size, payload_len);
+        return -EMSGSIZE;
+    }
+
+    if (k_mem_slab_alloc(&mqc->pubq_slab, (void **)&entry, K_NO_WAIT) != 0)
+    {
+        atomic_inc(&mqc->pub_dropped);
+        return -ENOBUFS;
+    }
+
+    entry->done_cb     = cb;
+    entry->done_arg    = arg;
+    entry->msg_id      = 0;
+    entry->state       = PUB_STATE_QUEUED;
+    entry->qos         = tp->topic.qos;
+    entry->topic_len   = (uint16_t)tp->topic.topic.size;
+    entry->payload_len = (uint16_t)payload_len;
+    memcpy(entry->topic, tp->topic.topic.utf8, entry->topic_len);
+    memcpy(entry->payload, payload, payload_len);
+
+    k_fifo_put(&mqc->pubq, entry);
+    client_wake(mqc);
+    return 0;
+}
+
+/******************************************************************************
+    [docimport MqttClient_publishSpace]
+*//**
+    @brief Returns the number of free publish queue slots.
+    @param[in] mqc  Pointer to MqttClient instance.
+******************************************************************************/
+uint32_t
+MqttClient_publishSpace(MqttClient *mqc)
+{
+    return k_mem_slab_num_free_get(&mqc->pubq_slab);
+}
+
+/******************************************************************************
+    sub_find
+*//**
+    @brief Returns the subscription slot in use for a filter, -1 if none.
+******************************************************************************/
+static int
+sub_find(MqttClient *mqc, const uint8_t *filter, uint16_t len)
+{
+    MqttClient_Sub *sub;
+    int i;
+
+    for (i = 0; i < MQTTCLIENT_SUB_MAX; i++)
+    {
+        sub = &mqc->subs[i];
+        if (sub->state != SUB_STATE_FREE &&
+            sub->filter_len == len && memcmp(sub->filter, filter, len) == 0)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/******************************************************************************
+    [docimport MqttClient_subscribe]
+*//**
+    @brief Subscribes to a topic filter ('+' and '#' wildcards allowed). The
+    SUBSCRIBE is sent by the client thread now or on the next connect, and
+    again after every reconnect. Subscribing to an existing filter replaces
+    its callback and QoS.
+    @param[in] mqc  Pointer to MqttClient instance.
+    @param[in] filter  Topic filter, copied.
+    @param[in] qos  Max QoS (use enum mqtt_qos).
+    @param[in] cb  Callback for matching PUBLISH messages.
+    @param[in] arg  Callback argument.
+    @return Returns 0 on success, -EINVAL for an invalid filter, -EMSGSIZE
+    for a filter longer than MQTTCLIENT_PUBQ_TOPIC_SIZE or -ENOMEM when out
+    of subscription slots or trie nodes.
+******************************************************************************/
+int
+MqttClient_subscribe(
+    MqttClient *mqc,
+    const char *filter,
+    uint8_t qos,
+    MqttClient_SubCb cb,
+    void *arg)
+{
+    MqttClient_Sub *sub;
+    size_t len = strlen(filter);
+    int ret = 0;
+    int i;
+
+    if (len > MQTTCLIENT_PUBQ_TOPIC_SIZE)
+    {
+        return -EMSGSIZE;
+    }
+    if (cb == NULL || !MqttClientSub_filterValid((const uint8_t *)filter, len))
+    {
+        return -EINVAL;
+    }
+
+    RTOS_MUTEX_GET(&mqc->sub_lock);
+
+    i = sub_find(mqc, (const uint8_t *)filter, len);
+    if (i < 0)
+    {
+        for (i = 0; i < MQTTCLIENT_SUB_MAX; i++)
+        {
+            if (mqc->subs[i].state == SUB_STATE_FREE)
+            {
+                break;
+            }
+        }
+        if (i == MQTTCLIENT_SUB_MAX)
+        {
+            ret = -ENOMEM;
+            goto exit;
+        }
+
+        sub = &mqc->subs[i];
+        memcpy(sub->filter, filter, len);
+        sub->filter_len = len;
+        ret = MqttClientSub_trieInsert(&mqc->sub_trie, sub->filter, len, i);
+        if (ret < 0)
+        {
+            LOG_ERR("Out of subscription trie nodes.");
+            /* Drop the partial path, it points into this free slot. */
+            sub_rebuild(mqc);
+            goto exit;
+        }
+    }
+    else if (mqc->subs[i].state == SUB_STATE_UNSUB)
+    {
+        /* Resubscribed before the UNSUBSCRIBE went out: reuse the slot. */
+        ret = MqttClientSub_trieInsert(&mqc->sub_trie, mqc->subs[i].filter,
+            len, i);
+        if (ret < 0)
+        {
+            LOG_ERR("Out of subscription trie nodes.");
+            sub_rebuild(mqc);
+            goto exit;
+        }
+    }
+
+    sub = &mqc->subs[i];
+    sub->cb    = cb;
+    sub->arg   = arg;
+    sub->qos   = qos;
+    sub->state = SUB_STATE_PENDING;
+
+exit:
+    RTOS_MUTEX_PUT(&mqc->sub_lock);
+    if (ret == 0)
+    {
+        client_wake(mqc);
+    }
+    return ret;
+}
+
+/******************************************************************************
+    [docimport MqttClient_unsubscribe]
+*//**
+    @brief Removes a subscription. The UNSUBSCRIBE is sent by the client
+    thread.
+    @param[in] mqc  Pointer to MqttClient instance.
+    @param[in] filter  Topic filter as passed to MqttClient_subscribe.
+    @return Returns 0 on success, -ENOENT if not subscribed.
+******************************************************************************/
+int
+MqttClient_unsubscribe(MqttClient *mqc, const char *filter)
+{
+    int i;
+
+    RTOS_MUTEX_GET(&mqc->sub_lock);
+    i = sub_find(mqc, (const uint8_t *)filter, strlen(filter));
+    if (i >= 0 && mqc->subs[i].state == SUB_STATE_UNSUB)
+    {
+        i = -1;
+    }
+    if (i >= 0)
+    {
+        mqc->subs[i].state = SUB_STATE_UNSUB;
+        sub_rebuild(mqc);
+    }
+    RTOS_MUTEX_PUT(&mqc->sub_lock);
+
+    if (i < 0)
+    {
+        return -ENOENT;
+    }
+    client_wake(mqc);
+    return 0;
+}
+
+/******************************************************************************
+    [docimport MqttClient_readPayload]
+*//**
+    @brief Reads the payload of the PUBLISH being delivered. Only valid
+    inside a MqttClient_SubCb. Reads straight from the socket into buf unless
+    the payload was buffered for overlapping subscriptions.
+    @param[in] mqc  Pointer to MqttClient instance.
+    @param[out] buf  Destination.
+    @param[in] len  Size of buf.
+    @return Returns the number of bytes read, 0 at the end of the payload or
+    negative error.
+******************************************************************************/
+int
+MqttClient_readPayload(MqttClient *mqc, void *buf, uint32_t len)
+{
+    int ret;
+
+    if (mqc->rx_buffered > 0)
+    {
+        len = MIN(len, mqc->rx_buffered - mqc->rx_cursor);
+        memcpy(buf, &mqc->publish_rx_buffer[mqc->rx_cursor], len);
+        mqc->rx_cursor += len;
+        return len;
+    }
+
+    if (mqc->rx_left == 0)
     {
-        LOG_WRN("Not connected, ignoring publish.");
         return 0;
     }
 
-    param.message.topic.qos        = tp->topic.qos;
-    param.message.topic.topic.utf8 = tp->topic.topic.utf8;
-    param.message.topic.topic.size = tp->topic.topic.size;
-    param.message.payload.data     = payload;
-    param.message.payload.len      = payload_len;
-    param.message_id               = tp->msg_id;
-    param.dup_flag                 = 0;
-    param.retain_flag              = 0;
-    tp->msg_id++;
+    ret = mqtt_read_publish_payload_blocking(&mqc->mclient, buf,
+        MIN(len, mqc->rx_left));
+    if (ret > 0)
+    {
+        mqc->rx_left -= ret;
+    }
+    return ret;
+}
 
-    return mqtt_publish(&mqc->mclient, &param);
+/******************************************************************************
+    [docimport MqttClient_stop]
+*//**
+    @brief Disconnects from the broker and stops the client thread.
+    @param[in] mqc  Pointer to MqttClient instance.
+******************************************************************************/
+void
+MqttClient_stop(MqttClient *mqc)
+{
+    atomic_set(&mqc->stop, 1);
+    client_wake(mqc);
 }
 
 /******************************************************************************
@@ -365,14 +1421,23 @@ MqttClient_connect(MqttClient *mqc)
     if (ret != 0)
     {
         LOG_ERR("mqtt_connect: %d", ret);
+        return ret;
     }
 
     /*  On successfull connect, create file descriptors and wait for reply from
         server. */
-    mqc->fds[0].fd     = client->transport.tcp.sock;
-    mqc->fds[0].events = ZSOCK_POLLIN;
+    mqc->fds[POLL_IDX_SOCK].fd     = client->transport.tcp.sock;
+    mqc->fds[POLL_IDX_SOCK].events = ZSOCK_POLLIN;
 
-    return wait_poll_input(mqc);
+    wait_poll_input(mqc, 1, mqc->poll_timeout_ms);
+    if (!mqc->connected)
+    {
+        /* No CONNACK or refused: close the socket for the next attempt. */
+        mqtt_abort(client);
+        return -ECONNREFUSED;
+    }
+
+    return 0;
 }
 
 /******************************************************************************
@@ -391,8 +1456,57 @@ MqttClient_init(MqttClient *mqc, char *client_id)
     
     LOG_INF("Initializing client: %s", client_id);
     mqc->connected = false;
-    mqc->publish_rx_ready = false;
+    Backoff_init(&mqc->reconnect,
+        MQTTCLIENT_RECONNECT_BASE_MS, MQTTCLIENT_RECONNECT_MAX_MS);
+    mqc->rx_left = 0;
+    mqc->rx_buffered = 0;
+    memset(mqc->subs, 0, sizeof(mqc->subs));
+    MqttClientSub_trieInit(&mqc->sub_trie);
+    RTOS_MUTEX_INIT(&mqc->sub_lock);
     mqc->poll_timeout_ms = MQTTCLIENT_POLL_TIMEOUT_MS;
+    mqc->pub_sent = 0;
+    mqc->pub_errors = 0;
+    mqc->pub_acked = 0;
+    mqc->pub_retransmits = 0;
+    mqc->pub_timeouts = 0;
+    mqc->inflight_count = 0;
+    mqc->last_msg_id = 0;
+    atomic_clear(&mqc->pub_dropped);
+
+    /* Wakeup fd, polled with the socket by the client thread. */
+    atomic_clear(&mqc->stop);
+    mqc->wake_fd = eventfd(0, EFD_NONBLOCK);
+    if (mqc->wake_fd < 0)
+    {
+        LOG_ERR("Error creating eventfd.");
+        return -ENOMEM;
+    }
+    mqc->fds[POLL_IDX_WAKE].fd     = mqc->wake_fd;
+    mqc->fds[POLL_IDX_WAKE].events = ZSOCK_POLLIN;
+
+    /* Publish queue. */
+    k_fifo_init(&mqc->pubq);
+    rc = k_mem_slab_init(&mqc->pubq_slab, mqc->pubq_slab_buf,
+        sizeof(MqttClient_PubEntry), MQTTCLIENT_PUBQ_DEPTH);
+    if (rc < 0)
+    {
+        LOG_ERR("Failed creating publish queue (%d)", rc);
+        return rc;
+    }
+
+#if defined(CONFIG_MQTTCLIENT_STORE)
+    /* Store-and-forward ring, reloaded from settings if mirrored. */
+    mqc->replay_next_ms = 0;
+    snprintf(mqc->store_key, sizeof(mqc->store_key), "mqttsf/%08x",
+        store_key_hash(client_id));
+    rc = MqttClientStore_init(&mqc->store,
+        IS_ENABLED(CONFIG_MQTTCLIENT_STORE_SETTINGS) ? mqc->store_key : NULL);
+    if (rc < 0)
+    {
+        LOG_ERR("Store reload failed (%d), using RAM only.", rc);
+        MqttClientStore_init(&mqc->store, NULL);
+    }
+#endif
 
     /* Init the Zephyr mqtt_client object. */
     mqtt_client_init(client);
@@ -0,0 +1,330 @@
+/*******************************************************************************
+ *  @file: MqttClientStore.c
+ *
+ *  @brief: Store-and-forward ring for MqttClient. Holds publishes made while
+ *  the broker is unreachable so they can be replayed in order on reconnect.
+ *  Records are fixed size slots in RAM, optionally mirrored one settings key
+ *  per record so they survive a reboot.
+*******************************************************************************/
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+
+#include <zephyr/kernel.h>
+#if defined(CONFIG_MQTTCLIENT_STORE_SETTINGS)
+#include <zephyr/settings/settings.h>
+#endif
+#include "MqttClientStore.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_DECLARE(MqttClient, CONFIG_MQTTCLIENT_LOG_LEVEL);
+
+/** @brief Persisted bytes of a record: everything up to the payload data. */
+#define REC_HDR_SIZE        offsetof(MqttClientStore_Rec, payload)
+#define REC_SIZE(rec)       (REC_HDR_SIZE + (rec)->payload_len)
+
+/** @brief Room for "<key>/<8 hex digits>". */
+#define KEY_BUF_SIZE        (SETTINGS_MAX_NAME_LEN + 1)
+
+/** @brief Index of the n'th record from the head. */
+#define rec_idx(st, n)      (((st)->head + (n)) % MQTTCLIENTSTORE_DEPTH)
+
+#if defined(CONFIG_MQTTCLIENT_STORE_SETTINGS)
+/******************************************************************************
+    rec_key
+*//**
+    @brief Builds the settings key for a record.
+******************************************************************************/
+static void
+rec_key(MqttClientStore *st, uint32_t seq, char *buf)
+{
+    snprintf(buf, KEY_BUF_SIZE, "%s/%08x", st->key, seq);
+}
+
+/******************************************************************************
+    rec_save
+*//**
+    @brief Mirrors a record to settings.
+******************************************************************************/
+static void
+rec_save(MqttClientStore *st, MqttClientStore_Rec *rec)
+{
+    char key[KEY_BUF_SIZE];
+    int rc;
+
+    if (st->key == NULL)
+    {
+        return;
+    }
+
+    rec_key(st, rec->seq, key);
+    rc = settings_save_one(key, rec, REC_SIZE(rec));
+    if (rc < 0)
+    {
+        LOG_ERR("settings_save_one %s error: %d", key, rc);
+    }
+}
+
+/******************************************************************************
+    rec_delete
+*//**
+    @brief Removes a record from settings.
+******************************************************************************/
+static void
+rec_delete(MqttClientStore *st, uint32_t seq)
+{
+    char key[KEY_BUF_SIZE];
+    int rc;
+
+    if (st->key == NULL)
+    {
+        return;
+    }
+
+    rec_key(st, seq, key);
+    rc = settings_delete(key);
+    if (rc < 0)
+    {
+        LOG_ERR("settings_delete %s error: %d", key, rc);
+    }
+}
+
+/******************************************************************************
+    load_cb
+*//**
+    @brief settings_load_subtree_direct callback, one call per stored record.
+    Records load in no particular order; when there are more than fit, the
+    oldest are deleted.
+******************************************************************************/
+static int
+load_cb(
+    const char *key,
+    size_t len,
+    settings_read_cb read_cb,
+    void *cb_arg,
+    void *param)
+{
+    MqttClientStore *st = (MqttClientStore *)param;
+    MqttClientStore_Rec rec;
+    uint32_t seq;
+    uint32_t i;
+    uint32_t oldest = 0;
+    ssize_t num;
+
+    seq = strtoul(key, NULL, 16);
+
+    /* Validate before anything is evicted for it. */
+    num = read_cb(cb_arg, &rec, MIN(len, sizeof(rec)));
+    if (num < (ssize_t)REC_HDR_SIZE || rec.seq != seq ||
+        rec.topic_len > sizeof(rec.topic) ||
+        rec.payload_len > sizeof(rec.payload) || num != REC_SIZE(&rec))
+    {
+        LOG_WRN("Dropping invalid stored record %s.", key);
+        rec_delete(st, seq);
+        return 0;
+    }
+    rec.done_cb  = NULL;
+    rec.done_arg = NULL;
+
+    if (st->count == MQTTCLIENTSTORE_DEPTH)
+    {
+        /* Full: replace the oldest record if this one is newer. */
+        for (i = 1; i < st->count; i++)
+        {
+            if (st->recs[i].seq < st->recs[oldest].seq)
+            {
+                oldest = i;
+            }
+        }
+        if (seq < st->recs[oldest].seq)
+        {
+            rec_delete(st, seq);
+            st->dropped++;
+            return 0;
+        }
+        rec_delete(st, st->recs[oldest].seq);
+        st->dropped++;
+        st->count--;
+        st->recs[oldest] = st->recs[st->count];
+    }
+
+    st->recs[st->count++] = rec;
+    if (seq >= st->next_seq)
+    {
+        st->next_seq = seq + 1;
+    }
+    return 0;
+}
+
+/******************************************************************************
+    load
+*//**
+    @brief Reloads records from settings and sorts them oldest first.
+******************************************************************************/
+static int
+load(MqttClientStore *st)
+{
+    MqttClientStore_Rec tmp;
+    int i;
+    int j;
+    int rc;
+
+    rc = settings_subsys_init();
+    if (rc < 0)
+    {
+        LOG_ERR("Settings init error: %d", rc);
+        return rc;
+    }
+
+    rc = settings_load_subtree_direct(st->key, load_cb, st);
+    if (rc < 0)
+    {
+        LOG_ERR("Loading stored publishes error: %d", rc);
+        return rc;
+    }
+
+    /* Insertion sort by seq, the depth is small. */
+    for (i = 1; i < st->count; i++)
+    {
+        tmp = st->recs[i];
+        for (j = i - 1; j >= 0 && st->recs[j].seq > tmp.seq; j--)
+        {
+            st->recs[j + 1] = st->recs[j];
+        }
+        st->recs[j + 1] = tmp;
+    }
+
+    if (st->count > 0)
+    {
+        LOG_INF("Loaded %u stored publishes.", st->count);
+    }
+    return 0;
+}
+#else
+#define rec_save(st, rec)
+#define rec_delete(st, seq)
+#endif
+
+/******************************************************************************
+    [docimport MqttClientStore_put]
+*//**
+    @brief Appends a publish, dropping the oldest record when full.
+    @param[in] st  Pointer to MqttClientStore instance.
+    @param[in] topic  Topic and QoS.
+    @param[in] payload  Payload data.
+    @param[in] payload_len  Payload length.
+    @param[in] done_cb  Completion callback kept with the record, may be NULL.
+    @param[in] done_arg  Callback argument.
+    @return Returns 0 on success, -EMSGSIZE if the topic or payload does not fit
+    a record.
+******************************************************************************/
+int
+MqttClientStore_put(
+    MqttClientStore *st,
+    const struct mqtt_topic *topic,
+    const uint8_t *payload,
+    uint32_t payload_len,
+    MqttClientStore_DoneCb done_cb,
+    void *done_arg)
+{
+    MqttClientStore_Rec *rec;
+
+    if (topic->topic.size > MQTTCLIENTSTORE_TOPIC_SIZE ||
+        payload_len > MQTTCLIENTSTORE_PAYLOAD_SIZE)
+    {
+        return -EMSGSIZE;
+    }
+
+    if (st->count == MQTTCLIENTSTORE_DEPTH)
+    {
+        MqttClientStore_pop(st);
+        st->dropped++;
+    }
+
+    rec = &st->recs[rec_idx(st, st->count)];
+    rec->seq         = st->next_seq++;
+    rec->qos         = topic->qos;
+    rec->topic_len   = topic->topic.size;
+    rec->payload_len = payload_len;
+    memcpy(rec->topic, topic->topic.utf8, rec->topic_len);
+    memcpy(rec->payload, payload, payload_len);
+    rec->done_cb     = done_cb;
+    rec->done_arg    = done_arg;
+    st->count++;
+    st->stored++;
+
+    rec_save(st, rec);
+    return 0;
+}
+
+/******************************************************************************
+    [docimport MqttClientStore_peek]
+*//**
+    @brief Returns the oldest record, NULL if empty.
+    @param[in] st  Pointer to MqttClientStore instance.
+******************************************************************************/
+MqttClientStore_Rec *
+MqttClientStore_peek(MqttClientStore *st)
+{
+    return (st->count > 0) ? &st->recs[st->head] : NULL;
+}
+
+/******************************************************************************
+    [docimport MqttClientStore_pop]
+*//**
+    @brief Removes the oldest record, e.g. once sent.
+    @param[in] st  Pointer to MqttClientStore instance.
+******************************************************************************/
+void
+MqttClientStore_pop(MqttClientStore *st)
+{
+    if (st->count == 0)
+    {
+        return;
+    }
+
+    rec_delete(st, st->recs[st->head].seq);
+    st->head = rec_idx(st, 1);
+    st->count--;
+}
+
+/******************************************************************************
+    [docimport MqttClientStore_init]
+*//**
+    @brief Initializes the store. With CONFIG_MQTTCLIENT_STORE_SETTINGS and a
+    key, records are mirrored to the settings (NVS) backend under
+    "<key>/<seq>" and records left from a previous run are reloaded.
+    @param[in] st  Pointer to MqttClientStore instance.
+    @param[in] key  Settings subtree, or NULL for RAM only.
+    @return Returns 0 on success, -ENAMETOOLONG if the key leaves no room for
+    the record names, negative error on settings failure.
+******************************************************************************/
+int
+MqttClientStore_init(MqttClientStore *st, const char *key)
+{
+    st->head     = 0;
+    st->count    = 0;
+    st->next_seq = 0;
+    st->key      = NULL;
+    st->stored   = 0;
+    st->replayed = 0;
+    st->dropped  = 0;
+
+#if defined(CONFIG_MQTTCLIENT_STORE_SETTINGS)
+    if (key != NULL)
+    {
+        /* "<key>/<8 hex digits>" must fit, a truncated key would collide. */
+        if (strlen(key) + 9 > SETTINGS_MAX_NAME_LEN)
+        {
+            LOG_ERR("Store key %s is too long.", key);
+            return -ENAMETOOLONG;
+        }
+        st->key = key;
+        return load(st);
+    }
+#else
+    ARG_UNUSED(key);
+#endif
+    return 0;
+}
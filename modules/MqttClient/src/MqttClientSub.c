@@ -0,0 +1,268 @@
+/*******************************************************************************
+ *  @file: MqttClientSub.c
+ *
+ *  @brief: Topic filter trie for MqttClient subscriptions. Each node is one
+ *  filter level, so matching a topic walks its levels once instead of testing
+ *  every filter. '+' and '#' are stored as ordinary levels and handled while
+ *  walking.
+*******************************************************************************/
+#include <string.h>
+#include <errno.h>
+
+#include "MqttClientSub.h"
+
+#define ROOT        0
+#define NONE        (-1)
+
+/** @brief Level is the single character c. */
+#define is_wild(n, c)   ((n)->len == 1 && (n)->level[0] == (c))
+
+/******************************************************************************
+    level_end
+*//**
+    @brief Returns the index of the '/' ending the level at pos, or len.
+******************************************************************************/
+static uint16_t
+level_end(const uint8_t *str, uint16_t len, uint16_t pos)
+{
+    while (pos < len && str[pos] != '/')
+    {
+        pos++;
+    }
+    return pos;
+}
+
+/******************************************************************************
+    emit
+*//**
+    @brief Reports a node's subscription, if any.
+******************************************************************************/
+static int
+emit(MqttClientSub_Node *node, MqttClientSub_MatchFn fn, void *arg)
+{
+    if (node->sub == NONE)
+    {
+        return 0;
+    }
+    fn(node->sub, arg);
+    return 1;
+}
+
+/******************************************************************************
+    match_level
+*//**
+    @brief Matches the topic level starting at pos against the children of
+    parent, recursing into the next level.
+******************************************************************************/
+static int
+match_level(
+    MqttClientSub_Trie *trie,
+    int16_t parent,
+    const uint8_t *topic,
+    uint16_t len,
+    uint16_t pos,
+    MqttClientSub_MatchFn fn,
+    void *arg)
+{
+    MqttClientSub_Node *node;
+    MqttClientSub_Node *hash;
+    uint16_t end = level_end(topic, len, pos);
+    bool last = (end == len);
+    /* Wildcards must not match topics beginning with '$'. */
+    bool no_wild = (pos == 0 && len > 0 && topic[0] == '$');
+    int16_t c;
+    int16_t h;
+    int count = 0;
+
+    for (c = trie->nodes[parent].child; c != NONE; c = node->sibling)
+    {
+        node = &trie->nodes[c];
+
+        if (is_wild(node, '#'))
+        {
+            if (!no_wild)
+            {
+                count += emit(node, fn, arg);
+            }
+            continue;
+        }
+
+        if (is_wild(node, '+'))
+        {
+            if (no_wild)
+            {
+                continue;
+            }
+        }
+        else if (node->len != end - pos ||
+            memcmp(node->level, &topic[pos], node->len) != 0)
+        {
+            continue;
+        }
+
+        if (!last)
+        {
+            count += match_level(trie, c, topic, len, end + 1, fn, arg);
+            continue;
+        }
+
+        count += emit(node, fn, arg);
+        /* "a/#" also matches "a". */
+        for (h = node->child; h != NONE; h = hash->sibling)
+        {
+            hash = &trie->nodes[h];
+            if (is_wild(hash, '#'))
+            {
+                count += emit(hash, fn, arg);
+            }
+        }
+    }
+
+    return count;
+}
+
+/******************************************************************************
+    [docimport MqttClientSub_filterValid]
+*//**
+    @brief Checks a topic filter: non-empty, '+' and '#' only as whole
+    levels and '#' only as the last level.
+    @param[in] filter  Topic filter.
+    @param[in] len  Filter length.
+******************************************************************************/
+bool
+MqttClientSub_filterValid(const uint8_t *filter, uint16_t len)
+{
+    uint16_t pos = 0;
+    uint16_t end;
+    uint16_t i;
+
+    if (len == 0)
+    {
+        return false;
+    }
+
+    while (pos <= len)
+    {
+        end = level_end(filter, len, pos);
+        for (i = pos; i < end; i++)
+        {
+            if ((filter[i] == '+' || filter[i] == '#') && end - pos != 1)
+            {
+                return false;
+            }
+            if (filter[i] == '#' && end != len)
+            {
+                return false;
+            }
+        }
+        pos = end + 1;
+    }
+    return true;
+}
+
+/******************************************************************************
+    [docimport MqttClientSub_trieInit]
+*//**
+    @brief Empties the trie.
+    @param[in] trie  Pointer to MqttClientSub_Trie instance.
+******************************************************************************/
+void
+MqttClientSub_trieInit(MqttClientSub_Trie *trie)
+{
+    trie->nodes[ROOT].level   = NULL;
+    trie->nodes[ROOT].len     = 0;
+    trie->nodes[ROOT].child   = NONE;
+    trie->nodes[ROOT].sibling = NONE;
+    trie->nodes[ROOT].sub     = NONE;
+    trie->used = 1;
+}
+
+/******************************************************************************
+    [docimport MqttClientSub_trieInsert]
+*//**
+    @brief Adds a (valid) topic filter.
+    @param[in] trie  Pointer to MqttClientSub_Trie instance.
+    @param[in] filter  Topic filter, referenced by the trie.
+    @param[in] len  Filter length.
+    @param[in] sub  Subscription index reported on match.
+    @return Returns 0 on success, -EEXIST if the filter is already present or
+    -ENOMEM when out of nodes.
+******************************************************************************/
+int
+MqttClientSub_trieInsert(
+    MqttClientSub_Trie *trie,
+    const uint8_t *filter,
+    uint16_t len,
+    int16_t sub)
+{
+    MqttClientSub_Node *node;
+    int16_t parent = ROOT;
+    int16_t c;
+    uint16_t pos = 0;
+    uint16_t end;
+
+    while (pos <= len)
+    {
+        end = level_end(filter, len, pos);
+
+        for (c = trie->nodes[parent].child; c != NONE; c = node->sibling)
+        {
+            node = &trie->nodes[c];
+            if (node->len == end - pos &&
+                memcmp(node->level, &filter[pos], node->len) == 0)
+            {
+                break;
+            }
+        }
+
+        if (c == NONE)
+        {
+            if (trie->used == MQTTCLIENTSUB_NODES)
+            {
+                return -ENOMEM;
+            }
+            c = trie->used++;
+            node = &trie->nodes[c];
+            node->level   = &filter[pos];
+            node->len     = end - pos;
+            node->child   = NONE;
+            node->sub     = NONE;
+            node->sibling = trie->nodes[parent].child;
+            trie->nodes[parent].child = c;
+        }
+
+        parent = c;
+        pos = end + 1;
+    }
+
+    if (trie->nodes[parent].sub != NONE)
+    {
+        return -EEXIST;
+    }
+    trie->nodes[parent].sub = sub;
+    return 0;
+}
+
+/******************************************************************************
+    [docimport MqttClientSub_trieMatch]
+*//**
+    @brief Finds the filters matching a topic name. Cost depends on the
+    number of topic levels and wildcard branches, not on the number of
+    subscriptions. Wildcards do not match a leading '$' level.
+    @param[in] trie  Pointer to MqttClientSub_Trie instance.
+    @param[in] topic  Topic name.
+    @param[in] len  Topic length.
+    @param[in] fn  Called with each matching subscription.
+    @param[in] arg  Argument for fn.
+    @return Returns the number of matches.
+******************************************************************************/
+int
+MqttClientSub_trieMatch(
+    MqttClientSub_Trie *trie,
+    const uint8_t *topic,
+    uint16_t len,
+    MqttClientSub_MatchFn fn,
+    void *arg)
+{
+    return match_level(trie, ROOT, topic, len, 0, fn, arg);
+}
@@ -6,6 +6,7 @@
 #ifndef RANDOM_H
 #define RANDOM_H
 
+#include <stdint.h>
 #include <zephyr/random/random.h>
 
 /** @brief Get a random number in the range 0 to 255. */
@@ -42,4 +43,69 @@
 /** @brief Fill buffer with random bytes. */
 #define RANDOM_FILL(buf, size)   sys_rand_get((void *)(buf), (size))
 
+/** @brief Fast pseudo random generator state (xorshift32). Not suitable for
+    anything security related: seed it from the entropy source with
+    RANDOM_FAST_SEED, then draw from it as often as needed at a few cycles per
+    number. Not thread safe, give each user its own state.
+*/
+typedef struct RandomFast
+{
+    uint32_t s;
+} RandomFast;
+
+/** @brief Seeds a fast generator from the entropy source. */
+static inline void
+RandomFast_seed(RandomFast *rf)
+{
+    /* xorshift never leaves an all zero state. */
+    do
+    {
+        rf->s = sys_rand32_get();
+    } while (rf->s == 0);
+}
+
+/** @brief Seeds a fast generator with a fixed seed, to repeat a sequence
+    (e.g. in tests). xorshift needs a non zero state. */
+static inline void
+RandomFast_seedWith(RandomFast *rf, uint32_t seed)
+{
+    rf->s = seed ? seed : 1;
+}
+
+/** @brief Returns the next number from a fast generator. */
+static inline uint32_t
+RandomFast_next(RandomFast *rf)
+{
+    uint32_t x = rf->s;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    rf->s = x;
+    return x;
+}
+
+/** @brief Seed a fast generator (see RandomFast). */
+#define RANDOM_FAST_SEED(rf)        RandomFast_seed((rf))
+
+/** @brief Seed a fast generator with a fixed seed (0 is taken as 1). */
+#define RANDOM_FAST_SEED_WITH(rf, seed)     RandomFast_seedWith((rf), (seed))
+
+/** @brief Get a fast random number in the range 0 to 2**32-1. */
+#define RANDOM_FAST_U32(rf)         RandomFast_next((rf))
+
+/** @brief Get a fast random number in the range 0 to 2**16-1. */
+#define RANDOM_FAST_U16(rf)         ((uint16_t)(RandomFast_next((rf)) >> 16))
+
+/** @brief Get a fast random number in the range 0 to 255. */
+#define RANDOM_FAST_U8(rf)          ((uint8_t)(RandomFast_next((rf)) >> 24))
+
+/** @brief Get a fast random number in the range 0 to n-1. */
+#define RANDOM_FAST_UINT(rf, type, n)\
+    ((type)(((uint64_t)RandomFast_next((rf)) * (n)) >> 32))
+
+/** @brief Get a fast random number between left and right. */
+#define RANDOM_FAST_URANGE(rf, type, left, right)\
+    ((type)(RANDOM_FAST_UINT(rf, type, (right) - (left) + 1) + (left)))
+
 #endif
@@ -213,7 +213,8 @@ getnexttraceram(void *call_frame, void *reply_frame, StatusEnum *status)
         return;
     }
 
-    int num_read = TraceRam_read(reply->data.bytes, call->max_size);
+    int num_read = TraceRam_read(reply->data.bytes,
+        MIN(call->max_size, sizeof(reply->data.bytes)));
     if (num_read <= 0)
     {
         LOG_ERR("TraceRam error: %d", num_read);
@@ -7,6 +7,7 @@
 #define TCPECHO_H
 
 #include <stdint.h>
+#include <zephyr/sys/atomic.h>
 #include "TcpServer.h"
 
 /** @brief TcpEcho object.
@@ -15,8 +16,8 @@ typedef struct TcpEcho
 {
     /** @brief Server instance. */
     TcpServer tcp_svr;
-    /** @brief Total byte count. */
-    uint32_t byte_count;
+    /** @brief Total byte count, updated from the connection workers. */
+    atomic_t byte_count;
     
 } TcpEcho;
 
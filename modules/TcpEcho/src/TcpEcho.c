@@ -27,10 +27,9 @@ echo_callback(void *server, int sock, uint8_t *data, uint16_t len, int *finished
     /** @brief TcpEcho type masquerades as a TcpServer. */
     TcpEcho *echo_server = (TcpEcho *)server;
     int num = TcpSocket_write(sock, data, len);
-    echo_server->byte_count += num;
+    atomic_val_t total = atomic_add(&echo_server->byte_count, num) + num;
     *finished = 1;
-    LOG_DBG("Echo'd %d bytes (total: %u).", num,
-        (unsigned int)echo_server->byte_count);
+    LOG_DBG("Echo'd %d bytes (total: %u).", num, (unsigned int)total);
 }
 
 /******************************************************************************
@@ -58,7 +57,7 @@ TcpEcho_init(
     char *name,
     uint8_t prio)
 {
-    echo->byte_count = 0;
+    atomic_clear(&echo->byte_count);
 
     /** @brief Initialize the TcpServer. */
     return TcpServer_init(
@@ -69,5 +68,6 @@ TcpEcho_init(
         stack_size,
         name,
         prio,
-        echo_callback);
+        echo_callback,
+        NULL);
 }
@@ -10,6 +10,9 @@
 #include "TcpServer.h"
 #include "ProtoRpc.h"
 #include "Cobs_frame.h"
+#if defined(CONFIG_TCPRPCSERVER_COMPRESS)
+#include "FrameCompress.h"
+#endif
 
 /** @brief TcpRpcServer object.
 */
@@ -19,8 +22,14 @@ typedef struct TcpRpcServer
     TcpServer tcp;
     /** @brief Pointer to the ProtoRpc instance. */
     ProtoRpc *rpc;
-    /** @brief Stream de-framer. */
-    Cobs_Deframer deframer;
+    /** @brief Stream de-framer per connection slot. */
+    Cobs_Deframer deframer[TCPSERVER_NUM_CONN];
+#if defined(CONFIG_TCPRPCSERVER_COMPRESS)
+    /** @brief Compression negotiation per connection slot. */
+    FrameCompress_Link compress[TCPSERVER_NUM_CONN];
+#endif
+    /** @brief Serializes RPC execution and the shared msg buffers. */
+    RTOS_MUTEX lock;
     
 } TcpRpcServer;
 
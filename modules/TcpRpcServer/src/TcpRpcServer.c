@@ -4,6 +4,7 @@
  *  @brief: Library for TCP-based Rpc server.
 *******************************************************************************/
 #include <zephyr/logging/log.h>
+#include "CheckCond.h"
 #include "TcpRpcServer.h"
 #include "TcpSocket.h"
 #include "TcpServer.h"
@@ -15,6 +16,13 @@ LOG_MODULE_REGISTER(TcpRpcServer, CONFIG_TCPRPCSERVER_LOG_LEVEL);
 
 #define TCP_BUFFER_SIZE     4*1024
 
+/** @brief Socket options for RPC connections. */
+#if CONFIG_TCPRPCSERVER_LOW_LATENCY
+static const TcpSocket_Opts rpc_sock_opts = TCPSOCKET_OPTS_LOW_LATENCY_RPC;
+#else
+static const TcpSocket_Opts rpc_sock_opts = TCPSOCKET_OPTS_DEFAULT;
+#endif
+
 /** @brief Static buffers used for data. */
 /* Buffer used to hold received socket data */
 static uint8_t tcp_rx_buf[TCP_BUFFER_SIZE];
@@ -25,6 +33,14 @@ static uint8_t rpc_rcv_msg[PROTORPC_MSG_MAX_SIZE];
 /* Buffer to hold the protobuf-packed rpc reply message. */
 static uint8_t rpc_reply_msg[PROTORPC_MSG_MAX_SIZE];
 
+#if defined(CONFIG_TCPRPCSERVER_COMPRESS)
+/* Deframed rx message and encoded reply, with the FrameCompress header. */
+static uint8_t rpc_rcv_wire[FRAMECOMPRESS_MAX_SIZE(PROTORPC_MSG_MAX_SIZE)];
+static uint8_t rpc_reply_wire[FRAMECOMPRESS_MAX_SIZE(PROTORPC_MSG_MAX_SIZE)];
+/* Compressor scratch, shared under the server lock. */
+static FrameCompress_Work compress_work;
+#endif
+
 /******************************************************************************
     rpc_callback
 *//**
@@ -41,58 +57,109 @@ rpc_callback(void *server, int sock, uint8_t *data, uint16_t len, int *finished)
     /** @brief TcpRpcServer type masquerades as a TcpServer. */
     TcpRpcServer *tcprpc_server = (TcpRpcServer *)server;
     ProtoRpc *rpc               = tcprpc_server->rpc;
-    Cobs_Deframer *deframer     = &tcprpc_server->deframer;
+    int conn_id                 = TcpServer_connId(&tcprpc_server->tcp, sock);
+    Cobs_Deframer *deframer;
+    uint8_t *reply_wire = rpc_reply_msg;
     int raw_msg_size;
     int num_sent;
     uint32_t reply_size;
 
     *finished = 1;
 
-    if (len > 0)
+    CHECK_COND_VOID_RETURN_MSG(conn_id < 0, "Unknown connection.");
+    deframer = &tcprpc_server->deframer[conn_id];
+
+    if (len == 0)
+    {
+        /* Peer closed, drop any partial frame before the slot is reused. */
+        Cobs_deframer_reset(deframer);
+#if defined(CONFIG_TCPRPCSERVER_COMPRESS)
+        FrameCompress_linkInitDetect(&tcprpc_server->compress[conn_id]);
+#endif
+        return;
+    }
+
+    RTOS_MUTEX_GET(&tcprpc_server->lock);
+
+    /*  Attempt deframe of incoming stream. A positive raw_msg_size
+        indicates a new decoded message is available.
+    */
+#if defined(CONFIG_TCPRPCSERVER_COMPRESS)
+    raw_msg_size = Cobs_deframer(
+        deframer,
+        data,
+        len,
+        rpc_rcv_wire,
+        sizeof(rpc_rcv_wire));
+
+    if (raw_msg_size > 0)
     {
-        /*  Attempt deframe of incoming stream. A positive raw_msg_size
-            indicates a new decoded message is available.
-        */
-        raw_msg_size = Cobs_deframer(
-            deframer,
-            data,
-            len,
+        raw_msg_size = FrameCompress_decode(
+            &tcprpc_server->compress[conn_id],
+            rpc_rcv_wire,
+            raw_msg_size,
             rpc_rcv_msg,
             sizeof(rpc_rcv_msg));
+    }
+#else
+    raw_msg_size = Cobs_deframer(
+        deframer,
+        data,
+        len,
+        rpc_rcv_msg,
+        sizeof(rpc_rcv_msg));
+#endif
 
-        if (raw_msg_size)
-        {
-            LOG_HEXDUMP_DBG(rpc_rcv_msg, raw_msg_size, "Deframed raw message.");
+    if (raw_msg_size > 0)
+    {
+        LOG_HEXDUMP_DBG(rpc_rcv_msg, raw_msg_size, "Deframed raw message.");
 
-            ProtoRpc_exec(
-                rpc,
-                rpc_rcv_msg,
-                raw_msg_size,
+        ProtoRpc_exec(
+            rpc,
+            rpc_rcv_msg,
+            raw_msg_size,
+            rpc_reply_msg,
+            sizeof(rpc_reply_msg),
+            &reply_size);
+
+#if defined(CONFIG_TCPRPCSERVER_COMPRESS)
+        if (reply_size > 0)
+        {
+            int wire_size = FrameCompress_encode(
+                &tcprpc_server->compress[conn_id],
+                &compress_work,
                 rpc_reply_msg,
-                sizeof(rpc_reply_msg),
-                &reply_size);
+                reply_size,
+                rpc_reply_wire,
+                sizeof(rpc_reply_wire));
+
+            reply_wire = rpc_reply_wire;
+            reply_size = (wire_size > 0) ? (uint32_t)wire_size : 0;
+        }
+#endif
+
+        if (reply_size > 0)
+        {
+            int framed_size = Cobs_framer(
+                reply_wire,
+                reply_size,
+                tcp_tx_buf,
+                sizeof(tcp_tx_buf));
 
-            if (reply_size > 0)
+            if (framed_size < 0)
             {
-                int framed_size = Cobs_framer(
-                    rpc_reply_msg,
-                    reply_size,
-                    tcp_tx_buf,
-                    sizeof(tcp_tx_buf));
-
-                if (framed_size < 0)
-                {
-                    LOG_ERR("Framer error detected in RPC reply.");
-                    return;
-                }
-
-                LOG_HEXDUMP_DBG(tcp_tx_buf, framed_size, "Framed Tx message.");
-
-                num_sent = TcpSocket_write(sock, tcp_tx_buf, framed_size);
-                LOG_DBG("Wrote rpc reply: %d bytes.", num_sent);
+                LOG_ERR("Framer error detected in RPC reply.");
+                RTOS_MUTEX_PUT(&tcprpc_server->lock);
+                return;
             }
+
+            LOG_HEXDUMP_DBG(tcp_tx_buf, framed_size, "Framed Tx message.");
+
+            num_sent = TcpSocket_write(sock, tcp_tx_buf, framed_size);
+            LOG_DBG("Wrote rpc reply: %d bytes.", num_sent);
         }
     }
+    RTOS_MUTEX_PUT(&tcprpc_server->lock);
 }
 
 /******************************************************************************
@@ -114,10 +181,21 @@ TcpRpcServer_init(
     uint16_t stack_size,
     uint8_t prio)
 {
+    int rc;
+    int i;
+
     server->rpc = rpc;
+    RTOS_MUTEX_INIT(&server->lock);
 
-    /** @brief Initialize the Deframer. */
-    Cobs_deframer_init(&server->deframer, sizeof(tcp_rx_buf));
+    /** @brief Initialize a Deframer per connection slot. */
+    for (i = 0; i < TCPSERVER_NUM_CONN; i++)
+    {
+        rc = Cobs_deframer_init(&server->deframer[i], sizeof(tcp_rx_buf));
+        CHECK_COND_RETURN(rc < 0, rc);
+#if defined(CONFIG_TCPRPCSERVER_COMPRESS)
+        FrameCompress_linkInitDetect(&server->compress[i]);
+#endif
+    }
 
     /** @brief Initialize the TcpServer. */
     return TcpServer_init(
@@ -128,5 +206,6 @@ TcpRpcServer_init(
         stack_size,
         "TCP Rpc",
         prio,
-        rpc_callback);
+        rpc_callback,
+        &rpc_sock_opts);
 }
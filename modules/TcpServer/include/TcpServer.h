@@ -10,6 +10,13 @@
 #include "RtosUtils.h"
 #include "TcpSocket.h"
 
+/** @brief Number of connection slots per server. */
+#if CONFIG_TCPSERVER_NONBLOCKING
+#define TCPSERVER_NUM_CONN      CONFIG_TCPSERVER_MAX_CONNECTIONS
+#else
+#define TCPSERVER_NUM_CONN      1
+#endif
+
 /******************************************************************************
     TcpServer_cb
 *//**
@@ -22,6 +29,10 @@
     @param[out] finished  Status:
     0 --> not finished, keep connection active
     1 --> finished, close connection.
+
+    A len of 0 indicates the peer closed its side. In non-blocking mode the
+    callback runs on a worker thread and may run concurrently for different
+    connections (never for the same connection).
 ******************************************************************************/
 typedef void
 TcpServer_cb(
@@ -49,6 +60,23 @@ typedef struct TcpTask
 
 } TcpTask;
 
+#if CONFIG_TCPSERVER_NONBLOCKING
+/** @brief Connection slot (non-blocking server).
+*/
+typedef struct TcpServer_Conn
+{
+    /** @brief Connected socket descriptor, -1 when the slot is free. */
+    int sock;
+    /** @brief Slot state (owned by poll task or a worker). */
+    atomic_t state;
+    /** @brief Peer has closed its side; no further reads. */
+    uint8_t read_done;
+    /** @brief Pointer to the connection rx buffer. */
+    uint8_t *data;
+
+} TcpServer_Conn;
+#endif
+
 typedef struct TcpServer
 {
     /** @brief TcpSocket object. */
@@ -60,10 +88,24 @@ typedef struct TcpServer
     uint16_t data_len;
     /** @brief User callback. */
     TcpServer_cb *cb;
+    /** @brief Socket options applied to accepted connections. */
+    TcpSocket_Opts opts;
 
     /** @brief Tcp task object. */
     TcpTask task;
 
+#if CONFIG_TCPSERVER_NONBLOCKING
+    /** @brief Connection slots. data_len is the per-connection length. */
+    TcpServer_Conn conns[TCPSERVER_NUM_CONN];
+    /** @brief Queue of ready slot indices handed to the workers. */
+    struct k_msgq ready_q;
+    uint8_t ready_q_buf[TCPSERVER_NUM_CONN];
+    /** @brief eventfd used by workers to wake the poll task. */
+    int wake_fd;
+    /** @brief Worker pool. */
+    TcpTask workers[CONFIG_TCPSERVER_NUM_WORKERS];
+#endif
+
 } TcpServer;
 
 
@@ -74,12 +116,17 @@ typedef struct TcpServer
     @param[in] server  Pointer to uninitialized TcpServer object.
     @param[in] port  Port number to use.
     @param[in] buf  Pointer to user-allocated buffer used for Rx. If NULL,
-    buffer will be dynamically allocated.
+    buffer will be dynamically allocated. In non-blocking mode the buffer is
+    split evenly into TCPSERVER_NUM_CONN per-connection buffers; when NULL,
+    each connection gets CONFIG_TCPSERVER_CONN_BUFFER_SIZE bytes and buf_len
+    is ignored.
     @param[in] buf_len  Length of the buffer.
     @param[in] task_stackSize  Size of the server task stack.
     @param[in] task_name  Name for the task.
     @param[in] task_prio  Task priority.
     @param[in] cb  User callback.
+    @param[in] opts  Socket options profile for accepted connections (copied).
+    NULL selects TCPSOCKET_OPTS_DEFAULT.
     @return Returns 0 on success, negative on error.
 ******************************************************************************/
 int
@@ -91,5 +138,19 @@ TcpServer_init(
     uint16_t task_stackSize,
     char *task_name,
     uint8_t task_prio,
-    TcpServer_cb *cb);
+    TcpServer_cb *cb,
+    const TcpSocket_Opts *opts);
+
+/******************************************************************************
+    [docexport TcpServer_connId]
+*//**
+    @brief Gets the connection slot index for a socket passed to the callback.
+    Lets callbacks keep per-connection state in an array of
+    TCPSERVER_NUM_CONN entries.
+    @param[in] server  Pointer to the TcpServer object.
+    @param[in] sock  Connected socket passed to the callback.
+    @return Returns the slot index (0 in blocking mode), negative if unknown.
+******************************************************************************/
+int
+TcpServer_connId(TcpServer *server, int sock);
 #endif
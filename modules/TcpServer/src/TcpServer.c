@@ -3,8 +3,12 @@
  *  
  *  @brief: Library implementing a tcp server.
 *******************************************************************************/
+#include <stdio.h>
 #include <string.h>
 #include <zephyr/logging/log.h>
+#if CONFIG_TCPSERVER_NONBLOCKING
+#include <zephyr/posix/sys/eventfd.h>
+#endif
 
 #include "CheckCond.h"
 #include "TcpServer.h"
@@ -12,10 +16,390 @@
 /** @brief Initialize the logging module. */
 LOG_MODULE_REGISTER(TcpServer, CONFIG_TCPSERVER_LOG_LEVEL);
 
-#define KEEPALIVE_IDLE          (int)5
-#define KEEPALIVE_COUNT         (int)3
-#define KEEPALIVE_INTERVAL      (int)5
+#if CONFIG_TCPSERVER_NONBLOCKING
+
+/** @brief Connection slot states. */
+enum {
+    CONN_FREE = 0,
+    /* Connected, in the poll set (owned by the server task). */
+    CONN_IDLE,
+    /* Dispatched to a worker (owned by the worker). */
+    CONN_BUSY
+};
+
+/** @brief Interval between callback calls once the peer has closed. */
+#define DRAIN_INTERVAL_MS       k_ticks_to_ms_ceil32(1)
+
+/** @brief Fixed poll set entries, connections follow. */
+#define POLL_IDX_LISTEN         0
+#define POLL_IDX_WAKE           1
+#define POLL_IDX_CONN           2
+
+/******************************************************************************
+    conn_close
+*//**
+    @brief Closes a connection and frees its slot. The slot lets go of the fd
+    before it is closed: once closed, the fd number can be handed to a new
+    connection in another slot, and TcpServer_connId must not find it here.
+******************************************************************************/
+static void
+conn_close(TcpServer_Conn *conn)
+{
+    int sock = conn->sock;
+
+    LOG_DBG("Closing socket connection.");
+    conn->sock = -1;
+    TcpSocket_shutdown(sock, 2);
+    TcpSocket_close(sock);
+    conn->read_done = 0;
+    atomic_set(&conn->state, CONN_FREE);
+}
+
+/******************************************************************************
+    conn_service
+*//**
+    @brief Services a ready connection. Drains the socket until it would
+    block, calling the user callback for each chunk read. Once the peer has
+    closed, the callback is called once per drain interval until finished.
+    @return Returns 1 if the connection should be closed, 0 otherwise.
+******************************************************************************/
+static int
+conn_service(TcpServer *server, TcpServer_Conn *conn)
+{
+    int callback_done = 0;
+
+    while (1)
+    {
+        int num_read = 0;
+
+        if (!conn->read_done)
+        {
+            num_read = TcpSocket_read(conn->sock, conn->data, server->data_len);
+            if (num_read < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                {
+                    /* Drained, hand back to the poll set. */
+                    return 0;
+                }
+                LOG_ERR("Closing socket due to read error.");
+                /* Let the callback drop its connection state, as on close. */
+                server->cb((void *)server, conn->sock, conn->data, 0,
+                    &callback_done);
+                return 1;
+            }
+            else if (num_read == 0)
+            {
+                conn->read_done = 1;
+            }
+        }
+
+        /** @brief Call callback to allow rx and tx on socket. */
+        server->cb(
+            (void *)server,
+            conn->sock,
+            conn->data,
+            (uint16_t)num_read,
+            &callback_done);
+
+        if (conn->read_done)
+        {
+            return callback_done;
+        }
+    }
+}
+
+/******************************************************************************
+    conn_accept
+*//**
+    @brief Accepts pending connections into free slots until the backlog is
+    empty or all slots are in use.
+******************************************************************************/
+static void
+conn_accept(TcpServer *server)
+{
+    TcpSocket *tcp = &server->tcpsock;
+    int i;
+
+    for (i = 0; i < TCPSERVER_NUM_CONN; i++)
+    {
+        TcpServer_Conn *conn = &server->conns[i];
+        int sock;
+
+        if (atomic_get(&conn->state) != CONN_FREE)
+        {
+            continue;
+        }
+
+        sock = TcpSocket_accept(tcp, &server->opts);
+        if (sock < 0)
+        {
+            /* Backlog empty (EAGAIN) or accept error (already logged). */
+            return;
+        }
+
+        if (TcpSocket_setNonblocking(sock) != 0)
+        {
+            TcpSocket_close(sock);
+            continue;
+        }
+
+        conn->sock = sock;
+        conn->read_done = 0;
+        atomic_set(&conn->state, CONN_IDLE);
+        LOG_DBG("Connection %d using slot %d: %s", sock, i, server->task.name);
+    }
+}
+
+/******************************************************************************
+    tcp_worker_task
+*//**
+    @brief Worker pool task. Services connections dispatched by the server
+    task, then wakes the server task to return the slot to the poll set.
+******************************************************************************/
+static void
+tcp_worker_task(void *p, void *arg1, void *arg2)
+{
+    TcpServer *server = (TcpServer *)p;
+
+    (void)arg1;
+    (void)arg2;
+
+    while (1)
+    {
+        TcpServer_Conn *conn;
+        uint8_t idx;
+
+        k_msgq_get(&server->ready_q, &idx, K_FOREVER);
+        conn = &server->conns[idx];
+
+        if (conn_service(server, conn))
+        {
+            conn_close(conn);
+        }
+        else
+        {
+            atomic_set(&conn->state, CONN_IDLE);
+        }
+
+        eventfd_write(server->wake_fd, 1);
+    }
+}
 
+/******************************************************************************
+    tcp_server_task
+*//**
+    @brief Main task loop for the non-blocking Tcp server. Polls the listener
+    and all idle connections, dispatching ready ones to the worker pool.
+******************************************************************************/
+static void
+tcp_server_task(void *p, void *arg1, void *arg2)
+{
+    TcpServer *server = (TcpServer *)p;
+    TcpSocket *tcp = &server->tcpsock;
+    TcpTask *task = &server->task;
+    struct zsock_pollfd fds[POLL_IDX_CONN + TCPSERVER_NUM_CONN];
+    uint8_t slot[TCPSERVER_NUM_CONN];
+    int64_t drain_at = 0;
+
+    (void)arg1;
+    (void)arg2;
+
+    LOG_INF("Starting TcpServer Task (non-blocking): %s.", task->name);
+
+    /** @brief Listen on port. */
+    if (TcpSocket_listen(tcp, CONFIG_TCPSERVER_LISTEN_BACKLOG) != 0 ||
+        TcpSocket_setNonblocking(tcp->sock) != 0)
+    {
+        goto cleanup;
+    }
+
+    fds[POLL_IDX_WAKE].fd = server->wake_fd;
+    fds[POLL_IDX_WAKE].events = ZSOCK_POLLIN;
+
+    while (1)
+    {
+        int nfds = POLL_IDX_CONN;
+        int free_slots = 0;
+        int draining = 0;
+        int timeout = -1;
+        int ready;
+        int i;
+
+        for (i = 0; i < TCPSERVER_NUM_CONN; i++)
+        {
+            TcpServer_Conn *conn = &server->conns[i];
+            int state = atomic_get(&conn->state);
+
+            if (state == CONN_FREE)
+            {
+                free_slots++;
+            }
+            else if (state == CONN_IDLE && conn->read_done)
+            {
+                /*  The peer has closed but the callback is not finished.
+                    Nothing will arrive to poll for, so it is re-run on a
+                    timer below.
+                */
+                draining++;
+            }
+            else if (state == CONN_IDLE)
+            {
+                fds[nfds].fd = conn->sock;
+                fds[nfds].events = ZSOCK_POLLIN;
+                slot[nfds - POLL_IDX_CONN] = (uint8_t)i;
+                nfds++;
+            }
+        }
+
+        if (draining > 0)
+        {
+            timeout = (int)MAX(drain_at - k_uptime_get(), 0);
+        }
+
+        /*  Leave new connections in the listen backlog while all slots are in
+            use (negative fds are ignored by poll).
+        */
+        fds[POLL_IDX_LISTEN].fd = (free_slots > 0) ? tcp->sock : -1;
+        fds[POLL_IDX_LISTEN].events = ZSOCK_POLLIN;
+
+        ready = zsock_poll(fds, nfds, timeout);
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            LOG_ERR("Exiting task %s due to poll error: errno %d",
+                task->name, errno);
+            break;
+        }
+
+        if (fds[POLL_IDX_WAKE].revents & ZSOCK_POLLIN)
+        {
+            eventfd_t val;
+            eventfd_read(server->wake_fd, &val);
+        }
+
+        /** @brief Dispatch ready connections to the worker pool. */
+        for (i = POLL_IDX_CONN; i < nfds; i++)
+        {
+            uint8_t idx = slot[i - POLL_IDX_CONN];
+
+            if (fds[i].revents == 0)
+            {
+                continue;
+            }
+            atomic_set(&server->conns[idx].state, CONN_BUSY);
+            /* Queue depth equals the slot count, so this cannot fail. */
+            k_msgq_put(&server->ready_q, &idx, K_NO_WAIT);
+        }
+
+        /*  Re-run callbacks of closed peers at most once per interval (the
+            blocking server sleeps a tick), however often workers wake us.
+        */
+        if (draining > 0 && k_uptime_get() >= drain_at)
+        {
+            drain_at = k_uptime_get() + DRAIN_INTERVAL_MS;
+            for (i = 0; i < TCPSERVER_NUM_CONN; i++)
+            {
+                TcpServer_Conn *conn = &server->conns[i];
+                uint8_t idx = (uint8_t)i;
+
+                if (conn->read_done && atomic_get(&conn->state) == CONN_IDLE)
+                {
+                    atomic_set(&conn->state, CONN_BUSY);
+                    k_msgq_put(&server->ready_q, &idx, K_NO_WAIT);
+                }
+            }
+        }
+
+        if (fds[POLL_IDX_LISTEN].revents & ZSOCK_POLLIN)
+        {
+            conn_accept(server);
+        }
+    }
+
+cleanup:
+    TcpSocket_close(tcp->sock);
+}
+
+/******************************************************************************
+    nonblocking_init
+*//**
+    @brief Sets up connection slots, the ready queue, the wakeup eventfd and
+    the worker pool.
+    @return Returns 0 on success, negative on error.
+******************************************************************************/
+static int
+nonblocking_init(TcpServer *server, uint8_t *buf, uint32_t buf_len)
+{
+    TcpTask *task = &server->task;
+    uint32_t conn_len;
+    int rc;
+    int i;
+
+    if (buf)
+    {
+        conn_len = buf_len / TCPSERVER_NUM_CONN;
+    }
+    else
+    {
+        conn_len = CONFIG_TCPSERVER_CONN_BUFFER_SIZE;
+        buf = (uint8_t *)malloc(conn_len * TCPSERVER_NUM_CONN);
+        CHECK_COND_RETURN_MSG(!buf, -1, "Error allocating memory.");
+    }
+    conn_len = MIN(conn_len, UINT16_MAX);
+    CHECK_COND_RETURN_MSG(conn_len == 0, -1, "Rx buffer too small.");
+
+    server->data = buf;
+    server->data_len = (uint16_t)conn_len;
+
+    for (i = 0; i < TCPSERVER_NUM_CONN; i++)
+    {
+        TcpServer_Conn *conn = &server->conns[i];
+        conn->sock = -1;
+        conn->read_done = 0;
+        conn->data = buf + i*conn_len;
+        atomic_set(&conn->state, CONN_FREE);
+    }
+
+    k_msgq_init(
+        &server->ready_q,
+        (char *)server->ready_q_buf,
+        sizeof(uint8_t),
+        TCPSERVER_NUM_CONN);
+
+    server->wake_fd = eventfd(0, EFD_NONBLOCK);
+    CHECK_COND_RETURN_MSG(server->wake_fd < 0, -1, "Error creating eventfd.");
+
+    for (i = 0; i < CONFIG_TCPSERVER_NUM_WORKERS; i++)
+    {
+        TcpTask *worker = &server->workers[i];
+
+        worker->stackSize = CONFIG_TCPSERVER_WORKER_STACK_SIZE;
+        worker->prio = task->prio;
+        snprintf(worker->name, sizeof(worker->name), "%.12s.%d", task->name, i);
+
+        rc = RTOS_TASK_CREATE_DYNAMIC(
+            &worker->handle,
+            tcp_worker_task,
+            worker->name,
+            worker->stack,
+            worker->stackSize,
+            (void *)server,
+            worker->prio);
+        if (rc < 0)
+        {
+            LOG_ERR("Failed creating tcp worker task (%d)", rc);
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+#else
 /******************************************************************************
     tcp_server_task
 *//**
@@ -34,7 +418,7 @@ tcp_server_task(void *p, void *arg1, void *arg2)
     LOG_INF("Starting TcpServer Task: %s.", task->name);
 
     /** @brief Listen on port. */
-    if (TcpSocket_listen(tcp, 2) != 0)
+    if (TcpSocket_listen(tcp, CONFIG_TCPSERVER_LISTEN_BACKLOG) != 0)
     {
         goto cleanup;
     }
@@ -47,10 +431,7 @@ tcp_server_task(void *p, void *arg1, void *arg2)
             (unsigned int)tcp->port, task->name);
 
         /** @brief Accept incoming connections. */
-        sock = TcpSocket_accept(tcp,
-                                KEEPALIVE_IDLE,
-                                KEEPALIVE_INTERVAL,
-                                KEEPALIVE_COUNT);
+        sock = TcpSocket_accept(tcp, &server->opts);
         if (sock < 0)
         {
             int err = errno;
@@ -82,6 +463,9 @@ tcp_server_task(void *p, void *arg1, void *arg2)
                 if (num_read < 0)
                 {
                     LOG_ERR("Closing socket due to read error.");
+                    /* Let the callback drop its connection state. */
+                    server->cb((void *)server, sock, server->data, 0,
+                        &callback_done);
                     break;
                 }
                 else if (num_read == 0)
@@ -126,6 +510,7 @@ tcp_server_task(void *p, void *arg1, void *arg2)
 cleanup:
     TcpSocket_close(tcp->sock);
 }
+#endif
 
 /******************************************************************************
     [docimport TcpServer_init]
@@ -134,12 +519,17 @@ cleanup:
     @param[in] server  Pointer to uninitialized TcpServer object.
     @param[in] port  Port number to use.
     @param[in] buf  Pointer to user-allocated buffer used for Rx. If NULL,
-    buffer will be dynamically allocated.
+    buffer will be dynamically allocated. In non-blocking mode the buffer is
+    split evenly into TCPSERVER_NUM_CONN per-connection buffers; when NULL,
+    each connection gets CONFIG_TCPSERVER_CONN_BUFFER_SIZE bytes and buf_len
+    is ignored.
     @param[in] buf_len  Length of the buffer.
     @param[in] task_stackSize  Size of the server task stack.
     @param[in] task_name  Name for the task.
     @param[in] task_prio  Task priority.
     @param[in] cb  User callback.
+    @param[in] opts  Socket options profile for accepted connections (copied).
+    NULL selects TCPSOCKET_OPTS_DEFAULT.
     @return Returns 0 on success, negative on error.
 ******************************************************************************/
 int
@@ -151,19 +541,23 @@ TcpServer_init(
     uint16_t task_stackSize,
     char *task_name,
     uint8_t task_prio,
-    TcpServer_cb *cb)
+    TcpServer_cb *cb,
+    const TcpSocket_Opts *opts)
 {
+    static const TcpSocket_Opts default_opts = TCPSOCKET_OPTS_DEFAULT;
     TcpSocket *tcp = &server->tcpsock;
     TcpTask *task = &server->task;
     int rc;
 
     CHECK_COND_RETURN_MSG(!cb, -1, "A callback must be provided.");
     server->cb = cb;
+    server->opts = opts ? *opts : default_opts;
 
     task->stackSize = task_stackSize;
     task->prio = task_prio;
     strncpy(task->name, task_name, sizeof(task->name));
 
+#if !CONFIG_TCPSERVER_NONBLOCKING
     if (buf)
     {
         server->data = buf;
@@ -174,6 +568,7 @@ TcpServer_init(
         CHECK_COND_RETURN_MSG(!server->data, -1, "Error allocating memory.");
     }
     server->data_len = buf_len;
+#endif
 
     rc = TcpSocket_init(tcp);
     CHECK_COND_RETURN(rc < 0, rc);
@@ -181,6 +576,11 @@ TcpServer_init(
     rc = TcpSocket_bind(tcp, port);
     CHECK_COND_RETURN(rc < 0, rc);
 
+#if CONFIG_TCPSERVER_NONBLOCKING
+    rc = nonblocking_init(server, buf, buf_len);
+    CHECK_COND_RETURN(rc < 0, rc);
+#endif
+
     rc = RTOS_TASK_CREATE_DYNAMIC(
         &task->handle,
         tcp_server_task,
@@ -197,3 +597,34 @@ TcpServer_init(
 
     return 0;
 }
+
+/******************************************************************************
+    [docimport TcpServer_connId]
+*//**
+    @brief Gets the connection slot index for a socket passed to the callback.
+    Lets callbacks keep per-connection state in an array of
+    TCPSERVER_NUM_CONN entries.
+    @param[in] server  Pointer to the TcpServer object.
+    @param[in] sock  Connected socket passed to the callback.
+    @return Returns the slot index (0 in blocking mode), negative if unknown.
+******************************************************************************/
+int
+TcpServer_connId(TcpServer *server, int sock)
+{
+#if CONFIG_TCPSERVER_NONBLOCKING
+    int i;
+
+    for (i = 0; i < TCPSERVER_NUM_CONN; i++)
+    {
+        if (server->conns[i].sock == sock)
+        {
+            return i;
+        }
+    }
+    return -1;
+#else
+    (void)server;
+    (void)sock;
+    return 0;
+#endif
+}
@@ -26,6 +26,53 @@ typedef struct TcpSocket
 
 } TcpSocket;
 
+/** @brief Socket options profile applied to accepted (or connected) sockets.
+*/
+typedef struct TcpSocket_Opts
+{
+    /** @brief Disable Nagle (TCP_NODELAY). */
+    uint8_t nodelay;
+    /** @brief Enable keep alive (SO_KEEPALIVE). */
+    uint8_t keepalive;
+    /** @brief Keep alive idle time, sec. */
+    int keepIdle;
+    /** @brief Keep alive interval time, sec. */
+    int keepInterval;
+    /** @brief Keep alive count. */
+    int keepCount;
+    /** @brief Send buffer size (SO_SNDBUF), 0 = stack default. */
+    int sndbuf;
+    /** @brief Receive buffer size (SO_RCVBUF), 0 = stack default. */
+    int rcvbuf;
+
+} TcpSocket_Opts;
+
+/** @brief Default profile: keep alive only. */
+#define TCPSOCKET_OPTS_DEFAULT                          \
+{                                                       \
+    .nodelay      = 0,                                  \
+    .keepalive    = 1,                                  \
+    .keepIdle     = CONFIG_TCPSOCKET_KEEPALIVE_IDLE,    \
+    .keepInterval = CONFIG_TCPSOCKET_KEEPALIVE_INTERVAL,\
+    .keepCount    = CONFIG_TCPSOCKET_KEEPALIVE_COUNT,   \
+    .sndbuf       = 0,                                  \
+    .rcvbuf       = 0,                                  \
+}
+
+/** @brief Low-latency RPC profile: small request/reply exchanges are sent
+    immediately instead of waiting on Nagle/delayed-ACK.
+*/
+#define TCPSOCKET_OPTS_LOW_LATENCY_RPC                  \
+{                                                       \
+    .nodelay      = 1,                                  \
+    .keepalive    = 1,                                  \
+    .keepIdle     = CONFIG_TCPSOCKET_KEEPALIVE_IDLE,    \
+    .keepInterval = CONFIG_TCPSOCKET_KEEPALIVE_INTERVAL,\
+    .keepCount    = CONFIG_TCPSOCKET_KEEPALIVE_COUNT,   \
+    .sndbuf       = 0,                                  \
+    .rcvbuf       = 0,                                  \
+}
+
 /** @brief Convert sender's IP to string. */
 #define TCPSOCKET_GET_ADDR(sa) \
     inet_ntoa(((struct sockaddr_in *)(&(sa)))->sin_addr)
@@ -39,7 +86,9 @@ typedef struct TcpSocket
     @param[in] sock  The active socket descriptor to read from.
     @param[in] buf  Pointer to read buffer.
     @param[in] buf_size  Max size of the buffer.
-    @return Returns the number of bytes read or -1 on error.
+    @return Returns the number of bytes read or -1 on error. On a
+    non-blocking socket with no data pending, -1 is returned with errno set to
+    EAGAIN.
 ******************************************************************************/
 int
 TcpSocket_read(int sock, uint8_t *buf, uint16_t buf_size);
@@ -52,7 +101,8 @@ TcpSocket_read(int sock, uint8_t *buf, uint16_t buf_size);
     @param[in] sock  The active socket descriptor to write to.
     @param[in] data  Pointer to data buffer.
     @param[in] data_size  Size of the buffer to write.
-    @return Returns the number of bytes written or -1 on error.
+    @return Returns the number of bytes written or -1 on error. On a
+    non-blocking socket, waits for send window space as needed.
 ******************************************************************************/
 int
 TcpSocket_write(int sock, uint8_t *data, uint16_t data_size);
@@ -99,13 +149,36 @@ TcpSocket_listen(TcpSocket *tcp, int queue_num);
     @brief Accepts incoming connections on the socket.
 
     @param[in] tcp  Pointer to TcpSocket object.
-    @param[in] keepIdle  Keep alive idle time, sec.
-    @param[in] keepInterval  Keep alive interval time, sec.
-    @param[in] keepCount  Keep alive count.
+    @param[in] opts  Options profile for the accepted socket. NULL selects
+    TCPSOCKET_OPTS_DEFAULT.
     @return Returns the accepted socket descriptor on success, -1 on error.
 ******************************************************************************/
 int
-TcpSocket_accept(TcpSocket *tcp, int keepIdle, int keepInterval, int keepCount);
+TcpSocket_accept(TcpSocket *tcp, const TcpSocket_Opts *opts);
+
+/******************************************************************************
+    [docexport TcpSocket_setOpts]
+*//**
+    @brief Applies an options profile to a socket. Options the stack does not
+    support are logged and skipped.
+
+    @param[in] sock  The socket descriptor.
+    @param[in] opts  Options profile to apply.
+    @return Returns 0 on success, -1 if any option failed.
+******************************************************************************/
+int
+TcpSocket_setOpts(int sock, const TcpSocket_Opts *opts);
+
+/******************************************************************************
+    [docexport TcpSocket_setNonblocking]
+*//**
+    @brief Puts a socket into non-blocking mode (O_NONBLOCK).
+
+    @param[in] sock  The socket descriptor.
+    @return Returns 0 on success, -1 on error.
+******************************************************************************/
+int
+TcpSocket_setNonblocking(int sock);
 
 /******************************************************************************
     [docexport TcpSocket_bind]
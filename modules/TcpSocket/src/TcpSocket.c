@@ -1,12 +1,54 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <errno.h>
+#include <fcntl.h>
 #include "CheckCond.h"
 #include "TcpSocket.h"
 
 /** @brief Initialize the logging module. */
 LOG_MODULE_REGISTER(TcpSocket, CONFIG_TCPSOCKET_LOG_LEVEL);
 
+/** @brief Max time a write waits for send window space, ms. */
+#define TCPSOCKET_WRITE_TIMEOUT_MS      1000
+
+/******************************************************************************
+    poll_send
+*//**
+    @brief Waits for a socket to become writable.
+    @param[in] sock  The active socket descriptor.
+    @param[in] timeout_ms  Poll timeout in ms.
+    @return Returns 0 when the socket is writable.
+    @return -ETIMEDOUT on timeout.
+    @return other negative code.
+******************************************************************************/
+static int
+poll_send(int sock, uint32_t timeout_ms)
+{
+    struct zsock_pollfd fds[1];
+    int ready;
+
+    fds[0].fd = sock;
+    fds[0].events = ZSOCK_POLLOUT;
+
+    if ((ready = zsock_poll(fds, 1, (int)timeout_ms)) < 0)
+    {
+        LOG_ERR("poll_send error: %d", errno);
+        return ready;
+    }
+
+    if (ready == 0)
+    {
+        return -ETIMEDOUT;
+    }
+
+    if (fds[0].revents & (ZSOCK_POLLERR | ZSOCK_POLLHUP | ZSOCK_POLLNVAL))
+    {
+        return -EIO;
+    }
+
+    return 0;
+}
+
 /******************************************************************************
     [docimport TcpSocket_read]
 *//**
@@ -15,7 +57,9 @@ LOG_MODULE_REGISTER(TcpSocket, CONFIG_TCPSOCKET_LOG_LEVEL);
     @param[in] sock  The active socket descriptor to read from.
     @param[in] buf  Pointer to read buffer.
     @param[in] buf_size  Max size of the buffer.
-    @return Returns the number of bytes read or -1 on error.
+    @return Returns the number of bytes read or -1 on error. On a
+    non-blocking socket with no data pending, -1 is returned with errno set to
+    EAGAIN.
 ******************************************************************************/
 int
 TcpSocket_read(int sock, uint8_t *buf, uint16_t buf_size)
@@ -27,7 +71,11 @@ TcpSocket_read(int sock, uint8_t *buf, uint16_t buf_size)
 
     if (len < 0)
     {
-        LOG_ERR("Error occured during socket recv: errno %d", errno);
+        /* Nothing pending on a non-blocking socket is not an error. */
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            LOG_ERR("Error occured during socket recv: errno %d", errno);
+        }
     }
     else if (len == 0)
     {
@@ -49,7 +97,8 @@ TcpSocket_read(int sock, uint8_t *buf, uint16_t buf_size)
     @param[in] sock  The active socket descriptor to write to.
     @param[in] data  Pointer to data buffer.
     @param[in] data_size  Size of the buffer to write.
-    @return Returns the number of bytes written or -1 on error.
+    @return Returns the number of bytes written or -1 on error. On a
+    non-blocking socket, waits for send window space as needed.
 ******************************************************************************/
 int
 TcpSocket_write(int sock, uint8_t *data, uint16_t data_size)
@@ -60,6 +109,16 @@ TcpSocket_write(int sock, uint8_t *data, uint16_t data_size)
     while (num_written < data_size)
     {
         int num = zsock_send(sock, data + num_written, to_write, 0);
+        if (num < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            /*  Non-blocking socket with a full send window. Wait for it to
+                drain rather than failing the write.
+            */
+            if (poll_send(sock, TCPSOCKET_WRITE_TIMEOUT_MS) == 0)
+            {
+                continue;
+            }
+        }
         if (num < 0)
         {
             LOG_ERR("Error writing to socket after writing %u bytes: "
@@ -136,16 +195,15 @@ TcpSocket_listen(TcpSocket *tcp, int queue_num)
     @brief Accepts incoming connections on the socket.
 
     @param[in] tcp  Pointer to TcpSocket object.
-    @param[in] keepIdle  Keep alive idle time, sec.
-    @param[in] keepInterval  Keep alive interval time, sec.
-    @param[in] keepCount  Keep alive count.
+    @param[in] opts  Options profile for the accepted socket. NULL selects
+    TCPSOCKET_OPTS_DEFAULT.
     @return Returns the accepted socket descriptor on success, -1 on error.
 ******************************************************************************/
 int
-TcpSocket_accept(TcpSocket *tcp, int keepIdle, int keepInterval, int keepCount)
+TcpSocket_accept(TcpSocket *tcp, const TcpSocket_Opts *opts)
 {
+    static const TcpSocket_Opts default_opts = TCPSOCKET_OPTS_DEFAULT;
     int sock;
-    int keepAlive = 1;
     char *addr_str;
     struct sockaddr_storage source_addr;
     socklen_t addr_len = sizeof(source_addr);
@@ -154,15 +212,16 @@ TcpSocket_accept(TcpSocket *tcp, int keepIdle, int keepInterval, int keepCount)
     sock = zsock_accept(tcp->sock, (struct sockaddr *)&source_addr, &addr_len);
     if (sock < 0)
     {
-        LOG_ERR("Error on socket accept: errno %d", errno);
+        /* No pending connection on a non-blocking listener. */
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            LOG_ERR("Error on socket accept: errno %d", errno);
+        }
         return -1;
     }
 
-    /** @brief Set incoming socket keep-alive options. */
-    zsock_setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(int));
-    zsock_setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &keepIdle, sizeof(int));
-    zsock_setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keepInterval, sizeof(int));
-    zsock_setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keepCount, sizeof(int));
+    /** @brief Apply the options profile to the incoming socket. */
+    TcpSocket_setOpts(sock, opts ? opts : &default_opts);
 
     addr_str = TCPSOCKET_GET_ADDR(source_addr);
     LOG_DBG("TCP connection accepted from %s", addr_str);
@@ -170,6 +229,84 @@ TcpSocket_accept(TcpSocket *tcp, int keepIdle, int keepInterval, int keepCount)
     return sock;
 }
 
+/******************************************************************************
+    set_opt
+*//**
+    @brief Sets an int socket option, logging failures.
+    @return Returns 0 on success, -1 on error.
+******************************************************************************/
+static int
+set_opt(int sock, int level, int name, int value, const char *name_str)
+{
+    int ret = zsock_setsockopt(sock, level, name, &value, sizeof(int));
+    if (ret < 0)
+    {
+        LOG_WRN("Error setting %s=%d: errno %d", name_str, value, errno);
+    }
+    return ret;
+}
+
+/******************************************************************************
+    [docimport TcpSocket_setOpts]
+*//**
+    @brief Applies an options profile to a socket. Options the stack does not
+    support are logged and skipped.
+
+    @param[in] sock  The socket descriptor.
+    @param[in] opts  Options profile to apply.
+    @return Returns 0 on success, -1 if any option failed.
+******************************************************************************/
+int
+TcpSocket_setOpts(int sock, const TcpSocket_Opts *opts)
+{
+    int ret = 0;
+
+    ret |= set_opt(sock, IPPROTO_TCP, TCP_NODELAY, opts->nodelay ? 1 : 0,
+        "TCP_NODELAY");
+
+    if (opts->sndbuf > 0)
+    {
+        ret |= set_opt(sock, SOL_SOCKET, SO_SNDBUF, opts->sndbuf, "SO_SNDBUF");
+    }
+    if (opts->rcvbuf > 0)
+    {
+        ret |= set_opt(sock, SOL_SOCKET, SO_RCVBUF, opts->rcvbuf, "SO_RCVBUF");
+    }
+
+    ret |= set_opt(sock, SOL_SOCKET, SO_KEEPALIVE, opts->keepalive ? 1 : 0,
+        "SO_KEEPALIVE");
+    if (opts->keepalive)
+    {
+        ret |= set_opt(sock, IPPROTO_TCP, TCP_KEEPIDLE, opts->keepIdle,
+            "TCP_KEEPIDLE");
+        ret |= set_opt(sock, IPPROTO_TCP, TCP_KEEPINTVL, opts->keepInterval,
+            "TCP_KEEPINTVL");
+        ret |= set_opt(sock, IPPROTO_TCP, TCP_KEEPCNT, opts->keepCount,
+            "TCP_KEEPCNT");
+    }
+
+    return (ret < 0) ? -1 : 0;
+}
+
+/******************************************************************************
+    [docimport TcpSocket_setNonblocking]
+*//**
+    @brief Puts a socket into non-blocking mode (O_NONBLOCK).
+
+    @param[in] sock  The socket descriptor.
+    @return Returns 0 on success, -1 on error.
+******************************************************************************/
+int
+TcpSocket_setNonblocking(int sock)
+{
+    int flags = zsock_fcntl(sock, F_GETFL, 0);
+    CHECK_COND_RETURN_MSG(flags < 0, -1, "Error reading socket flags.");
+
+    int ret = zsock_fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+    CHECK_COND_RETURN_MSG(ret < 0, -1, "Error setting O_NONBLOCK.");
+    return 0;
+}
+
 /******************************************************************************
     [docimport TcpSocket_bind]
 *//**
@@ -58,10 +58,43 @@ TraceRam_flush(void);
 *//**
     @brief Reads a block from the TraceRam circular buffer.
     TraceRam_disable() should be called prior to calls to this function.
+    To read while tracing, use TraceRam_drain().
     @param[in] buf  Pointer to buffer to hold data.
     @param[in] size  Number of bytes to read.
     @return Returns the number read or negative error code.
 ******************************************************************************/
 int
 TraceRam_read(uint8_t *buf, uint32_t size);
+
+/******************************************************************************
+    [docexport TraceRam_drain]
+*//**
+    @brief Reads the next trace bytes while tracing continues. The drain has
+    its own read position and does not consume the buffer or block the
+    tracing backend; bytes overwritten before they are drained are counted
+    as dropped. Calls must not run concurrently.
+    @param[in] buf  Pointer to buffer to hold data.
+    @param[in] size  Number of bytes to read.
+    @param[out] dropped  Bytes dropped since the previous drain.
+    @return Returns the number read.
+******************************************************************************/
+int
+TraceRam_drain(uint8_t *buf, uint32_t size, uint32_t *dropped);
+
+/******************************************************************************
+    [docexport TraceRam_drainReset]
+*//**
+    @brief Restarts the drain at the current end of the trace and clears the
+    dropped total.
+******************************************************************************/
+void
+TraceRam_drainReset(void);
+
+/******************************************************************************
+    [docexport TraceRam_getDropped]
+*//**
+    @brief Gets the total bytes dropped by the drain since its last reset.
+******************************************************************************/
+uint32_t
+TraceRam_getDropped(void);
 #endif
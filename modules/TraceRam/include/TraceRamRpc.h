@@ -0,0 +1,25 @@
+/*******************************************************************************
+ *  @file: TraceRamRpc.h
+ *
+ *  @brief: Header for the TraceRam RPC callset.
+*******************************************************************************/
+#ifndef TRACERAMRPC_H
+#define TRACERAMRPC_H
+
+#include <stdint.h>
+#include "ProtoRpc.h"
+#include "ProtoRpcHeader.pb.h"
+#include "TraceRamRpc.pb.h"
+
+extern CallsetInfo traceram_Callset_info;
+
+/******************************************************************************
+    [docexport TraceRamRpc_resolver]
+*//**
+    @brief Resolver function for TraceRamRpc.
+    @param[in] call_frame  Pointer to the unpacked call frame object.
+    @param[out] which_msg  Output which_msg was requested.
+******************************************************************************/
+ProtoRpc_handler *
+TraceRamRpc_resolver(void *call_frame, uint32_t *which_msg);
+#endif
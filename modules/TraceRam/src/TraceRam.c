@@ -10,6 +10,10 @@
 
 LOG_MODULE_REGISTER(TraceRam, CONFIG_TRACERAM_LOG_LEVEL);
 
+/** @brief Drain read position. It starts with the buffer, at zero. */
+static CircBuffer_Cursor drain_cursor;
+static uint32_t drain_dropped;
+
 /******************************************************************************
     [docimport TraceRam_getState]
 *//**
@@ -86,6 +90,7 @@ TraceRam_flush(void)
 *//**
     @brief Reads a block from the TraceRam circular buffer.
     TraceRam_disable() should be called prior to calls to this function.
+    To read while tracing, use TraceRam_drain().
     @param[in] buf  Pointer to buffer to hold data.
     @param[in] size  Number of bytes to read.
     @return Returns the number read or negative error code.
@@ -97,3 +102,49 @@ TraceRam_read(uint8_t *buf, uint32_t size)
     LOG_DBG("CircBuffer read %u bytes.", num);
     return num;
 }
+
+/******************************************************************************
+    [docimport TraceRam_drain]
+*//**
+    @brief Reads the next trace bytes while tracing continues. The drain has
+    its own read position and does not consume the buffer or block the
+    tracing backend; bytes overwritten before they are drained are counted
+    as dropped. Calls must not run concurrently.
+    @param[in] buf  Pointer to buffer to hold data.
+    @param[in] size  Number of bytes to read.
+    @param[out] dropped  Bytes dropped since the previous drain.
+    @return Returns the number read.
+******************************************************************************/
+int
+TraceRam_drain(uint8_t *buf, uint32_t size, uint32_t *dropped)
+{
+    int num = CircBuffer_cursorRead(
+        &traceram_circ, &drain_cursor, buf, size, dropped);
+    drain_dropped += *dropped;
+    LOG_DBG("Drained %d bytes, dropped %u.", num, *dropped);
+    return num;
+}
+
+/******************************************************************************
+    [docimport TraceRam_drainReset]
+*//**
+    @brief Restarts the drain at the current end of the trace and clears the
+    dropped total.
+******************************************************************************/
+void
+TraceRam_drainReset(void)
+{
+    CircBuffer_cursorInit(&traceram_circ, &drain_cursor);
+    drain_dropped = 0;
+}
+
+/******************************************************************************
+    [docimport TraceRam_getDropped]
+*//**
+    @brief Gets the total bytes dropped by the drain since its last reset.
+******************************************************************************/
+uint32_t
+TraceRam_getDropped(void)
+{
+    return drain_dropped;
+}
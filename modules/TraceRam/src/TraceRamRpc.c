@@ -0,0 +1,128 @@
+/*******************************************************************************
+ *  @file: TraceRamRpc.c
+ *
+ *  @brief: Handlers for the TraceRam RPC callset (proto/TraceRamRpc).
+*******************************************************************************/
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include "TraceRam.h"
+#include "TraceRamRpc.h"
+
+LOG_MODULE_DECLARE(TraceRam, CONFIG_TRACERAM_LOG_LEVEL);
+
+CallsetInfo traceram_Callset_info = {
+    .ver_major = traceram_CallsetVersion_MAJOR,
+    .ver_minor = traceram_CallsetVersion_MINOR,
+    .ver_patch = traceram_CallsetVersion_PATCH,
+    .name = "traceram",
+};
+
+/******************************************************************************
+    getstatus
+
+    Call params:
+    Reply params:
+        reply->state: bool
+        reply->count: uint32
+        reply->total_dropped: uint32
+*//**
+    @brief Implements the RPC getstatus handler.
+******************************************************************************/
+static void
+getstatus(void *call_frame, void *reply_frame, StatusEnum *status)
+{
+    traceram_Callset *call_msg = (traceram_Callset *)call_frame;
+    traceram_Callset *reply_msg = (traceram_Callset *)reply_frame;
+    traceram_GetStatus_call *call = &call_msg->msg.getstatus_call;
+    traceram_GetStatus_reply *reply = &reply_msg->msg.getstatus_reply;
+
+    (void)call;
+
+    LOG_DBG("In getstatus handler");
+
+    reply_msg->which_msg = traceram_Callset_getstatus_reply_tag;
+    *status = StatusEnum_RPC_SUCCESS;
+
+    reply->state = TraceRam_getState();
+    reply->count = TraceRam_getCount();
+    reply->total_dropped = TraceRam_getDropped();
+}
+
+/******************************************************************************
+    drain
+
+    Call params:
+        call->max_size: uint32
+        call->reset: bool
+    Reply params:
+        reply->state: bool
+        reply->data: bytes
+        reply->dropped: uint32
+        reply->total_dropped: uint32
+*//**
+    @brief Implements the RPC drain handler. Streams the trace while it
+    runs: each call returns the next chunk after the previous one, and the
+    bytes the tracer overwrote before they could be sent. An empty chunk
+    means the host is caught up.
+******************************************************************************/
+static void
+drain(void *call_frame, void *reply_frame, StatusEnum *status)
+{
+    traceram_Callset *call_msg = (traceram_Callset *)call_frame;
+    traceram_Callset *reply_msg = (traceram_Callset *)reply_frame;
+    traceram_Drain_call *call = &call_msg->msg.drain_call;
+    traceram_Drain_reply *reply = &reply_msg->msg.drain_reply;
+
+    LOG_DBG("In drain handler");
+
+    reply_msg->which_msg = traceram_Callset_drain_reply_tag;
+    *status = StatusEnum_RPC_SUCCESS;
+
+    if (call->reset)
+    {
+        TraceRam_drainReset();
+    }
+
+    reply->data.size = TraceRam_drain(reply->data.bytes,
+        MIN(call->max_size, sizeof(reply->data.bytes)), &reply->dropped);
+    reply->total_dropped = TraceRam_getDropped();
+    reply->state = TraceRam_getState();
+    LOG_DBG("Drained: %u; dropped: %u", (unsigned int)reply->data.size,
+        reply->dropped);
+}
+
+
+static ProtoRpc_Handler_Entry handlers[] = {
+    PROTORPC_ADD_HANDLER(traceram_Callset_getstatus_call_tag, getstatus),
+    PROTORPC_ADD_HANDLER(traceram_Callset_drain_call_tag, drain),
+};
+
+#define NUM_HANDLERS    PROTORPC_ARRAY_LENGTH(handlers)
+
+/******************************************************************************
+    [docimport TraceRamRpc_resolver]
+*//**
+    @brief Resolver function for TraceRamRpc.
+    @param[in] call_frame  Pointer to the unpacked call frame object.
+    @param[out] which_msg  Output which_msg was requested.
+******************************************************************************/
+ProtoRpc_handler *
+TraceRamRpc_resolver(void *call_frame, uint32_t *which_msg)
+{
+    traceram_Callset *this = (traceram_Callset *)call_frame;
+    unsigned int i;
+
+    *which_msg = this->which_msg;
+
+    /** @brief Handler lookup */
+    for (i = 0; i < NUM_HANDLERS; i++)
+    {
+        ProtoRpc_Handler_Entry *entry = &handlers[i];
+        if (entry->tag == this->which_msg)
+        {
+            return entry->handler;
+        }
+    }
+
+    return NULL;
+}
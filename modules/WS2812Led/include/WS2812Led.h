@@ -6,37 +6,16 @@
 #ifndef WS2812LED_H
 #define WS2812LED_H
 
+#include <stddef.h>
 #include <stdint.h>
 #include <zephyr/kernel.h>
 #include <zephyr/drivers/led_strip.h>
+#include <zephyr/sys/iterable_sections.h>
 #include "CList.h"
 #include "SwTimer.h"
 #include "RtosUtils.h"
-
-/** @brief RGB Color type.
-*/
-typedef struct led_rgb CRGB;
-
-/** @brief HSV Color type.
-*/
-typedef struct CHSV
-{
-    uint8_t h;
-    uint8_t s;
-    uint8_t v;
-} CHSV;
-
-/** @brief Predefined Hue colors for CHSV objects. */
-typedef enum {
-    HUE_RED = 0,
-    HUE_ORANGE = 32,
-    HUE_YELLOW = 64,
-    HUE_GREEN = 96,
-    HUE_AQUA = 128,
-    HUE_BLUE = 160,
-    HUE_PURPLE = 192,
-    HUE_PINK = 224
-} HSVHue;
+#include "Random.h"
+#include "WS2812LedColor.h"
 
 enum WS2812Led_State {
     SEG_OFF = 0,
@@ -59,6 +38,15 @@ typedef enum {
 #define WS2812LED_RGB_COLOR(r, g, b)             (CRGB){ (r), (g), (b) }
 #define WS2812LED_RGB_COLOR_OFF                  (CRGB){ 0, 0, 0 }
 
+/** @brief Random colors drawn from a segment's generator (seg->rng). */
+#define WS2812LED_RAND8(seg)            RANDOM_FAST_U8(&(seg)->rng)
+#define WS2812LED_RANDOM_HSV(seg)\
+    (CHSV){ WS2812LED_RAND8(seg), WS2812LED_RAND8(seg), WS2812LED_RAND8(seg) }
+#define WS2812LED_RANDOM_HUE(seg, s, v)\
+    (CHSV){ WS2812LED_RAND8(seg), (s), (v) }
+#define WS2812LED_RANDOM_SATVAL(seg, h)\
+    (CHSV){ (h), WS2812LED_RAND8(seg), WS2812LED_RAND8(seg) }
+
 /** @brief State object for iterating from one color to another is a gradient
       manner.
 */
@@ -83,18 +71,120 @@ typedef struct WS2812Led_GradientIter
     
 } WS2812Led_GradientIter;
 
-enum Mode {
-    MODE_STATIC = 0,
-    MODE_BLINK,
-    MODE_BLEND,
-    MODE_TWINKLE,
-    MODE_SPARKLE,
-    MODE_METEOR,
-    MODE_DISSOLVE,
-    MODE_FIRE,
-};
+/** @brief One of a segment's two pixel buffers, with the state it was
+    published with.
+*/
+typedef struct WS2812Led_SegBuf
+{
+    CHSV *pixels;
+    CRGB *rgb_pixels;
+    bool use_rgb_pixels;
+    enum WS2812Led_State state;
+    WS2812Led_BlendMode blend;
+    uint8_t alpha;
+} WS2812Led_SegBuf;
+
+struct WS2812Led_Segment;
 
-/** @brief Defines an segment of an LED strip.
+/** @brief Segment effect. Effects are registered with WS2812LED_EFFECT_DEFINE
+    and started on a segment with WS2812Led_seg_effect. Both functions run
+    with the segment locked, write the segment's back buffer (pixels or
+    rgb_pixels) and must not call the WS2812Led_seg_* methods, which stop
+    the running effect.
+*/
+typedef struct WS2812Led_Effect
+{
+    /** @brief Name, for lookup with WS2812Led_findEffect. */
+    const char *name;
+    /** @brief Called when the effect is started, with its zeroed state and
+        the caller's parameters. Sets use_rgb_pixels and the first pixels. */
+    void (*init)(struct WS2812Led_Segment *seg, void *state,
+        const void *params);
+    /** @brief Called every time the effect period expires. */
+    void (*step)(struct WS2812Led_Segment *seg, void *state);
+    /** @brief Size of the effect's state. */
+    size_t state_size;
+} WS2812Led_Effect;
+
+/** @brief Registers an effect in the WS2812Led_Effect section. Segments
+    allocate effect state for the largest registered effect when added.
+    @param _name  Effect variable name, declare it with WS2812LED_EFFECT_DECLARE
+    for use in other files.
+    @param _init  Init function.
+    @param _step  Step function.
+    @param _state  State type.
+*/
+#define WS2812LED_EFFECT_DEFINE(_name, _init, _step, _state)     \
+    const STRUCT_SECTION_ITERABLE(WS2812Led_Effect, _name) =      \
+    {                                                             \
+        .name = #_name,                                           \
+        .init = (_init),                                          \
+        .step = (_step),                                          \
+        .state_size = sizeof(_state),                             \
+    }
+
+/** @brief Declares an effect defined in another file. */
+#define WS2812LED_EFFECT_DECLARE(_name)\
+    extern const struct WS2812Led_Effect _name
+
+/** @brief Built-in effects and their parameters. The period passed to
+    WS2812Led_seg_effect is the step period. */
+typedef struct WS2812Led_TwinkleParams
+{
+    /** @brief Pixels lit (at random) before the segment is cleared. */
+    uint16_t num;
+} WS2812Led_TwinkleParams;
+
+typedef struct WS2812Led_SparkleParams
+{
+    /** @brief Hue to sparkle with, NULL for random colors. */
+    const CHSV *color;
+    /** @brief Pixels lit each step. */
+    uint16_t num;
+} WS2812Led_SparkleParams;
+
+typedef struct WS2812Led_FireParams
+{
+    uint8_t cooling;
+    uint8_t sparking;
+} WS2812Led_FireParams;
+
+typedef struct WS2812Led_DissolveParams
+{
+    const CHSV *color;
+    /** @brief Fade per step and chance (percent) a pixel fades. */
+    uint8_t decayFactor;
+    uint8_t decayProb;
+} WS2812Led_DissolveParams;
+
+typedef struct WS2812Led_MeteorParams
+{
+    const CHSV *color;
+    uint8_t size;
+    uint8_t decay;
+    /** @brief Fade at random rather than evenly. */
+    bool decayRandom;
+} WS2812Led_MeteorParams;
+
+typedef struct WS2812Led_BlendParams
+{
+    const CHSV *startColor;
+    const CHSV *endColor;
+    GradientDir dir;
+    uint16_t numSteps;
+} WS2812Led_BlendParams;
+
+WS2812LED_EFFECT_DECLARE(WS2812Led_effect_blink);
+WS2812LED_EFFECT_DECLARE(WS2812Led_effect_blend);
+WS2812LED_EFFECT_DECLARE(WS2812Led_effect_twinkle);
+WS2812LED_EFFECT_DECLARE(WS2812Led_effect_sparkle);
+WS2812LED_EFFECT_DECLARE(WS2812Led_effect_fire);
+WS2812LED_EFFECT_DECLARE(WS2812Led_effect_dissolve);
+WS2812LED_EFFECT_DECLARE(WS2812Led_effect_meteor);
+
+/** @brief Defines an segment of an LED strip. Segments are layers: they may
+    overlap, and are blended in the order they were added (the first at the
+    bottom) with their blend mode. A hidden segment shows the layers below.
 */
 typedef struct WS2812Led_Segment
 {
@@ -112,24 +202,53 @@ typedef struct WS2812Led_Segment
     uint16_t numPixels;
     /** @brief Flag indicating that pixels are stored as RGB. */
     bool use_rgb_pixels;
-    /** @brief Pixel storage, in HSV. */
+    /** @brief Pixel storage, in HSV. Points into the back buffer. */
     CHSV *pixels;
-    /** @brief Pixel storage, in RGB. */
+    /** @brief Pixel storage, in RGB. Points into the back buffer. */
     CRGB *rgb_pixels;
+    /** @brief Pixel buffers. Methods write the back buffer under lock and
+        flip it to the front on return; the strip thread reads the front
+        buffer without taking the lock. */
+    WS2812Led_SegBuf buf[2];
+    /** @brief Index of the back buffer, owned by the lock holder. */
+    uint8_t back;
+    /** @brief Index of the front buffer. */
+    atomic_t front;
+    /** @brief Incremented on every flip, lets the reader detect a flip
+        during its read. */
+    atomic_t seq;
+    /** @brief Serializes methods, which may nest. */
+    RTOS_MUTEX lock;
+    uint8_t lockDepth;
+    /** @brief Set when a method changes the back buffer. */
+    bool modified;
     /** @brief Timer object. */
     SwTimer timer;
     /** @brief Timer period, ms. */
     uint32_t timer_period_ms;
     /** @brief State */
     enum WS2812Led_State state;
-    /** @brief Segment effect mode. */
-    enum Mode mode;
-    /** @brief task loop delay (ms) */
+    /** @brief Layer blend mode and alpha, see WS2812Led_seg_layer. Set
+        before adding the segment or with WS2812Led_seg_layer; 0 (COPY)
+        replaces the pixels below. */
+    WS2812Led_BlendMode blend;
+    uint8_t alpha;
+    /** @brief Running effect, NULL when static. */
+    const WS2812Led_Effect *effect;
+    /** @brief Effect state, sized for the largest registered effect. */
+    void *fxState;
+    size_t fxStateSize;
+    /** @brief Set when a new front buffer is published, cleared by the strip
+        thread when it recomposes the segment. */
+    atomic_t dirty;
+    /** @brief task loop delay (ms), unused with the render scheduler. */
     uint32_t loopDelay_ms;
     /** @brief A work buffer of bytes of length numPixels. */
     uint8_t *workBuf;
 
-    /** @brief Task stack size. */
+    /** @brief Task stack size (the task is not created with the render
+        scheduler). 0 creates no task, the application steps the effect
+        with WS2812Led_seg_step. */
     uint16_t taskStackSize;
     /** @brief Task name. */
     char taskName[CONFIG_THREAD_MAX_NAME_LEN];
@@ -140,33 +259,36 @@ typedef struct WS2812Led_Segment
     /** @brief Task stack pointer. */
     RTOS_TASK_STACK *taskStack;
 
-    /** @brief Gradient iterator state object. */
-    WS2812Led_GradientIter gradIter;
-
-    /** @brief Methods */
-    void (*single)(void *self, const CHSV *color, uint16_t idx);
-    void (*single_rgb)(void *self, const CRGB *color, uint16_t idx);
-    void (*single_random)(void *self, uint8_t sat, uint8_t val, uint16_t idx);
-    void (*fill_solid)(void *self, const CHSV *color);
-    void (*fill_solid_rgb)(void *self, const CRGB *color);
-    void (*fill_random)(void *self, uint8_t sat, uint8_t val);
-    void (*fill_rainbow)(void *self, uint8_t initialHue, uint8_t sat, uint8_t val);
-    void (*fill_gradient)(void *self, CHSV *startColor, CHSV *endColor, GradientDir dir);
-    void (*twinkle)(void *self, bool init, uint16_t num, uint32_t delay_ms);
-    void (*sparkle)(void *self, bool init, CHSV *color, uint16_t num, uint32_t delay_ms);
-    void (*meteor)(void *self, bool init, CHSV *color, uint8_t size,
-        uint8_t decay, bool rand, uint32_t delay_ms);
-    void (*dissolve)(void *self, bool init, CHSV *color, uint8_t decayFactor,
-        uint8_t decayProb, uint32_t delay_ms);
-    void (*fire)(void *self, bool init, uint8_t cooling, uint8_t sparking, uint32_t delay_ms);
-    void (*blend)(void *self, bool init, CHSV *startColor, CHSV *endColor, GradientDir dir, uint16_t numSteps, uint16_t ms);
-    void (*blink)(void *self, uint32_t period_ms);
-    void (*show)(void *self);
-    void (*hide)(void *self);
-    void (*off)(void *self);
-    
+    /** @brief Generator for effect randomness, seeded from the entropy source
+        when the segment is added. */
+    RandomFast rng;
+
 } WS2812Led_Segment;
 
+/** @brief Duration of one stage of a frame, us. */
+typedef struct WS2812Led_Timing
+{
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t count;
+} WS2812Led_Timing;
+
+/** @brief Strip frame metrics, for sizing installations. */
+typedef struct WS2812Led_Metrics
+{
+    /** @brief Frames rendered (written or skipped). */
+    uint32_t frames;
+    /** @brief Frames that ended after their deadline, with a target FPS. */
+    uint32_t missedDeadlines;
+    /** @brief Effect steps (only with the render scheduler, where effects
+        run in the strip thread), HSV to RGB conversion of dirty segments,
+        and led_strip_update_rgb. */
+    WS2812Led_Timing step;
+    WS2812Led_Timing convert;
+    WS2812Led_Timing tx;
+} WS2812Led_Metrics;
+
 /** @brief Defines an LED strip.
 */
 typedef struct WS2812Led_Strip
@@ -177,13 +299,18 @@ typedef struct WS2812Led_Strip
     /** @brief Number of pixels in strip. */
     uint16_t numPixels;
 
-    /** @brief Main thread loop delay (ms) */
+    /** @brief Main thread loop delay (ms), used when targetFps is 0. */
     uint32_t loopDelay_ms;
+    /** @brief Frame rate, frames start on absolute deadlines 1/targetFps
+        apart whatever the frame work takes. 0 sleeps loopDelay_ms after
+        each frame instead. */
+    uint16_t targetFps;
 
     /** @brief RMT resolution. */
     int rmt_resolution_hz;
 
-    /** @brief Task stack size. */
+    /** @brief Task stack size. 0 creates no task, the application renders
+        frames with WS2812Led_frame. */
     uint16_t taskStackSize;
     /** @brief Task name. */
     char taskName[CONFIG_THREAD_MAX_NAME_LEN];
@@ -192,6 +319,9 @@ typedef struct WS2812Led_Strip
 
     /** @brief Semaphore signaling init complete. */
     RTOS_SEM initialized;
+    /** @brief Protects the segment list, and with the render scheduler the
+        effect steps, against the strip thread. */
+    RTOS_MUTEX lock;
 
     /* Internal Members. */
     /** @brief Loop task handle. */
@@ -202,9 +332,68 @@ typedef struct WS2812Led_Strip
     CList segments;
     /** @brief Number of segments. */
     uint16_t numSegments;
+    /** @brief Frames written, loops skipped because nothing changed, and
+        segment (layer) reads to recompose dirty regions. */
+    uint32_t framesWritten;
+    uint32_t framesSkipped;
+    uint32_t segmentsComposed;
+    /** @brief Composed frame, and the copy handed to the driver. */
+    CRGB *leds;
+    CRGB *txLeds;
+    /** @brief Set while leds holds a frame not yet written. */
+    bool pending;
+    /** @brief Frame metrics. */
+    WS2812Led_Metrics metrics;
+    /** @brief Next initialized strip, for WS2812Led_getStrip. */
+    struct WS2812Led_Strip *next;
+#if defined(CONFIG_WS2812LED_GROUP_PARALLEL)
+    /** @brief Start and completion of a group write by the strip's tx
+        task. */
+    RTOS_SEM txStart;
+    RTOS_SEM txDone;
+#endif
 
 } WS2812Led_Strip;
 
+/** @brief Maximum number of strips in a group. */
+#define WS2812LED_GROUP_MAX_STRIPS      32
+
+/** @brief Defines a group of LED strips on separate devices, driven by a
+    single task so that their frames are composed and latched together.
+    Segments are added to the member strips with WS2812Led_addSegment.
+    The strips' own task settings are only used, for their tx tasks, with
+    CONFIG_WS2812LED_GROUP_PARALLEL.
+*/
+typedef struct WS2812Led_Group
+{
+    /** @brief Member strips, with dev and numPixels set. */
+    WS2812Led_Strip **strips;
+    uint8_t numStrips;
+
+    /** @brief Main thread loop delay (ms), used when targetFps is 0. */
+    uint32_t loopDelay_ms;
+    /** @brief Frame rate, see WS2812Led_Strip. */
+    uint16_t targetFps;
+
+    /** @brief Task stack size. */
+    uint16_t taskStackSize;
+    /** @brief Task name. */
+    char taskName[CONFIG_THREAD_MAX_NAME_LEN];
+    /** @brief Task prio. */
+    uint8_t taskPrio;
+
+    /* Internal Members. */
+    /** @brief Loop task handle. */
+    RTOS_TASK taskHandle;
+    /** @brief Task stack pointer. */
+    RTOS_TASK_STACK *taskStack;
+    /** @brief Group frames in which at least one strip was written. */
+    uint32_t framesWritten;
+    /** @brief Group frames that ended after their deadline. */
+    uint32_t missedDeadlines;
+
+} WS2812Led_Group;
+
 /** @brief Object for a single LED strip containing one segment. */
 typedef struct WS2812Led
 {
@@ -230,19 +419,19 @@ typedef struct WS2812Led
         15)    /* segPrio */
 
 #define WS2812Led_show(pled)\
-    (pled)->seg.show(&(pled)->seg) 
+    WS2812Led_seg_show(&(pled)->seg)
 
 #define WS2812Led_hide(pled)\
-    (pled)->seg.hide(&(pled)->seg) 
+    WS2812Led_seg_hide(&(pled)->seg)
 
 #define WS2812Led_off(pled)\
-    (pled)->seg.off(&(pled)->seg) 
+    WS2812Led_seg_off(&(pled)->seg)
 
 #define WS2812Led_single(pled, color, idx)\
-    (pled)->seg.single(&(pled)->seg, (color), (idx)) 
+    WS2812Led_seg_single(&(pled)->seg, (color), (idx))
 
 #define WS2812Led_single_random(pled, sat, val, idx)\
-    (pled)->seg.single_random(&(pled)->seg, (sat), (val), (idx)) 
+    WS2812Led_seg_single_random(&(pled)->seg, (sat), (val), (idx))
 
 /******************************************************************************
     [docexport WS2812Led_single_update]
@@ -270,6 +459,302 @@ WS2812Led_single_off(const struct device *dev);
 int
 WS2812Led_addSegment(WS2812Led_Strip *strip, WS2812Led_Segment *segment);
 
+/******************************************************************************
+    [docexport WS2812Led_seg_single]
+*//**
+    @brief Sets a single pixel to an HSV color.
+    @param[in] seg  Pointer to the segment.
+    @param[in] color  Color to use.
+    @param[in] idx  Index of pixel.
+******************************************************************************/
+void
+WS2812Led_seg_single(WS2812Led_Segment *seg, const CHSV *color, uint16_t idx);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_single_rgb]
+*//**
+    @brief Sets a single pixel to an RGB color. An HSV segment is switched
+    to RGB pixels.
+    @param[in] seg  Pointer to the segment.
+    @param[in] color  Color to use.
+    @param[in] idx  Index of pixel.
+******************************************************************************/
+void
+WS2812Led_seg_single_rgb(
+    WS2812Led_Segment *seg,
+    const CRGB *color,
+    uint16_t idx);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_single_random]
+*//**
+    @brief Sets a single pixel to a random hue.
+    @param[in] seg  Pointer to the segment.
+    @param[in] sat  HSV saturation.
+    @param[in] val  HSV value.
+    @param[in] idx  Index of pixel.
+******************************************************************************/
+void
+WS2812Led_seg_single_random(
+    WS2812Led_Segment *seg,
+    uint8_t sat,
+    uint8_t val,
+    uint16_t idx);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_fill_solid]
+*//**
+    @brief Fills all pixels with an HSV color.
+    @param[in] seg  Pointer to the segment.
+    @param[in] color  Color to use.
+******************************************************************************/
+void
+WS2812Led_seg_fill_solid(WS2812Led_Segment *seg, const CHSV *color);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_fill_solid_rgb]
+*//**
+    @brief Fills all pixels with an RGB color.
+    @param[in] seg  Pointer to the segment.
+    @param[in] color  Color to use.
+******************************************************************************/
+void
+WS2812Led_seg_fill_solid_rgb(WS2812Led_Segment *seg, const CRGB *color);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_fill_random]
+*//**
+    @brief Fills all pixels with random hues.
+    @param[in] seg  Pointer to the segment.
+    @param[in] sat  HSV saturation.
+    @param[in] val  HSV value.
+******************************************************************************/
+void
+WS2812Led_seg_fill_random(WS2812Led_Segment *seg, uint8_t sat, uint8_t val);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_fill_rainbow]
+*//**
+    @brief Fills all pixels across all hues.
+    @param[in] seg  Pointer to the segment.
+    @param[in] initialHue  Hue of pixel 0.
+    @param[in] sat  HSV saturation.
+    @param[in] val  HSV value.
+******************************************************************************/
+void
+WS2812Led_seg_fill_rainbow(
+    WS2812Led_Segment *seg,
+    uint8_t initialHue,
+    uint8_t sat,
+    uint8_t val);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_fill_gradient]
+*//**
+    @brief Fills all pixels from a gradient.
+    @param[in] seg  Pointer to the segment.
+    @param[in] startColor  The gradient start color.
+    @param[in] endColor  The gradient end color.
+    @param[in] dir  Gradient direction (usually GRAD_LONGEST).
+******************************************************************************/
+void
+WS2812Led_seg_fill_gradient(
+    WS2812Led_Segment *seg,
+    const CHSV *startColor,
+    const CHSV *endColor,
+    GradientDir dir);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_show]
+*//**
+    @brief Shows the segment's pixels.
+    @param[in] seg  Pointer to the segment.
+******************************************************************************/
+void
+WS2812Led_seg_show(WS2812Led_Segment *seg);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_hide]
+*//**
+    @brief Hides the segment's pixels, retaining them.
+    @param[in] seg  Pointer to the segment.
+******************************************************************************/
+void
+WS2812Led_seg_hide(WS2812Led_Segment *seg);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_off]
+*//**
+    @brief Blanks all pixels.
+    @param[in] seg  Pointer to the segment.
+******************************************************************************/
+void
+WS2812Led_seg_off(WS2812Led_Segment *seg);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_layer]
+*//**
+    @brief Sets how the segment is blended onto the segments added before
+    it (the layers below) where they overlap.
+
+    Example, sparkles over a gradient on the same pixels:
+        base.startIdx = 0; base.endIdx = 299;
+        top.startIdx = 0; top.endIdx = 299;
+        top.blend = WS2812LED_BLEND_ADD; top.alpha = 255;
+        WS2812Led_addSegment(&strip, &base);
+        WS2812Led_addSegment(&strip, &top);
+        WS2812Led_seg_fill_gradient(&base, &red, &blue, GRAD_LONGEST);
+        WS2812Led_seg_sparkle(&top, NULL, 3, 20);
+
+    @param[in] seg  Pointer to the segment.
+    @param[in] mode  Blend mode.
+    @param[in] alpha  Opacity (ALPHA) or scale (ADD, MAX), 255 is full.
+******************************************************************************/
+void
+WS2812Led_seg_layer(
+    WS2812Led_Segment *seg,
+    WS2812Led_BlendMode mode,
+    uint8_t alpha);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_effect]
+*//**
+    @brief Starts an effect on a segment, replacing the running one. The
+    WS2812Led_seg_* fill and single methods stop it.
+
+    Example:
+        WS2812Led_FireParams fire = { .cooling = 120, .sparking = 100 };
+        WS2812Led_seg_effect(&seg, &WS2812Led_effect_fire, &fire, 10);
+
+    @param[in] seg  Pointer to the segment.
+    @param[in] effect  Effect to run.
+    @param[in] params  Effect parameters, only used during the call.
+    @param[in] period_ms  Step period, ms.
+    @return Returns 0 on success, -ENOMEM if the effect's state does not fit
+    the segment (an effect that is not registered).
+******************************************************************************/
+int
+WS2812Led_seg_effect(
+    WS2812Led_Segment *seg,
+    const WS2812Led_Effect *effect,
+    const void *params,
+    uint32_t period_ms);
+
+/******************************************************************************
+    [docexport WS2812Led_seg_step]
+*//**
+    @brief Advances the segment's running effect by one step now, whatever
+    its period, and restarts the period. For segments without a task, or to
+    step effects in time with something else (e.g. a beat).
+    @param[in] seg  Pointer to the segment.
+    @return Returns true if an effect was stepped.
+******************************************************************************/
+bool
+WS2812Led_seg_step(WS2812Led_Segment *seg);
+
+/******************************************************************************
+    [docexport WS2812Led_findEffect]
+*//**
+    @brief Looks up a registered effect by name.
+    @param[in] name  Effect name, e.g. "WS2812Led_effect_fire".
+    @return Returns the effect, NULL if not found.
+******************************************************************************/
+const WS2812Led_Effect *
+WS2812Led_findEffect(const char *name);
+
+/******************************************************************************
+    [docexport WS2812Led_gradientIter]
+*//**
+    @brief Initializes a gradient iterator, for effects.
+    @param[in] startColor  The gradient start color.
+    @param[in] endColor  The gradient end color.
+    @param[in] dir  Gradient direction (usually GRAD_LONGEST).
+    @param[in] numSteps  Number of steps to use.
+    @param[out] gradIter  Returned initialized iterator.
+******************************************************************************/
+void
+WS2812Led_gradientIter(
+    const CHSV *startColor,
+    const CHSV *endColor,
+    GradientDir dir,
+    uint16_t numSteps,
+    WS2812Led_GradientIter *gradIter);
+
+/** @brief Starts the built-in effects with their parameters inline. */
+static inline void
+WS2812Led_seg_blink(WS2812Led_Segment *seg, uint32_t period_ms)
+{
+    /* On for half the period. */
+    WS2812Led_seg_effect(seg, &WS2812Led_effect_blink, NULL, period_ms/2);
+}
+
+static inline void
+WS2812Led_seg_blend(
+    WS2812Led_Segment *seg,
+    const CHSV *startColor,
+    const CHSV *endColor,
+    GradientDir dir,
+    uint16_t numSteps,
+    uint32_t stepInc_ms)
+{
+    WS2812Led_BlendParams p = { startColor, endColor, dir, numSteps };
+    WS2812Led_seg_effect(seg, &WS2812Led_effect_blend, &p, stepInc_ms);
+}
+
+static inline void
+WS2812Led_seg_twinkle(WS2812Led_Segment *seg, uint16_t num, uint32_t delay_ms)
+{
+    WS2812Led_TwinkleParams p = { num };
+    WS2812Led_seg_effect(seg, &WS2812Led_effect_twinkle, &p, delay_ms);
+}
+
+static inline void
+WS2812Led_seg_sparkle(
+    WS2812Led_Segment *seg,
+    const CHSV *color,
+    uint16_t num,
+    uint32_t delay_ms)
+{
+    WS2812Led_SparkleParams p = { color, num };
+    WS2812Led_seg_effect(seg, &WS2812Led_effect_sparkle, &p, delay_ms);
+}
+
+static inline void
+WS2812Led_seg_fire(
+    WS2812Led_Segment *seg,
+    uint8_t cooling,
+    uint8_t sparking,
+    uint32_t delay_ms)
+{
+    WS2812Led_FireParams p = { cooling, sparking };
+    WS2812Led_seg_effect(seg, &WS2812Led_effect_fire, &p, delay_ms);
+}
+
+static inline void
+WS2812Led_seg_dissolve(
+    WS2812Led_Segment *seg,
+    const CHSV *color,
+    uint8_t decayFactor,
+    uint8_t decayProb,
+    uint32_t delay_ms)
+{
+    WS2812Led_DissolveParams p = { color, decayFactor, decayProb };
+    WS2812Led_seg_effect(seg, &WS2812Led_effect_dissolve, &p, delay_ms);
+}
+
+static inline void
+WS2812Led_seg_meteor(
+    WS2812Led_Segment *seg,
+    const CHSV *color,
+    uint8_t size,
+    uint8_t decay,
+    bool decayRandom,
+    uint32_t delay_ms)
+{
+    WS2812Led_MeteorParams p = { color, size, decay, decayRandom };
+    WS2812Led_seg_effect(seg, &WS2812Led_effect_meteor, &p, delay_ms);
+}
+
 /******************************************************************************
     [docexport WS2812_show_all]
 *//**
@@ -290,6 +775,79 @@ WS2812Led_show_all(WS2812Led_Strip *strip);
 int
 WS2812Led_init_strip( const struct device *dev, WS2812Led_Strip *strip);
 
+/******************************************************************************
+    [docexport WS2812Led_frame]
+*//**
+    @brief Renders one frame of a strip from the caller's thread, and writes
+    it if it changed. For strips initialized without a task (taskStackSize
+    0), driven by the application or a test. With the render scheduler,
+    effects whose period has expired are stepped first.
+
+    Example:
+        while (1)
+        {
+            WS2812Led_seg_step(&seg);
+            WS2812Led_frame(&strip);
+            k_sleep(K_MSEC(20));
+        }
+
+    @param[in] strip  Pointer to the strip.
+    @return Returns 1 if the frame was written, 0 if nothing changed, else
+    the led_strip_update_rgb error.
+******************************************************************************/
+int
+WS2812Led_frame(WS2812Led_Strip *strip);
+
+/******************************************************************************
+    [docexport WS2812Led_getStrip]
+*//**
+    @brief Returns an initialized strip, in order of initialization.
+    @param[in] idx  Strip index.
+    @return Returns the strip, NULL if there are not that many strips.
+******************************************************************************/
+WS2812Led_Strip *
+WS2812Led_getStrip(uint32_t idx);
+
+/******************************************************************************
+    [docexport WS2812Led_getMetrics]
+*//**
+    @brief Copies a strip's frame metrics.
+    @param[in] strip  Pointer to the strip.
+    @param[out] metrics  Returned metrics.
+******************************************************************************/
+void
+WS2812Led_getMetrics(WS2812Led_Strip *strip, WS2812Led_Metrics *metrics);
+
+/******************************************************************************
+    [docexport WS2812Led_resetMetrics]
+*//**
+    @brief Clears a strip's frame metrics and frame counters.
+    @param[in] strip  Pointer to the strip.
+******************************************************************************/
+void
+WS2812Led_resetMetrics(WS2812Led_Strip *strip);
+
+/******************************************************************************
+    [docexport WS2812Led_init_group]
+*//**
+    @brief Initializes a group of LED strips driven by one task.
+
+    Example:
+        WS2812Led_Strip *strips[] = { &stripA, &stripB };
+        WS2812Led_Group group = {
+            .strips = strips, .numStrips = 2, .loopDelay_ms = 20,
+            .taskStackSize = 1024, .taskName = "leds", .taskPrio = 15 };
+        stripA.dev = devA; stripA.numPixels = 300; (same for stripB)
+        WS2812Led_init_group(&group);
+        WS2812Led_addSegment(&stripA, &segA);
+
+    @param[in] group  Pointer to the group, with strips, numStrips and the task
+    settings set.
+    @return 0 on success, negative error code on failure.
+******************************************************************************/
+int
+WS2812Led_init_group(WS2812Led_Group *group);
+
 /******************************************************************************
     [docexport WS2812Led_init]
 *//**
@@ -306,6 +864,8 @@ WS2812Led_init_strip( const struct device *dev, WS2812Led_Strip *strip);
     @param[in] segStackSize  Stack size for the segment effects loop (try 512).
     @param[in] segLoop_ms  Loop delay, ms for the segment effects loop (try 50).
     @param[in] segPrio  Segment task priority (try 15).
+    The seg* parameters are unused with CONFIG_WS2812LED_RENDER_SCHEDULER.
+    A stack size of 0 creates no task, see WS2812Led_frame.
     @return 0 on success, negative error code on failure.
 ******************************************************************************/
 int
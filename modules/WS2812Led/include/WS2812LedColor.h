@@ -0,0 +1,106 @@
+/*******************************************************************************
+ *  @file: WS2812LedColor.h
+ *
+ *  @brief: Color types and HSV to RGB conversion for WS2812 strips.
+*******************************************************************************/
+#ifndef WS2812LEDCOLOR_H
+#define WS2812LEDCOLOR_H
+
+#include <stdint.h>
+#include <zephyr/drivers/led_strip.h>
+
+/** @brief RGB Color type.
+*/
+typedef struct led_rgb CRGB;
+
+/** @brief HSV Color type.
+*/
+typedef struct CHSV
+{
+    uint8_t h;
+    uint8_t s;
+    uint8_t v;
+} CHSV;
+
+/** @brief How a layer (segment) is combined with the pixels below it. All in
+    8-bit fixed point, saturating. */
+typedef enum WS2812Led_BlendMode
+{
+    /** @brief Replaces the pixels below, alpha is unused. */
+    WS2812LED_BLEND_COPY = 0,
+    /** @brief Mixes with the pixels below by alpha, 255 is opaque. */
+    WS2812LED_BLEND_ALPHA,
+    /** @brief Adds the color scaled by alpha, saturating at 255. */
+    WS2812LED_BLEND_ADD,
+    /** @brief Keeps the brighter of the pixel below and the color scaled by
+        alpha, per channel. */
+    WS2812LED_BLEND_MAX,
+} WS2812Led_BlendMode;
+
+/** @brief Predefined Hue colors for CHSV objects. */
+typedef enum {
+    HUE_RED = 0,
+    HUE_ORANGE = 32,
+    HUE_YELLOW = 64,
+    HUE_GREEN = 96,
+    HUE_AQUA = 128,
+    HUE_BLUE = 160,
+    HUE_PURPLE = 192,
+    HUE_PINK = 224
+} HSVHue;
+
+/******************************************************************************
+    [docexport WS2812Led_hsv2rgb]
+*//**
+    @brief Converts an HSV color to gamma corrected RGB (hexcone spectrum).
+    @param[in] hsv  Color to convert.
+    @param[out] rgb  Converted color.
+******************************************************************************/
+void
+WS2812Led_hsv2rgb(const CHSV *hsv, CRGB *rgb);
+
+/******************************************************************************
+    [docexport WS2812Led_hsv2rgbRainbow]
+*//**
+    @brief Converts HSV colors to gamma corrected RGB (rainbow spectrum, as
+    FastLED's hsv2rgb_rainbow) from a lookup table. No branches or divides
+    per pixel.
+    @param[in] hsv  Colors to convert.
+    @param[out] rgb  Converted colors.
+    @param[in] num  Number of colors.
+******************************************************************************/
+void
+WS2812Led_hsv2rgbRainbow(const CHSV *hsv, CRGB *rgb, uint16_t num);
+
+/******************************************************************************
+    [docexport WS2812Led_hsv2rgbBatch]
+*//**
+    @brief Converts HSV colors to RGB with the conversion used by the strip:
+    WS2812Led_hsv2rgbRainbow with CONFIG_WS2812LED_HSV_LUT, else
+    WS2812Led_hsv2rgb.
+    @param[in] hsv  Colors to convert.
+    @param[out] rgb  Converted colors.
+    @param[in] num  Number of colors.
+******************************************************************************/
+void
+WS2812Led_hsv2rgbBatch(const CHSV *hsv, CRGB *rgb, uint16_t num);
+
+/******************************************************************************
+    [docexport WS2812Led_blendRgb]
+*//**
+    @brief Blends colors onto the colors below them.
+    @param[in,out] dst  Colors below, returned blended.
+    @param[in] src  Colors on top.
+    @param[in] num  Number of colors.
+    @param[in] mode  Blend mode.
+    @param[in] alpha  Opacity (ALPHA) or scale (ADD, MAX) of src, 255 is full.
+******************************************************************************/
+void
+WS2812Led_blendRgb(
+    CRGB *dst,
+    const CRGB *src,
+    uint16_t num,
+    WS2812Led_BlendMode mode,
+    uint8_t alpha);
+
+#endif
@@ -0,0 +1,25 @@
+/*******************************************************************************
+ *  @file: WS2812LedRpc.h
+ *
+ *  @brief: Header for the WS2812Led RPC callset.
+*******************************************************************************/
+#ifndef WS2812LEDRPC_H
+#define WS2812LEDRPC_H
+
+#include <stdint.h>
+#include "ProtoRpc.h"
+#include "ProtoRpcHeader.pb.h"
+#include "WS2812LedRpc.pb.h"
+
+extern CallsetInfo ws2812led_Callset_info;
+
+/******************************************************************************
+    [docexport WS2812LedRpc_resolver]
+*//**
+    @brief Resolver function for WS2812LedRpc.
+    @param[in] call_frame  Pointer to the unpacked call frame object.
+    @param[out] which_msg  Output which_msg was requested.
+******************************************************************************/
+ProtoRpc_handler *
+WS2812LedRpc_resolver(void *call_frame, uint32_t *which_msg);
+#endif
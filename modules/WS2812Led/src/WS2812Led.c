@@ -12,6 +12,7 @@
 #include <zephyr/logging/log.h>
 #include <zephyr/drivers/gpio.h>
 #include <zephyr/drivers/led_strip.h>
+#include <zephyr/sys/barrier.h>
 
 #include "WS2812Led.h"
 #include "Random.h"
@@ -19,272 +20,42 @@
 /** @brief Initialize the logging module. */
 LOG_MODULE_REGISTER(WS2812Led, CONFIG_WS2812LED_LOG_LEVEL);
 
-#define GET_RANDOM_HSV()        (CHSV){ RANDOM_U8(), RANDOM_U8(), RANDOM_U8() }
-#define GET_RANDOM_HUE(s, v)    (CHSV){ RANDOM_U8(), (s), (v) }
-#define GET_RANDOM_VAL(h, s)    (CHSV){ (h), (s), RANDOM_U8() }
-#define GET_RANDOM_SAT(h, v)    (CHSV){ (h), RANDOM_U8(), (v) }
-#define GET_RANDOM_SATVAL(h)    (CHSV){ (h), RANDOM_U8(), RANDOM_U8() }
-
-/** @brief Computes u[8 0]*u[8 8] -> u[8 0] */
-#define SCALE8(x, scale)        ((uint8_t)(((uint16_t)(x) * (scale)) >> 8))
-
-/** @brief Computes u[8 0]*u[8 8] -> u[8 0] but guarantees the output is nonzero
-  if both inputs are nonzero (referred to as 'video' dimming) */
-#define SCALE8_NZ(x, scale)\
-    ((uint8_t)(((uint16_t)(x) * (uint16_t)(scale)) >> 8) + (((x) && (scale)) ? 1 : 0))
-
-/** @brief Perform a - b but clamp result at 0. */
-#define SUB_SAFE(a, b)    (((b) > (a)) ? 0 : (a) - (b))
-
-/** @brief Perform a + b, do not allow overflow. */
-#define ADD8_SAFE(a, b)\
-    (((uint16_t)(a) + (uint16_t)(b) > 255) ? 255 : (a) + (b))
-
-#define BLANK_STRIP(seg)            \
-do {                                \
-    CHSV off = { 0, 0, 0 };         \
-    fill_solid(seg, &off);           \
-} while (0);
-
-#define BLANK_STRIP_RGB(seg)        \
-do {                                \
-    CRGB off = { 0, 0, 0 };         \
-    fill_solid_rgb(seg, &off);      \
-} while (0);
-
-/** @brief Gamma correction array. */
-const uint8_t gammaArray[] = {
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
-    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,
-    1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,
-    2,  3,  3,  3,  3,  3,  3,  3,  4,  4,  4,  4,  4,  5,  5,  5,
-    5,  6,  6,  6,  6,  7,  7,  7,  7,  8,  8,  8,  9,  9,  9, 10,
-   10, 10, 11, 11, 11, 12, 12, 13, 13, 13, 14, 14, 15, 15, 16, 16,
-   17, 17, 18, 18, 19, 19, 20, 20, 21, 21, 22, 22, 23, 24, 24, 25,
-   25, 26, 27, 27, 28, 29, 29, 30, 31, 32, 32, 33, 34, 35, 35, 36,
-   37, 38, 39, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 50,
-   51, 52, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 66, 67, 68,
-   69, 70, 72, 73, 74, 75, 77, 78, 79, 81, 82, 83, 85, 86, 87, 89,
-   90, 92, 93, 95, 96, 98, 99,101,102,104,105,107,109,110,112,114,
-  115,117,119,120,122,124,126,127,129,131,133,135,137,138,140,142,
-  144,146,148,150,152,154,156,158,160,162,164,167,169,171,173,175,
-  177,180,182,184,186,189,191,193,196,198,200,203,205,208,210,213,
-  215,218,220,223,225,228,231,233,236,239,241,244,247,249,252,255
-};
-
-/** @brief Gamma correction lookup. */
-static inline uint8_t
-gamma8(uint8_t idx)
-{
-    return gammaArray[idx];
-}
-
-/** @brief Scale an RGB value. */
-static inline void
-scale8_rgb(CRGB *rgb, uint8_t scale)
-{
-    rgb->r = SCALE8(rgb->r, scale);
-    rgb->g = SCALE8(rgb->g, scale);
-    rgb->b = SCALE8(rgb->b, scale);
-}
-
-#if 0
-static uint16_t
-random_walk(uint16_t pos, uint16_t limit)
-{
-    if (RANDOM_BIN())
-    {
-        return (pos + 1 > limit) ? 0 : pos + 1;
-    }
-    else
-    {
-        return (pos == 0) ? limit-1 : pos - 1;
-    }
-}
-#endif
-
-/******************************************************************************
-    is_seg_blank_rgb
-*//**
-    @brief Test that a segment is blank (using rgb_pixels).
-    @param[in] seg  Pointer to active segment.
-    @return Returns true if the segment is blank, false otherwise.
-******************************************************************************/
-static bool
-is_seg_blank_rgb(WS2812Led_Segment *seg)
-{
-    CRGB *pix;
-    for (int i = 0; i < seg->numPixels; i++)
-    {
-        pix = &seg->rgb_pixels[i];
-        if (pix->r > 0 || pix->g > 0 || pix->b > 0)
-        {
-            return false;
-        }
-    }
-    return true;
-}
+/** @brief Marks the segment's back buffer as changed, to be published when
+    the method returns. Set when changing pixels or state. */
+#define SEG_SET_DIRTY(seg)      ((seg)->modified = true)
 
-/******************************************************************************
-    get_heatcolor
-*//**
-    @brief Approximates a black body radiadion spectrum for a given temperature
-  level. Used for fire animations. Ported from FastLED's HeatColor function.
-******************************************************************************/
-static void
-get_heatcolor(uint8_t temperature, CRGB *heatcolor)
-{
-    uint8_t t192;
-    uint8_t heatramp;
-
-    /* Scale temperature from 0-255 to 0-191. This can easily be divided into
-        three equal thirds of 64 each. */
-    t192 = SCALE8_NZ(temperature, 191);
-    //LOG_INF("temp = %u; t192 = %u",
-    //    (unsigned int)temperature,
-    //    (unsigned int)t192);
+/** @brief Attempts to read a consistent front buffer before leaving the
+    segment for the next frame. */
+#define COMPOSE_RETRIES         3
 
-    /* Calculate a value that ramps up from 0 to 255 in each third of the scale
-    */
-    heatramp = t192 & 0x3f;   /* 0..63 */
-    heatramp <<= 2;           /* Scale up to 0..252 */
+/** @brief Dirty regions composed separately each frame, more are merged. */
+#define COMPOSE_MAX_REGIONS     8
 
-    //LOG_INF("heatramp = %u", (unsigned int)heatramp);
-
-    /* Hottest 1/3 */
-    if (t192 & 0x80)
-    {
-        heatcolor->r = 255;
-        heatcolor->g = 255;
-        heatcolor->b = heatramp;
-    }
-    /* Middle 1/3 */
-    else if (t192 & 0x40)
-    {
-        heatcolor->r = 255;
-        heatcolor->g = heatramp;
-        heatcolor->b = 0;
-    }
-    /* Coolest 1/3 */
-    else
-    {
-        heatcolor->r = heatramp;
-        heatcolor->g = 0;
-        heatcolor->b = 0;
-    }
-}
+/** @brief Pixels of an HSV layer converted at a time for blending. */
+#define BLEND_CHUNK             32
 
-/******************************************************************************
-    hsv2rgb
-*//**
-    @brief Convert an HSV color to RGB.
-******************************************************************************/
-static void
+/** @brief Converts a single color with the strip's conversion. */
+static inline void
 hsv2rgb(const CHSV *hsv, CRGB *rgb)
 {
-    unsigned char region, remainder, p, q, t;
-    
-    if (hsv->s == 0)
-    {
-        rgb->r = gamma8(hsv->v);
-        rgb->g = gamma8(hsv->v);
-        rgb->b = gamma8(hsv->v);
-        return;
-    }
-    
-    region = hsv->h / 43;
-    remainder = (hsv->h - (region * 43)) * 6; 
-    
-    p = (hsv->v * (255 - hsv->s)) >> 8;
-    q = (hsv->v * (255 - ((hsv->s * remainder) >> 8))) >> 8;
-    t = (hsv->v * (255 - ((hsv->s * (255 - remainder)) >> 8))) >> 8;
-    
-    switch (region)
-    {
-        case 0:
-            rgb->r = hsv->v;
-            rgb->g = t;
-            rgb->b = p;
-            break;
-        case 1:
-            rgb->r = q;
-            rgb->g = hsv->v;
-            rgb->b = p;
-            break;
-        case 2:
-            rgb->r = p;
-            rgb->g = hsv->v;
-            rgb->b = t;
-            break;
-        case 3:
-            rgb->r = p;
-            rgb->g = q;
-            rgb->b = hsv->v;
-            break;
-        case 4:
-            rgb->r = t;
-            rgb->g = p;
-            rgb->b = hsv->v;
-            break;
-        default:
-            rgb->r = hsv->v;
-            rgb->g = p; 
-            rgb->b = q;
-            break;
-    }
-
-    rgb->r = gamma8(rgb->r);
-    rgb->g = gamma8(rgb->g);
-    rgb->b = gamma8(rgb->b);
-}
-
-/******************************************************************************
-    fadeColor
-*//**
-    @brief Fades CRGB by factor 0-255 (0=no fade, 255=max fade).
-    Modifies RGB object in place.
-
-    @param[in] rgb  CRGB color to affect.
-    @param[in] factor  Factor controlling amount to fade by.
-******************************************************************************/
-static void
-fadeColor(CRGB *rgb, uint8_t factor)
-{
-    scale8_rgb(rgb, 255-factor);
+    WS2812Led_hsv2rgbBatch(hsv, rgb, 1);
 }
 
 /******************************************************************************
-    fadePixel
+    [docimport WS2812Led_gradientIter]
 *//**
-    @brief Fades a pixel by a factor (internal use only).
-
-    @param[in] seg  Pointer to the active segment.
-    @param[in] idx  The segment pixel index to fade.
-    @param[in] factor  Factor controlling amount to fade by.
-******************************************************************************/
-static void
-fadePixel(WS2812Led_Segment *seg, uint16_t idx, uint8_t factor)
-{
-    CRGB *pixel_rgb = &seg->rgb_pixels[idx];
-    /* Fade the RGB value by the provided factor. */
-    fadeColor(pixel_rgb, factor);
-}
-
-/******************************************************************************
-    get_gradient_iter
-*//**
-    @brief Gets a gradient iterator.
+    @brief Initializes a gradient iterator, for effects.
 
     @param[in] startColor  The gradient start color.
     @param[in] endColor  The gradient end color.
     @param[in] dir  Gradient direction (usually GRAD_LONGEST).
-    @param[in] numSteps  Number of steps to use
+    @param[in] numSteps  Number of steps to use.
     @param[out] gradIter  Returned initialized iterator.
 ******************************************************************************/
-static void
-get_gradient_iter(
-    CHSV *startColor,
-    CHSV *endColor,
+void
+WS2812Led_gradientIter(
+    const CHSV *startColor,
+    const CHSV *endColor,
     GradientDir dir,
     uint16_t numSteps,
     WS2812Led_GradientIter *gradIter)
@@ -352,71 +123,135 @@ get_gradient_iter(
     gradIter->valStart_8 = gradIter->valAccum_8;
 }
 
-/****************** METHODS ***************************************************/
+/******************************************************************************
+    seg_publish
+*//**
+    @brief Flips the segment's back buffer to the front and refills the new
+    back buffer from it, so effects continue from the published pixels.
+    Called with the segment lock held.
+    @param[in] seg  Pointer to the segment.
+******************************************************************************/
+static void
+seg_publish(WS2812Led_Segment *seg)
+{
+    WS2812Led_SegBuf *back = &seg->buf[seg->back];
+    WS2812Led_SegBuf *next;
+
+    back->use_rgb_pixels = seg->use_rgb_pixels;
+    back->state = seg->state;
+    back->blend = seg->blend;
+    back->alpha = seg->alpha;
+
+    /*  A reader that started on the old front sees seq change and retries,
+        since the old front is written from here on.
+    */
+    atomic_set(&seg->front, seg->back);
+    atomic_inc(&seg->seq);
+    seg->back ^= 1;
+
+    next = &seg->buf[seg->back];
+    memcpy(next->pixels, back->pixels, seg->numPixels * sizeof(CHSV));
+    memcpy(next->rgb_pixels, back->rgb_pixels, seg->numPixels * sizeof(CRGB));
+    seg->pixels = next->pixels;
+    seg->rgb_pixels = next->rgb_pixels;
+
+    seg->modified = false;
+    atomic_set(&seg->dirty, 1);
+}
 
 /******************************************************************************
-    fill_solid_rgb
+    seg_begin
 *//**
-    @brief Method which fills all pixels with an HSV color.
+    @brief Starts a method: takes the segment lock. Methods may nest.
+    @param[in] seg  Pointer to the segment.
+******************************************************************************/
+static void
+seg_begin(WS2812Led_Segment *seg)
+{
+    RTOS_MUTEX_GET(&seg->lock);
+    seg->lockDepth++;
+}
 
-    @param[in] self  Pointer to self segment.
-    @param[in] color  CHSV pointer to color to use.
+/******************************************************************************
+    seg_end
+*//**
+    @brief Ends a method: publishes the back buffer if the outermost method
+    changed it, and releases the segment lock.
+    @param[in] seg  Pointer to the segment.
 ******************************************************************************/
 static void
-fill_solid(void *self, const CHSV *color)
+seg_end(WS2812Led_Segment *seg)
+{
+    if (--seg->lockDepth == 0 && seg->modified)
+    {
+        seg_publish(seg);
+    }
+    RTOS_MUTEX_PUT(&seg->lock);
+}
+
+/****************** METHODS ***************************************************/
+
+/******************************************************************************
+    [docimport WS2812Led_seg_fill_solid]
+*//**
+    @brief Fills all pixels with an HSV color.
+    @param[in] seg  Pointer to the segment.
+    @param[in] color  Color to use.
+******************************************************************************/
+void
+WS2812Led_seg_fill_solid(WS2812Led_Segment *seg, const CHSV *color)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
     uint16_t i;
 
+    seg_begin(seg);
     for (i = 0; i < seg->numPixels; i++)
     {
         seg->pixels[i].h = color->h;
         seg->pixels[i].s = color->s;
         seg->pixels[i].v = color->v;
     }
-    seg->mode = MODE_STATIC;
+    seg->use_rgb_pixels = false;
+    seg->effect = NULL;
+    SEG_SET_DIRTY(seg);
+    seg_end(seg);
 }
 
 /******************************************************************************
-    fill_solid_rgb
+    [docimport WS2812Led_seg_fill_solid_rgb]
 *//**
-    @brief Method which fills all pixels with an RBG color.
-
-    @param[in] self  Pointer to self segment.
-    @param[in] color  CRGB pointer to color to use.
+    @brief Fills all pixels with an RGB color.
+    @param[in] seg  Pointer to the segment.
+    @param[in] color  Color to use.
 ******************************************************************************/
-static void
-fill_solid_rgb(void *self, const CRGB *color)
+void
+WS2812Led_seg_fill_solid_rgb(WS2812Led_Segment *seg, const CRGB *color)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
     uint16_t i;
 
+    seg_begin(seg);
     for (i = 0; i < seg->numPixels; i++)
     {
         seg->rgb_pixels[i].r = color->r;
         seg->rgb_pixels[i].g = color->g;
         seg->rgb_pixels[i].b = color->b;
     }
-    seg->mode = MODE_STATIC;
+    seg->use_rgb_pixels = true;
+    seg->effect = NULL;
+    SEG_SET_DIRTY(seg);
+    seg_end(seg);
 }
 
 /******************************************************************************
-    single_random
+    [docimport WS2812Led_seg_single]
 *//**
-    @brief Method which populates a single pixel with an HSV color.
-
-    @param[in] self  Pointer to self segment.
-    @param[in] color  CHSB pointer to color to use..
+    @brief Sets a single pixel to an HSV color.
+    @param[in] seg  Pointer to the segment.
+    @param[in] color  Color to use.
     @param[in] idx  Index of pixel.
 ******************************************************************************/
-static void
-single(
-    void *self,
-    const CHSV *color,
-    uint16_t idx)
+void
+WS2812Led_seg_single(WS2812Led_Segment *seg, const CHSV *color, uint16_t idx)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-
     if (!(idx >= seg->startIdx && idx <= seg->endIdx))
     {
         LOG_ERR("single: idx out of range. (%u not in %u to %u)",
@@ -424,29 +259,38 @@ single(
         return;
     }
 
-    seg->pixels[idx].h = color->h;
-    seg->pixels[idx].s = color->s;
-    seg->pixels[idx].v = color->v;
-    seg->mode = MODE_STATIC;
+    seg_begin(seg);
+    if (seg->use_rgb_pixels)
+    {
+        /* Keep the other pixels of an RGB segment. */
+        hsv2rgb(color, &seg->rgb_pixels[idx]);
+    }
+    else
+    {
+        seg->pixels[idx].h = color->h;
+        seg->pixels[idx].s = color->s;
+        seg->pixels[idx].v = color->v;
+    }
+    seg->effect = NULL;
+    SEG_SET_DIRTY(seg);
+    seg_end(seg);
 }
 
 /******************************************************************************
-    single_random
+    [docimport WS2812Led_seg_single_rgb]
 *//**
-    @brief Method which populates a single pixel with an RGB color.
-
-    @param[in] self  Pointer to self segment.
-    @param[in] color  CRBG pointer to color to use..
+    @brief Sets a single pixel to an RGB color. An HSV segment is switched
+    to RGB pixels.
+    @param[in] seg  Pointer to the segment.
+    @param[in] color  Color to use.
     @param[in] idx  Index of pixel.
 ******************************************************************************/
-static void
-single_rgb(
-    void *self,
+void
+WS2812Led_seg_single_rgb(
+    WS2812Led_Segment *seg,
     const CRGB *color,
     uint16_t idx)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-
     if (!(idx >= seg->startIdx && idx <= seg->endIdx))
     {
         LOG_ERR("single_rgb: idx out of range. (%u not in %u to %u)",
@@ -454,30 +298,38 @@ single_rgb(
         return;
     }
 
+    seg_begin(seg);
+    if (!seg->use_rgb_pixels)
+    {
+        /* Switch to RGB, keeping the other pixels. */
+        WS2812Led_hsv2rgbBatch(seg->pixels, seg->rgb_pixels, seg->numPixels);
+        seg->use_rgb_pixels = true;
+    }
     seg->rgb_pixels[idx].r = color->r;
     seg->rgb_pixels[idx].g = color->g;
     seg->rgb_pixels[idx].b = color->b;
-    seg->mode = MODE_STATIC;
+    seg->effect = NULL;
+    SEG_SET_DIRTY(seg);
+    seg_end(seg);
 }
 
 /******************************************************************************
-    single_random
+    [docimport WS2812Led_seg_single_random]
 *//**
-    @brief Method which populates a single pixel with a random color.
-
-    @param[in] self  Pointer to self segment.
+    @brief Sets a single pixel to a random hue.
+    @param[in] seg  Pointer to the segment.
     @param[in] sat  HSV saturation.
     @param[in] val  HSV value.
     @param[in] idx  Index of pixel.
 ******************************************************************************/
-static void
-single_random(
-    void *self,
+void
+WS2812Led_seg_single_random(
+    WS2812Led_Segment *seg,
     uint8_t sat,
     uint8_t val,
     uint16_t idx)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
+    CHSV color;
 
     if (!(idx >= seg->startIdx && idx <= seg->endIdx))
     {
@@ -486,57 +338,59 @@ single_random(
         return;
     }
 
-    seg->pixels[idx] = GET_RANDOM_HUE(sat, val);
-    seg->mode = MODE_STATIC;
+    seg_begin(seg);
+    color = WS2812LED_RANDOM_HUE(seg, sat, val);
+    WS2812Led_seg_single(seg, &color, idx);
+    seg_end(seg);
 }
 
-
 /******************************************************************************
-    fill_random
+    [docimport WS2812Led_seg_fill_random]
 *//**
-    @brief Method which fills all pixels with random colors.
-
-    @param[in] self  Pointer to self segment.
+    @brief Fills all pixels with random hues.
+    @param[in] seg  Pointer to the segment.
     @param[in] sat  HSV saturation.
     @param[in] val  HSV value.
 ******************************************************************************/
-static void
-fill_random(void *self, uint8_t sat, uint8_t val)
+void
+WS2812Led_seg_fill_random(WS2812Led_Segment *seg, uint8_t sat, uint8_t val)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
     uint16_t i;
 
+    seg_begin(seg);
     for (i = 0; i < seg->numPixels; i++)
     {
-        seg->pixels[i] = GET_RANDOM_HUE(sat, val);
+        seg->pixels[i] = WS2812LED_RANDOM_HUE(seg, sat, val);
     }
-    seg->mode = MODE_STATIC;
+    seg->use_rgb_pixels = false;
+    seg->effect = NULL;
+    SEG_SET_DIRTY(seg);
+    seg_end(seg);
 }
 
-
 /******************************************************************************
-    fill_gradient
+    [docimport WS2812Led_seg_fill_gradient]
 *//**
-    @brief Method which fills all pixels from a gradient.
+    @brief Fills all pixels from a gradient.
     (ported from FastLED's fill_gradiant() function.)
 
-    @param[in] self  Pointer to self segment.
+    @param[in] seg  Pointer to the segment.
     @param[in] startColor  The gradient start color.
     @param[in] endColor  The gradient end color.
     @param[in] dir  Gradient direction (usually GRAD_LONGEST).
 ******************************************************************************/
-static void
-fill_gradient(
-    void *self,
-    CHSV *startColor,
-    CHSV *endColor,
+void
+WS2812Led_seg_fill_gradient(
+    WS2812Led_Segment *seg,
+    const CHSV *startColor,
+    const CHSV *endColor,
     GradientDir dir)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
     WS2812Led_GradientIter iter;
     uint16_t numSteps = (seg->endIdx - seg->startIdx) + 1;
 
-    get_gradient_iter(startColor, endColor, dir, numSteps, &iter);
+    seg_begin(seg);
+    WS2812Led_gradientIter(startColor, endColor, dir, numSteps, &iter);
 
     for (unsigned int i = 0; i < iter.numSteps; i++)
     {
@@ -547,699 +401,815 @@ fill_gradient(
         iter.hueAccum_8 += iter.hueDelta_8;
         iter.satAccum_8 += iter.satDelta_8;
         iter.valAccum_8 += iter.valDelta_8;
-
-        //CRGB rgb;
-        //hsv2rgb(&seg->pixels[i], &rgb);
-        //LOG_INF("[%u]: h=%u, s=%u, v=%u (r=%u, g=%u, b=%u)",
-        //    i,
-        //    (unsigned int)seg->pixels[i].h,
-        //    (unsigned int)seg->pixels[i].s,
-        //    (unsigned int)seg->pixels[i].v,
-        //    (unsigned int)rgb.r,
-        //    (unsigned int)rgb.g,
-        //    (unsigned int)rgb.b);
     }
 
-    seg->mode = MODE_STATIC;
+    seg->use_rgb_pixels = false;
+    seg->effect = NULL;
+    SEG_SET_DIRTY(seg);
+    seg_end(seg);
 }
 
 /******************************************************************************
-    twinkle
+    [docimport WS2812Led_seg_fill_rainbow]
 *//**
-    @brief Method which provides a twinkling effect. Each pixel is given a
-    random color.
-
-    @param[in] self  Pointer to self segment.
-    @param[in] init  Flag indicating the first call.
-    @param[in] numToLight  Count of number of pixels to light (random
-    locations across the segment) until the process is restarted..
-    @param[in] delay_ms  Loop delay, ms.
+    @brief Fills all pixels across all hues.
+    @param[in] seg  Pointer to the segment.
+    @param[in] initialHue  Hue of pixel 0.
+    @param[in] sat  HSV saturation.
+    @param[in] val  HSV value.
 ******************************************************************************/
-static void
-twinkle(
-    void *self,
-    bool init,
-    uint16_t numToLight,
-    uint32_t delay_ms)
+void
+WS2812Led_seg_fill_rainbow(
+    WS2812Led_Segment *seg,
+    uint8_t initialHue,
+    uint8_t sat,
+    uint8_t val)
+{
+    CHSV start = { .h = initialHue, .s = sat, .v = val };
+    CHSV end = { .h = initialHue + 255, .s = sat, .v = val };
+    WS2812Led_seg_fill_gradient(seg, &start, &end, GRAD_LONGEST);
+}
+
+/******************************************************************************
+    [docimport WS2812Led_seg_show]
+*//**
+    @brief Shows the segment's pixels.
+    @param[in] seg  Pointer to the segment.
+******************************************************************************/
+void
+WS2812Led_seg_show(WS2812Led_Segment *seg)
+{
+    seg_begin(seg);
+    seg->state = SEG_ON;
+    SEG_SET_DIRTY(seg);
+    seg_end(seg);
+}
+
+/******************************************************************************
+    [docimport WS2812Led_seg_hide]
+*//**
+    @brief Hides the segment's pixels, retaining them.
+    @param[in] seg  Pointer to the segment.
+******************************************************************************/
+void
+WS2812Led_seg_hide(WS2812Led_Segment *seg)
+{
+    seg_begin(seg);
+    seg->state = SEG_OFF;
+    SEG_SET_DIRTY(seg);
+    seg_end(seg);
+}
+
+/******************************************************************************
+    [docimport WS2812Led_seg_off]
+*//**
+    @brief Blanks all pixels.
+    @param[in] seg  Pointer to the segment.
+******************************************************************************/
+void
+WS2812Led_seg_off(WS2812Led_Segment *seg)
+{
+    CHSV blank = { .h = 0, .s = 0, .v = 0 };
+    WS2812Led_seg_fill_solid(seg, &blank);
+}
+
+/******************************************************************************
+    [docimport WS2812Led_seg_layer]
+*//**
+    @brief Sets how the segment is blended onto the segments added before
+    it (the layers below) where they overlap.
+    @param[in] seg  Pointer to the segment.
+    @param[in] mode  Blend mode.
+    @param[in] alpha  Opacity (ALPHA) or scale (ADD, MAX), 255 is full.
+******************************************************************************/
+void
+WS2812Led_seg_layer(
+    WS2812Led_Segment *seg,
+    WS2812Led_BlendMode mode,
+    uint8_t alpha)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-    static int num;
-    static int count = 0;
-    uint16_t idx;
+    seg_begin(seg);
+    seg->blend = mode;
+    seg->alpha = alpha;
+    SEG_SET_DIRTY(seg);
+    seg_end(seg);
+}
 
-    if (init)
+/******************************************************************************
+    [docimport WS2812Led_seg_effect]
+*//**
+    @brief Starts an effect on a segment, replacing the running one. The
+    WS2812Led_seg_* fill and single methods stop it.
+    @param[in] seg  Pointer to the segment.
+    @param[in] effect  Effect to run.
+    @param[in] params  Effect parameters, only used during the call.
+    @param[in] period_ms  Step period, ms.
+    @return Returns 0 on success, -ENOMEM if the effect's state does not fit
+    the segment (an effect that is not registered).
+******************************************************************************/
+int
+WS2812Led_seg_effect(
+    WS2812Led_Segment *seg,
+    const WS2812Led_Effect *effect,
+    const void *params,
+    uint32_t period_ms)
+{
+    if (effect->state_size > seg->fxStateSize)
     {
-        seg->timer_period_ms = delay_ms;
-        seg->use_rgb_pixels = false;
-        num = numToLight;
-        count = 0;
-        SwTimer_setMs(&seg->timer, delay_ms);
-        BLANK_STRIP(seg);
+        LOG_ERR("Effect %s state does not fit the segment.", effect->name);
+        return -ENOMEM;
     }
 
-    if (SwTimer_test(&seg->timer))
+    seg_begin(seg);
+    memset(seg->fxState, 0, effect->state_size);
+    seg->timer_period_ms = period_ms;
+    effect->init(seg, seg->fxState, params);
+    SwTimer_setMs(&seg->timer, period_ms);
+    seg->effect = effect;
+    SEG_SET_DIRTY(seg);
+    seg_end(seg);
+
+    return 0;
+}
+
+/******************************************************************************
+    [docimport WS2812Led_findEffect]
+*//**
+    @brief Looks up a registered effect by name.
+    @param[in] name  Effect name, e.g. "WS2812Led_effect_fire".
+    @return Returns the effect, NULL if not found.
+******************************************************************************/
+const WS2812Led_Effect *
+WS2812Led_findEffect(const char *name)
+{
+    STRUCT_SECTION_FOREACH(WS2812Led_Effect, effect)
     {
-        SwTimer_setMs(&seg->timer, seg->timer_period_ms);
-        idx = RANDOM_UINT(uint16_t, seg->numPixels);
-        seg->pixels[idx] = GET_RANDOM_HSV();
-        
-        count++;
-        if (count == num)
+        if (strcmp(effect->name, name) == 0)
         {
-            BLANK_STRIP(seg);
-            count = 0;
+            return effect;
         }
     }
-    seg->mode = MODE_TWINKLE;
+    return NULL;
 }
 
 /******************************************************************************
-    twinkle
+    [docimport WS2812Led_seg_step]
 *//**
-    @brief Method which provides a sparkle effect. Each pixel is given the
-    color provided at init.
-
-    Example:
-        CHSV color = WS2812LED_HSV_COLOR(HUE_AQUA, 255, 240);
-        segment0.sparkle(&segment0, true, &color, 1, 10);
-        RTOS_TASK_SLEEP_s(10);
-
-    @param[in] self  Pointer to self segment.
-    @param[in] init  Flag indicating the first call.
-    @param[in] color  HSV color to use.
-    @param[in] numToLight  Count of number of pixels to light (random
-    locations across the segment) until the process is restarted..
-    @param[in] delay_ms  Loop delay, ms.
+    @brief Advances the segment's running effect by one step now, whatever
+    its period, and restarts the period.
+    @param[in] seg  Pointer to the segment.
+    @return Returns true if an effect was stepped.
 ******************************************************************************/
-static void
-sparkle(
-    void *self,
-    bool init,
-    CHSV *color,
-    uint16_t numToLight,
-    uint32_t delay_ms)
+bool
+WS2812Led_seg_step(WS2812Led_Segment *seg)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-    static CHSV *c;
-    static int num;
-    uint16_t idx;
+    bool stepped = false;
 
-    if (init)
+    seg_begin(seg);
+    if (seg->effect)
     {
-        seg->timer_period_ms = delay_ms;
-        seg->use_rgb_pixels = false;
-        c = color;
-        num = numToLight;
-        SwTimer_setMs(&seg->timer, delay_ms);
-        BLANK_STRIP(seg);
+        SwTimer_setMs(&seg->timer, seg->timer_period_ms);
+        seg->effect->step(seg, seg->fxState);
+        SEG_SET_DIRTY(seg);
+        stepped = true;
     }
+    seg_end(seg);
 
-    if (SwTimer_test(&seg->timer))
-    {
-        SwTimer_setMs(&seg->timer, seg->timer_period_ms);
-        BLANK_STRIP(seg);
+    return stepped;
+}
 
-        for (int i = 0; i < num; i++)
-        {
-            idx = RANDOM_UINT(uint16_t, seg->numPixels);
-            if (c)
-            {
-                seg->pixels[idx] = GET_RANDOM_SATVAL(c->h);
-            }
-            else
-            {
-                seg->pixels[idx] = GET_RANDOM_HSV();
-            }
-        }
+/******************************************************************************
+    segment_step
+*//**
+    @brief Advances the segment's effect by one step once its period has
+    expired.
+******************************************************************************/
+static void
+segment_step(WS2812Led_Segment *self)
+{
+    seg_begin(self);
+    if (self->effect && SwTimer_test(&self->timer))
+    {
+        (void)WS2812Led_seg_step(self);
     }
-    seg->mode = MODE_SPARKLE;
+    seg_end(self);
 }
 
-
+#if !defined(CONFIG_WS2812LED_RENDER_SCHEDULER)
 /******************************************************************************
-    fire
+    segment_loop
 *//**
-    @brief Method which provides a fire effect. 
-
-    Example:
-        segment0.fire(&segment0, true, 120, 100, 10);
-        RTOS_TASK_SLEEP_s(20);
-
-    @param[in] self  Pointer to self segment.
-    @param[in] init  Flag indicating the first call.
-    @param[in] cooling  Cooling factor (play around with it).
-    @param[in] sparking  Sparking factor
-    locations across the segment) until the process is restarted..
-    @param[in] delay_ms  Loop delay, ms.
+    @brief Main task loop for segment effects.
 ******************************************************************************/
 static void
-fire(
-    void *self,
-    bool init,
-    uint8_t cooling,
-    uint8_t sparking,
-    uint32_t delay_ms)
+segment_loop(void *p0, void *p1, void *p2)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-    uint8_t *heat = seg->workBuf;
-    static uint8_t cool;
-    static uint8_t spark;
+    WS2812Led_Segment *self = (WS2812Led_Segment *)p0;
+
+    (void)p1;
+    (void)p2;
 
-    if (init)
+    while (1)
     {
-        seg->timer_period_ms = delay_ms;
-        seg->use_rgb_pixels = true;
-        cool = cooling;
-        spark = sparking;
-        SwTimer_setMs(&seg->timer, delay_ms);
-        memset(heat, 0, seg->numPixels);
-        BLANK_STRIP_RGB(seg);
+        segment_step(self);
+        RTOS_TASK_SLEEP_ms(self->loopDelay_ms);
     }
+}
+#endif
 
-    if (SwTimer_test(&seg->timer))
-    {
-        int i;
-        uint8_t randu8;
-        uint8_t randrange;
-        CRGB color;
+/** @brief Pixel range [lo, hi] of a strip frame. */
+typedef struct
+{
+    uint16_t lo;
+    uint16_t hi;
+} ComposeRegion;
 
-        SwTimer_setMs(&seg->timer, seg->timer_period_ms);
+/******************************************************************************
+    region_add
+*//**
+    @brief Adds a range to a frame's dirty regions, kept sorted and disjoint:
+    overlapping or adjacent regions are merged. When all COMPOSE_MAX_REGIONS
+    are used, a neighbour is widened over the gap, which only recomposes a
+    few clean pixels.
+    @param[in,out] regions  Dirty regions.
+    @param[in,out] numRegions  Number of regions.
+    @param[in] lo  First pixel.
+    @param[in] hi  Last pixel.
+******************************************************************************/
+static void
+region_add(ComposeRegion *regions, uint8_t *numRegions, uint16_t lo, uint16_t hi)
+{
+    uint8_t i;
+    uint8_t j;
 
-        /* Cool down every pixel a little */
-        for (i = 0; i < seg->numPixels; i++)
-        {
-            randu8 = RANDOM_UINT(uint8_t, ((cool*10)/seg->numPixels) + 2);
-            heat[i] = SUB_SAFE(heat[i], randu8);
-            //LOG_INF("randu8 = %u, heat[%u]=%u",
-            //    (unsigned int)randu8, i, (unsigned int)heat[i]);
-        }
+    /* First region not entirely below the range. */
+    for (i = 0; i < *numRegions && regions[i].hi + 1 < lo; i++)
+    {
+    }
 
-        /* Heat from each cell drifts up and diffuses a little */
-        for (i = seg->numPixels-1; i >= 2; i--)
+    if (i < *numRegions && regions[i].lo <= hi + 1)
+    {
+        /* Merge, along with the regions the range now reaches. */
+        regions[i].lo = MIN(regions[i].lo, lo);
+        regions[i].hi = MAX(regions[i].hi, hi);
+        for (j = i + 1; j < *numRegions && regions[j].lo <= regions[i].hi + 1;
+            j++)
         {
-            heat[i] = (heat[i-1] + heat[i-2] + heat[i-2])/3;
+            regions[i].hi = MAX(regions[i].hi, regions[j].hi);
         }
-
-        /* Randomly ignite new 'sparks' of heat near the bottom */
-        if (RANDOM_U8() < spark)
+        memmove(&regions[i + 1], &regions[j],
+            (*numRegions - j) * sizeof(ComposeRegion));
+        *numRegions -= j - i - 1;
+    }
+    else if (*numRegions == COMPOSE_MAX_REGIONS)
+    {
+        if (i == *numRegions)
         {
-            /** @todo Change 7 to be a function of numPixels, this will break if
-                  segment has less than 8 leds. */
-            randu8 = RANDOM_UINT(uint8_t, 7); //!!!!!!!!!!
-            randrange = RANDOM_U8_RANGE(160, 255);
-            heat[randu8] = ADD8_SAFE(heat[randu8], randrange);
-            //LOG_INF("randrange = %u, heat[%u]=%u",
-            //    (unsigned int)randrange, (unsigned int)randu8,
-            //    (unsigned int)heat[randu8]);
+            regions[i - 1].hi = hi;
         }
-        
-        /* Map from heat cells to LED colors. */
-        for (i = 0; i < seg->numPixels; i++)
+        else
         {
-            get_heatcolor(heat[i], &color);
-            seg->rgb_pixels[i] = color;
-            //LOG_INF("[%u] heat=%u; r=%u, g=%u, b=%u",
-            //    i,
-            //    (unsigned int)heat[i],
-            //    (unsigned int)color.r,
-            //    (unsigned int)color.g,
-            //    (unsigned int)color.b);
+            regions[i].lo = lo;
         }
     }
-    seg->mode = MODE_FIRE;
+    else
+    {
+        memmove(&regions[i + 1], &regions[i],
+            (*numRegions - i) * sizeof(ComposeRegion));
+        regions[i].lo = lo;
+        regions[i].hi = hi;
+        (*numRegions)++;
+    }
 }
 
 /******************************************************************************
-    dissolve
+    layer_blend
 *//**
-    @brief Method which provides a pixel dissolving effect. 
-
-    Example:
-        color = WS2812LED_HSV_COLOR(HUE_AQUA, 255, 240);
-        segment0.dissolve(&segment0, true, &color, 80, 20, 50);
-        RTOS_TASK_SLEEP_s(20);
-
-    @param[in] self  Pointer to self segment.
-    @param[in] init  Flag indicating the first call.
-    @param[in] color  HSV color to use.
-    @param[in] decayFactor  Decaying factor (experiment with this).
-    @param[in] decayProb  Probability a pixel will be chosen for decay.
-    @param[in] delay_ms  Loop delay, ms.
+    @brief Blends pixels of a layer's buffer onto the frame with the layer's
+    blend mode. HSV pixels are converted in chunks on the stack.
+    @param[in] buf  Layer (segment) buffer.
+    @param[in] off  First pixel, segment relative.
+    @param[in,out] dst  Frame at the first pixel.
+    @param[in] num  Number of pixels.
 ******************************************************************************/
 static void
-dissolve(
-    void *self,
-    bool init,
-    CHSV *color,
-    uint8_t decayFactor,
-    uint8_t decayProb,
-    uint32_t delay_ms)
+layer_blend(
+    const WS2812Led_SegBuf *buf,
+    uint16_t off,
+    CRGB *dst,
+    uint16_t num)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-    static CRGB c;
-    static uint8_t decay;
-    static uint8_t prob;
-    int j;
+    CRGB chunk[BLEND_CHUNK];
+    uint16_t n;
 
-    if (init)
+    if (buf->blend == WS2812LED_BLEND_COPY)
     {
-        seg->timer_period_ms = delay_ms;
-        seg->use_rgb_pixels = true;
-        hsv2rgb(color, &c);
-        decay = decayFactor;
-        prob = (decayProb > 100) ? 100 : decayProb;
-        SwTimer_setMs(&seg->timer, delay_ms);
-
-        BLANK_STRIP_RGB(seg);
-        for (j = 0; j < seg->numPixels; j++)
+        /* Straight into the frame. */
+        if (buf->use_rgb_pixels)
         {
-            seg->rgb_pixels[j] = c;
+            memcpy(dst, buf->rgb_pixels + off, num * sizeof(CRGB));
+        }
+        else
+        {
+            WS2812Led_hsv2rgbBatch(buf->pixels + off, dst, num);
+        }
+    }
+    else if (buf->use_rgb_pixels)
+    {
+        WS2812Led_blendRgb(dst, buf->rgb_pixels + off, num, buf->blend,
+            buf->alpha);
+    }
+    else
+    {
+        for (; num > 0; num -= n, off += n, dst += n)
+        {
+            n = MIN(num, BLEND_CHUNK);
+            WS2812Led_hsv2rgbBatch(buf->pixels + off, chunk, n);
+            WS2812Led_blendRgb(dst, chunk, n, buf->blend, buf->alpha);
         }
     }
+}
+
+/******************************************************************************
+    compose_region
+*//**
+    @brief Composes a region of the frame from black, blending every shown
+    layer that overlaps it in list order.
+    @param[in] strip  Pointer to the strip.
+    @param[in] region  Region to compose.
+    @param[out] scratch  Frame the region is composed into.
+    @return Returns false if a layer was flipped while it was read.
+******************************************************************************/
+static bool
+compose_region(
+    WS2812Led_Strip *strip,
+    const ComposeRegion *region,
+    CRGB *scratch)
+{
+    WS2812Led_Segment *segment;
+    const WS2812Led_SegBuf *buf;
+    atomic_val_t seq;
+    uint16_t lo;
+    uint16_t hi;
 
-    if (SwTimer_test(&seg->timer))
+    memset(scratch + region->lo, 0,
+        (region->hi - region->lo + 1) * sizeof(CRGB));
+
+    CLIST_ITER_ENTRY(segment, &strip->segments)
     {
-        SwTimer_setMs(&seg->timer, seg->timer_period_ms);
+        lo = MAX(region->lo, segment->startIdx);
+        hi = MIN(region->hi, segment->endIdx);
+        if (lo > hi)
+        {
+            continue;
+        }
 
-        /*  Fade all pixels by the decay factor. */
-        for (j = 0; j < seg->numPixels; j++)
+        seq = atomic_get(&segment->seq);
+        buf = &segment->buf[atomic_get(&segment->front)];
+        if (buf->state != SEG_OFF)
         {
-            if (RANDOM_UINT(uint8_t, 100) > (100 - prob))
-            {
-                fadePixel(seg, (uint16_t)j, decay);
-            }
+            layer_blend(buf, lo - segment->startIdx, scratch + lo,
+                hi - lo + 1);
+            strip->segmentsComposed++;
         }
 
-        /* When entire segment has decayed, restore. */
-        if (is_seg_blank_rgb(seg))
+        /*  A flip during the read means the writer has taken this buffer
+            as its back buffer; compose the region again.
+        */
+        barrier_dmem_fence_full();
+        if (atomic_get(&segment->seq) != seq)
         {
-            for (j = 0; j < seg->numPixels; j++)
-            {
-                seg->rgb_pixels[j] = c;
-            }
+            return false;
         }
     }
-    seg->mode = MODE_DISSOLVE;
+
+    return true;
 }
 
 /******************************************************************************
-    meteor
+    compose
 *//**
-    @brief Method which provides a shooting start effect. 
-
-    Example:
-        color = WS2812LED_HSV_COLOR(HUE_BLUE, 255, 240);
-        segment0.meteor(&segment0, true, &color, 1, 80, true, 20);
-        RTOS_TASK_SLEEP_s(20);
-
-    @param[in] self  Pointer to self segment.
-    @param[in] init  Flag indicating the first call.
-    @param[in] color  HSV color to use.
-    @param[in] meteorSize  Relative size of the meteor pixel group.
-    @param[in] meteorDecay  Decay factor.
-    @param[in] decayRandom  Randomize decay factors.
-    @param[in] delay_ms  Loop delay, ms.
+    @brief Recomposes the regions of the strip frame covered by dirty
+    segments. Segments are layers, blended in the order they were added over
+    black; only the layers overlapping a dirty region are read, and other
+    pixels keep their value from the previous frame.
+    @param[in] strip  Pointer to the strip.
+    @param[in,out] leds  Frame, strip->numPixels long.
+    @param[in] scratch  Conversion buffer, strip->numPixels long.
+    @return Returns true if the frame changed.
 ******************************************************************************/
-static void
-meteor(
-    void *self,
-    bool init,
-    CHSV *color,
-    uint8_t meteorSize,
-    uint8_t meteorDecay,
-    bool decayRandom,
-    uint32_t delay_ms)
+static bool
+compose(WS2812Led_Strip *strip, CRGB *leds, CRGB *scratch)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-    static CRGB c;
-    static uint8_t msize;
-    static uint8_t mdecay;
-    static bool decayrandom;
-    static int count;
-
-    if (init)
+    WS2812Led_Segment *segment;
+    ComposeRegion regions[COMPOSE_MAX_REGIONS];
+    const ComposeRegion *region;
+    uint8_t numRegions = 0;
+    uint8_t retry;
+    uint8_t i;
+    size_t size;
+    bool changed = false;
+
+    /*  Clear before reading: a flip made while composing sets the flag again
+        and is picked up next frame.
+    */
+    CLIST_ITER_ENTRY(segment, &strip->segments)
     {
-        seg->timer_period_ms = delay_ms;
-        seg->use_rgb_pixels = true;
-        hsv2rgb(color, &c);
-        msize = meteorSize;
-        mdecay = meteorDecay;
-        decayrandom = decayRandom;
-        count = 0;
-        SwTimer_setMs(&seg->timer, delay_ms);
-        BLANK_STRIP_RGB(seg);
+        if (atomic_clear(&segment->dirty))
+        {
+            region_add(regions, &numRegions, segment->startIdx,
+                segment->endIdx);
+        }
     }
 
-    if (SwTimer_test(&seg->timer))
+    for (i = 0; i < numRegions; i++)
     {
-        SwTimer_setMs(&seg->timer, seg->timer_period_ms);
-
-
-        /*  Fade all pixels by the decay factor. If meteorDecay boolean is false,
-            this happens smoothly, otherwise some randomness is built into the
-            decay.
-        */
-        for (int j = 0; j < seg->numPixels; j++)
+        region = &regions[i];
+        for (retry = 0; retry < COMPOSE_RETRIES; retry++)
         {
-            if ((!decayrandom) || (RANDOM_UINT(uint8_t, 100) > 60))
+            if (compose_region(strip, region, scratch))
             {
-                fadePixel(seg, (uint16_t)j, mdecay);
+                break;
             }
         }
-
-        /* Draw the meteor */
-        for (int j = 0; j < msize; j++)
+        if (retry == COMPOSE_RETRIES)
         {
-            int pixelPos = count - j;
-            if (pixelPos < 0) continue;
-
-            if (pixelPos < seg->numPixels)
+            /* Writers too busy, leave the region for the next frame. */
+            CLIST_ITER_ENTRY(segment, &strip->segments)
             {
-                seg->rgb_pixels[pixelPos] = c;
+                if (segment->startIdx <= region->hi &&
+                    segment->endIdx >= region->lo)
+                {
+                    atomic_set(&segment->dirty, 1);
+                }
             }
+            continue;
         }
 
-        count++;
-        if (count == 2*seg->numPixels)
+        size = (region->hi - region->lo + 1) * sizeof(CRGB);
+        if (memcmp(leds + region->lo, scratch + region->lo, size) != 0)
         {
-            count = 0;
+            memcpy(leds + region->lo, scratch + region->lo, size);
+            changed = true;
         }
     }
-    seg->mode = MODE_METEOR;
+
+    return changed;
 }
 
+/** @brief Initialized strips, for WS2812Led_getStrip. */
+static WS2812Led_Strip *strips;
+static K_MUTEX_DEFINE(strips_lock);
+
 /******************************************************************************
-    blend
+    timing_add
 *//**
-    @brief Segment method to blend from start color to end color over a set
-    number of steps.
-    @param[in] self  Pointer to self segment.
-    @param[in] init  Flag indicating the first initializing call.
-    @param[in] startColor  Starting color (hsv)
-    @param[in] endColor  Ending color (hsv)
-    @param[in] dir  Gradient direction (GRAD_LONGEST is typical)
-    @param[in] numSteps  Number of steps from start to end color.
-    @param[in] stepInc_ms  Step period, ms.
+    @brief Records a stage duration.
+    @param[in] t  Stage timing.
+    @param[in] start  k_cycle_get_32() at the start of the stage.
 ******************************************************************************/
 static void
-blend(
-    void *self,
-    bool init,
-    CHSV *startColor,
-    CHSV *endColor,
-    GradientDir dir,
-    uint16_t numSteps,
-    uint16_t stepInc_ms)
+timing_add(WS2812Led_Timing *t, uint32_t start)
+{
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+    t->last_us = us;
+    t->max_us = MAX(t->max_us, us);
+    t->total_us += us;
+    t->count++;
+}
+
+/******************************************************************************
+    frame_wait
+*//**
+    @brief Waits for the next frame. With a target FPS, frames start on
+    absolute deadlines so the frame period does not depend on the frame
+    work; a frame that ends late counts a missed deadline and the next one
+    starts at once. When a full period late, the schedule restarts from now
+    rather than rendering a burst of catch up frames.
+    @param[in] targetFps  Frame rate, 0 to sleep delay_ms.
+    @param[in] delay_ms  Loop delay without a target FPS.
+    @param[in,out] deadline_us  Deadline of the frame just done, uptime us.
+    @param[in,out] missed  Missed deadline counter.
+******************************************************************************/
+static void
+frame_wait(
+    uint16_t targetFps,
+    uint32_t delay_ms,
+    int64_t *deadline_us,
+    uint32_t *missed)
+{
+    int64_t now_us;
+    uint32_t period_us;
+
+    if (targetFps == 0)
+    {
+        RTOS_TASK_SLEEP_ms(delay_ms);
+        return;
+    }
+
+    period_us = 1000000 / targetFps;
+    now_us = k_ticks_to_us_floor64(k_uptime_ticks());
+    if (now_us > *deadline_us)
+    {
+        (*missed)++;
+        if (now_us - *deadline_us >= period_us)
+        {
+            *deadline_us = now_us;
+        }
+    }
+    else
+    {
+        k_sleep(K_USEC(*deadline_us - now_us));
+    }
+    *deadline_us += period_us;
+}
+
+/******************************************************************************
+    strip_setup
+*//**
+    @brief Initializes a strip's locks, segment list and frame buffers. The
+    strip's dev and numPixels must be set.
+    @param[in] strip  Pointer to the strip.
+    @return Returns 0 on success, negative error code on failure.
+******************************************************************************/
+static int
+strip_setup(WS2812Led_Strip *strip)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-    WS2812Led_GradientIter *gradIter = &seg->gradIter;
+    unsigned int led_array_size = strip->numPixels * sizeof(CRGB);
+
+    if (!device_is_ready(strip->dev))
+    {
+        LOG_ERR("LED strip device is not ready");
+        return -ENODEV;
+    }
+
+    RTOS_SEM_INIT(&strip->initialized);
+    RTOS_MUTEX_INIT(&strip->lock);
+    strip->framesWritten = 0;
+    strip->framesSkipped = 0;
+    strip->segmentsComposed = 0;
+    memset(&strip->metrics, 0, sizeof(strip->metrics));
+
+    /*  leds holds the composed frame across loops. The driver may use the
+        buffer passed to led_strip_update_rgb as scratch, so it gets a copy;
+        compose uses the same buffer for conversion.
+    */
+    strip->leds = (CRGB *)malloc(led_array_size);
+    strip->txLeds = (CRGB *)malloc(led_array_size);
+    if (!strip->leds || !strip->txLeds)
+    {
+        LOG_ERR("Error allocated memory for led strip.");
+        free(strip->leds);
+        free(strip->txLeds);
+        return -ENOMEM;
+    }
+    memset(strip->leds, 0, led_array_size);
+    strip->pending = true;
+
+    /* Initialize the segment list. */
+    CList_init(&strip->segments);
+
+    /* Give semaphore indicating that the segment list has been initialized. */
+    RTOS_SEM_GIVE(&strip->initialized);
 
-    if (init)
+    /* Append to the strips list. */
+    RTOS_MUTEX_GET(&strips_lock);
+    strip->next = NULL;
+    if (!strips)
     {
-        seg->timer_period_ms = stepInc_ms;
-        seg->use_rgb_pixels = false;
-        get_gradient_iter(startColor, endColor, dir, numSteps, gradIter);
-        gradIter->initialized = OBJ_INIT_CODE;
-        SwTimer_setMs(&seg->timer, seg->timer_period_ms);
-        fill_solid(self, startColor);
-        seg->mode = MODE_BLEND;
-        return;
+        strips = strip;
     }
-
-    if (SwTimer_test(&seg->timer))
+    else
     {
-        SwTimer_setMs(&seg->timer, seg->timer_period_ms);
-
-        gradIter->hueAccum_8 += gradIter->hueDelta_8;
-        gradIter->satAccum_8 += gradIter->satDelta_8;
-        gradIter->valAccum_8 += gradIter->valDelta_8;
-
-        for (unsigned int i = 0; i < seg->numPixels; i++)
-        {
-            seg->pixels[i].h = gradIter->hueAccum_8 >> 8;
-            seg->pixels[i].s = gradIter->satAccum_8 >> 8;
-            seg->pixels[i].v = gradIter->valAccum_8 >> 8;
-        }
+        WS2812Led_Strip *last = strips;
 
-        gradIter->stepIdx++;
-
-        if (gradIter->stepIdx == gradIter->numSteps)
+        while (last->next)
         {
-            CHSV hsv = { .h = gradIter->hueStart_8 >> 8,
-                         .s = gradIter->satStart_8 >> 8,
-                         .v = gradIter->valStart_8 >> 8 };
-            fill_solid(self, &hsv);
-            seg->mode = MODE_BLEND;
-            gradIter->hueAccum_8 = gradIter->hueStart_8;
-            gradIter->satAccum_8 = gradIter->satStart_8;
-            gradIter->valAccum_8 = gradIter->valStart_8;
-            gradIter->stepIdx = 0;
+            last = last->next;
         }
+        last->next = strip;
     }
-}
+    RTOS_MUTEX_PUT(&strips_lock);
 
-/******************************************************************************
-    fill_rainbow
-*//**
-    @brief Segment method to fill across all pixels from all colors.
-
-    @param[in] self  Pointer to self segment.
-    @param[in] initialHue  Starting color for pixel 0.
-    @param[in] sat  HSV saturation
-    @param[in] val  HSV value
-******************************************************************************/
-static void
-fill_rainbow(
-    void *self,
-    uint8_t initialHue,
-    uint8_t sat,
-    uint8_t val)
-{
-    CHSV start = { .h = initialHue, .s = sat, .v = val };
-    CHSV end = { .h = initialHue + 255, .s = sat, .v = val };
-    fill_gradient(self, &start, &end, GRAD_LONGEST);
+    return 0;
 }
 
 /******************************************************************************
-    fill_rainbow
+    strip_render
 *//**
-    @brief Segment method to blink all pixels at a certain period.
-
-    @param[in] self  Pointer to self segment.
-    @param[in] period_ms  Blink period (on time will be period/2).
+    @brief Steps the strip's effects (with the render scheduler) and composes
+    its frame.
+    @param[in] strip  Pointer to the strip.
+    @return Returns true if the frame needs writing.
 ******************************************************************************/
-static void
-blink(
-    void *self,
-    uint32_t period_ms)
+static bool
+strip_render(WS2812Led_Strip *strip)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-    seg->timer_period_ms = period_ms;
+    uint32_t start;
 
-    if (seg->timer.state == STATE_RUNNING)
+    RTOS_MUTEX_GET(&strip->lock);
+#if defined(CONFIG_WS2812LED_RENDER_SCHEDULER)
     {
-        if (SwTimer_test(&seg->timer))
+        WS2812Led_Segment *segment;
+
+        /*  Step every effect, then compose, so that the frame written is the
+            result of one tick of all segments.
+        */
+        start = k_cycle_get_32();
+        CLIST_ITER_ENTRY(segment, &strip->segments)
         {
-            seg->state = (seg->state == SEG_ON) ? SEG_OFF : SEG_ON;
-            SwTimer_setMs(&seg->timer, seg->timer_period_ms/2);
+            segment_step(segment);
         }
+        timing_add(&strip->metrics.step, start);
     }
-    else
+#endif
+    start = k_cycle_get_32();
+    if (compose(strip, strip->leds, strip->txLeds))
     {
-        SwTimer_setMs(&seg->timer, period_ms);
-        
+        strip->pending = true;
     }
-    seg->mode = MODE_BLINK;
-}
+    timing_add(&strip->metrics.convert, start);
+    strip->metrics.frames++;
+    RTOS_MUTEX_PUT(&strip->lock);
 
-/******************************************************************************
-    show
-*//**
-    @brief Segment method to show all pixels.
+    if (!strip->pending)
+    {
+        /* Nothing changed since the last write. */
+        strip->framesSkipped++;
+    }
 
-    @param[in] self  Pointer to self segment.
-******************************************************************************/
-static void
-show(void *self)
-{
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-    seg->state = SEG_ON;
+    return strip->pending;
 }
 
 /******************************************************************************
-    hide
+    strip_write
 *//**
-    @brief Segment method to hide all pixels (retaining information).
-
-    @param[in] self  Pointer to self segment.
+    @brief Writes the strip's composed frame to the device.
+    @param[in] strip  Pointer to the strip.
+    @return Returns 0 on success, else the led_strip_update_rgb error.
 ******************************************************************************/
-static void
-hide(void *self)
+static int
+strip_write(WS2812Led_Strip *strip)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-    seg->state = SEG_OFF;
+    uint32_t start;
+    int ret;
+
+    memcpy(strip->txLeds, strip->leds, strip->numPixels * sizeof(CRGB));
+    start = k_cycle_get_32();
+    ret = led_strip_update_rgb(strip->dev, strip->txLeds, strip->numPixels);
+    RTOS_MUTEX_GET(&strip->lock);
+    timing_add(&strip->metrics.tx, start);
+    RTOS_MUTEX_PUT(&strip->lock);
+    if (ret != 0)
+    {
+        LOG_ERR("Error in led_strip_update_rgb: %d", ret);
+        return ret;
+    }
+    strip->pending = false;
+    strip->framesWritten++;
+
+    return 0;
 }
 
 /******************************************************************************
-    off
+    [docimport WS2812Led_frame]
 *//**
-    @brief Segment method to blank all pixels.
-
-    @param[in] self  Pointer to self segment.
+    @brief Renders one frame of a strip from the caller's thread, and writes
+    it if it changed.
+    @param[in] strip  Pointer to the strip.
+    @return Returns 1 if the frame was written, 0 if nothing changed, else
+    the led_strip_update_rgb error.
 ******************************************************************************/
-static void
-off(void *self)
+int
+WS2812Led_frame(WS2812Led_Strip *strip)
 {
-    WS2812Led_Segment *seg = (WS2812Led_Segment *)self;
-    CHSV blank = { .h = 0, .s = 0, .v = 0 };
-    fill_solid(seg, &blank);
+    int ret;
+
+    if (!strip_render(strip))
+    {
+        return 0;
+    }
+    if ((ret = strip_write(strip)) != 0)
+    {
+        return ret;
+    }
+
+    return 1;
 }
 
 /******************************************************************************
-    segment_loop
+    led_main
 *//**
-    @brief Main task loop for segment effects.
+    @brief Main task loop for writing to the led strip.
 ******************************************************************************/
 static void
-segment_loop(void *p0, void *p1, void *p2)
+led_main(void *p0, void *p1, void *p2)
 {
-    WS2812Led_Segment *self = (WS2812Led_Segment *)p0;
+    WS2812Led_Strip *strip = (WS2812Led_Strip *)p0;
+    int64_t deadline_us = k_ticks_to_us_floor64(k_uptime_ticks());
 
     (void)p1;
     (void)p2;
 
     while (1)
     {
-        switch (self->mode)
-        {
-        case MODE_STATIC:
-            break;
-
-        case MODE_BLINK:
-            blink(self, self->timer_period_ms);
-            break;
-
-        case MODE_BLEND:
-            blend(self, false, NULL, NULL, 0, 0, 0);
-            break;
-
-        case MODE_TWINKLE:
-            twinkle(self, false, 0, 0);
-            break;
-
-        case MODE_SPARKLE:
-            sparkle(self, false, NULL, 0, 0);
-            break;
-
-        case MODE_METEOR:
-            meteor(self, false, NULL, 0, 0, false, 0);
-            break;
-
-        case MODE_DISSOLVE:
-            dissolve(self, false, NULL, 0, 0, 0);
-            break;
-
-        case MODE_FIRE:
-            fire(self, false, 0, 0, 0);
-            break;
+        LOG_DBG("Hello from LED strip %s", strip->taskName);
 
-        default:
-            break;
+        if (strip_render(strip) && strip_write(strip) != 0)
+        {
+            RTOS_TASK_SLEEP_ms(1000);
         }
 
-        RTOS_TASK_SLEEP_ms(self->loopDelay_ms);
+        frame_wait(strip->targetFps, strip->loopDelay_ms, &deadline_us,
+            &strip->metrics.missedDeadlines);
     }
 }
 
+#if defined(CONFIG_WS2812LED_GROUP_PARALLEL)
 /******************************************************************************
-    led_main
+    strip_tx_main
 *//**
-    @brief Main task loop for writing to the led strip.
+    @brief Task loop writing one strip of a group, so that the group's
+    transfers run in parallel on their own peripherals.
 ******************************************************************************/
 static void
-led_main(void *p0, void *p1, void *p2)
+strip_tx_main(void *p0, void *p1, void *p2)
 {
-    int ret;
     WS2812Led_Strip *strip = (WS2812Led_Strip *)p0;
-    CRGB *leds;
-    unsigned int led_array_size = strip->numPixels * sizeof(CRGB);
 
     (void)p1;
     (void)p2;
 
-    /* Initialize the segment list. */
-    CList_init(&strip->segments);
-
-    /* Give semaphore indicating that the segment list has been initialized. */
-    RTOS_SEM_GIVE(&strip->initialized);
-
-    leds = (CRGB *)malloc(led_array_size);
-    if (!leds)
+    while (1)
     {
-        LOG_ERR("Error allocated memory for led strip.");
-        return;
+        RTOS_SEM_TAKE(&strip->txStart);
+        (void)strip_write(strip);
+        RTOS_SEM_GIVE(&strip->txDone);
     }
+}
+#endif
 
-    memset(leds, 0, led_array_size);
+/******************************************************************************
+    group_main
+*//**
+    @brief Main task loop for a strip group. Composes every strip, then
+    starts all writes together so that the strips latch the same frame.
+******************************************************************************/
+static void
+group_main(void *p0, void *p1, void *p2)
+{
+    WS2812Led_Group *group = (WS2812Led_Group *)p0;
+    WS2812Led_Strip *strip;
+    int64_t deadline_us = k_ticks_to_us_floor64(k_uptime_ticks());
+    uint32_t writing;
+    uint8_t i;
+
+    (void)p1;
+    (void)p2;
 
     while (1)
     {
-        WS2812Led_Segment *segment;
-        CHSV *hsv;
-        CRGB *rgb;
-        CRGB rgbColor;
-        int k;
-        LOG_DBG("Hello from LED strip %s", strip->taskName);
-
-        /* Iterate through strip segments. */
-        CLIST_ITER_ENTRY(segment, &strip->segments)
+        writing = 0;
+        for (i = 0; i < group->numStrips; i++)
         {
-            for (k = 0; k < segment->numPixels; k++)
+            if (strip_render(group->strips[i]))
             {
-                if (segment->state == SEG_OFF)
-                {
-                    rgbColor.r = 0;
-                    rgbColor.g = 0;
-                    rgbColor.b = 0;
-                    leds[k + segment->startIdx] = rgbColor;
-                    continue;
-                }
-
-                hsv = segment->pixels + k;
-                rgb = segment->rgb_pixels + k;
-
-                if (segment->use_rgb_pixels)
-                {
-                    leds[k + segment->startIdx] = *rgb;
-                }
-                else
-                {
-                    /* Convert pixel HSV to RGB. */
-                    hsv2rgb(hsv, &rgbColor);
-                    leds[k + segment->startIdx] = rgbColor;
-                }
+                writing |= BIT(i);
+            }
+        }
 
-                LOG_DBG("[%u]: h=%u s=%u v=%u --> r=%u g=%u b=%u",
-                    k,
-                    (unsigned int)hsv->h,
-                    (unsigned int)hsv->s,
-                    (unsigned int)hsv->v,
-                    (unsigned int)rgbColor.r,
-                    (unsigned int)rgbColor.g,
-                    (unsigned int)rgbColor.b);
+        for (i = 0; i < group->numStrips; i++)
+        {
+            if (!(writing & BIT(i)))
+            {
+                continue;
             }
+            strip = group->strips[i];
+#if defined(CONFIG_WS2812LED_GROUP_PARALLEL)
+            RTOS_SEM_GIVE(&strip->txStart);
+#else
+            /* Back to back, a failed strip is retried next frame. */
+            (void)strip_write(strip);
+#endif
         }
 
-        /* Write updated leds to the strip. */
-        ret = led_strip_update_rgb(strip->dev, leds, strip->numPixels);
-        if (ret != 0)
+#if defined(CONFIG_WS2812LED_GROUP_PARALLEL)
+        for (i = 0; i < group->numStrips; i++)
         {
-            LOG_ERR("Error in led_strip_update_rgb: %d", ret);
-            RTOS_TASK_SLEEP_ms(1000);
-            continue;
+            if (writing & BIT(i))
+            {
+                RTOS_SEM_TAKE(&group->strips[i]->txDone);
+            }
+        }
+#endif
+        if (writing)
+        {
+            group->framesWritten++;
         }
 
-        RTOS_TASK_SLEEP_ms(strip->loopDelay_ms);
+        frame_wait(group->targetFps, group->loopDelay_ms, &deadline_us,
+            &group->missedDeadlines);
     }
 }
 
@@ -1282,6 +1252,24 @@ WS2812Led_single_off(const struct device *dev)
     WS2812Led_single_update(dev, &color);
 }
 
+/******************************************************************************
+    segment_free
+*//**
+    @brief Frees the buffers of a segment that was not added. NULL pointers
+    are left by the allocations that were not made.
+******************************************************************************/
+static void
+segment_free(WS2812Led_Segment *segment)
+{
+    /* Both pixel buffers are one block, starting at buf[0].pixels. */
+    free(segment->buf[0].pixels);
+    free(segment->workBuf);
+    free(segment->fxState);
+    segment->buf[0].pixels = NULL;
+    segment->workBuf = NULL;
+    segment->fxState = NULL;
+}
+
 /******************************************************************************
     [docimport WS2812Led_addSegment]
 *//**
@@ -1294,61 +1282,89 @@ WS2812Led_addSegment(WS2812Led_Strip *strip, WS2812Led_Segment *segment)
     CList *list = &strip->segments;
     WS2812Led_Segment *last_segment_added;
     uint16_t numPixels = (segment->endIdx - segment->startIdx) + 1;
+    uint8_t *pixels;
+    uint8_t i;
 
     LOG_INF("Adding LED segment:");
     LOG_INF("    start: %u", segment->startIdx);
     LOG_INF("    end: %u", segment->endIdx);
 
-    /* Allocate memory for the pixel array. */
-    segment->pixels = (CHSV *)malloc(numPixels*sizeof(CHSV));
-    if (!segment->pixels)
+    /* Segments may overlap (layers), but not leave the strip. */
+    if (segment->startIdx > segment->endIdx ||
+        segment->endIdx >= strip->numPixels)
     {
-        LOG_ERR("Error allocating memory for segment.");
-        return -ENOMEM;
+        LOG_ERR("Segment %u to %u is outside the strip.",
+            segment->startIdx, segment->endIdx);
+        return -EINVAL;
     }
 
-    segment->rgb_pixels = (CRGB *)malloc(numPixels*sizeof(CRGB));
-    if (!segment->rgb_pixels)
+    /* Allocate memory for both pixel buffers, HSV and RGB, in one block. */
+    pixels = (uint8_t *)malloc(2*numPixels*(sizeof(CHSV) + sizeof(CRGB)));
+    if (!pixels)
     {
         LOG_ERR("Error allocating memory for segment.");
         return -ENOMEM;
     }
+    memset(pixels, 0, 2*numPixels*(sizeof(CHSV) + sizeof(CRGB)));
+    segment->workBuf = NULL;
+    segment->fxState = NULL;
+
+    for (i = 0; i < 2; i++)
+    {
+        segment->buf[i].pixels = (CHSV *)pixels;
+        pixels += numPixels*sizeof(CHSV);
+        segment->buf[i].rgb_pixels = (CRGB *)pixels;
+        pixels += numPixels*sizeof(CRGB);
+        segment->buf[i].use_rgb_pixels = false;
+        segment->buf[i].state = segment->state;
+        segment->buf[i].blend = segment->blend;
+        segment->buf[i].alpha = segment->alpha;
+    }
+
+    /* Methods write buf[0], the strip thread reads buf[1]. */
+    segment->back = 0;
+    atomic_set(&segment->front, 1);
+    atomic_set(&segment->seq, 0);
+    segment->lockDepth = 0;
+    segment->modified = false;
+    RTOS_MUTEX_INIT(&segment->lock);
+    segment->pixels = segment->buf[0].pixels;
+    segment->rgb_pixels = segment->buf[0].rgb_pixels;
 
     segment->workBuf = (uint8_t *)malloc(numPixels);
     if (!segment->workBuf)
     {
         LOG_ERR("Error allocating memory for segment.");
+        segment_free(segment);
+        return -ENOMEM;
+    }
+
+    /* Effects draw from their own generator, seeded once here. */
+    RANDOM_FAST_SEED(&segment->rng);
+
+    /*  Effect state, sized once for the largest registered effect so that
+        any effect can be started without allocating.
+    */
+    segment->fxStateSize = 0;
+    STRUCT_SECTION_FOREACH(WS2812Led_Effect, effect)
+    {
+        segment->fxStateSize = MAX(segment->fxStateSize, effect->state_size);
+    }
+    segment->fxState = malloc(segment->fxStateSize);
+    if (!segment->fxState && segment->fxStateSize > 0)
+    {
+        LOG_ERR("Error allocating memory for segment.");
+        segment_free(segment);
         return -ENOMEM;
     }
 
-    /* Default to static mode. */
-    segment->mode = MODE_STATIC;
+    /* Default to static, composed on the next frame. */
+    segment->effect = NULL;
+    atomic_set(&segment->dirty, 1);
 
     segment->numPixels      = numPixels;
     segment->use_rgb_pixels = false;
 
-    /* Indicate the object is not initialized. */
-    segment->gradIter.initialized = 0;
-
-    segment->off            = off;
-    segment->show           = show;
-    segment->hide           = hide;
-    segment->single         = single;
-    segment->single_rgb     = single_rgb;
-    segment->single_random  = single_random;
-    segment->fill_solid     = fill_solid;
-    segment->fill_solid_rgb = fill_solid_rgb;
-    segment->fill_random    = fill_random;
-    segment->fill_rainbow   = fill_rainbow;
-    segment->fill_gradient  = fill_gradient;
-    segment->blink          = blink;
-    segment->blend          = blend;
-    segment->twinkle        = twinkle;
-    segment->sparkle        = sparkle;
-    segment->meteor         = meteor;
-    segment->dissolve       = dissolve;
-    segment->fire           = fire;
-
     /*  Wait here to make sure that the led strip has been initialized prior to
         adding the segment to the list. */
     LOG_INF("Waiting for strip to be initialized.");
@@ -1365,28 +1381,49 @@ WS2812Led_addSegment(WS2812Led_Strip *strip, WS2812Led_Segment *segment)
         if (!last_segment_added)
         {
             LOG_ERR("Error getting last segment.");
+            RTOS_SEM_GIVE(&strip->initialized);
+            segment_free(segment);
             return -EINVAL;
         }
         segment->number = last_segment_added->number + 1;
     }
 
+#if defined(CONFIG_WS2812LED_RENDER_SCHEDULER)
+    /* Effects are stepped by the strip thread. */
+    ARG_UNUSED(ret);
+#else
+    /*  Start the effect task before the strip sees the segment, so a failure
+        leaves nothing in the list to undo. A task of 0 bytes means the
+        application steps the segment with WS2812Led_seg_step.
+    */
+    if (segment->taskStackSize != 0)
+    {
+        ret = RTOS_TASK_CREATE_DYNAMIC(
+            &segment->taskHandle,
+            segment_loop,
+            segment->taskName,
+            segment->taskStack,
+            segment->taskStackSize,
+            (void *)segment,
+            segment->taskPrio);
+        if (ret != 0)
+        {
+            LOG_ERR("Failed creating LED segment task (%d)", ret);
+            RTOS_SEM_GIVE(&strip->initialized);
+            segment_free(segment);
+            return ret;
+        }
+    }
+#endif
+
+    /*  Let the next segment added through. */
+    RTOS_SEM_GIVE(&strip->initialized);
+
     /* Add the segment to the segments list. */
+    RTOS_MUTEX_GET(&strip->lock);
     CList_append(list, segment);
     strip->numSegments++;
-
-    ret = RTOS_TASK_CREATE_DYNAMIC(
-        &segment->taskHandle,
-        segment_loop,
-        segment->taskName,
-        segment->taskStack,
-        segment->taskStackSize,
-        (void *)segment,
-        segment->taskPrio);
-    if (ret != 0)
-    {
-        LOG_ERR("Failed creating LED segment task (%d)", ret);
-        return ret;
-    }
+    RTOS_MUTEX_PUT(&strip->lock);
 
     return 0;
 }
@@ -1406,7 +1443,7 @@ WS2812Led_show_all(WS2812Led_Strip *strip)
     CLIST_ITER(iter, &strip->segments)
     {
         segment = (WS2812Led_Segment *)iter;
-        segment->show(segment);
+        WS2812Led_seg_show(segment);
     }
 }
 
@@ -1426,13 +1463,16 @@ WS2812Led_init_strip( const struct device *dev, WS2812Led_Strip *strip)
 
     strip->dev = dev;
 
-    if (!device_is_ready(dev))
+    if ((ret = strip_setup(strip)) < 0)
     {
-        LOG_ERR("LED strip device is not ready");
-        return -ENODEV;
+        return ret;
     }
 
-    RTOS_SEM_INIT(&strip->initialized);
+    if (strip->taskStackSize == 0)
+    {
+        /* Frames are driven by the application with WS2812Led_frame. */
+        return 0;
+    }
 
     LOG_INF("Creating Led strip task.");
     ret = RTOS_TASK_CREATE_DYNAMIC(
@@ -1468,6 +1508,8 @@ WS2812Led_init_strip( const struct device *dev, WS2812Led_Strip *strip)
     @param[in] segStackSize  Stack size for the segment effects loop (try 512).
     @param[in] segLoop_ms  Loop delay, ms for the segment effects loop (try 50).
     @param[in] segPrio  Segment task priority (try 15).
+    The seg* parameters are unused with CONFIG_WS2812LED_RENDER_SCHEDULER.
+    A stack size of 0 creates no task, see WS2812Led_frame.
     @return 0 on success, negative error code on failure.
 ******************************************************************************/
 int
@@ -1490,6 +1532,7 @@ WS2812Led_init(
     strip->dev = dev;
     strip->numPixels = numPixels;
     strip->loopDelay_ms = taskLoop_ms;
+    strip->targetFps = CONFIG_WS2812LED_TARGET_FPS;
     strip->taskStackSize = taskStackSize;
     strip->taskPrio = taskPrio;
     strncpy(strip->taskName, name, sizeof(strip->taskName));
@@ -1504,27 +1547,27 @@ WS2812Led_init(
 
     LOG_INF("seg->startIdx = %u", seg->startIdx);
 
-    if (!device_is_ready(dev))
+    if ((ret = strip_setup(strip)) < 0)
     {
-        LOG_ERR("LED strip device is not ready");
-        return -ENODEV;
+        return ret;
     }
 
-    RTOS_SEM_INIT(&strip->initialized);
-
-    LOG_INF("Creating Led task.");
-    ret = RTOS_TASK_CREATE_DYNAMIC(
-        &strip->taskHandle,
-        led_main,
-        strip->taskName,
-        strip->taskStack,
-        strip->taskStackSize,
-        (void *)strip,
-        strip->taskPrio);
-    if (ret != 0)
+    if (strip->taskStackSize != 0)
     {
-        LOG_ERR("Failed creating LED strip task (%d)", ret);
-        return ret;
+        LOG_INF("Creating Led task.");
+        ret = RTOS_TASK_CREATE_DYNAMIC(
+            &strip->taskHandle,
+            led_main,
+            strip->taskName,
+            strip->taskStack,
+            strip->taskStackSize,
+            (void *)strip,
+            strip->taskPrio);
+        if (ret != 0)
+        {
+            LOG_ERR("Failed creating LED strip task (%d)", ret);
+            return ret;
+        }
     }
 
     /* Add the built-in segment. */
@@ -1536,3 +1579,128 @@ WS2812Led_init(
 
     return 0;
 }
+
+/******************************************************************************
+    [docimport WS2812Led_getStrip]
+*//**
+    @brief Returns an initialized strip, in order of initialization.
+    @param[in] idx  Strip index.
+    @return Returns the strip, NULL if there are not that many strips.
+******************************************************************************/
+WS2812Led_Strip *
+WS2812Led_getStrip(uint32_t idx)
+{
+    WS2812Led_Strip *strip;
+
+    RTOS_MUTEX_GET(&strips_lock);
+    for (strip = strips; strip && idx > 0; idx--)
+    {
+        strip = strip->next;
+    }
+    RTOS_MUTEX_PUT(&strips_lock);
+
+    return strip;
+}
+
+/******************************************************************************
+    [docimport WS2812Led_getMetrics]
+*//**
+    @brief Copies a strip's frame metrics.
+    @param[in] strip  Pointer to the strip.
+    @param[out] metrics  Returned metrics.
+******************************************************************************/
+void
+WS2812Led_getMetrics(WS2812Led_Strip *strip, WS2812Led_Metrics *metrics)
+{
+    RTOS_MUTEX_GET(&strip->lock);
+    *metrics = strip->metrics;
+    RTOS_MUTEX_PUT(&strip->lock);
+}
+
+/******************************************************************************
+    [docimport WS2812Led_resetMetrics]
+*//**
+    @brief Clears a strip's frame metrics and frame counters.
+    @param[in] strip  Pointer to the strip.
+******************************************************************************/
+void
+WS2812Led_resetMetrics(WS2812Led_Strip *strip)
+{
+    RTOS_MUTEX_GET(&strip->lock);
+    memset(&strip->metrics, 0, sizeof(strip->metrics));
+    strip->framesWritten = 0;
+    strip->framesSkipped = 0;
+    strip->segmentsComposed = 0;
+    RTOS_MUTEX_PUT(&strip->lock);
+}
+
+/******************************************************************************
+    [docimport WS2812Led_init_group]
+*//**
+    @brief Initializes a group of LED strips driven by one task.
+    @param[in] group  Pointer to the group, with strips, numStrips and the task
+    settings set.
+    @return 0 on success, negative error code on failure.
+******************************************************************************/
+int
+WS2812Led_init_group(WS2812Led_Group *group)
+{
+    WS2812Led_Strip *strip;
+    uint8_t i;
+    int ret;
+
+    if (group->numStrips == 0 || group->numStrips > WS2812LED_GROUP_MAX_STRIPS)
+    {
+        LOG_ERR("Invalid number of strips in group: %u", group->numStrips);
+        return -EINVAL;
+    }
+
+    group->framesWritten = 0;
+    group->missedDeadlines = 0;
+
+    for (i = 0; i < group->numStrips; i++)
+    {
+        strip = group->strips[i];
+        if ((ret = strip_setup(strip)) < 0)
+        {
+            return ret;
+        }
+
+#if defined(CONFIG_WS2812LED_GROUP_PARALLEL)
+        RTOS_SEM_INIT(&strip->txStart);
+        RTOS_SEM_INIT(&strip->txDone);
+
+        LOG_INF("Creating Led strip tx task.");
+        ret = RTOS_TASK_CREATE_DYNAMIC(
+            &strip->taskHandle,
+            strip_tx_main,
+            strip->taskName,
+            strip->taskStack,
+            strip->taskStackSize,
+            (void *)strip,
+            strip->taskPrio);
+        if (ret != 0)
+        {
+            LOG_ERR("Failed creating LED strip tx task (%d)", ret);
+            return ret;
+        }
+#endif
+    }
+
+    LOG_INF("Creating Led group task.");
+    ret = RTOS_TASK_CREATE_DYNAMIC(
+        &group->taskHandle,
+        group_main,
+        group->taskName,
+        group->taskStack,
+        group->taskStackSize,
+        (void *)group,
+        group->taskPrio);
+    if (ret != 0)
+    {
+        LOG_ERR("Failed creating LED group task (%d)", ret);
+        return ret;
+    }
+
+    return 0;
+}
@@ -0,0 +1,327 @@
+/*******************************************************************************
+ *  @file: WS2812LedColor.c
+ *
+ *  @brief: HSV to RGB conversion and blending for WS2812 strips.
+*******************************************************************************/
+#include <stdint.h>
+#include <zephyr/sys/util.h>
+
+#include "WS2812LedColor.h"
+
+/** @brief Gamma correction array. */
+const uint8_t gammaArray[] = {
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+    0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  1,  1,  1,  1,
+    1,  1,  1,  1,  1,  1,  1,  1,  1,  2,  2,  2,  2,  2,  2,  2,
+    2,  3,  3,  3,  3,  3,  3,  3,  4,  4,  4,  4,  4,  5,  5,  5,
+    5,  6,  6,  6,  6,  7,  7,  7,  7,  8,  8,  8,  9,  9,  9, 10,
+   10, 10, 11, 11, 11, 12, 12, 13, 13, 13, 14, 14, 15, 15, 16, 16,
+   17, 17, 18, 18, 19, 19, 20, 20, 21, 21, 22, 22, 23, 24, 24, 25,
+   25, 26, 27, 27, 28, 29, 29, 30, 31, 32, 32, 33, 34, 35, 35, 36,
+   37, 38, 39, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 50,
+   51, 52, 54, 55, 56, 57, 58, 59, 60, 61, 62, 63, 64, 66, 67, 68,
+   69, 70, 72, 73, 74, 75, 77, 78, 79, 81, 82, 83, 85, 86, 87, 89,
+   90, 92, 93, 95, 96, 98, 99,101,102,104,105,107,109,110,112,114,
+  115,117,119,120,122,124,126,127,129,131,133,135,137,138,140,142,
+  144,146,148,150,152,154,156,158,160,162,164,167,169,171,173,175,
+  177,180,182,184,186,189,191,193,196,198,200,203,205,208,210,213,
+  215,218,220,223,225,228,231,233,236,239,241,244,247,249,252,255
+};
+
+/** @brief Gamma correction lookup. */
+static inline uint8_t
+gamma8(uint8_t idx)
+{
+    return gammaArray[idx];
+}
+
+/** @brief Rainbow spectrum at full saturation and value, linear (before
+    gamma): FastLED's hsv2rgb_rainbow (yellow boost Y1) per hue.
+    Indexed by hue, { r, g, b }.
+*/
+static const uint8_t rainbowLut[256][3] = {
+    {255,  0,  0}, {253,  2,  0}, {250,  5,  0}, {248,  7,  0},
+    {245, 10,  0}, {242, 13,  0}, {240, 15,  0}, {237, 18,  0},
+    {234, 21,  0}, {232, 23,  0}, {229, 26,  0}, {226, 29,  0},
+    {224, 31,  0}, {221, 34,  0}, {218, 37,  0}, {216, 39,  0},
+    {213, 42,  0}, {210, 45,  0}, {208, 47,  0}, {205, 50,  0},
+    {202, 53,  0}, {200, 55,  0}, {197, 58,  0}, {194, 61,  0},
+    {192, 63,  0}, {189, 66,  0}, {186, 69,  0}, {184, 71,  0},
+    {181, 74,  0}, {178, 77,  0}, {176, 79,  0}, {173, 82,  0},
+    {171, 85,  0}, {171, 87,  0}, {171, 90,  0}, {171, 92,  0},
+    {171, 95,  0}, {171, 98,  0}, {171,100,  0}, {171,103,  0},
+    {171,106,  0}, {171,108,  0}, {171,111,  0}, {171,114,  0},
+    {171,116,  0}, {171,119,  0}, {171,122,  0}, {171,124,  0},
+    {171,127,  0}, {171,130,  0}, {171,132,  0}, {171,135,  0},
+    {171,138,  0}, {171,140,  0}, {171,143,  0}, {171,146,  0},
+    {171,148,  0}, {171,151,  0}, {171,154,  0}, {171,156,  0},
+    {171,159,  0}, {171,162,  0}, {171,164,  0}, {171,167,  0},
+    {171,170,  0}, {166,172,  0}, {161,175,  0}, {156,177,  0},
+    {150,180,  0}, {145,183,  0}, {140,185,  0}, {134,188,  0},
+    {129,191,  0}, {124,193,  0}, {118,196,  0}, {113,199,  0},
+    {108,201,  0}, {102,204,  0}, { 97,207,  0}, { 92,209,  0},
+    { 86,212,  0}, { 81,215,  0}, { 76,217,  0}, { 71,220,  0},
+    { 65,223,  0}, { 60,225,  0}, { 55,228,  0}, { 49,231,  0},
+    { 44,233,  0}, { 39,236,  0}, { 33,239,  0}, { 28,241,  0},
+    { 23,244,  0}, { 17,247,  0}, { 12,249,  0}, {  7,252,  0},
+    {  0,255,  0}, {  0,253,  2}, {  0,250,  5}, {  0,248,  7},
+    {  0,245, 10}, {  0,242, 13}, {  0,240, 15}, {  0,237, 18},
+    {  0,234, 21}, {  0,232, 23}, {  0,229, 26}, {  0,226, 29},
+    {  0,224, 31}, {  0,221, 34}, {  0,218, 37}, {  0,216, 39},
+    {  0,213, 42}, {  0,210, 45}, {  0,208, 47}, {  0,205, 50},
+    {  0,202, 53}, {  0,200, 55}, {  0,197, 58}, {  0,194, 61},
+    {  0,192, 63}, {  0,189, 66}, {  0,186, 69}, {  0,184, 71},
+    {  0,181, 74}, {  0,178, 77}, {  0,176, 79}, {  0,173, 82},
+    {  0,171, 85}, {  0,166, 90}, {  0,161, 95}, {  0,156,100},
+    {  0,150,106}, {  0,145,111}, {  0,140,116}, {  0,134,122},
+    {  0,129,127}, {  0,124,132}, {  0,118,138}, {  0,113,143},
+    {  0,108,148}, {  0,102,154}, {  0, 97,159}, {  0, 92,164},
+    {  0, 86,170}, {  0, 81,175}, {  0, 76,180}, {  0, 71,185},
+    {  0, 65,191}, {  0, 60,196}, {  0, 55,201}, {  0, 49,207},
+    {  0, 44,212}, {  0, 39,217}, {  0, 33,223}, {  0, 28,228},
+    {  0, 23,233}, {  0, 17,239}, {  0, 12,244}, {  0,  7,249},
+    {  0,  0,255}, {  2,  0,253}, {  5,  0,250}, {  7,  0,248},
+    { 10,  0,245}, { 13,  0,242}, { 15,  0,240}, { 18,  0,237},
+    { 21,  0,234}, { 23,  0,232}, { 26,  0,229}, { 29,  0,226},
+    { 31,  0,224}, { 34,  0,221}, { 37,  0,218}, { 39,  0,216},
+    { 42,  0,213}, { 45,  0,210}, { 47,  0,208}, { 50,  0,205},
+    { 53,  0,202}, { 55,  0,200}, { 58,  0,197}, { 61,  0,194},
+    { 63,  0,192}, { 66,  0,189}, { 69,  0,186}, { 71,  0,184},
+    { 74,  0,181}, { 77,  0,178}, { 79,  0,176}, { 82,  0,173},
+    { 85,  0,171}, { 87,  0,169}, { 90,  0,166}, { 92,  0,164},
+    { 95,  0,161}, { 98,  0,158}, {100,  0,156}, {103,  0,153},
+    {106,  0,150}, {108,  0,148}, {111,  0,145}, {114,  0,142},
+    {116,  0,140}, {119,  0,137}, {122,  0,134}, {124,  0,132},
+    {127,  0,129}, {130,  0,126}, {132,  0,124}, {135,  0,121},
+    {138,  0,118}, {140,  0,116}, {143,  0,113}, {146,  0,110},
+    {148,  0,108}, {151,  0,105}, {154,  0,102}, {156,  0,100},
+    {159,  0, 97}, {162,  0, 94}, {164,  0, 92}, {167,  0, 89},
+    {170,  0, 85}, {172,  0, 83}, {175,  0, 80}, {177,  0, 78},
+    {180,  0, 75}, {183,  0, 72}, {185,  0, 70}, {188,  0, 67},
+    {191,  0, 64}, {193,  0, 62}, {196,  0, 59}, {199,  0, 56},
+    {201,  0, 54}, {204,  0, 51}, {207,  0, 48}, {209,  0, 46},
+    {212,  0, 43}, {215,  0, 40}, {217,  0, 38}, {220,  0, 35},
+    {223,  0, 32}, {225,  0, 30}, {228,  0, 27}, {231,  0, 24},
+    {233,  0, 22}, {236,  0, 19}, {239,  0, 16}, {241,  0, 14},
+    {244,  0, 11}, {247,  0,  8}, {249,  0,  6}, {252,  0,  3},
+};
+
+/******************************************************************************
+    [docimport WS2812Led_hsv2rgb]
+*//**
+    @brief Converts an HSV color to gamma corrected RGB (hexcone spectrum).
+    @param[in] hsv  Color to convert.
+    @param[out] rgb  Converted color.
+******************************************************************************/
+void
+WS2812Led_hsv2rgb(const CHSV *hsv, CRGB *rgb)
+{
+    unsigned char region, remainder, p, q, t;
+    
+    if (hsv->s == 0)
+    {
+        rgb->r = gamma8(hsv->v);
+        rgb->g = gamma8(hsv->v);
+        rgb->b = gamma8(hsv->v);
+        return;
+    }
+    
+    region = hsv->h / 43;
+    remainder = (hsv->h - (region * 43)) * 6; 
+    
+    p = (hsv->v * (255 - hsv->s)) >> 8;
+    q = (hsv->v * (255 - ((hsv->s * remainder) >> 8))) >> 8;
+    t = (hsv->v * (255 - ((hsv->s * (255 - remainder)) >> 8))) >> 8;
+    
+    switch (region)
+    {
+        case 0:
+            rgb->r = hsv->v;
+            rgb->g = t;
+            rgb->b = p;
+            break;
+        case 1:
+            rgb->r = q;
+            rgb->g = hsv->v;
+            rgb->b = p;
+            break;
+        case 2:
+            rgb->r = p;
+            rgb->g = hsv->v;
+            rgb->b = t;
+            break;
+        case 3:
+            rgb->r = p;
+            rgb->g = q;
+            rgb->b = hsv->v;
+            break;
+        case 4:
+            rgb->r = t;
+            rgb->g = p;
+            rgb->b = hsv->v;
+            break;
+        default:
+            rgb->r = hsv->v;
+            rgb->g = p; 
+            rgb->b = q;
+            break;
+    }
+
+    rgb->r = gamma8(rgb->r);
+    rgb->g = gamma8(rgb->g);
+    rgb->b = gamma8(rgb->b);
+}
+
+/** @brief Scales a table channel by saturation and value, linear. */
+static inline uint8_t
+rainbow8(uint8_t c, uint32_t sat, uint32_t bright, uint32_t val)
+{
+    return (uint8_t)(((((c * sat) >> 8) + bright) * val) >> 8);
+}
+
+/******************************************************************************
+    [docimport WS2812Led_hsv2rgbRainbow]
+*//**
+    @brief Converts HSV colors to gamma corrected RGB (rainbow spectrum, as
+    FastLED's hsv2rgb_rainbow) from a lookup table. No branches or divides
+    per pixel.
+    @param[in] hsv  Colors to convert.
+    @param[out] rgb  Converted colors.
+    @param[in] num  Number of colors.
+******************************************************************************/
+void
+WS2812Led_hsv2rgbRainbow(const CHSV *hsv, CRGB *rgb, uint16_t num)
+{
+    const uint8_t *c;
+    uint32_t sat;
+    uint32_t bright;
+    uint32_t val;
+    uint16_t i;
+
+    for (i = 0; i < num; i++)
+    {
+        /*  Linear u[8 8] scales, as the hexcone conversion: the table color
+            is scaled by s and lifted by the white floor 255 - s, which can
+            not overflow (c * (s + 1) >> 8 <= s), then scaled by v. Gamma
+            is applied once, last.
+        */
+        c = rainbowLut[hsv[i].h];
+        sat = (uint32_t)hsv[i].s + 1;
+        bright = 255 - (uint32_t)hsv[i].s;
+        val = (uint32_t)hsv[i].v + 1;
+
+        rgb[i].r = gamma8(rainbow8(c[0], sat, bright, val));
+        rgb[i].g = gamma8(rainbow8(c[1], sat, bright, val));
+        rgb[i].b = gamma8(rainbow8(c[2], sat, bright, val));
+    }
+}
+
+/******************************************************************************
+    [docimport WS2812Led_hsv2rgbBatch]
+*//**
+    @brief Converts HSV colors to RGB with the conversion used by the strip:
+    WS2812Led_hsv2rgbRainbow with CONFIG_WS2812LED_HSV_LUT, else
+    WS2812Led_hsv2rgb.
+    @param[in] hsv  Colors to convert.
+    @param[out] rgb  Converted colors.
+    @param[in] num  Number of colors.
+******************************************************************************/
+void
+WS2812Led_hsv2rgbBatch(const CHSV *hsv, CRGB *rgb, uint16_t num)
+{
+#if defined(CONFIG_WS2812LED_HSV_LUT)
+    WS2812Led_hsv2rgbRainbow(hsv, rgb, num);
+#else
+    uint16_t i;
+
+    for (i = 0; i < num; i++)
+    {
+        WS2812Led_hsv2rgb(&hsv[i], &rgb[i]);
+    }
+#endif
+}
+
+/** @brief Scales a channel by a u[0 8] amount, 255 keeps it. */
+static inline uint8_t
+scale8(uint8_t x, uint8_t amt)
+{
+    return (uint8_t)((x * ((uint32_t)amt + 1)) >> 8);
+}
+
+/** @brief Mixes from a to b by amt, as FastLED's blend8: 0 is a, 255 is b. */
+static inline uint8_t
+blend8(uint8_t a, uint8_t b, uint8_t amt)
+{
+    return (uint8_t)((((int32_t)a << 8) + b + ((int32_t)b - a) * amt) >> 8);
+}
+
+/** @brief Saturating add. */
+static inline uint8_t
+qadd8(uint8_t a, uint8_t b)
+{
+    uint32_t sum = (uint32_t)a + b;
+
+    return (sum > 255) ? 255 : (uint8_t)sum;
+}
+
+/******************************************************************************
+    [docimport WS2812Led_blendRgb]
+*//**
+    @brief Blends colors onto the colors below them.
+    @param[in,out] dst  Colors below, returned blended.
+    @param[in] src  Colors on top.
+    @param[in] num  Number of colors.
+    @param[in] mode  Blend mode.
+    @param[in] alpha  Opacity (ALPHA) or scale (ADD, MAX) of src, 255 is full.
+******************************************************************************/
+void
+WS2812Led_blendRgb(
+    CRGB *dst,
+    const CRGB *src,
+    uint16_t num,
+    WS2812Led_BlendMode mode,
+    uint8_t alpha)
+{
+    uint16_t i;
+
+    /* One loop per mode, no switch per pixel. */
+    switch (mode)
+    {
+    case WS2812LED_BLEND_ALPHA:
+        for (i = 0; i < num; i++)
+        {
+            dst[i].r = blend8(dst[i].r, src[i].r, alpha);
+            dst[i].g = blend8(dst[i].g, src[i].g, alpha);
+            dst[i].b = blend8(dst[i].b, src[i].b, alpha);
+        }
+        break;
+
+    case WS2812LED_BLEND_ADD:
+        for (i = 0; i < num; i++)
+        {
+            dst[i].r = qadd8(dst[i].r, scale8(src[i].r, alpha));
+            dst[i].g = qadd8(dst[i].g, scale8(src[i].g, alpha));
+            dst[i].b = qadd8(dst[i].b, scale8(src[i].b, alpha));
+        }
+        break;
+
+    case WS2812LED_BLEND_MAX:
+        for (i = 0; i < num; i++)
+        {
+            dst[i].r = MAX(dst[i].r, scale8(src[i].r, alpha));
+            dst[i].g = MAX(dst[i].g, scale8(src[i].g, alpha));
+            dst[i].b = MAX(dst[i].b, scale8(src[i].b, alpha));
+        }
+        break;
+
+    case WS2812LED_BLEND_COPY:
+    default:
+        for (i = 0; i < num; i++)
+        {
+            dst[i].r = src[i].r;
+            dst[i].g = src[i].g;
+            dst[i].b = src[i].b;
+        }
+        break;
+    }
+}
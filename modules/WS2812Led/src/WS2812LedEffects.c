@@ -0,0 +1,481 @@
+/*******************************************************************************
+ *  @file: WS2812LedEffects.c
+ *
+ *  @brief: Built-in WS2812 segment effects.
+*******************************************************************************/
+#include <string.h>
+
+#include <zephyr/kernel.h>
+
+#include "WS2812Led.h"
+
+/** @brief Computes u[8 0]*u[8 8] -> u[8 0] */
+#define SCALE8(x, scale)        ((uint8_t)(((uint16_t)(x) * (scale)) >> 8))
+
+/** @brief Computes u[8 0]*u[8 8] -> u[8 0] but guarantees the output is nonzero
+  if both inputs are nonzero (referred to as 'video' dimming) */
+#define SCALE8_NZ(x, scale)\
+    ((uint8_t)(((uint16_t)(x) * (uint16_t)(scale)) >> 8) + (((x) && (scale)) ? 1 : 0))
+
+/** @brief Perform a - b but clamp result at 0. */
+#define SUB_SAFE(a, b)    (((b) > (a)) ? 0 : (a) - (b))
+
+/** @brief Perform a + b, do not allow overflow. */
+#define ADD8_SAFE(a, b)\
+    (((uint16_t)(a) + (uint16_t)(b) > 255) ? 255 : (a) + (b))
+
+/** @brief Blanks the segment's back buffer. Effects do not use the segment
+    fill methods, which would stop them. */
+#define BLANK_STRIP(seg)\
+    memset((seg)->pixels, 0, (seg)->numPixels * sizeof(CHSV))
+
+#define BLANK_STRIP_RGB(seg)\
+    memset((seg)->rgb_pixels, 0, (seg)->numPixels * sizeof(CRGB))
+
+/** @brief Scale an RGB value. */
+static inline void
+scale8_rgb(CRGB *rgb, uint8_t scale)
+{
+    rgb->r = SCALE8(rgb->r, scale);
+    rgb->g = SCALE8(rgb->g, scale);
+    rgb->b = SCALE8(rgb->b, scale);
+}
+
+/** @brief Converts a single color with the strip's conversion. */
+static inline void
+hsv2rgb(const CHSV *hsv, CRGB *rgb)
+{
+    WS2812Led_hsv2rgbBatch(hsv, rgb, 1);
+}
+
+/******************************************************************************
+    is_seg_blank_rgb
+*//**
+    @brief Test that a segment is blank (using rgb_pixels).
+    @param[in] seg  Pointer to active segment.
+    @return Returns true if the segment is blank, false otherwise.
+******************************************************************************/
+static bool
+is_seg_blank_rgb(WS2812Led_Segment *seg)
+{
+    CRGB *pix;
+    for (int i = 0; i < seg->numPixels; i++)
+    {
+        pix = &seg->rgb_pixels[i];
+        if (pix->r > 0 || pix->g > 0 || pix->b > 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/******************************************************************************
+    get_heatcolor
+*//**
+    @brief Approximates a black body radiadion spectrum for a given temperature
+  level. Used for fire animations. Ported from FastLED's HeatColor function.
+******************************************************************************/
+static void
+get_heatcolor(uint8_t temperature, CRGB *heatcolor)
+{
+    uint8_t t192;
+    uint8_t heatramp;
+
+    /* Scale temperature from 0-255 to 0-191. This can easily be divided into
+        three equal thirds of 64 each. */
+    t192 = SCALE8_NZ(temperature, 191);
+
+    /* Calculate a value that ramps up from 0 to 255 in each third of the scale
+    */
+    heatramp = t192 & 0x3f;   /* 0..63 */
+    heatramp <<= 2;           /* Scale up to 0..252 */
+
+    /* Hottest 1/3 */
+    if (t192 & 0x80)
+    {
+        heatcolor->r = 255;
+        heatcolor->g = 255;
+        heatcolor->b = heatramp;
+    }
+    /* Middle 1/3 */
+    else if (t192 & 0x40)
+    {
+        heatcolor->r = 255;
+        heatcolor->g = heatramp;
+        heatcolor->b = 0;
+    }
+    /* Coolest 1/3 */
+    else
+    {
+        heatcolor->r = heatramp;
+        heatcolor->g = 0;
+        heatcolor->b = 0;
+    }
+}
+
+/******************************************************************************
+    fadePixel
+*//**
+    @brief Fades a pixel by factor 0-255 (0=no fade, 255=max fade).
+
+    @param[in] seg  Pointer to the active segment.
+    @param[in] idx  The segment pixel index to fade.
+    @param[in] factor  Factor controlling amount to fade by.
+******************************************************************************/
+static void
+fadePixel(WS2812Led_Segment *seg, uint16_t idx, uint8_t factor)
+{
+    scale8_rgb(&seg->rgb_pixels[idx], 255-factor);
+}
+
+/****************** BLINK *****************************************************/
+
+/** @brief Toggles the segment on and off every step. */
+static void
+blink_init(WS2812Led_Segment *seg, void *state, const void *params)
+{
+    ARG_UNUSED(seg);
+    ARG_UNUSED(state);
+    ARG_UNUSED(params);
+}
+
+static void
+blink_step(WS2812Led_Segment *seg, void *state)
+{
+    ARG_UNUSED(state);
+
+    seg->state = (seg->state == SEG_ON) ? SEG_OFF : SEG_ON;
+}
+
+/* Blink keeps no state of its own. */
+WS2812LED_EFFECT_DEFINE(WS2812Led_effect_blink,
+    blink_init, blink_step, uint8_t);
+
+/****************** BLEND *****************************************************/
+
+/** @brief Blends all pixels from start color to end color over a set number
+    of steps, then starts over. */
+static void
+blend_init(WS2812Led_Segment *seg, void *state, const void *params)
+{
+    WS2812Led_GradientIter *gradIter = (WS2812Led_GradientIter *)state;
+    const WS2812Led_BlendParams *p = (const WS2812Led_BlendParams *)params;
+
+    seg->use_rgb_pixels = false;
+    WS2812Led_gradientIter(p->startColor, p->endColor, p->dir, p->numSteps,
+        gradIter);
+    gradIter->initialized = OBJ_INIT_CODE;
+    for (unsigned int i = 0; i < seg->numPixels; i++)
+    {
+        seg->pixels[i] = *p->startColor;
+    }
+}
+
+static void
+blend_step(WS2812Led_Segment *seg, void *state)
+{
+    WS2812Led_GradientIter *gradIter = (WS2812Led_GradientIter *)state;
+    CHSV hsv;
+
+    gradIter->hueAccum_8 += gradIter->hueDelta_8;
+    gradIter->satAccum_8 += gradIter->satDelta_8;
+    gradIter->valAccum_8 += gradIter->valDelta_8;
+    gradIter->stepIdx++;
+
+    if (gradIter->stepIdx == gradIter->numSteps)
+    {
+        gradIter->hueAccum_8 = gradIter->hueStart_8;
+        gradIter->satAccum_8 = gradIter->satStart_8;
+        gradIter->valAccum_8 = gradIter->valStart_8;
+        gradIter->stepIdx = 0;
+    }
+
+    hsv.h = gradIter->hueAccum_8 >> 8;
+    hsv.s = gradIter->satAccum_8 >> 8;
+    hsv.v = gradIter->valAccum_8 >> 8;
+    for (unsigned int i = 0; i < seg->numPixels; i++)
+    {
+        seg->pixels[i] = hsv;
+    }
+}
+
+WS2812LED_EFFECT_DEFINE(WS2812Led_effect_blend,
+    blend_init, blend_step, WS2812Led_GradientIter);
+
+/****************** TWINKLE ***************************************************/
+
+typedef struct
+{
+    uint16_t num;
+    uint16_t count;
+} TwinkleState;
+
+/** @brief Lights random pixels with random colors, one per step, clearing the
+    segment after num. */
+static void
+twinkle_init(WS2812Led_Segment *seg, void *state, const void *params)
+{
+    TwinkleState *fx = (TwinkleState *)state;
+    const WS2812Led_TwinkleParams *p = (const WS2812Led_TwinkleParams *)params;
+
+    seg->use_rgb_pixels = false;
+    fx->num = p->num;
+    BLANK_STRIP(seg);
+}
+
+static void
+twinkle_step(WS2812Led_Segment *seg, void *state)
+{
+    TwinkleState *fx = (TwinkleState *)state;
+    uint16_t idx;
+
+    idx = RANDOM_FAST_UINT(&seg->rng, uint16_t, seg->numPixels);
+    seg->pixels[idx] = WS2812LED_RANDOM_HSV(seg);
+
+    fx->count++;
+    if (fx->count == fx->num)
+    {
+        BLANK_STRIP(seg);
+        fx->count = 0;
+    }
+}
+
+WS2812LED_EFFECT_DEFINE(WS2812Led_effect_twinkle,
+    twinkle_init, twinkle_step, TwinkleState);
+
+/****************** SPARKLE ***************************************************/
+
+typedef struct
+{
+    CHSV color;
+    bool useColor;
+    uint16_t num;
+} SparkleState;
+
+/** @brief Lights num random pixels each step, in the given hue or in random
+    colors. */
+static void
+sparkle_init(WS2812Led_Segment *seg, void *state, const void *params)
+{
+    SparkleState *fx = (SparkleState *)state;
+    const WS2812Led_SparkleParams *p = (const WS2812Led_SparkleParams *)params;
+
+    seg->use_rgb_pixels = false;
+    fx->useColor = (p->color != NULL);
+    if (p->color)
+    {
+        fx->color = *p->color;
+    }
+    fx->num = p->num;
+    BLANK_STRIP(seg);
+}
+
+static void
+sparkle_step(WS2812Led_Segment *seg, void *state)
+{
+    SparkleState *fx = (SparkleState *)state;
+    uint16_t idx;
+
+    BLANK_STRIP(seg);
+    for (int i = 0; i < fx->num; i++)
+    {
+        idx = RANDOM_FAST_UINT(&seg->rng, uint16_t, seg->numPixels);
+        if (fx->useColor)
+        {
+            seg->pixels[idx] = WS2812LED_RANDOM_SATVAL(seg, fx->color.h);
+        }
+        else
+        {
+            seg->pixels[idx] = WS2812LED_RANDOM_HSV(seg);
+        }
+    }
+}
+
+WS2812LED_EFFECT_DEFINE(WS2812Led_effect_sparkle,
+    sparkle_init, sparkle_step, SparkleState);
+
+/****************** FIRE ******************************************************/
+
+typedef struct
+{
+    uint8_t cooling;
+    uint8_t sparking;
+} FireState;
+
+/** @brief Fire, heat per pixel kept in the segment's work buffer. */
+static void
+fire_init(WS2812Led_Segment *seg, void *state, const void *params)
+{
+    FireState *fx = (FireState *)state;
+    const WS2812Led_FireParams *p = (const WS2812Led_FireParams *)params;
+
+    seg->use_rgb_pixels = true;
+    fx->cooling = p->cooling;
+    fx->sparking = p->sparking;
+    memset(seg->workBuf, 0, seg->numPixels);
+    BLANK_STRIP_RGB(seg);
+}
+
+static void
+fire_step(WS2812Led_Segment *seg, void *state)
+{
+    FireState *fx = (FireState *)state;
+    uint8_t *heat = seg->workBuf;
+    uint8_t coolMax = ((fx->cooling*10)/seg->numPixels) + 2;
+    uint8_t randu8;
+    uint8_t randrange;
+    int i;
+
+    /* Cool down every pixel a little */
+    for (i = 0; i < seg->numPixels; i++)
+    {
+        randu8 = RANDOM_FAST_UINT(&seg->rng, uint8_t, coolMax);
+        heat[i] = SUB_SAFE(heat[i], randu8);
+    }
+
+    /* Heat from each cell drifts up and diffuses a little */
+    for (i = seg->numPixels-1; i >= 2; i--)
+    {
+        heat[i] = (heat[i-1] + heat[i-2] + heat[i-2])/3;
+    }
+
+    /* Randomly ignite new 'sparks' of heat near the bottom */
+    if (RANDOM_FAST_U8(&seg->rng) < fx->sparking)
+    {
+        randu8 = RANDOM_FAST_UINT(&seg->rng, uint8_t,
+            MIN(seg->numPixels, 7));
+        randrange = RANDOM_FAST_URANGE(&seg->rng, uint8_t, 160, 255);
+        heat[randu8] = ADD8_SAFE(heat[randu8], randrange);
+    }
+
+    /* Map from heat cells to LED colors. */
+    for (i = 0; i < seg->numPixels; i++)
+    {
+        get_heatcolor(heat[i], &seg->rgb_pixels[i]);
+    }
+}
+
+WS2812LED_EFFECT_DEFINE(WS2812Led_effect_fire,
+    fire_init, fire_step, FireState);
+
+/****************** DISSOLVE **************************************************/
+
+typedef struct
+{
+    CRGB color;
+    uint8_t decay;
+    uint8_t prob;
+} DissolveState;
+
+/** @brief Fades random pixels out of a solid color, restoring it once the
+    segment is blank. */
+static void
+dissolve_init(WS2812Led_Segment *seg, void *state, const void *params)
+{
+    DissolveState *fx = (DissolveState *)state;
+    const WS2812Led_DissolveParams *p =
+        (const WS2812Led_DissolveParams *)params;
+
+    seg->use_rgb_pixels = true;
+    hsv2rgb(p->color, &fx->color);
+    fx->decay = p->decayFactor;
+    fx->prob = (p->decayProb > 100) ? 100 : p->decayProb;
+    for (int j = 0; j < seg->numPixels; j++)
+    {
+        seg->rgb_pixels[j] = fx->color;
+    }
+}
+
+static void
+dissolve_step(WS2812Led_Segment *seg, void *state)
+{
+    DissolveState *fx = (DissolveState *)state;
+    int j;
+
+    /*  Fade pixels by the decay factor. */
+    for (j = 0; j < seg->numPixels; j++)
+    {
+        if (RANDOM_FAST_UINT(&seg->rng, uint8_t, 100) > (100 - fx->prob))
+        {
+            fadePixel(seg, (uint16_t)j, fx->decay);
+        }
+    }
+
+    /* When entire segment has decayed, restore. */
+    if (is_seg_blank_rgb(seg))
+    {
+        for (j = 0; j < seg->numPixels; j++)
+        {
+            seg->rgb_pixels[j] = fx->color;
+        }
+    }
+}
+
+WS2812LED_EFFECT_DEFINE(WS2812Led_effect_dissolve,
+    dissolve_init, dissolve_step, DissolveState);
+
+/****************** METEOR ****************************************************/
+
+typedef struct
+{
+    CRGB color;
+    uint8_t size;
+    uint8_t decay;
+    bool decayRandom;
+    uint32_t count;
+} MeteorState;
+
+/** @brief A shooting star with a fading tail. */
+static void
+meteor_init(WS2812Led_Segment *seg, void *state, const void *params)
+{
+    MeteorState *fx = (MeteorState *)state;
+    const WS2812Led_MeteorParams *p = (const WS2812Led_MeteorParams *)params;
+
+    seg->use_rgb_pixels = true;
+    hsv2rgb(p->color, &fx->color);
+    fx->size = p->size;
+    fx->decay = p->decay;
+    fx->decayRandom = p->decayRandom;
+    BLANK_STRIP_RGB(seg);
+}
+
+static void
+meteor_step(WS2812Led_Segment *seg, void *state)
+{
+    MeteorState *fx = (MeteorState *)state;
+
+    /*  Fade all pixels by the decay factor. If decayRandom is false, this
+        happens smoothly, otherwise some randomness is built into the decay.
+    */
+    for (int j = 0; j < seg->numPixels; j++)
+    {
+        if ((!fx->decayRandom) ||
+            (RANDOM_FAST_UINT(&seg->rng, uint8_t, 100) > 60))
+        {
+            fadePixel(seg, (uint16_t)j, fx->decay);
+        }
+    }
+
+    /* Draw the meteor */
+    for (int j = 0; j < fx->size; j++)
+    {
+        int pixelPos = (int)fx->count - j;
+        if (pixelPos < 0) continue;
+
+        if (pixelPos < seg->numPixels)
+        {
+            seg->rgb_pixels[pixelPos] = fx->color;
+        }
+    }
+
+    fx->count++;
+    if (fx->count >= 2*seg->numPixels)
+    {
+        fx->count = 0;
+    }
+}
+
+WS2812LED_EFFECT_DEFINE(WS2812Led_effect_meteor,
+    meteor_init, meteor_step, MeteorState);
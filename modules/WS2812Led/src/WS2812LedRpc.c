@@ -0,0 +1,167 @@
+/*******************************************************************************
+ *  @file: WS2812LedRpc.c
+ *
+ *  @brief: Handlers for the WS2812Led RPC callset (proto/WS2812LedRpc).
+*******************************************************************************/
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include "WS2812Led.h"
+#include "WS2812LedRpc.h"
+
+LOG_MODULE_DECLARE(WS2812Led, CONFIG_WS2812LED_LOG_LEVEL);
+
+CallsetInfo ws2812led_Callset_info = {
+    .ver_major = ws2812led_CallsetVersion_MAJOR,
+    .ver_minor = ws2812led_CallsetVersion_MINOR,
+    .ver_patch = ws2812led_CallsetVersion_PATCH,
+    .name = "ws2812led",
+};
+
+/** @brief Copies a stage timing into its reply message. */
+static void
+put_timing(ws2812led_Timing *out, const WS2812Led_Timing *t)
+{
+    out->last_us = t->last_us;
+    out->max_us = t->max_us;
+    out->avg_us = (t->count > 0) ? (uint32_t)(t->total_us / t->count) : 0;
+}
+
+/******************************************************************************
+    getmetrics
+
+    Call params:
+        call->strip: uint32
+    Reply params:
+        reply->num_strips: uint32
+        reply->num_pixels: uint32
+        reply->num_segments: uint32
+        reply->target_fps: uint32
+        reply->frames: uint32
+        reply->frames_written: uint32
+        reply->frames_skipped: uint32
+        reply->missed_deadlines: uint32
+        reply->segments_composed: uint32
+        reply->step: Timing
+        reply->convert: Timing
+        reply->tx: Timing
+*//**
+    @brief Implements the RPC getmetrics handler.
+******************************************************************************/
+static void
+getmetrics(void *call_frame, void *reply_frame, StatusEnum *status)
+{
+    ws2812led_Callset *call_msg = (ws2812led_Callset *)call_frame;
+    ws2812led_Callset *reply_msg = (ws2812led_Callset *)reply_frame;
+    ws2812led_GetMetrics_call *call = &call_msg->msg.getmetrics_call;
+    ws2812led_GetMetrics_reply *reply = &reply_msg->msg.getmetrics_reply;
+    WS2812Led_Strip *strip;
+    WS2812Led_Metrics m;
+
+    LOG_DBG("In getmetrics handler");
+
+    reply_msg->which_msg = ws2812led_Callset_getmetrics_reply_tag;
+    *status = StatusEnum_RPC_SUCCESS;
+
+    reply->num_strips = 0;
+    while (WS2812Led_getStrip(reply->num_strips))
+    {
+        reply->num_strips++;
+    }
+
+    strip = WS2812Led_getStrip(call->strip);
+    if (!strip)
+    {
+        LOG_ERR("No strip %u.", call->strip);
+        *status = StatusEnum_RPC_HANDLER_ERROR;
+        return;
+    }
+
+    WS2812Led_getMetrics(strip, &m);
+
+    reply->num_pixels = strip->numPixels;
+    reply->num_segments = strip->numSegments;
+    reply->target_fps = strip->targetFps;
+    reply->frames = m.frames;
+    reply->frames_written = strip->framesWritten;
+    reply->frames_skipped = strip->framesSkipped;
+    reply->missed_deadlines = m.missedDeadlines;
+    reply->segments_composed = strip->segmentsComposed;
+    reply->has_step = true;
+    put_timing(&reply->step, &m.step);
+    reply->has_convert = true;
+    put_timing(&reply->convert, &m.convert);
+    reply->has_tx = true;
+    put_timing(&reply->tx, &m.tx);
+}
+
+/******************************************************************************
+    resetmetrics
+
+    Call params:
+        call->strip: uint32
+    Reply params:
+*//**
+    @brief Implements the RPC resetmetrics handler.
+******************************************************************************/
+static void
+resetmetrics(void *call_frame, void *reply_frame, StatusEnum *status)
+{
+    ws2812led_Callset *call_msg = (ws2812led_Callset *)call_frame;
+    ws2812led_Callset *reply_msg = (ws2812led_Callset *)reply_frame;
+    ws2812led_ResetMetrics_call *call = &call_msg->msg.resetmetrics_call;
+    ws2812led_ResetMetrics_reply *reply = &reply_msg->msg.resetmetrics_reply;
+    WS2812Led_Strip *strip;
+
+    (void)reply;
+
+    LOG_DBG("In resetmetrics handler");
+
+    reply_msg->which_msg = ws2812led_Callset_resetmetrics_reply_tag;
+    *status = StatusEnum_RPC_SUCCESS;
+
+    strip = WS2812Led_getStrip(call->strip);
+    if (!strip)
+    {
+        LOG_ERR("No strip %u.", call->strip);
+        *status = StatusEnum_RPC_HANDLER_ERROR;
+        return;
+    }
+
+    WS2812Led_resetMetrics(strip);
+}
+
+
+static ProtoRpc_Handler_Entry handlers[] = {
+    PROTORPC_ADD_HANDLER(ws2812led_Callset_getmetrics_call_tag, getmetrics),
+    PROTORPC_ADD_HANDLER(ws2812led_Callset_resetmetrics_call_tag, resetmetrics),
+};
+
+#define NUM_HANDLERS    PROTORPC_ARRAY_LENGTH(handlers)
+
+/******************************************************************************
+    [docimport WS2812LedRpc_resolver]
+*//**
+    @brief Resolver function for WS2812LedRpc.
+    @param[in] call_frame  Pointer to the unpacked call frame object.
+    @param[out] which_msg  Output which_msg was requested.
+******************************************************************************/
+ProtoRpc_handler *
+WS2812LedRpc_resolver(void *call_frame, uint32_t *which_msg)
+{
+    ws2812led_Callset *this = (ws2812led_Callset *)call_frame;
+    unsigned int i;
+
+    *which_msg = this->which_msg;
+
+    /** @brief Handler lookup */
+    for (i = 0; i < NUM_HANDLERS; i++)
+    {
+        ProtoRpc_Handler_Entry *entry = &handlers[i];
+        if (entry->tag == this->which_msg)
+        {
+            return entry->handler;
+        }
+    }
+
+    return NULL;
+}
@@ -6,7 +6,42 @@
 #ifndef WIFICONNECT_H
 #define WIFICONNECT_H
 
+#include <stdbool.h>
+#include <stdint.h>
+#include "Backoff.h"
 
+/** @brief Reconnect state snapshot, see WifiConnect_getReconnectState. */
+typedef struct WifiConnect_ReconnectState
+{
+    /** @brief Policy state and whether a reconnect is scheduled. */
+    Backoff_State state;
+    bool reconnecting;
+    /** @brief Consecutive failures and ms until the next attempt. */
+    uint32_t failures;
+    uint32_t next_attempt_ms;
+    /** @brief Error (connect status) of the last failed attempt. */
+    int last_err;
+    /** @brief Counters. */
+    uint32_t attempts;
+    uint32_t successes;
+    uint32_t losses;
+    /** @brief Cached AP used for reconnects without a scan. */
+    bool ap_cached;
+    uint8_t bssid[6];
+    uint8_t channel;
+    /** @brief Attempts on the cached AP, and those that connected. */
+    uint32_t fast_attempts;
+    uint32_t fast_hits;
+} WifiConnect_ReconnectState;
+
+/******************************************************************************
+    [docexport WifiConnect_getReconnectState]
+*//**
+    @brief Gets a snapshot of the reconnect state.
+    @param[out] st  Filled in.
+******************************************************************************/
+void
+WifiConnect_getReconnectState(WifiConnect_ReconnectState *st);
 
 /******************************************************************************
     [docexport WifiConnect_getState]
@@ -10,8 +10,10 @@
 #include <zephyr/net/net_event.h>
 #include <zephyr/logging/log.h>
 #include <errno.h>
+#include <string.h>
 #include "WifiConnect.h"
 #include "RtosUtils.h"
+#include "Backoff.h"
 
 /** @brief Initialize the logging module. */
 LOG_MODULE_REGISTER(WifiConnect, CONFIG_WIFICONNECT_LOG_LEVEL);
@@ -20,6 +22,28 @@ LOG_MODULE_REGISTER(WifiConnect, CONFIG_WIFICONNECT_LOG_LEVEL);
 #define FLAG_DISCONNECTED   ((uint32_t)0x1 << 1)
 #define FLAG_IP_OBTAINED    ((uint32_t)0x1 << 2)
 #define FLAG_DO_CONNECT     ((uint32_t)0x1 << 3)
+#define FLAG_CONNECT_FAILED ((uint32_t)0x1 << 4)
+
+#if !defined(CONFIG_WIFICONNECT_RECONNECT_BASE_MS)
+#define RECONNECT_BASE_MS       1000
+#else
+#define RECONNECT_BASE_MS       CONFIG_WIFICONNECT_RECONNECT_BASE_MS
+#endif
+
+#if !defined(CONFIG_WIFICONNECT_RECONNECT_MAX_MS)
+#define RECONNECT_MAX_MS        30000
+#else
+#define RECONNECT_MAX_MS        CONFIG_WIFICONNECT_RECONNECT_MAX_MS
+#endif
+
+#if !defined(CONFIG_WIFICONNECT_IFACE_RESET_FAILURES)
+#define IFACE_RESET_FAILURES    3
+#else
+#define IFACE_RESET_FAILURES    CONFIG_WIFICONNECT_IFACE_RESET_FAILURES
+#endif
+
+/** @brief An attempt with no connect result by then counts as failed. */
+#define CONNECT_TIMEOUT_MS      20000
 
 static K_SEM_DEFINE(connect_sem, 0, 1);
 static K_SEM_DEFINE(monitor_started, 0, 1);
@@ -44,6 +68,29 @@ static struct net_mgmt_event_callback ipv4_cb;
 
 static bool initialized = false;
 
+/** @brief Reconnect policy, owned by the monitor thread. */
+static Backoff policy;
+/** @brief A reconnect is scheduled (connection lost or attempt failed). */
+static bool reconnecting;
+/** @brief Uptime, ms, of the current attempt. */
+static int64_t attempt_ms;
+/** @brief Status of the last failed connect result. */
+static int last_conn_status;
+
+/** @brief AP of the last association. Reconnects target it directly,
+    skipping the scan, until an attempt on it fails. */
+static struct
+{
+    bool valid;
+    uint8_t bssid[WIFI_MAC_ADDR_LEN];
+    uint8_t channel;
+    uint8_t band;
+} ap_cache;
+/** @brief The current attempt targets ap_cache. */
+static bool fast_attempt;
+static uint32_t fast_attempts;
+static uint32_t fast_hits;
+
 static void 
 handle_connect_result(struct net_mgmt_event_callback *cb)
 {
@@ -75,6 +122,8 @@ handle_connect_result(struct net_mgmt_event_callback *cb)
         }
 
         LOG_ERR("Connection request failed: reason=%s", reason);
+        last_conn_status = status->conn_status;
+        RTOS_FLAGS_SET(&wifi_flags, FLAG_CONNECT_FAILED);
     }
     else
     {
@@ -173,10 +222,11 @@ event_handler(
     }
 }
 
-static void
-connect(const char *ssid, const char *pass)
+static int
+connect(const char *ssid, const char *pass, bool fast)
 {
     struct net_if *iface = net_if_get_default();
+    int ret;
 
     struct wifi_connect_req_params wifi_params = {0};
 
@@ -189,12 +239,30 @@ connect(const char *ssid, const char *pass)
     wifi_params.band = WIFI_FREQ_BAND_2_4_GHZ; 
     wifi_params.mfp = WIFI_MFP_OPTIONAL;
 
-    LOG_INF("Connecting to SSID: %s", wifi_params.ssid);
+    fast_attempt = fast && ap_cache.valid;
+    if (fast_attempt)
+    {
+        /* Known AP: skip the scan across all channels. */
+        wifi_params.channel = ap_cache.channel;
+        wifi_params.band = ap_cache.band;
+        memcpy(wifi_params.bssid, ap_cache.bssid, sizeof(wifi_params.bssid));
+        fast_attempts++;
+    }
+
+    LOG_INF("Connecting to SSID: %s%s", wifi_params.ssid,
+        fast_attempt ? " (cached AP)" : "");
 
-    net_mgmt(NET_REQUEST_WIFI_CONNECT,
-             iface,
-             &wifi_params,
-             sizeof(struct wifi_connect_req_params));
+    attempt_ms = k_uptime_get();
+    ret = net_mgmt(NET_REQUEST_WIFI_CONNECT,
+                   iface,
+                   &wifi_params,
+                   sizeof(struct wifi_connect_req_params));
+    if (ret != 0)
+    {
+        LOG_ERR("WiFi Connect Request Failed (%d)", ret);
+    }
+
+    return ret;
 }
 
 static void
@@ -218,6 +286,14 @@ status(void)
         LOG_INF("Channel: %d", status.channel);
         LOG_INF("Security: %s", wifi_security_txt(status.security));
         LOG_INF("RSSI: %d", status.rssi);
+
+        if (IS_ENABLED(CONFIG_WIFICONNECT_FAST_RECONNECT))
+        {
+            memcpy(ap_cache.bssid, status.bssid, sizeof(ap_cache.bssid));
+            ap_cache.channel = status.channel;
+            ap_cache.band = status.band;
+            ap_cache.valid = true;
+        }
     }
 }
 
@@ -231,6 +307,72 @@ static void disconnect(void)
     }
 }
 
+/******************************************************************************
+    attempt
+*//**
+    @brief Starts a connect attempt, recording it with the policy.
+******************************************************************************/
+static void
+attempt(const char *ssid, const char *pass, bool fast)
+{
+    int ret;
+
+    Backoff_attempt(&policy);
+    ret = connect(ssid, pass, fast);
+    if (ret != 0)
+    {
+        last_conn_status = ret;
+        RTOS_FLAGS_SET(&wifi_flags, FLAG_CONNECT_FAILED);
+    }
+}
+
+/******************************************************************************
+    attempt_failed
+*//**
+    @brief Schedules the next attempt after a failed one. A failed attempt on
+    the cached AP drops it, so the next one scans.
+******************************************************************************/
+static void
+attempt_failed(int err)
+{
+    uint32_t delay_ms;
+
+    if (fast_attempt)
+    {
+        LOG_INF("Cached AP not reachable, next attempt scans.");
+        ap_cache.valid = false;
+        fast_attempt = false;
+    }
+
+    delay_ms = Backoff_fail(&policy, err);
+    reconnecting = true;
+    LOG_WRN("Wifi connect attempt failed (%d), retry in %u ms.", err, delay_ms);
+}
+
+/******************************************************************************
+    [docimport WifiConnect_getReconnectState]
+*//**
+    @brief Gets a snapshot of the reconnect state.
+    @param[out] st  Filled in.
+******************************************************************************/
+void
+WifiConnect_getReconnectState(WifiConnect_ReconnectState *st)
+{
+    st->state = policy.state;
+    st->reconnecting = reconnecting;
+    st->failures = policy.failures;
+    st->next_attempt_ms = reconnecting ? Backoff_remainingMs(&policy) : 0;
+    st->last_err = policy.last_err;
+    st->attempts = policy.attempts;
+    st->successes = policy.successes;
+    st->losses = policy.losses;
+    st->ap_cached = ap_cache.valid;
+    memcpy(st->bssid, ap_cache.bssid, sizeof(st->bssid));
+    st->channel = ap_cache.channel;
+    st->fast_attempts = fast_attempts;
+    st->fast_hits = fast_hits;
+}
+
 /******************************************************************************
     [docimport WifiConnect_getState]
 *//**
@@ -303,6 +445,8 @@ WifiConnect_init(const char *ssid, const char *pass)
     net_mgmt_add_event_callback(&wifi_cb);
     net_mgmt_add_event_callback(&ipv4_cb);
 
+    Backoff_init(&policy, RECONNECT_BASE_MS, RECONNECT_MAX_MS);
+
     monitor_args.ssid = ssid;
     monitor_args.pass = pass;
 
@@ -351,32 +495,38 @@ monitor_thread(void *arg0, void *arg1, void *arg2)
     while (1)
     {
         uint32_t flags;
+        uint32_t timeout_ms = 10000;
 
-        flags = RTOS_PEND_ANY_FLAGS_MS(
-            &wifi_flags,
-            FLAG_DO_CONNECT | FLAG_CONNECTED | FLAG_IP_OBTAINED | FLAG_DISCONNECTED,
-            10000);
-
-        if (flags == 0)
+        if (reconnecting && policy.state == BACKOFF_STATE_WAITING)
         {
-            /* Maintenance timeout. */
-            LOG_DBG("Wifi monitor heartbeat.");
-            continue;
+            timeout_ms = MIN(Backoff_remainingMs(&policy), timeout_ms);
         }
 
+        flags = RTOS_PEND_ANY_FLAGS_MS(
+            &wifi_flags,
+            FLAG_DO_CONNECT | FLAG_CONNECTED | FLAG_IP_OBTAINED |
+            FLAG_DISCONNECTED | FLAG_CONNECT_FAILED,
+            timeout_ms);
+
         if (flags & FLAG_DO_CONNECT)
         {
             LOG_INF("Wifi connect initiated.");
             RTOS_FLAGS_CLR(&wifi_flags, FLAG_DO_CONNECT);
             give_sem_on_connect = true;
-            connect(ssid, pass);
+            attempt(ssid, pass, false);
         }
 
         if (flags & FLAG_CONNECTED)
         {
             LOG_INF("Wifi connected.");
-            status();
             RTOS_FLAGS_CLR(&wifi_flags, FLAG_CONNECTED);
+            if (fast_attempt)
+            {
+                fast_hits++;
+            }
+            Backoff_success(&policy);
+            reconnecting = false;
+            status();
             if (give_sem_on_connect)
             {
                 k_sem_give(&connect_sem);
@@ -384,6 +534,12 @@ monitor_thread(void *arg0, void *arg1, void *arg2)
             }
         }
 
+        if (flags & FLAG_CONNECT_FAILED)
+        {
+            RTOS_FLAGS_CLR(&wifi_flags, FLAG_CONNECT_FAILED);
+            attempt_failed(last_conn_status);
+        }
+
         if (flags & FLAG_IP_OBTAINED)
         {
             LOG_INF("Wifi IP obtained.");
@@ -394,19 +550,50 @@ monitor_thread(void *arg0, void *arg1, void *arg2)
         {
             RTOS_FLAGS_CLR(&wifi_flags, FLAG_DISCONNECTED);
 
-            /* Sleep before attempting to reconnect. */
-            RTOS_TASK_SLEEP_ms(3000);
+            if (policy.state == BACKOFF_STATE_CONNECTED)
+            {
+                LOG_INF("Reconnecting in %u ms.", Backoff_lost(&policy));
+                reconnecting = true;
+            }
+            else if (policy.state == BACKOFF_STATE_CONNECTING &&
+                     !(flags & FLAG_CONNECT_FAILED))
+            {
+                /* Some drivers report a failed attempt as a disconnect. */
+                attempt_failed(-ENOTCONN);
+            }
+        }
 
-            net_if_down(iface);
-            LOG_INF("Interface down.");
-            RTOS_TASK_SLEEP_ms(500);
+        if (policy.state == BACKOFF_STATE_CONNECTING &&
+            k_uptime_get() - attempt_ms > CONNECT_TIMEOUT_MS)
+        {
+            attempt_failed(-ETIMEDOUT);
+        }
 
-            net_if_up(iface);
-            RTOS_TASK_SLEEP_ms(500);
-            LOG_INF("Interface up.");
+        if (reconnecting && policy.state == BACKOFF_STATE_WAITING &&
+            Backoff_remainingMs(&policy) == 0)
+        {
+            /*  Cycle the interface when attempts keep failing, in case the
+                driver is stuck.
+            */
+            if (IFACE_RESET_FAILURES > 0 && policy.failures > 0 &&
+                policy.failures % IFACE_RESET_FAILURES == 0)
+            {
+                net_if_down(iface);
+                LOG_INF("Interface down.");
+                RTOS_TASK_SLEEP_ms(500);
+
+                net_if_up(iface);
+                RTOS_TASK_SLEEP_ms(500);
+                LOG_INF("Interface up.");
+            }
 
             LOG_INF("Attempting to reconnect...");
-            connect(ssid, pass);
+            attempt(ssid, pass, true);
+        }
+        else if (flags == 0)
+        {
+            /* Maintenance timeout. */
+            LOG_DBG("Wifi monitor heartbeat.");
         }
     }
 }
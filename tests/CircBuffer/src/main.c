@@ -28,7 +28,7 @@ producer_thread_func(void *p1, void *p2, void *p3)
     CircBuffer circ;
     uint8_t buf[PRODUCER_RAND_MAX];
 
-    ret = CircBuffer_init(&circ, CIRCBUFFER_DEPTH, NULL, 0, CIRCBUFFER_MAX_ITEMS);
+    ret = CircBuffer_init(&circ, CIRCBUFFER_DEPTH, NULL, 0);
     zassert_equal(ret, 0, "CircBuffer_init error %d", ret);
 
     while(1)
@@ -95,8 +95,7 @@ ZTEST(circbuffer_tests, test_read_write)
     CircBuffer circ;
     uint8_t circbuf[CircBuffer_getMemAllocSize(CIRCBUFFER_DEPTH)];
 
-    ret = CircBuffer_init(&circ, CIRCBUFFER_DEPTH, circbuf, sizeof(circbuf),
-        CIRCBUFFER_MAX_ITEMS);
+    ret = CircBuffer_init(&circ, CIRCBUFFER_DEPTH, circbuf, sizeof(circbuf));
     zassert_equal(ret, 0, "CircBuffer_init error %d", ret);
 
     for (uint32_t i = 0; i < CIRCBUFFER_DEPTH; i++)
@@ -111,3 +110,78 @@ ZTEST(circbuffer_tests, test_read_write)
     }
 
 }
+
+#define CURSOR_DEPTH    64
+
+/** @brief Writes num bytes of a running count, in chunks. */
+static void
+write_count(CircBuffer *circ, uint8_t *next, uint32_t num, uint32_t chunk)
+{
+    uint8_t buf[32];
+
+    while (num > 0)
+    {
+        uint32_t n = MIN(num, MIN(chunk, sizeof(buf)));
+        for (uint32_t i = 0; i < n; i++)
+        {
+            buf[i] = (*next)++;
+        }
+        zassert_equal(CircBuffer_write(circ, buf, n), 0, "write error");
+        num -= n;
+    }
+}
+
+ZTEST(circbuffer_tests, test_cursor_read)
+{
+    int ret;
+    CircBuffer circ;
+    CircBuffer_Cursor cur;
+    uint8_t circbuf[CircBuffer_getMemAllocSize(CURSOR_DEPTH)];
+    uint8_t buf[2 * CURSOR_DEPTH];
+    uint8_t next = 0;
+    uint32_t dropped;
+
+    ret = CircBuffer_init(&circ, CURSOR_DEPTH, circbuf, sizeof(circbuf));
+    zassert_equal(ret, 0, "CircBuffer_init error %d", ret);
+    CircBuffer_cursorInit(&circ, &cur);
+
+    /* Reads in order and leaves the buffer to the consuming reader. */
+    write_count(&circ, &next, 10, 10);
+    ret = CircBuffer_cursorRead(&circ, &cur, buf, 4, &dropped);
+    zassert_equal(ret, 4, "read %d", ret);
+    ret = CircBuffer_cursorRead(&circ, &cur, buf + 4, sizeof(buf), &dropped);
+    zassert_equal(ret, 6, "read %d", ret);
+    zassert_equal(dropped, 0, "dropped %u", dropped);
+    for (int i = 0; i < 10; i++)
+    {
+        zassert_equal(buf[i], i, "byte %d", i);
+    }
+    zassert_equal(CircBuffer_getCount(&circ), 10, "count changed");
+    ret = CircBuffer_cursorRead(&circ, &cur, buf, sizeof(buf), &dropped);
+    zassert_equal(ret, 0, "read %d when caught up", ret);
+
+    /* Overrun: the writer wraps past the cursor several times. */
+    write_count(&circ, &next, 200, 20);
+    ret = CircBuffer_cursorRead(&circ, &cur, buf, sizeof(buf), &dropped);
+    zassert_equal(ret, CURSOR_DEPTH, "read %d", ret);
+    zassert_equal(dropped, 200 - CURSOR_DEPTH, "dropped %u", dropped);
+    for (int i = 0; i < ret; i++)
+    {
+        zassert_equal(buf[i], (uint8_t)(next - CURSOR_DEPTH + i),
+            "byte %d", i);
+    }
+
+    /* Flushed bytes the cursor had not read count as dropped. */
+    write_count(&circ, &next, 5, 5);
+    CircBuffer_flush(&circ);
+    write_count(&circ, &next, 3, 3);
+    ret = CircBuffer_cursorRead(&circ, &cur, buf, sizeof(buf), &dropped);
+    zassert_equal(ret, 3, "read %d", ret);
+    zassert_equal(dropped, 5, "dropped %u", dropped);
+    zassert_equal(buf[0], (uint8_t)(next - 3), "byte after flush");
+
+    /* A new cursor starts at the end. */
+    CircBuffer_cursorInit(&circ, &cur);
+    ret = CircBuffer_cursorRead(&circ, &cur, buf, sizeof(buf), &dropped);
+    zassert_equal(ret, 0, "read %d", ret);
+}
@@ -0,0 +1,236 @@
+"""Captures the Ethernet frames of a TcpRpcServer-style exchange and writes
+them as C arrays for the FrameCompress benchmark (src/captured_frames.h).
+
+The exchange runs over loopback on the host: an ARP resolution of the
+default gateway on the given interface, then a TCP connection carrying
+COBS-framed ProtoRpc frames (a ws2812led GetMetrics call and reply, encoded
+by protoc from modules/WS2812Led/proto). The kernel's own ARP, IPv4 and TCP
+headers (with options) are captured as sent. Loopback frames carry zero MAC
+addresses, which would flatter the compressor, so they are replaced by the
+interface and gateway MACs, as on the point-to-point eth_serial link (the
+IPv4 checksums do not cover them). The ProtoRpcHeader proto is not in this tree, so its two
+fields (seqn, callset) are encoded by hand.
+
+Needs root (AF_PACKET) and protoc:
+
+    sudo python3 capture_frames.py --iface eth0 > ../src/captured_frames.h
+"""
+import argparse
+import os
+import select
+import socket
+import struct
+import subprocess
+import sys
+import threading
+import time
+
+ETH_P_ALL = 0x0003
+ETH_P_ARP = 0x0806
+PROTO = os.path.join(os.path.dirname(__file__),
+                     "../../../modules/WS2812Led/proto/WS2812LedRpc")
+
+CALL = "getmetrics_call { strip: 0 }"
+REPLY = """getmetrics_reply {
+    num_strips: 2 num_pixels: 300 num_segments: 4 target_fps: 60
+    frames: 107342 frames_written: 98211 frames_skipped: 9131
+    missed_deadlines: 3 segments_composed: 412877
+    step { last_us: 412 max_us: 1290 avg_us: 436 }
+    convert { last_us: 221 max_us: 480 avg_us: 218 }
+    tx { last_us: 9012 max_us: 9120 avg_us: 9010 }
+}"""
+
+
+def protoc_encode(text: str) -> bytes:
+    return subprocess.run(
+        ["protoc", "-I", PROTO, "--encode=ws2812led.Callset",
+         "WS2812LedRpc.proto"],
+        input=text.encode(), capture_output=True, check=True).stdout
+
+
+def varint(n: int) -> bytes:
+    out = bytearray()
+    while True:
+        b = n & 0x7f
+        n >>= 7
+        out.append(b | (0x80 if n else 0))
+        if not n:
+            return bytes(out)
+
+
+def delimited(msg: bytes) -> bytes:
+    return varint(len(msg)) + msg
+
+
+def rpc_frame(seqn: int, callset: bytes) -> bytes:
+    # ProtoRpcHeader: seqn = 1, callset oneof (empty message) = 10.
+    header = b"\x08" + varint(seqn) + b"\x52\x00"
+    return delimited(header) + delimited(callset)
+
+
+def cobs(data: bytes) -> bytes:
+    out = bytearray([0])
+    code_idx = 0
+    for b in data:
+        if b == 0:
+            out[code_idx] = len(out) - code_idx
+            code_idx = len(out)
+            out.append(0)
+        else:
+            out.append(b)
+            if len(out) - code_idx == 0xff:
+                out[code_idx] = 0xff
+                code_idx = len(out)
+                out.append(0)
+    out[code_idx] = len(out) - code_idx
+    return bytes(out)
+
+
+def cobs_frame(data: bytes) -> bytes:
+    return b"\x00" + cobs(data) + b"\x00"
+
+
+def capture(sock, until, keep):
+    frames = []
+    while time.time() < until:
+        r, _, _ = select.select([sock], [], [], 0.05)
+        if r:
+            frame, addr = sock.recvfrom(65536)
+            if addr[2] != socket.PACKET_OUTGOING and keep(frame):
+                frames.append(frame)
+    return frames
+
+
+def arp_exchange(iface):
+    gw = None
+    with open("/proc/net/route") as f:
+        for line in f.readlines()[1:]:
+            fields = line.split()
+            if fields[0] == iface and fields[1] == "00000000":
+                gw = socket.inet_ntoa(struct.pack("<I", int(fields[2], 16)))
+    if not gw:
+        return []
+
+    sock = socket.socket(socket.AF_PACKET, socket.SOCK_RAW,
+                         socket.htons(ETH_P_ARP))
+    sock.bind((iface, 0))
+    subprocess.run(["ip", "neigh", "flush", "dev", iface], check=False)
+    # Any packet to the gateway makes the kernel resolve it.
+    socket.socket(socket.AF_INET, socket.SOCK_DGRAM).sendto(b"", (gw, 9))
+    frames = []
+    until = time.time() + 1.0
+    while time.time() < until and len(frames) < 2:
+        r, _, _ = select.select([sock], [], [], 0.05)
+        if r:
+            frames.append(sock.recvfrom(65536)[0])
+    return frames
+
+
+def rpc_exchange(port):
+    call = cobs_frame(rpc_frame(7, protoc_encode(CALL)))
+    reply = cobs_frame(rpc_frame(7, protoc_encode(REPLY)))
+
+    srv = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    srv.bind(("127.0.0.1", port))
+    srv.listen(1)
+
+    def serve():
+        conn, _ = srv.accept()
+        conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        conn.recv(4096)
+        conn.sendall(reply)
+        conn.recv(4096)
+        conn.close()
+
+    sniff = socket.socket(socket.AF_PACKET, socket.SOCK_RAW,
+                          socket.htons(ETH_P_ALL))
+    sniff.bind(("lo", 0))
+    th = threading.Thread(target=serve)
+    th.start()
+
+    cli = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    cli.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    cli.connect(("127.0.0.1", port))
+    cli.sendall(call)
+    cli.recv(4096)
+    cli.close()
+    th.join()
+    srv.close()
+
+    tcp_port = struct.pack("!H", port)
+
+    def keep(frame):
+        return frame[12:14] == b"\x08\x00" and tcp_port in (
+            frame[34:36], frame[36:38])
+
+    return capture(sniff, time.time() + 0.5, keep)
+
+
+def set_macs(frames, port, host_mac, peer_mac):
+    """Host is the client; frames from the server port come from the peer.
+    """
+    out = []
+    for frame in frames:
+        if frame[34:36] == struct.pack("!H", port):
+            out.append(host_mac + peer_mac + frame[12:])
+        else:
+            out.append(peer_mac + host_mac + frame[12:])
+    return out
+
+
+def tcp_flags(frame):
+    ihl = (frame[14] & 0x0f) * 4
+    flags = frame[14 + ihl + 13]
+    off = (frame[14 + ihl + 12] >> 4) * 4
+    payload = len(frame) - 14 - ihl - off
+    names = [n for b, n in ((0x02, "syn"), (0x01, "fin"), (0x08, "psh"),
+                            (0x10, "ack")) if flags & b]
+    return "_".join(names) + (f" {payload} payload bytes" if payload else "")
+
+
+def emit(name, frame, comment):
+    print(f"/* {comment} */")
+    print(f"static const uint8_t {name}[{len(frame)}] =")
+    print("{")
+    for i in range(0, len(frame), 12):
+        print("    " + " ".join(f"0x{b:02x}," for b in frame[i:i + 12]))
+    print("};")
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--iface", default="eth0")
+    parser.add_argument("--port", type=int, default=13001)
+    args = parser.parse_args()
+
+    arp = arp_exchange(args.iface)
+    rpc = rpc_exchange(args.port)
+    with open(f"/sys/class/net/{args.iface}/address") as f:
+        host_mac = bytes.fromhex(f.read().strip().replace(":", ""))
+    peer_mac = arp[0][6:12] if arp else bytes.fromhex("02fc00000005")
+    rpc = set_macs(rpc, args.port, host_mac, peer_mac)
+
+    print("/* Generated by capture/capture_frames.py, do not edit. */")
+    print("#ifndef CAPTURED_FRAMES_H")
+    print("#define CAPTURED_FRAMES_H")
+    print()
+    names = []
+    for i, frame in enumerate(arp):
+        op = "request" if frame[21] == 1 else "reply"
+        names.append(f"cap_arp_{op}")
+        emit(names[-1], frame, f"ARP {op}, {args.iface}.")
+    for i, frame in enumerate(rpc):
+        names.append(f"cap_tcp_{i}")
+        emit(names[-1], frame, f"TCP {tcp_flags(frame)}.")
+    print("#define CAPTURED_FRAMES \\")
+    for n in names:
+        print(f"    {{ \"{n}\", {n}, sizeof({n}) }}, \\")
+    print()
+    print("#endif")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,146 @@
+/* Generated by capture/capture_frames.py, do not edit. */
+#ifndef CAPTURED_FRAMES_H
+#define CAPTURED_FRAMES_H
+
+/* ARP reply, eth0. */
+static const uint8_t cap_arp_reply[42] =
+{
+    0x02, 0xfc, 0x00, 0x00, 0x00, 0x01, 0x02, 0xfc, 0x00, 0x00, 0x00, 0x05,
+    0x08, 0x06, 0x00, 0x01, 0x08, 0x00, 0x06, 0x04, 0x00, 0x02, 0x02, 0xfc,
+    0x00, 0x00, 0x00, 0x05, 0xc0, 0x00, 0x02, 0x01, 0x02, 0xfc, 0x00, 0x00,
+    0x00, 0x01, 0xc0, 0x00, 0x02, 0x02,
+};
+
+/* TCP syn. */
+static const uint8_t cap_tcp_0[74] =
+{
+    0x02, 0xfc, 0x00, 0x00, 0x00, 0x05, 0x02, 0xfc, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x3c, 0x24, 0x1a, 0x40, 0x00, 0x40, 0x06,
+    0x18, 0xa0, 0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01, 0xdd, 0x04,
+    0x32, 0xc9, 0xbf, 0x5b, 0xde, 0xcd, 0x00, 0x00, 0x00, 0x00, 0xa0, 0x02,
+    0xff, 0xd7, 0xfe, 0x30, 0x00, 0x00, 0x02, 0x04, 0xff, 0xd7, 0x04, 0x02,
+    0x08, 0x0a, 0x5a, 0x55, 0xd8, 0xc9, 0x00, 0x00, 0x00, 0x00, 0x01, 0x03,
+    0x03, 0x0a,
+};
+
+/* TCP syn_ack. */
+static const uint8_t cap_tcp_1[74] =
+{
+    0x02, 0xfc, 0x00, 0x00, 0x00, 0x01, 0x02, 0xfc, 0x00, 0x00, 0x00, 0x05,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x3c, 0x00, 0x00, 0x40, 0x00, 0x40, 0x06,
+    0x3c, 0xba, 0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01, 0x32, 0xc9,
+    0xdd, 0x04, 0xfd, 0xd0, 0x2b, 0x3e, 0xbf, 0x5b, 0xde, 0xce, 0xa0, 0x12,
+    0xff, 0xcb, 0xfe, 0x30, 0x00, 0x00, 0x02, 0x04, 0xff, 0xd7, 0x04, 0x02,
+    0x08, 0x0a, 0x9a, 0x36, 0x05, 0x00, 0x5a, 0x55, 0xd8, 0xc9, 0x01, 0x03,
+    0x03, 0x0a,
+};
+
+/* TCP ack. */
+static const uint8_t cap_tcp_2[66] =
+{
+    0x02, 0xfc, 0x00, 0x00, 0x00, 0x05, 0x02, 0xfc, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x34, 0x24, 0x1b, 0x40, 0x00, 0x40, 0x06,
+    0x18, 0xa7, 0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01, 0xdd, 0x04,
+    0x32, 0xc9, 0xbf, 0x5b, 0xde, 0xce, 0xfd, 0xd0, 0x2b, 0x3f, 0x80, 0x10,
+    0x00, 0x40, 0xfe, 0x28, 0x00, 0x00, 0x01, 0x01, 0x08, 0x0a, 0x5a, 0x55,
+    0xd8, 0xc9, 0x9a, 0x36, 0x05, 0x00,
+};
+
+/* TCP psh_ack 11 payload bytes. */
+static const uint8_t cap_tcp_3[77] =
+{
+    0x02, 0xfc, 0x00, 0x00, 0x00, 0x05, 0x02, 0xfc, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x3f, 0x24, 0x1c, 0x40, 0x00, 0x40, 0x06,
+    0x18, 0x9b, 0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01, 0xdd, 0x04,
+    0x32, 0xc9, 0xbf, 0x5b, 0xde, 0xce, 0xfd, 0xd0, 0x2b, 0x3f, 0x80, 0x18,
+    0x00, 0x40, 0xfe, 0x33, 0x00, 0x00, 0x01, 0x01, 0x08, 0x0a, 0x5a, 0x55,
+    0xd8, 0xc9, 0x9a, 0x36, 0x05, 0x00, 0x00, 0x05, 0x04, 0x08, 0x07, 0x52,
+    0x03, 0x02, 0x0a, 0x01, 0x00,
+};
+
+/* TCP ack. */
+static const uint8_t cap_tcp_4[66] =
+{
+    0x02, 0xfc, 0x00, 0x00, 0x00, 0x01, 0x02, 0xfc, 0x00, 0x00, 0x00, 0x05,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x34, 0x3b, 0x5b, 0x40, 0x00, 0x40, 0x06,
+    0x01, 0x67, 0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01, 0x32, 0xc9,
+    0xdd, 0x04, 0xfd, 0xd0, 0x2b, 0x3f, 0xbf, 0x5b, 0xde, 0xd9, 0x80, 0x10,
+    0x00, 0x40, 0xfe, 0x28, 0x00, 0x00, 0x01, 0x01, 0x08, 0x0a, 0x9a, 0x36,
+    0x05, 0x00, 0x5a, 0x55, 0xd8, 0xc9,
+};
+
+/* TCP psh_ack 70 payload bytes. */
+static const uint8_t cap_tcp_5[136] =
+{
+    0x02, 0xfc, 0x00, 0x00, 0x00, 0x01, 0x02, 0xfc, 0x00, 0x00, 0x00, 0x05,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x7a, 0x3b, 0x5c, 0x40, 0x00, 0x40, 0x06,
+    0x01, 0x20, 0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01, 0x32, 0xc9,
+    0xdd, 0x04, 0xfd, 0xd0, 0x2b, 0x3f, 0xbf, 0x5b, 0xde, 0xd9, 0x80, 0x18,
+    0x00, 0x40, 0xfe, 0x6e, 0x00, 0x00, 0x01, 0x01, 0x08, 0x0a, 0x9a, 0x36,
+    0x05, 0x00, 0x5a, 0x55, 0xd8, 0xc9, 0x00, 0x05, 0x04, 0x08, 0x07, 0x52,
+    0x3f, 0x3d, 0x12, 0x3b, 0x08, 0x02, 0x10, 0xac, 0x02, 0x18, 0x04, 0x20,
+    0x3c, 0x28, 0xce, 0xc6, 0x06, 0x30, 0xa3, 0xff, 0x05, 0x38, 0xab, 0x47,
+    0x40, 0x03, 0x48, 0xcd, 0x99, 0x19, 0x52, 0x09, 0x08, 0x9c, 0x03, 0x10,
+    0x8a, 0x0a, 0x18, 0xb4, 0x03, 0x5a, 0x09, 0x08, 0xdd, 0x01, 0x10, 0xe0,
+    0x03, 0x18, 0xda, 0x01, 0x62, 0x09, 0x08, 0xb4, 0x46, 0x10, 0xa0, 0x47,
+    0x18, 0xb2, 0x46, 0x00,
+};
+
+/* TCP ack. */
+static const uint8_t cap_tcp_6[66] =
+{
+    0x02, 0xfc, 0x00, 0x00, 0x00, 0x05, 0x02, 0xfc, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x34, 0x24, 0x1d, 0x40, 0x00, 0x40, 0x06,
+    0x18, 0xa5, 0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01, 0xdd, 0x04,
+    0x32, 0xc9, 0xbf, 0x5b, 0xde, 0xd9, 0xfd, 0xd0, 0x2b, 0x85, 0x80, 0x10,
+    0x00, 0x40, 0xfe, 0x28, 0x00, 0x00, 0x01, 0x01, 0x08, 0x0a, 0x5a, 0x55,
+    0xd8, 0xc9, 0x9a, 0x36, 0x05, 0x00,
+};
+
+/* TCP fin_ack. */
+static const uint8_t cap_tcp_7[66] =
+{
+    0x02, 0xfc, 0x00, 0x00, 0x00, 0x05, 0x02, 0xfc, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x34, 0x24, 0x1e, 0x40, 0x00, 0x40, 0x06,
+    0x18, 0xa4, 0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01, 0xdd, 0x04,
+    0x32, 0xc9, 0xbf, 0x5b, 0xde, 0xd9, 0xfd, 0xd0, 0x2b, 0x85, 0x80, 0x11,
+    0x00, 0x40, 0xfe, 0x28, 0x00, 0x00, 0x01, 0x01, 0x08, 0x0a, 0x5a, 0x55,
+    0xd8, 0xc9, 0x9a, 0x36, 0x05, 0x00,
+};
+
+/* TCP fin_ack. */
+static const uint8_t cap_tcp_8[66] =
+{
+    0x02, 0xfc, 0x00, 0x00, 0x00, 0x01, 0x02, 0xfc, 0x00, 0x00, 0x00, 0x05,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x34, 0x3b, 0x5d, 0x40, 0x00, 0x40, 0x06,
+    0x01, 0x65, 0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01, 0x32, 0xc9,
+    0xdd, 0x04, 0xfd, 0xd0, 0x2b, 0x85, 0xbf, 0x5b, 0xde, 0xda, 0x80, 0x11,
+    0x00, 0x40, 0xfe, 0x28, 0x00, 0x00, 0x01, 0x01, 0x08, 0x0a, 0x9a, 0x36,
+    0x05, 0x00, 0x5a, 0x55, 0xd8, 0xc9,
+};
+
+/* TCP ack. */
+static const uint8_t cap_tcp_9[66] =
+{
+    0x02, 0xfc, 0x00, 0x00, 0x00, 0x05, 0x02, 0xfc, 0x00, 0x00, 0x00, 0x01,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x34, 0x24, 0x1f, 0x40, 0x00, 0x40, 0x06,
+    0x18, 0xa3, 0x7f, 0x00, 0x00, 0x01, 0x7f, 0x00, 0x00, 0x01, 0xdd, 0x04,
+    0x32, 0xc9, 0xbf, 0x5b, 0xde, 0xda, 0xfd, 0xd0, 0x2b, 0x86, 0x80, 0x10,
+    0x00, 0x40, 0xfe, 0x28, 0x00, 0x00, 0x01, 0x01, 0x08, 0x0a, 0x5a, 0x55,
+    0xd8, 0xc9, 0x9a, 0x36, 0x05, 0x00,
+};
+
+#define CAPTURED_FRAMES \
+    { "cap_arp_reply", cap_arp_reply, sizeof(cap_arp_reply) }, \
+    { "cap_tcp_0", cap_tcp_0, sizeof(cap_tcp_0) }, \
+    { "cap_tcp_1", cap_tcp_1, sizeof(cap_tcp_1) }, \
+    { "cap_tcp_2", cap_tcp_2, sizeof(cap_tcp_2) }, \
+    { "cap_tcp_3", cap_tcp_3, sizeof(cap_tcp_3) }, \
+    { "cap_tcp_4", cap_tcp_4, sizeof(cap_tcp_4) }, \
+    { "cap_tcp_5", cap_tcp_5, sizeof(cap_tcp_5) }, \
+    { "cap_tcp_6", cap_tcp_6, sizeof(cap_tcp_6) }, \
+    { "cap_tcp_7", cap_tcp_7, sizeof(cap_tcp_7) }, \
+    { "cap_tcp_8", cap_tcp_8, sizeof(cap_tcp_8) }, \
+    { "cap_tcp_9", cap_tcp_9, sizeof(cap_tcp_9) }, \
+
+#endif
@@ -0,0 +1,310 @@
+#include <stdint.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include "FrameCompress.h"
+#include "captured_frames.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(framecompress_tests);
+
+#define MAX_FRAME       1600
+#define BENCH_LOOPS     100
+/* 1 Mbaud, 8N1: 10 us per byte on the wire. */
+#define LINE_US_PER_BYTE    10
+
+typedef struct
+{
+    const char *name;
+    const uint8_t *data;
+    uint32_t len;
+} TestFrame;
+
+static const uint8_t frame_arp[42] =
+{
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x5e, 0x00, 0x53, 0x01,
+    0x08, 0x06, 0x00, 0x01, 0x08, 0x00, 0x06, 0x04, 0x00, 0x01, 0x00, 0x00,
+    0x5e, 0x00, 0x53, 0x01, 0xc0, 0x00, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xc0, 0x00, 0x02, 0x02,
+};
+
+static const uint8_t frame_tcp_ack[60] =
+{
+    0x00, 0x00, 0x5e, 0x00, 0x53, 0x02, 0x00, 0x00, 0x5e, 0x00, 0x53, 0x01,
+    0x08, 0x00, 0x45, 0x00, 0x00, 0x28, 0x1c, 0x46, 0x40, 0x00, 0x40, 0x06,
+    0x9d, 0x35, 0xc0, 0x00, 0x02, 0x01, 0xc0, 0x00, 0x02, 0x02, 0x1f, 0x90,
+    0xd4, 0x31, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x20, 0x00, 0x50, 0x10,
+    0x16, 0xd0, 0x5b, 0x2c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+static uint8_t frame_rpc_reply[512];
+static uint8_t frame_random[1024];
+
+static TestFrame frames[] =
+{
+    { "arp", frame_arp, sizeof(frame_arp) },
+    { "tcp_ack", frame_tcp_ack, sizeof(frame_tcp_ack) },
+    { "rpc_reply", frame_rpc_reply, sizeof(frame_rpc_reply) },
+    { "random", frame_random, sizeof(frame_random) },
+};
+
+/* Captured exchange, see capture/capture_frames.py. */
+static const TestFrame captured[] =
+{
+    CAPTURED_FRAMES
+};
+
+static FrameCompress_Work work;
+static uint8_t enc[FRAMECOMPRESS_MAX_SIZE(MAX_FRAME)];
+static uint8_t dec[MAX_FRAME];
+
+static void *
+suite_setup(void)
+{
+    static const char text[] =
+        "thread: main prio: 0 stack: 2048 used: 812 state: pending\n";
+    uint32_t seed = 12345;
+    uint32_t i;
+
+    /* ProtoRpc-like reply: a short header followed by repeated text rows. */
+    frame_rpc_reply[0] = 0x0a;
+    frame_rpc_reply[1] = 0x00;
+    for (i = 2; i < sizeof(frame_rpc_reply); i++)
+    {
+        frame_rpc_reply[i] = text[(i - 2) % (sizeof(text) - 1)];
+    }
+
+    for (i = 0; i < sizeof(frame_random); i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        frame_random[i] = (uint8_t)(seed >> 16);
+    }
+    return NULL;
+}
+
+ZTEST_SUITE(framecompress_tests, NULL, suite_setup, NULL, NULL, NULL);
+
+ZTEST(framecompress_tests, test_lz4_roundtrip)
+{
+    uint32_t i;
+    uint32_t len;
+    int csize;
+    int dsize;
+
+    for (i = 0; i < ARRAY_SIZE(frames); i++)
+    {
+        /* Full frames and short prefixes, below and around MFLIMIT. */
+        for (len = 0; len <= frames[i].len; len += (len < 32) ? 1 : 97)
+        {
+            csize = FrameCompress_lz4Compress(&work, frames[i].data, len, enc,
+                sizeof(enc));
+            zassert_true(csize > 0, "%s/%u: compress error %d",
+                frames[i].name, len, csize);
+
+            dsize = FrameCompress_lz4Decompress(enc, csize, dec, sizeof(dec));
+            zassert_equal(dsize, len, "%s/%u: decompressed %d",
+                frames[i].name, len, dsize);
+            zassert_mem_equal(dec, frames[i].data, len, "%s/%u: mismatch",
+                frames[i].name, len);
+        }
+    }
+}
+
+ZTEST(framecompress_tests, test_negotiation)
+{
+    FrameCompress_Link a;
+    FrameCompress_Link b;
+    int size;
+
+    FrameCompress_linkInit(&a);
+    FrameCompress_linkInit(&b);
+
+    /* No caps from the peer yet: sent raw. */
+    size = FrameCompress_encode(&a, &work, frame_rpc_reply,
+        sizeof(frame_rpc_reply), enc, sizeof(enc));
+    zassert_equal(size, sizeof(frame_rpc_reply) + FRAMECOMPRESS_HDR_SIZE,
+        "Compressed before negotiation.");
+    zassert_equal(enc[0], FRAMECOMPRESS_HDR_CAPS, "Bad header 0x%02x", enc[0]);
+
+    size = FrameCompress_decode(&b, enc, size, dec, sizeof(dec));
+    zassert_equal(size, sizeof(frame_rpc_reply), "Decode error %d", size);
+    zassert_true(b.peer_caps, "Caps not recorded.");
+
+    /* b has seen caps: compresses. */
+    size = FrameCompress_encode(&b, &work, frame_rpc_reply,
+        sizeof(frame_rpc_reply), enc, sizeof(enc));
+    zassert_true(size < sizeof(frame_rpc_reply), "Not compressed (%d).", size);
+    zassert_equal(enc[0], FRAMECOMPRESS_HDR_CAPS | FRAMECOMPRESS_HDR_LZ4,
+        "Bad header 0x%02x", enc[0]);
+
+    size = FrameCompress_decode(&a, enc, size, dec, sizeof(dec));
+    zassert_equal(size, sizeof(frame_rpc_reply), "Decode error %d", size);
+    zassert_mem_equal(dec, frame_rpc_reply, size, "Mismatch.");
+
+    /* Incompressible data is still sent raw. */
+    size = FrameCompress_encode(&b, &work, frame_random, sizeof(frame_random),
+        enc, sizeof(enc));
+    zassert_equal(enc[0], FRAMECOMPRESS_HDR_CAPS, "Random data compressed.");
+    zassert_equal(size, sizeof(frame_random) + FRAMECOMPRESS_HDR_SIZE,
+        "Bad raw size %d", size);
+}
+
+ZTEST(framecompress_tests, test_detect)
+{
+    FrameCompress_Link client;
+    FrameCompress_Link server;
+    /* Bare ProtoRpc call: the header length varint comes first. */
+    uint8_t bare[] = { 0x04, 0x08, 0x01, 0x10, 0x02, 0x0a, 0x00 };
+    int size;
+
+    /* A FrameCompress peer is detected and compression negotiated. */
+    FrameCompress_linkInit(&client);
+    FrameCompress_linkInitDetect(&server);
+    size = FrameCompress_encode(&client, &work, frame_rpc_reply,
+        sizeof(frame_rpc_reply), enc, sizeof(enc));
+    size = FrameCompress_decode(&server, enc, size, dec, sizeof(dec));
+    zassert_equal(size, sizeof(frame_rpc_reply), "Decode error %d", size);
+    zassert_false(server.bare, "FrameCompress peer taken as bare.");
+    size = FrameCompress_encode(&server, &work, frame_rpc_reply,
+        sizeof(frame_rpc_reply), enc, sizeof(enc));
+    zassert_equal(enc[0], FRAMECOMPRESS_HDR_CAPS | FRAMECOMPRESS_HDR_LZ4,
+        "Bad header 0x%02x", enc[0]);
+
+    /* An old peer's frames pass through, and replies go out bare. */
+    FrameCompress_linkInitDetect(&server);
+    size = FrameCompress_decode(&server, bare, sizeof(bare), dec, sizeof(dec));
+    zassert_equal(size, sizeof(bare), "Decode error %d", size);
+    zassert_mem_equal(dec, bare, sizeof(bare), "Bare frame changed.");
+    zassert_true(server.bare, "Bare peer not detected.");
+    size = FrameCompress_encode(&server, &work, frame_rpc_reply,
+        sizeof(frame_rpc_reply), enc, sizeof(enc));
+    zassert_equal(size, sizeof(frame_rpc_reply), "Bare reply size %d", size);
+    zassert_mem_equal(enc, frame_rpc_reply, size, "Bare reply changed.");
+
+    /* The decision holds for the connection: a later 0x80 is data. */
+    bare[0] = FRAMECOMPRESS_HDR_CAPS;
+    size = FrameCompress_decode(&server, bare, sizeof(bare), dec, sizeof(dec));
+    zassert_equal(size, sizeof(bare), "Decode error %d", size);
+    zassert_equal(server.rx_errors, 0, "rx_errors %u", server.rx_errors);
+}
+
+ZTEST(framecompress_tests, test_malformed)
+{
+    FrameCompress_Link link;
+    uint8_t bad_offset[] = { FRAMECOMPRESS_HDR_LZ4, 0x10, 'a', 0x05, 0x00 };
+    uint8_t bad_hdr[] = { 0x40, 'a' };
+    uint8_t truncated[] = { FRAMECOMPRESS_HDR_LZ4, 0xf0 };
+    int size;
+
+    FrameCompress_linkInit(&link);
+
+    size = FrameCompress_decode(&link, bad_offset, sizeof(bad_offset), dec,
+        sizeof(dec));
+    zassert_true(size < 0, "Offset past output accepted.");
+    size = FrameCompress_decode(&link, bad_hdr, sizeof(bad_hdr), dec,
+        sizeof(dec));
+    zassert_true(size < 0, "Unknown header bits accepted.");
+    size = FrameCompress_decode(&link, truncated, sizeof(truncated), dec,
+        sizeof(dec));
+    zassert_true(size < 0, "Truncated length accepted.");
+    size = FrameCompress_decode(&link, bad_hdr, 0, dec, sizeof(dec));
+    zassert_true(size < 0, "Empty frame accepted.");
+    zassert_equal(link.rx_errors, 4, "rx_errors %u", link.rx_errors);
+
+    /* Output overflow. */
+    size = FrameCompress_lz4Compress(&work, frame_rpc_reply,
+        sizeof(frame_rpc_reply), enc, sizeof(enc));
+    zassert_true(size > 0, "Compress error %d", size);
+    zassert_true(FrameCompress_lz4Decompress(enc, size, dec, 100) < 0,
+        "Overflow not detected.");
+}
+
+ZTEST(framecompress_tests, test_bench)
+{
+    uint32_t start;
+    uint32_t t_enc;
+    uint32_t t_dec;
+    uint32_t wire_us;
+    uint32_t cpu_us;
+    uint32_t i;
+    int csize = 0;
+    int dsize = 0;
+    int n;
+
+    TC_PRINT("frame       len  comp  ratio  enc_cyc  dec_cyc  "
+        "kB/s@1Mbaud (raw)\n");
+
+    for (i = 0; i < ARRAY_SIZE(frames); i++)
+    {
+        start = k_cycle_get_32();
+        for (n = 0; n < BENCH_LOOPS; n++)
+        {
+            csize = FrameCompress_lz4Compress(&work, frames[i].data,
+                frames[i].len, enc, sizeof(enc));
+        }
+        t_enc = (k_cycle_get_32() - start) / BENCH_LOOPS;
+        zassert_true(csize > 0, "Compress error %d", csize);
+
+        start = k_cycle_get_32();
+        for (n = 0; n < BENCH_LOOPS; n++)
+        {
+            dsize = FrameCompress_lz4Decompress(enc, csize, dec, sizeof(dec));
+        }
+        t_dec = (k_cycle_get_32() - start) / BENCH_LOOPS;
+        zassert_equal(dsize, frames[i].len, "Decompress error %d", dsize);
+
+        /*  What goes on the wire is the smaller of the two plus the header.
+            Effective throughput counts line time plus encode and decode time.
+        */
+        if ((uint32_t)csize >= frames[i].len)
+        {
+            csize = frames[i].len;
+            t_dec = 0;
+        }
+        wire_us = (csize + FRAMECOMPRESS_HDR_SIZE) * LINE_US_PER_BYTE;
+        cpu_us = k_cyc_to_us_ceil32(t_enc + t_dec);
+
+        TC_PRINT("%-10s %4u  %4d  %3u%%  %7u  %7u  %6u (%u)\n",
+            frames[i].name, frames[i].len, csize,
+            (uint32_t)csize * 100 / frames[i].len, t_enc, t_dec,
+            frames[i].len * 1000 / (wire_us + cpu_us),
+            1000 / LINE_US_PER_BYTE);
+    }
+}
+
+ZTEST(framecompress_tests, test_capture)
+{
+    FrameCompress_Link tx;
+    FrameCompress_Link rx;
+    uint32_t i;
+    int size;
+
+    FrameCompress_linkInit(&tx);
+    FrameCompress_linkInit(&rx);
+    tx.peer_caps = true;
+
+    TC_PRINT("captured        len  wire\n");
+
+    for (i = 0; i < ARRAY_SIZE(captured); i++)
+    {
+        size = FrameCompress_encode(&tx, &work, captured[i].data,
+            captured[i].len, enc, sizeof(enc));
+        zassert_true(size > 0, "%s: encode error %d", captured[i].name, size);
+        TC_PRINT("%-14s %4u  %4d\n", captured[i].name, captured[i].len, size);
+
+        size = FrameCompress_decode(&rx, enc, size, dec, sizeof(dec));
+        zassert_equal(size, captured[i].len, "%s: decode error %d",
+            captured[i].name, size);
+        zassert_mem_equal(dec, captured[i].data, size, "%s: mismatch",
+            captured[i].name);
+    }
+
+    /* Wire bytes include the header; at a fixed line rate the throughput
+       gain is raw / wire.
+    */
+    TC_PRINT("total          %4u  %4u  ratio %u%%, %u compressed\n",
+        tx.tx_raw_bytes, tx.tx_wire_bytes,
+        tx.tx_wire_bytes * 100 / tx.tx_raw_bytes, tx.tx_compressed);
+    zassert_true(tx.tx_wire_bytes < tx.tx_raw_bytes + ARRAY_SIZE(captured),
+        "Worse than the header overhead.");
+}
@@ -0,0 +1,155 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include "MqttClientSub.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(mqttclientsub_tests);
+
+static MqttClientSub_Trie trie;
+
+/* Subscriptions, by index. */
+static const char *filters[] =
+{
+    "a/b",
+    "a/+",
+    "a/#",
+    "#",
+    "+/b",
+    "$SYS/#",
+    "+/+",
+};
+
+#define BIT_SUB(i)  (1u << (i))
+
+static void
+collect(int16_t sub, void *arg)
+{
+    uint32_t *mask = (uint32_t *)arg;
+
+    *mask |= BIT_SUB(sub);
+}
+
+static uint32_t
+match(const char *topic)
+{
+    uint32_t mask = 0;
+    int n;
+
+    n = MqttClientSub_trieMatch(&trie, (const uint8_t *)topic, strlen(topic),
+        collect, &mask);
+    zassert_equal(n, __builtin_popcount(mask), "%s: %d matches", topic, n);
+    return mask;
+}
+
+static int
+insert(const char *filter, int16_t sub)
+{
+    return MqttClientSub_trieInsert(&trie, (const uint8_t *)filter,
+        strlen(filter), sub);
+}
+
+static void
+before(void *fixture)
+{
+    uint32_t i;
+
+    ARG_UNUSED(fixture);
+
+    MqttClientSub_trieInit(&trie);
+    for (i = 0; i < ARRAY_SIZE(filters); i++)
+    {
+        zassert_equal(insert(filters[i], i), 0, "insert %s", filters[i]);
+    }
+}
+
+ZTEST_SUITE(mqttclientsub_tests, NULL, NULL, before, NULL, NULL);
+
+ZTEST(mqttclientsub_tests, test_filter_valid)
+{
+    static const char *valid[] =
+    {
+        "a", "a/b", "+", "#", "a/+/c", "a/#", "+/+", "/", "a//b", "$SYS/#",
+    };
+    static const char *invalid[] =
+    {
+        "", "a#", "#a", "a/#/b", "a+/b", "+a", "a/b#", "#/",
+    };
+    uint32_t i;
+
+    for (i = 0; i < ARRAY_SIZE(valid); i++)
+    {
+        zassert_true(MqttClientSub_filterValid((const uint8_t *)valid[i],
+            strlen(valid[i])), "%s rejected", valid[i]);
+    }
+    for (i = 0; i < ARRAY_SIZE(invalid); i++)
+    {
+        zassert_false(MqttClientSub_filterValid((const uint8_t *)invalid[i],
+            strlen(invalid[i])), "%s accepted", invalid[i]);
+    }
+}
+
+ZTEST(mqttclientsub_tests, test_match)
+{
+    uint32_t mask;
+
+    mask = match("a/b");
+    zassert_equal(mask, BIT_SUB(0) | BIT_SUB(1) | BIT_SUB(2) | BIT_SUB(3) |
+        BIT_SUB(4) | BIT_SUB(6), "a/b: 0x%x", mask);
+
+    /* "a/#" matches its parent level, "a/+" does not. */
+    mask = match("a");
+    zassert_equal(mask, BIT_SUB(2) | BIT_SUB(3), "a: 0x%x", mask);
+
+    mask = match("a/b/c");
+    zassert_equal(mask, BIT_SUB(2) | BIT_SUB(3), "a/b/c: 0x%x", mask);
+
+    /* An empty level is a level. */
+    mask = match("/b");
+    zassert_equal(mask, BIT_SUB(3) | BIT_SUB(4) | BIT_SUB(6), "/b: 0x%x",
+        mask);
+
+    mask = match("x/y");
+    zassert_equal(mask, BIT_SUB(3) | BIT_SUB(6), "x/y: 0x%x", mask);
+}
+
+ZTEST(mqttclientsub_tests, test_dollar)
+{
+    uint32_t mask;
+
+    /* Wildcards at the first level do not match '$' topics. */
+    mask = match("$SYS/uptime");
+    zassert_equal(mask, BIT_SUB(5), "$SYS/uptime: 0x%x", mask);
+    mask = match("$SYS");
+    zassert_equal(mask, BIT_SUB(5), "$SYS: 0x%x", mask);
+
+    /* Only the first level counts. */
+    mask = match("a/$b");
+    zassert_equal(mask, BIT_SUB(1) | BIT_SUB(2) | BIT_SUB(3) | BIT_SUB(6),
+        "a/$b: 0x%x", mask);
+}
+
+ZTEST(mqttclientsub_tests, test_insert)
+{
+    /* The trie references the filters. */
+    static char extra[MQTTCLIENTSUB_NODES][8];
+    uint32_t mask;
+    int ret = 0;
+    int i;
+
+    zassert_equal(insert("a/+", 9), -EEXIST, "Duplicate accepted.");
+
+    /* Run out of nodes; what was inserted before still matches. */
+    for (i = 0; i < MQTTCLIENTSUB_NODES && ret == 0; i++)
+    {
+        snprintf(extra[i], sizeof(extra[i]), "n%d/x", i);
+        ret = insert(extra[i], 7);
+    }
+    zassert_equal(ret, -ENOMEM, "Insert %d: %d", i, ret);
+
+    mask = match("a/b");
+    zassert_equal(mask, BIT_SUB(0) | BIT_SUB(1) | BIT_SUB(2) | BIT_SUB(3) |
+        BIT_SUB(4) | BIT_SUB(6), "a/b after -ENOMEM: 0x%x", mask);
+}
@@ -0,0 +1,128 @@
+#include <stdint.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include "TcpSocket.h"
+#include "TcpServer.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(tcpserver_tests);
+
+#define PORT_DEFAULT        4242
+#define PORT_LOW_LATENCY    4243
+#define SERVER_STACK_SIZE   4096
+#define SERVER_PRIO         5
+
+#define RTT_NUM_ITER        200
+#define RTT_HDR_SIZE        4
+#define RTT_BODY_SIZE       28
+#define RTT_MSG_SIZE        (RTT_HDR_SIZE + RTT_BODY_SIZE)
+
+static TcpServer server_default;
+static TcpServer server_low_latency;
+static uint8_t rx_buf_default[1024];
+static uint8_t rx_buf_low_latency[1024];
+
+static const TcpSocket_Opts opts_default = TCPSOCKET_OPTS_DEFAULT;
+static const TcpSocket_Opts opts_low_latency = TCPSOCKET_OPTS_LOW_LATENCY_RPC;
+
+static void
+echo_callback(void *server, int sock, uint8_t *data, uint16_t len, int *finished)
+{
+    (void)server;
+    if (len > 0)
+    {
+        TcpSocket_write(sock, data, len);
+    }
+    *finished = 1;
+}
+
+static void *
+suite_setup(void)
+{
+    int ret;
+
+    ret = TcpServer_init(&server_default, PORT_DEFAULT,
+        rx_buf_default, sizeof(rx_buf_default), SERVER_STACK_SIZE,
+        "tcp_default", SERVER_PRIO, echo_callback, &opts_default);
+    zassert_equal(ret, 0, "TcpServer_init (default) error %d", ret);
+
+    ret = TcpServer_init(&server_low_latency, PORT_LOW_LATENCY,
+        rx_buf_low_latency, sizeof(rx_buf_low_latency), SERVER_STACK_SIZE,
+        "tcp_lowlat", SERVER_PRIO, echo_callback, &opts_low_latency);
+    zassert_equal(ret, 0, "TcpServer_init (low latency) error %d", ret);
+
+    /* Let the server tasks reach accept. */
+    k_sleep(K_MSEC(100));
+    return NULL;
+}
+
+ZTEST_SUITE(tcpserver_tests, NULL, suite_setup, NULL, NULL, NULL);
+
+/******************************************************************************
+    run_rtt
+*//**
+    @brief Runs RTT_NUM_ITER request/reply exchanges against the server on
+    port, with the client using the same options profile. Each request is
+    written as a header and a body.
+******************************************************************************/
+static void
+run_rtt(const char *name, uint16_t port, const TcpSocket_Opts *opts)
+{
+    TcpSocket client;
+    uint8_t msg[RTT_MSG_SIZE];
+    uint8_t reply[RTT_MSG_SIZE];
+    uint32_t min_us = UINT32_MAX;
+    uint32_t max_us = 0;
+    uint64_t total_us = 0;
+    int ret;
+    int i;
+
+    ret = TcpSocket_init(&client);
+    zassert_equal(ret, 0, "TcpSocket_init error %d", ret);
+    TcpSocket_setOpts(client.sock, opts);
+    ret = TcpSocket_connect(&client, "127.0.0.1", port);
+    zassert_equal(ret, 0, "TcpSocket_connect error %d", ret);
+
+    for (i = 0; i < RTT_NUM_ITER; i++)
+    {
+        uint32_t start;
+        uint32_t elapsed_us;
+        int num_read = 0;
+
+        memset(msg, (uint8_t)i, sizeof(msg));
+
+        start = k_cycle_get_32();
+        ret = TcpSocket_write(client.sock, msg, RTT_HDR_SIZE);
+        zassert_equal(ret, RTT_HDR_SIZE, "write error %d", ret);
+        ret = TcpSocket_write(client.sock, msg + RTT_HDR_SIZE, RTT_BODY_SIZE);
+        zassert_equal(ret, RTT_BODY_SIZE, "write error %d", ret);
+
+        while (num_read < RTT_MSG_SIZE)
+        {
+            ret = TcpSocket_read(client.sock, reply + num_read,
+                RTT_MSG_SIZE - num_read);
+            zassert_true(ret > 0, "read error %d", ret);
+            num_read += ret;
+        }
+        elapsed_us = k_cyc_to_us_floor32(k_cycle_get_32() - start);
+
+        zassert_mem_equal(reply, msg, RTT_MSG_SIZE, "Echo mismatch.");
+
+        min_us = MIN(min_us, elapsed_us);
+        max_us = MAX(max_us, elapsed_us);
+        total_us += elapsed_us;
+    }
+
+    TcpSocket_close(client.sock);
+
+    TC_PRINT("%-12s RTT over %u iter: min=%u us avg=%u us max=%u us\n",
+        name, RTT_NUM_ITER, min_us,
+        (uint32_t)(total_us / RTT_NUM_ITER), max_us);
+}
+
+ZTEST(tcpserver_tests, test_rtt)
+{
+    run_rtt("default", PORT_DEFAULT, &opts_default);
+    run_rtt("low-latency", PORT_LOW_LATENCY, &opts_low_latency);
+}
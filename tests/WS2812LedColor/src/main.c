@@ -0,0 +1,214 @@
+#include <stdint.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include "WS2812LedColor.h"
+#include "test_bench.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(ws2812ledcolor_tests);
+
+#define BENCH_PIXELS    300
+#define BENCH_LOOPS     200
+
+static CHSV hsv[BENCH_PIXELS];
+static CRGB rgb[BENCH_PIXELS];
+
+static void *
+suite_setup(void)
+{
+    uint32_t seed = 12345;
+    uint32_t i;
+
+    /* Varying colors so the reference conversion takes all its branches. */
+    for (i = 0; i < BENCH_PIXELS; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        hsv[i].h = (uint8_t)(seed >> 8);
+        hsv[i].s = (uint8_t)(seed >> 16) | 0x80;
+        hsv[i].v = (uint8_t)(seed >> 24);
+    }
+
+    return NULL;
+}
+
+ZTEST_SUITE(ws2812ledcolor_tests, NULL, suite_setup, NULL, NULL, NULL);
+
+ZTEST(ws2812ledcolor_tests, test_rainbow_corners)
+{
+    CHSV c;
+    CRGB out;
+    uint32_t h;
+
+    for (h = 0; h < 256; h++)
+    {
+        /* No saturation is white, no value is black, for any hue. */
+        c = (CHSV){ (uint8_t)h, 0, 255 };
+        WS2812Led_hsv2rgbRainbow(&c, &out, 1);
+        zassert_true(out.r == 255 && out.g == 255 && out.b == 255,
+            "hue %u not white", h);
+
+        c = (CHSV){ (uint8_t)h, 255, 0 };
+        WS2812Led_hsv2rgbRainbow(&c, &out, 1);
+        zassert_true(out.r == 0 && out.g == 0 && out.b == 0,
+            "hue %u not black", h);
+    }
+
+    c = (CHSV){ HUE_RED, 255, 255 };
+    WS2812Led_hsv2rgbRainbow(&c, &out, 1);
+    zassert_true(out.r == 255 && out.g == 0 && out.b == 0, "red");
+
+    c = (CHSV){ HUE_BLUE, 255, 255 };
+    WS2812Led_hsv2rgbRainbow(&c, &out, 1);
+    zassert_true(out.b > out.r && out.b > out.g, "blue");
+}
+
+/** @brief Returns channel 0 (r), 1 (g) or 2 (b) of a color. */
+static uint8_t
+rgb_channel(const CRGB *c, int ch)
+{
+    return (ch == 0) ? c->r : (ch == 1) ? c->g : c->b;
+}
+
+ZTEST(ws2812ledcolor_tests, test_rainbow_saturation)
+{
+    /* Hues where both spectra have one channel at full scale. */
+    static const struct
+    {
+        uint8_t h_rainbow;
+        uint8_t h_hex;
+        int ch;
+    } prim[] = {
+        { HUE_RED, 0, 0 }, { HUE_GREEN, 85, 1 }, { HUE_BLUE, 171, 2 },
+    };
+    static const uint8_t vals[] = { 255, 192, 128, 64 };
+    CHSV c;
+    CRGB out;
+    CRGB ref;
+    uint8_t dom;
+    uint8_t dom_ref;
+    uint8_t last;
+    uint32_t p;
+    uint32_t v;
+    int32_t s;
+
+    for (p = 0; p < ARRAY_SIZE(prim); p++)
+    {
+        for (v = 0; v < ARRAY_SIZE(vals); v++)
+        {
+            last = 0;
+            for (s = 255; s >= 0; s--)
+            {
+                /*  The dominant channel stays at the hexcone value, and
+                    does not drop as the color is desaturated.
+                */
+                c = (CHSV){ prim[p].h_rainbow, (uint8_t)s, vals[v] };
+                WS2812Led_hsv2rgbRainbow(&c, &out, 1);
+                c = (CHSV){ prim[p].h_hex, (uint8_t)s, vals[v] };
+                WS2812Led_hsv2rgb(&c, &ref);
+                dom = rgb_channel(&out, prim[p].ch);
+                dom_ref = rgb_channel(&ref, prim[p].ch);
+
+                zassert_true(dom + 2 >= dom_ref,
+                    "hue %u s %d v %u: %u < %u", prim[p].h_rainbow, s,
+                    vals[v], dom, dom_ref);
+                zassert_true(dom >= last, "hue %u s %d v %u: %u < %u",
+                    prim[p].h_rainbow, s, vals[v], dom, last);
+                last = dom;
+            }
+        }
+    }
+}
+
+ZTEST(ws2812ledcolor_tests, test_rainbow_batch)
+{
+    CRGB one;
+    uint32_t i;
+
+    /* The batch result is the same as converting one at a time. */
+    WS2812Led_hsv2rgbRainbow(hsv, rgb, BENCH_PIXELS);
+    for (i = 0; i < BENCH_PIXELS; i++)
+    {
+        WS2812Led_hsv2rgbRainbow(&hsv[i], &one, 1);
+        zassert_mem_equal(&one, &rgb[i], sizeof(one), "pixel %u", i);
+    }
+}
+
+ZTEST(ws2812ledcolor_tests, test_blend)
+{
+    CRGB dst;
+    CRGB src = { .r = 200, .g = 100, .b = 0 };
+    CRGB below = { .r = 100, .g = 200, .b = 255 };
+    uint32_t a;
+
+    for (a = 0; a < 256; a++)
+    {
+        /* Alpha goes from the color below (0) to the color on top (255). */
+        dst = below;
+        WS2812Led_blendRgb(&dst, &src, 1, WS2812LED_BLEND_ALPHA, (uint8_t)a);
+        zassert_true(dst.r >= 100 && dst.r <= 200, "alpha %u r", a);
+        zassert_true(dst.g >= 100 && dst.g <= 200, "alpha %u g", a);
+        if (a == 0)
+        {
+            zassert_mem_equal(&dst, &below, sizeof(dst), "alpha 0");
+        }
+        else if (a == 255)
+        {
+            zassert_mem_equal(&dst, &src, sizeof(dst), "alpha 255");
+        }
+    }
+
+    /* Add saturates, max keeps the brighter channel. */
+    dst = below;
+    WS2812Led_blendRgb(&dst, &src, 1, WS2812LED_BLEND_ADD, 255);
+    zassert_true(dst.r == 255 && dst.g == 255 && dst.b == 255, "add");
+    dst = below;
+    WS2812Led_blendRgb(&dst, &src, 1, WS2812LED_BLEND_ADD, 127);
+    zassert_true(dst.r == 200 && dst.g == 250 && dst.b == 255, "add half");
+
+    dst = below;
+    WS2812Led_blendRgb(&dst, &src, 1, WS2812LED_BLEND_MAX, 255);
+    zassert_true(dst.r == 200 && dst.g == 200 && dst.b == 255, "max");
+    dst = below;
+    WS2812Led_blendRgb(&dst, &src, 1, WS2812LED_BLEND_MAX, 0);
+    zassert_mem_equal(&dst, &below, sizeof(dst), "max 0");
+
+    dst = below;
+    WS2812Led_blendRgb(&dst, &src, 1, WS2812LED_BLEND_COPY, 0);
+    zassert_mem_equal(&dst, &src, sizeof(dst), "copy");
+}
+
+ZTEST(ws2812ledcolor_tests, test_bench)
+{
+    uint64_t start;
+    uint64_t t_ref;
+    uint64_t t_lut;
+    uint64_t pix_ns = BENCH_LOOPS * BENCH_PIXELS * 1000000000ULL;
+    uint32_t n;
+    uint32_t i;
+
+    start = bench_stamp();
+    for (n = 0; n < BENCH_LOOPS; n++)
+    {
+        for (i = 0; i < BENCH_PIXELS; i++)
+        {
+            WS2812Led_hsv2rgb(&hsv[i], &rgb[i]);
+        }
+    }
+    t_ref = bench_elapsed_ns(start);
+
+    start = bench_stamp();
+    for (n = 0; n < BENCH_LOOPS; n++)
+    {
+        WS2812Led_hsv2rgbRainbow(hsv, rgb, BENCH_PIXELS);
+    }
+    t_lut = bench_elapsed_ns(start);
+
+    TC_PRINT("conversion        pixels/s\n");
+    TC_PRINT("hsv2rgb         %10llu\n",
+        (unsigned long long)(pix_ns / t_ref));
+    TC_PRINT("hsv2rgbRainbow  %10llu  (x%llu.%02llu)\n",
+        (unsigned long long)(pix_ns / t_lut),
+        (unsigned long long)(t_ref / t_lut),
+        (unsigned long long)((t_ref * 100 / t_lut) % 100));
+}
@@ -0,0 +1,233 @@
+/*******************************************************************************
+ *  @file: fake_strip.c
+ *
+ *  @brief: Fake led_strip device that keeps and captures written frames.
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/led_strip.h>
+
+#include "fake_strip.h"
+
+#if defined(CONFIG_ARCH_POSIX) && defined(CONFIG_EXTERNAL_LIBC)
+#include <stdio.h>
+#define FAKE_STRIP_HOST_FILES
+#endif
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(fake_strip);
+
+/** @brief Device state. Only the test thread writes frames. */
+static struct
+{
+    CRGB last[FAKE_STRIP_MAX_PIXELS];
+    uint16_t lastPixels;
+    uint32_t frames;
+    /** @brief Capture, rows of width pixels. */
+    const char *path;
+    uint8_t *rows;
+    uint16_t width;
+    uint16_t maxRows;
+    uint16_t numRows;
+} fake;
+
+/******************************************************************************
+    capture_row
+*//**
+    @brief Appends the last frame to the capture as an RGB row.
+******************************************************************************/
+static void
+capture_row(void)
+{
+    uint8_t *row;
+    uint16_t i;
+
+    if (!fake.rows || fake.numRows == fake.maxRows)
+    {
+        return;
+    }
+
+    row = fake.rows + (size_t)fake.numRows * fake.width * 3;
+    memset(row, 0, (size_t)fake.width * 3);
+    for (i = 0; i < MIN(fake.lastPixels, fake.width); i++)
+    {
+        *row++ = fake.last[i].r;
+        *row++ = fake.last[i].g;
+        *row++ = fake.last[i].b;
+    }
+    fake.numRows++;
+}
+
+static int
+fake_strip_update_rgb(
+    const struct device *dev,
+    struct led_rgb *pixels,
+    size_t num_pixels)
+{
+    ARG_UNUSED(dev);
+
+    if (num_pixels > FAKE_STRIP_MAX_PIXELS)
+    {
+        return -EINVAL;
+    }
+
+    memcpy(fake.last, pixels, num_pixels * sizeof(CRGB));
+    fake.lastPixels = num_pixels;
+    fake.frames++;
+    capture_row();
+
+    return 0;
+}
+
+static size_t
+fake_strip_length(const struct device *dev)
+{
+    ARG_UNUSED(dev);
+
+    return FAKE_STRIP_MAX_PIXELS;
+}
+
+static const struct led_strip_driver_api fake_strip_api =
+{
+    .update_rgb = fake_strip_update_rgb,
+    .length = fake_strip_length,
+};
+
+static int
+fake_strip_init(const struct device *dev)
+{
+    ARG_UNUSED(dev);
+
+    return 0;
+}
+
+DEVICE_DEFINE(fake_led_strip, "fake_led_strip", fake_strip_init, NULL, NULL,
+    NULL, POST_KERNEL, CONFIG_KERNEL_INIT_PRIORITY_DEVICE, &fake_strip_api);
+
+/******************************************************************************
+    [docimport fake_strip_device]
+*//**
+    @brief Returns the fake led_strip device.
+******************************************************************************/
+const struct device *
+fake_strip_device(void)
+{
+    return DEVICE_GET(fake_led_strip);
+}
+
+/******************************************************************************
+    [docimport fake_strip_frames]
+*//**
+    @brief Returns the number of frames written to the device.
+******************************************************************************/
+uint32_t
+fake_strip_frames(void)
+{
+    return fake.frames;
+}
+
+/******************************************************************************
+    [docimport fake_strip_last]
+*//**
+    @brief Returns the last frame written.
+    @param[out] numPixels  Returned frame length.
+******************************************************************************/
+const CRGB *
+fake_strip_last(uint16_t *numPixels)
+{
+    *numPixels = fake.lastPixels;
+    return fake.last;
+}
+
+/******************************************************************************
+    [docimport fake_strip_capture_start]
+*//**
+    @brief Starts capturing frames to a binary PPM image, one row per frame
+    (a timeline of the strip). The image is written by
+    fake_strip_capture_stop. Only on native_sim with the host libc, else
+    frames are not captured.
+    @param[in] path  Image path, on the host.
+    @param[in] numPixels  Frame length (image width).
+    @param[in] maxFrames  Frames to keep (image height at most).
+    @return Returns 0 on success, -ENOTSUP without host files, -ENOMEM.
+******************************************************************************/
+int
+fake_strip_capture_start(
+    const char *path,
+    uint16_t numPixels,
+    uint16_t maxFrames)
+{
+#if defined(FAKE_STRIP_HOST_FILES)
+    fake.rows = malloc((size_t)numPixels * maxFrames * 3);
+    if (!fake.rows)
+    {
+        return -ENOMEM;
+    }
+    fake.path = path;
+    fake.width = numPixels;
+    fake.maxRows = maxFrames;
+    fake.numRows = 0;
+
+    return 0;
+#else
+    ARG_UNUSED(path);
+    ARG_UNUSED(numPixels);
+    ARG_UNUSED(maxFrames);
+
+    return -ENOTSUP;
+#endif
+}
+
+/******************************************************************************
+    [docimport fake_strip_capture_frame]
+*//**
+    @brief Adds the last frame to the capture again, for a frame in which
+    nothing was written (the strip holds its pixels).
+******************************************************************************/
+void
+fake_strip_capture_frame(void)
+{
+    capture_row();
+}
+
+/******************************************************************************
+    [docimport fake_strip_capture_stop]
+*//**
+    @brief Writes the captured frames and stops capturing.
+    @return Returns the number of frames written to the image.
+******************************************************************************/
+uint32_t
+fake_strip_capture_stop(void)
+{
+    uint32_t numRows = 0;
+
+#if defined(FAKE_STRIP_HOST_FILES)
+    FILE *f;
+
+    if (!fake.rows)
+    {
+        return 0;
+    }
+
+    f = fopen(fake.path, "wb");
+    if (!f)
+    {
+        LOG_ERR("Error opening %s", fake.path);
+    }
+    else
+    {
+        fprintf(f, "P6\n%u %u\n255\n", fake.width, fake.numRows);
+        fwrite(fake.rows, 3, (size_t)fake.width * fake.numRows, f);
+        fclose(f);
+        numRows = fake.numRows;
+    }
+
+    free(fake.rows);
+    fake.rows = NULL;
+#endif
+
+    return numRows;
+}
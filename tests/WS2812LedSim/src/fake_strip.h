@@ -0,0 +1,76 @@
+/*******************************************************************************
+ *  @file: fake_strip.h
+ *
+ *  @brief: Fake led_strip device that keeps and captures written frames.
+*******************************************************************************/
+#ifndef FAKE_STRIP_H
+#define FAKE_STRIP_H
+
+#include <stdint.h>
+#include <zephyr/device.h>
+#include "WS2812LedColor.h"
+
+/** @brief Longest frame the fake strip takes. */
+#define FAKE_STRIP_MAX_PIXELS       1000
+
+/******************************************************************************
+    [docexport fake_strip_device]
+*//**
+    @brief Returns the fake led_strip device.
+******************************************************************************/
+const struct device *
+fake_strip_device(void);
+
+/******************************************************************************
+    [docexport fake_strip_frames]
+*//**
+    @brief Returns the number of frames written to the device.
+******************************************************************************/
+uint32_t
+fake_strip_frames(void);
+
+/******************************************************************************
+    [docexport fake_strip_last]
+*//**
+    @brief Returns the last frame written.
+    @param[out] numPixels  Returned frame length.
+******************************************************************************/
+const CRGB *
+fake_strip_last(uint16_t *numPixels);
+
+/******************************************************************************
+    [docexport fake_strip_capture_start]
+*//**
+    @brief Starts capturing frames to a binary PPM image, one row per frame
+    (a timeline of the strip). The image is written by
+    fake_strip_capture_stop. Only on native_sim with the host libc, else
+    frames are not captured.
+    @param[in] path  Image path, on the host.
+    @param[in] numPixels  Frame length (image width).
+    @param[in] maxFrames  Frames to keep (image height at most).
+    @return Returns 0 on success, -ENOTSUP without host files, -ENOMEM.
+******************************************************************************/
+int
+fake_strip_capture_start(
+    const char *path,
+    uint16_t numPixels,
+    uint16_t maxFrames);
+
+/******************************************************************************
+    [docexport fake_strip_capture_frame]
+*//**
+    @brief Adds the last frame to the capture again, for a frame in which
+    nothing was written (the strip holds its pixels).
+******************************************************************************/
+void
+fake_strip_capture_frame(void);
+
+/******************************************************************************
+    [docexport fake_strip_capture_stop]
+*//**
+    @brief Writes the captured frames and stops capturing.
+    @return Returns the number of frames written to the image.
+******************************************************************************/
+uint32_t
+fake_strip_capture_stop(void);
+#endif
@@ -0,0 +1,421 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/sys/crc.h>
+#include "WS2812Led.h"
+#include "fake_strip.h"
+#include "test_bench.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(ws2812ledsim_tests);
+
+/** @brief Golden runs: frames per effect, from a fixed generator seed. */
+#define GOLDEN_PIXELS   60
+#define GOLDEN_FRAMES   64
+#define GOLDEN_SEED     0x2812
+
+#define BENCH_FRAMES    200
+
+/** @brief Strips without tasks, driven by the tests. The first one is used
+    for the golden runs. */
+static const uint16_t strip_pixels[] = { GOLDEN_PIXELS, 300, 1000 };
+static WS2812Led leds[ARRAY_SIZE(strip_pixels)];
+
+/** @brief Layered strip: a base under the whole strip, a top layer over
+    part of it, and a separate layer at the end. */
+#define LAYER_PIXELS    40
+static WS2812Led_Strip layer_strip;
+static WS2812Led_Segment base = { .startIdx = 0, .endIdx = 39 };
+static WS2812Led_Segment top = { .startIdx = 10, .endIdx = 19,
+    .blend = WS2812LED_BLEND_ADD, .alpha = 255 };
+static WS2812Led_Segment far = { .startIdx = 30, .endIdx = 39 };
+
+/** @brief Frame packed as RGB bytes, for hashing. */
+static uint8_t frame_rgb[FAKE_STRIP_MAX_PIXELS * 3];
+
+static const CHSV red = { HUE_RED, 255, 255 };
+static const CHSV green = { HUE_GREEN, 255, 255 };
+static const CHSV blue = { HUE_BLUE, 255, 255 };
+static const CHSV purple = { HUE_PURPLE, 255, 200 };
+
+static void
+start_solid(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_fill_solid(seg, &blue);
+}
+
+static void
+start_rainbow(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_fill_rainbow(seg, 0, 255, 255);
+}
+
+static void
+start_gradient(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_fill_gradient(seg, &red, &blue, GRAD_LONGEST);
+}
+
+static void
+start_random(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_fill_random(seg, 255, 255);
+}
+
+static void
+start_blink(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_fill_rainbow(seg, 0, 255, 255);
+    WS2812Led_seg_blink(seg, 20);
+}
+
+static void
+start_blend(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_blend(seg, &red, &blue, GRAD_SHORTEST, 16, 10);
+}
+
+static void
+start_twinkle(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_twinkle(seg, 20, 10);
+}
+
+static void
+start_sparkle(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_sparkle(seg, NULL, 3, 10);
+}
+
+static void
+start_sparkle_hue(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_sparkle(seg, &green, 3, 10);
+}
+
+static void
+start_fire(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_fire(seg, 55, 120, 10);
+}
+
+static void
+start_dissolve(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_dissolve(seg, &green, 32, 50, 10);
+}
+
+static void
+start_meteor(WS2812Led_Segment *seg)
+{
+    WS2812Led_seg_meteor(seg, &purple, 5, 64, true, 10);
+}
+
+/** @brief Every mode, with the CRC-32 of its golden run: GOLDEN_FRAMES
+    frames of GOLDEN_PIXELS pixels as RGB bytes. When an effect changes on
+    purpose, check its captured timeline and take the CRC reported by
+    test_golden. */
+static const struct
+{
+    const char *name;
+    void (*start)(WS2812Led_Segment *seg);
+    uint32_t crc;
+} modes[] =
+{
+    { "solid",       start_solid,       0x3af3ad2e },
+    { "rainbow",     start_rainbow,     0xbd9f42f0 },
+    { "gradient",    start_gradient,    0xd7da7a45 },
+    { "random",      start_random,      0x486eb4f5 },
+    { "blink",       start_blink,       0xed2358f4 },
+    { "blend",       start_blend,       0x6402add5 },
+    { "twinkle",     start_twinkle,     0x3fc10825 },
+    { "sparkle",     start_sparkle,     0xe57fe937 },
+    { "sparkle_hue", start_sparkle_hue, 0xbd801c1d },
+    { "fire",        start_fire,        0xc54ab54e },
+    { "dissolve",    start_dissolve,    0x68a1a4ac },
+    { "meteor",      start_meteor,      0xdfd34a07 },
+};
+
+/******************************************************************************
+    reset
+*//**
+    @brief Stops the segment's effect, blanks it through a written frame, so
+    the fake strip holds this strip's frame, and reseeds its generator.
+******************************************************************************/
+static void
+reset(WS2812Led *led, uint32_t seed)
+{
+    CRGB white = WS2812LED_RGB_COLOR(255, 255, 255);
+    CRGB black = WS2812LED_RGB_COLOR_OFF;
+
+    WS2812Led_seg_show(&led->seg);
+    WS2812Led_seg_fill_solid_rgb(&led->seg, &white);
+    (void)WS2812Led_frame(&led->strip);
+    WS2812Led_seg_fill_solid_rgb(&led->seg, &black);
+    WS2812Led_seg_off(&led->seg);
+    zassert_equal(WS2812Led_frame(&led->strip), 1, "blank frame not written");
+    RANDOM_FAST_SEED_WITH(&led->seg.rng, seed);
+}
+
+/******************************************************************************
+    frame_crc
+*//**
+    @brief Adds the frame held by the fake strip to a CRC.
+******************************************************************************/
+static uint32_t
+frame_crc(uint32_t crc)
+{
+    const CRGB *frame;
+    uint16_t numPixels;
+    uint16_t i;
+
+    frame = fake_strip_last(&numPixels);
+    for (i = 0; i < numPixels; i++)
+    {
+        /* Color bytes only, CRGB may have a scratch byte. */
+        frame_rgb[3*i] = frame[i].r;
+        frame_rgb[3*i + 1] = frame[i].g;
+        frame_rgb[3*i + 2] = frame[i].b;
+    }
+
+    return crc32_ieee_update(crc, frame_rgb, 3*numPixels);
+}
+
+static void *
+suite_setup(void)
+{
+    uint32_t i;
+    int ret;
+
+    for (i = 0; i < ARRAY_SIZE(leds); i++)
+    {
+        /* No tasks: frames and effect steps are driven by the tests. */
+        ret = WS2812Led_init(fake_strip_device(), &leds[i], "sim",
+            strip_pixels[i], 0, 20, 15, 0, 20, 15);
+        zassert_equal(ret, 0, "WS2812Led_init %u", strip_pixels[i]);
+    }
+
+    layer_strip.numPixels = LAYER_PIXELS;
+    ret = WS2812Led_init_strip(fake_strip_device(), &layer_strip);
+    zassert_equal(ret, 0, "WS2812Led_init_strip");
+    zassert_equal(WS2812Led_addSegment(&layer_strip, &base), 0, "base");
+    zassert_equal(WS2812Led_addSegment(&layer_strip, &top), 0, "top");
+    zassert_equal(WS2812Led_addSegment(&layer_strip, &far), 0, "far");
+
+    return NULL;
+}
+
+ZTEST_SUITE(ws2812ledsim_tests, NULL, suite_setup, NULL, NULL, NULL);
+
+ZTEST(ws2812ledsim_tests, test_frame_skip)
+{
+    WS2812Led *led = &leds[0];
+    const CRGB *frame;
+    uint16_t numPixels;
+    uint32_t frames;
+    uint16_t i;
+
+    reset(led, GOLDEN_SEED);
+
+    /* Nothing changed: no write. */
+    frames = fake_strip_frames();
+    zassert_equal(WS2812Led_frame(&led->strip), 0, "unchanged frame written");
+    zassert_equal(fake_strip_frames(), frames, "device written");
+
+    /* Hiding lit pixels blanks the frame, showing restores them. */
+    WS2812Led_seg_fill_solid(&led->seg, &red);
+    zassert_equal(WS2812Led_frame(&led->strip), 1, "fill not written");
+    frame = fake_strip_last(&numPixels);
+    zassert_equal(numPixels, GOLDEN_PIXELS, "frame length");
+    zassert_true(frame[0].r == 255 && frame[0].g == 0 && frame[0].b == 0,
+        "not red");
+
+    WS2812Led_seg_hide(&led->seg);
+    zassert_equal(WS2812Led_frame(&led->strip), 1, "hide not written");
+    frame = fake_strip_last(&numPixels);
+    for (i = 0; i < numPixels; i++)
+    {
+        zassert_true(frame[i].r == 0 && frame[i].g == 0 && frame[i].b == 0,
+            "pixel %u not blank", i);
+    }
+
+    WS2812Led_seg_show(&led->seg);
+    zassert_equal(WS2812Led_frame(&led->strip), 1, "show not written");
+    frame = fake_strip_last(&numPixels);
+    zassert_equal(frame[numPixels - 1].r, 255, "not restored");
+}
+
+/******************************************************************************
+    pixel_is
+*//**
+    @brief Returns true if a pixel of the last frame has the given color.
+******************************************************************************/
+static bool
+pixel_is(uint16_t idx, uint8_t r, uint8_t g, uint8_t b)
+{
+    const CRGB *frame;
+    uint16_t numPixels;
+
+    frame = fake_strip_last(&numPixels);
+    return idx < numPixels &&
+        frame[idx].r == r && frame[idx].g == g && frame[idx].b == b;
+}
+
+ZTEST(ws2812ledsim_tests, test_layers)
+{
+    CRGB red = WS2812LED_RGB_COLOR(100, 20, 0);
+    CRGB orange = WS2812LED_RGB_COLOR(200, 20, 0);
+    CRGB blue = WS2812LED_RGB_COLOR(0, 0, 50);
+    CHSV black = WS2812LED_HSV_COLOR_OFF;
+    WS2812Led_Segment outside = { .startIdx = 30, .endIdx = LAYER_PIXELS };
+
+    WS2812Led_seg_show(&base);
+    WS2812Led_seg_show(&top);
+    WS2812Led_seg_show(&far);
+    WS2812Led_seg_fill_solid_rgb(&base, &red);
+    WS2812Led_seg_fill_solid_rgb(&top, &orange);
+    WS2812Led_seg_fill_solid_rgb(&far, &blue);
+    zassert_equal(WS2812Led_frame(&layer_strip), 1, "layers not written");
+
+    /* Add saturates, copy replaces. */
+    zassert_true(pixel_is(9, 100, 20, 0), "base");
+    zassert_true(pixel_is(10, 255, 40, 0), "add");
+    zassert_true(pixel_is(19, 255, 40, 0), "add");
+    zassert_true(pixel_is(20, 100, 20, 0), "base");
+    zassert_true(pixel_is(30, 0, 0, 50), "copy");
+
+    WS2812Led_seg_layer(&top, WS2812LED_BLEND_MAX, 255);
+    zassert_equal(WS2812Led_frame(&layer_strip), 1, "max not written");
+    zassert_true(pixel_is(15, 200, 20, 0), "max");
+
+    /* Half way, as blend8. Alpha 0 is the base. */
+    WS2812Led_seg_layer(&top, WS2812LED_BLEND_ALPHA, 128);
+    zassert_equal(WS2812Led_frame(&layer_strip), 1, "alpha not written");
+    zassert_true(pixel_is(15, 150, 20, 0), "alpha");
+    WS2812Led_seg_layer(&top, WS2812LED_BLEND_ALPHA, 0);
+    zassert_equal(WS2812Led_frame(&layer_strip), 1, "alpha 0 not written");
+    zassert_true(pixel_is(15, 100, 20, 0), "alpha 0");
+
+    /* Adding nothing leaves the base, also from HSV pixels. */
+    WS2812Led_seg_layer(&top, WS2812LED_BLEND_ADD, 0);
+    zassert_equal(WS2812Led_frame(&layer_strip), 0, "add 0 changed");
+    WS2812Led_seg_layer(&top, WS2812LED_BLEND_ADD, 255);
+    WS2812Led_seg_fill_solid(&top, &black);
+    zassert_equal(WS2812Led_frame(&layer_strip), 0, "add black changed");
+    WS2812Led_seg_fill_solid_rgb(&top, &orange);
+
+    /*  Only the dirty region is recomposed, from the layers overlapping
+        it: hiding the top reads the base under it.
+    */
+    zassert_equal(WS2812Led_frame(&layer_strip), 1, "add not written");
+    zassert_true(pixel_is(15, 255, 40, 0), "add");
+    WS2812Led_resetMetrics(&layer_strip);
+    WS2812Led_seg_hide(&top);
+    zassert_equal(WS2812Led_frame(&layer_strip), 1, "hide not written");
+    zassert_equal(layer_strip.segmentsComposed, 1, "layers read");
+    zassert_true(pixel_is(15, 100, 20, 0), "hidden");
+
+    /* The far layer's region also has the base under it. */
+    WS2812Led_resetMetrics(&layer_strip);
+    WS2812Led_seg_fill_solid_rgb(&far, &orange);
+    zassert_equal(WS2812Led_frame(&layer_strip), 1, "far not written");
+    zassert_equal(layer_strip.segmentsComposed, 2, "layers read");
+    zassert_true(pixel_is(29, 100, 20, 0), "base");
+    zassert_true(pixel_is(39, 200, 20, 0), "far");
+
+    /* Segments must be inside the strip. */
+    zassert_equal(WS2812Led_addSegment(&layer_strip, &outside), -EINVAL,
+        "outside segment added");
+}
+
+ZTEST(ws2812ledsim_tests, test_golden)
+{
+    WS2812Led *led = &leds[0];
+    char path[48];
+    uint32_t mismatches = 0;
+    uint32_t crc;
+    uint32_t i;
+    uint32_t n;
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        reset(led, GOLDEN_SEED);
+
+        snprintf(path, sizeof(path), "ws2812led_%s.ppm", modes[i].name);
+        (void)fake_strip_capture_start(path, GOLDEN_PIXELS, GOLDEN_FRAMES);
+
+        modes[i].start(&led->seg);
+        crc = 0;
+        for (n = 0; n < GOLDEN_FRAMES; n++)
+        {
+            /* The first frame is the effect's initial pixels. */
+            if (n > 0)
+            {
+                (void)WS2812Led_seg_step(&led->seg);
+            }
+            if (WS2812Led_frame(&led->strip) == 0)
+            {
+                /* The strip holds its pixels, keep the timeline. */
+                fake_strip_capture_frame();
+            }
+            crc = frame_crc(crc);
+        }
+
+        if (fake_strip_capture_stop() > 0)
+        {
+            TC_PRINT("captured %s\n", path);
+        }
+        if (crc != modes[i].crc)
+        {
+            TC_PRINT("%-12s crc 0x%08x, golden 0x%08x\n", modes[i].name,
+                crc, modes[i].crc);
+            mismatches++;
+        }
+    }
+
+    zassert_equal(mismatches, 0, "%u modes differ from golden", mismatches);
+}
+
+ZTEST(ws2812ledsim_tests, test_bench)
+{
+    uint64_t start;
+    uint64_t t[ARRAY_SIZE(leds)];
+    uint32_t i;
+    uint32_t j;
+    uint32_t n;
+
+    TC_PRINT("frames/s     ");
+    for (j = 0; j < ARRAY_SIZE(leds); j++)
+    {
+        TC_PRINT("  %5u px", strip_pixels[j]);
+    }
+    TC_PRINT("\n");
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(leds); j++)
+        {
+            reset(&leds[j], GOLDEN_SEED);
+            modes[i].start(&leds[j].seg);
+
+            /* Step, compose and write, as the strip task does. */
+            start = bench_stamp();
+            for (n = 0; n < BENCH_FRAMES; n++)
+            {
+                (void)WS2812Led_seg_step(&leds[j].seg);
+                (void)WS2812Led_frame(&leds[j].strip);
+            }
+            t[j] = bench_elapsed_ns(start);
+        }
+
+        TC_PRINT("%-12s ", modes[i].name);
+        for (j = 0; j < ARRAY_SIZE(leds); j++)
+        {
+            TC_PRINT("  %8llu",
+                (unsigned long long)(BENCH_FRAMES * 1000000000ULL / t[j]));
+        }
+        TC_PRINT("\n");
+    }
+}
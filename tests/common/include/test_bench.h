@@ -0,0 +1,54 @@
+/*******************************************************************************
+ *  @file: test_bench.h
+ *
+ *  @brief: Timing helpers shared by the test benches.
+*******************************************************************************/
+#ifndef TEST_BENCH_H
+#define TEST_BENCH_H
+
+#include <stdint.h>
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+
+#if defined(CONFIG_ARCH_POSIX) && defined(CONFIG_EXTERNAL_LIBC)
+#include <time.h>
+#endif
+
+/******************************************************************************
+    bench_stamp
+*//**
+    @brief Returns a timestamp for bench_elapsed_ns. Host time on native_sim,
+    where code takes no simulated time, else the cycle counter.
+******************************************************************************/
+static inline uint64_t
+bench_stamp(void)
+{
+#if defined(CONFIG_ARCH_POSIX) && defined(CONFIG_EXTERNAL_LIBC)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+    return k_cycle_get_32();
+#endif
+}
+
+/******************************************************************************
+    bench_elapsed_ns
+*//**
+    @brief Returns the ns elapsed since a bench_stamp, at least 1.
+******************************************************************************/
+static inline uint64_t
+bench_elapsed_ns(uint64_t stamp)
+{
+    uint64_t ns;
+
+#if defined(CONFIG_ARCH_POSIX) && defined(CONFIG_EXTERNAL_LIBC)
+    ns = bench_stamp() - stamp;
+#else
+    ns = k_cyc_to_ns_floor64((uint32_t)(k_cycle_get_32() - (uint32_t)stamp));
+#endif
+    return MAX(ns, 1);
+}
+
+#endif
@@ -0,0 +1,256 @@
+#include <stdint.h>
+#include <string.h>
+#include <zephyr/kernel.h>
+#include <zephyr/ztest.h>
+#include <zephyr/device.h>
+#include <zephyr/devicetree.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+#include <zephyr/net/net_if.h>
+#include <zephyr/net/net_pkt.h>
+#include <zephyr/net/ethernet.h>
+#if defined(CONFIG_ETH_SERIAL_SLIP)
+#include "slip.h"
+#else
+#include "Cobs_frame.h"
+#endif
+#include "eth_serial.h"
+
+#include <zephyr/logging/log.h>
+LOG_MODULE_REGISTER(eth_serial_tests);
+
+#define MAX_FRAME_SIZE      1518
+#define ETH_TYPE_ARP        0x0806
+#define ARP_OP_REPLY        2
+#define ETH_TYPE_LOCAL      0x88b5
+
+static const struct device *const uart_dev =
+    DEVICE_DT_GET(DT_CHOSEN(zephyr_uart_pipe));
+
+static struct net_if *iface;
+static uint8_t buf_framed[2*MAX_FRAME_SIZE + 2];
+static uint8_t buf_tx[2*MAX_FRAME_SIZE + 2];
+static uint8_t buf_deframed[MAX_FRAME_SIZE];
+
+static const struct in_addr my_addr = { { { 192, 0, 2, 1 } } };
+static const uint8_t peer_mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x02 };
+
+#if defined(CONFIG_ETH_SERIAL_SLIP)
+#define test_framer             slip_framer
+#else
+#define test_framer             Cobs_framer
+static Cobs_Deframer cobs_deframer;
+#endif
+
+static void *
+suite_setup(void)
+{
+    iface = net_if_get_default();
+    zassert_not_null(iface, "No network interface.");
+    zassert_not_null(
+        net_if_ipv4_addr_add(iface, (struct in_addr *)&my_addr,
+            NET_ADDR_MANUAL, 0),
+        "Failed adding ipv4 address.");
+#if defined(CONFIG_ETH_SERIAL_COBS)
+    zassert_equal(Cobs_deframer_init(&cobs_deframer, 2*MAX_FRAME_SIZE + 2), 0,
+        "Deframer init failed.");
+#endif
+    return NULL;
+}
+
+static void
+before_each(void *fixture)
+{
+    (void)fixture;
+    uart_emul_flush_tx_data(uart_dev);
+    eth_serial_stats_reset(net_if_get_device(iface));
+}
+
+ZTEST_SUITE(eth_serial_tests, NULL, suite_setup, before_each, NULL, NULL);
+
+/******************************************************************************
+    read_tx_frame
+*//**
+    @brief Waits for the driver to write a frame on the uart, then deframes it.
+    @return Returns the deframed size, 0 if nothing was sent.
+******************************************************************************/
+static int
+read_tx_frame(uint8_t *out, uint32_t out_max)
+{
+#if defined(CONFIG_ETH_SERIAL_SLIP)
+    slip_deframer_ctx deframer;
+#endif
+    uint32_t num;
+
+    /* Async tx completes from the uart emulator work queue. */
+    k_sleep(K_MSEC(50));
+
+    num = uart_emul_get_tx_data(uart_dev, buf_tx, sizeof(buf_tx));
+    if (num == 0)
+    {
+        return 0;
+    }
+
+#if defined(CONFIG_ETH_SERIAL_SLIP)
+    zassert_equal(slip_deframer_init(&deframer, MAX_FRAME_SIZE), 0,
+        "Deframer init failed.");
+    return slip_deframer(&deframer, buf_tx, num, out, out_max);
+#else
+    Cobs_deframer_reset(&cobs_deframer);
+    return Cobs_deframer(&cobs_deframer, buf_tx, num, out, out_max);
+#endif
+}
+
+ZTEST(eth_serial_tests, test_tx_framing)
+{
+    const struct device *dev = net_if_get_device(iface);
+    const struct ethernet_api *api = dev->api;
+    struct eth_serial_stats stats;
+    struct net_pkt *pkt;
+    uint8_t frame[64];
+    int size;
+    int i;
+
+    /* Include zero and the SLIP END/ESC bytes so escaping is exercised. */
+    for (i = 0; i < sizeof(frame); i++)
+    {
+        frame[i] = (uint8_t)(i * 7);
+    }
+    frame[20] = 0xc0;
+    frame[21] = 0xdb;
+
+    pkt = net_pkt_alloc_with_buffer(iface, sizeof(frame), AF_UNSPEC, 0,
+        K_NO_WAIT);
+    zassert_not_null(pkt, "Failed allocating packet.");
+    zassert_equal(net_pkt_write(pkt, frame, sizeof(frame)), 0, "write failed");
+
+    zassert_equal(api->send(dev, pkt), 0, "send failed");
+    net_pkt_unref(pkt);
+
+    size = read_tx_frame(buf_deframed, sizeof(buf_deframed));
+    zassert_equal(size, sizeof(frame), "Deframed %d bytes, expected %u",
+        size, sizeof(frame));
+    zassert_mem_equal(buf_deframed, frame, sizeof(frame), "Frame mismatch.");
+
+    eth_serial_stats_get(dev, &stats);
+    zassert_equal(stats.tx_packets, 1, "tx_packets %u", stats.tx_packets);
+    zassert_equal(stats.tx_bytes, sizeof(frame), "tx_bytes %u", stats.tx_bytes);
+    zassert_equal(stats.tx_writes, 1, "tx_writes %u", stats.tx_writes);
+    zassert_equal(stats.tx_queued, 0, "tx_queued %u", stats.tx_queued);
+}
+
+ZTEST(eth_serial_tests, test_rx_error_stats)
+{
+    /* A 4 byte runt, then a frame with an invalid escape sequence. */
+    static uint8_t runt[] = { 0xc0, 1, 2, 3, 4, 0xc0 };
+    static uint8_t bad_esc[] = { 0xc0, 1, 0xdb, 0x55, 2, 0xc0 };
+    struct eth_serial_stats stats;
+
+    Z_TEST_SKIP_IFNDEF(CONFIG_ETH_SERIAL_SLIP);
+
+    uart_emul_put_rx_data(uart_dev, runt, sizeof(runt));
+    k_sleep(K_MSEC(10));
+    uart_emul_put_rx_data(uart_dev, bad_esc, sizeof(bad_esc));
+    k_sleep(K_MSEC(10));
+
+    eth_serial_stats_get(net_if_get_device(iface), &stats);
+    zassert_equal(stats.rx_runts, 1, "rx_runts %u", stats.rx_runts);
+    zassert_equal(stats.rx_deframe_errors, 1, "rx_deframe_errors %u",
+        stats.rx_deframe_errors);
+    zassert_equal(stats.rx_packets, 0, "rx_packets %u", stats.rx_packets);
+}
+
+ZTEST(eth_serial_tests, test_rx_error_stats_cobs)
+{
+    /*  A 4 byte runt, then a frame whose code byte runs past its end, then
+        a valid runt: the bad frame must not take the next one with it.
+    */
+    static uint8_t runt[] = { 0x00, 5, 1, 2, 3, 4, 0x00 };
+    static uint8_t bad_code[] = { 0x00, 5, 1, 2, 0x00 };
+    struct eth_serial_stats stats;
+
+    Z_TEST_SKIP_IFNDEF(CONFIG_ETH_SERIAL_COBS);
+
+    uart_emul_put_rx_data(uart_dev, runt, sizeof(runt));
+    k_sleep(K_MSEC(10));
+    uart_emul_put_rx_data(uart_dev, bad_code, sizeof(bad_code));
+    k_sleep(K_MSEC(10));
+    uart_emul_put_rx_data(uart_dev, runt, sizeof(runt));
+    k_sleep(K_MSEC(10));
+
+    eth_serial_stats_get(net_if_get_device(iface), &stats);
+    zassert_equal(stats.rx_runts, 2, "rx_runts %u", stats.rx_runts);
+    zassert_equal(stats.rx_deframe_errors, 1, "rx_deframe_errors %u",
+        stats.rx_deframe_errors);
+    zassert_equal(stats.rx_packets, 0, "rx_packets %u", stats.rx_packets);
+}
+
+ZTEST(eth_serial_tests, test_rx_burst)
+{
+    uint8_t frame[60];
+    struct eth_serial_stats stats;
+    int framed_size = 0;
+    int size;
+    int i;
+
+    /*  Three frames in one uart write, so they arrive in one backend chunk
+        and are all delivered without further traffic.
+    */
+    memset(frame, 0xff, 6);
+    memcpy(&frame[6], peer_mac, 6);
+    frame[12] = ETH_TYPE_LOCAL >> 8;
+    frame[13] = ETH_TYPE_LOCAL & 0xff;
+    for (i = 0; i < 3; i++)
+    {
+        memset(&frame[14], i, sizeof(frame) - 14);
+        size = test_framer(frame, sizeof(frame), &buf_framed[framed_size],
+            sizeof(buf_framed) - framed_size);
+        zassert_true(size > 0, "Framer returned %d", size);
+        framed_size += size;
+    }
+
+    uart_emul_put_rx_data(uart_dev, buf_framed, framed_size);
+    k_sleep(K_MSEC(10));
+
+    eth_serial_stats_get(net_if_get_device(iface), &stats);
+    zassert_equal(stats.rx_packets, 3, "rx_packets %u", stats.rx_packets);
+    zassert_equal(stats.rx_bytes, 3 * sizeof(frame), "rx_bytes %u",
+        stats.rx_bytes);
+}
+
+ZTEST(eth_serial_tests, test_rx_arp_reply)
+{
+    uint8_t frame[42];
+    uint8_t *arp = &frame[14];
+    int framed_size;
+    int size;
+
+    /* Ethernet header: broadcast ARP from peer_mac. */
+    memset(frame, 0xff, 6);
+    memcpy(&frame[6], peer_mac, 6);
+    frame[12] = ETH_TYPE_ARP >> 8;
+    frame[13] = ETH_TYPE_ARP & 0xff;
+
+    /* ARP request: who has 192.0.2.1? tell 192.0.2.2 */
+    arp[0] = 0x00; arp[1] = 0x01;               /* htype ethernet */
+    arp[2] = 0x08; arp[3] = 0x00;               /* ptype ipv4 */
+    arp[4] = 6;    arp[5] = 4;                  /* hlen, plen */
+    arp[6] = 0x00; arp[7] = 0x01;               /* op request */
+    memcpy(&arp[8], peer_mac, 6);               /* sha */
+    arp[14] = 192; arp[15] = 0; arp[16] = 2; arp[17] = 2;   /* spa */
+    memset(&arp[18], 0, 6);                     /* tha */
+    memcpy(&arp[24], &my_addr, 4);              /* tpa */
+
+    framed_size = test_framer(frame, sizeof(frame), buf_framed,
+        sizeof(buf_framed));
+    zassert_true(framed_size > 0, "Framer returned %d", framed_size);
+
+    uart_emul_put_rx_data(uart_dev, buf_framed, framed_size);
+
+    size = read_tx_frame(buf_deframed, sizeof(buf_deframed));
+    zassert_true(size >= 42, "No ARP reply (size %d).", size);
+    zassert_mem_equal(buf_deframed, peer_mac, 6, "Reply not sent to peer.");
+    zassert_equal((buf_deframed[12] << 8) | buf_deframed[13], ETH_TYPE_ARP,
+        "Reply is not ARP.");
+    zassert_equal((buf_deframed[20] << 8) | buf_deframed[21], ARP_OP_REPLY,
+        "ARP op is not reply.");
+}
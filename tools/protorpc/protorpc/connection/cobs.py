@@ -1,6 +1,7 @@
 import queue
 import typing as t
 import logging
+import zlib
 
 from queue import Queue
 from rich.logging import RichHandler
@@ -8,6 +9,7 @@ from rich.logging import RichHandler
 logger = logging.getLogger(__name__)
 
 ESCAPED_BYTE = 0x00
+CRC_SIZE = 4
 
 
 def encode(bytes_in: t.ByteString) -> t.ByteString:
@@ -86,12 +88,41 @@ def decode(encbytes_in: t.ByteString) -> t.ByteString:
     return bytearray(dec_out[:num])
 
 
+def append_crc(data: t.ByteString) -> t.ByteString:
+    """Appends a little-endian CRC-32 trailer (matches eth_serial
+    CONFIG_ETH_SERIAL_CRC32).
+    """
+    return bytearray(data) + zlib.crc32(data).to_bytes(CRC_SIZE, 'little')
+
+
+def check_crc(data: t.ByteString) -> t.Optional[t.ByteString]:
+    """Verifies and strips the CRC-32 trailer. Returns None on mismatch.
+    """
+    if len(data) < CRC_SIZE:
+        return None
+    payload = data[:-CRC_SIZE]
+    if zlib.crc32(payload) != int.from_bytes(data[-CRC_SIZE:], 'little'):
+        return None
+    return bytearray(payload)
+
+
+def frame(data: t.ByteString, crc=False) -> t.ByteString:
+    """COBS encodes data and adds the framing bytes, optionally with a CRC-32
+    trailer.
+    """
+    if crc:
+        data = append_crc(data)
+    return bytearray([0]) + encode(data) + bytearray([0])
+
+
 class Deframer:
-    def __init__(self):
+    def __init__(self, crc=False):
         self.state = "INIT"
         self.q = Queue()
         self.data = []
         self.count = 0
+        self.crc = crc
+        self.crc_errors = 0
 
     def process(self, new_data):
         """Processes new data, returns decoded message if framing detected.
@@ -154,7 +185,18 @@ class Deframer:
             elif self.state == "DECODE":
                 logger.debug("DEFRAMER: DECODE")
                 self.state = "INIT"
-                return decode(bytearray(self.data))
+                decoded = decode(bytearray(self.data))
+                if not self.crc:
+                    return decoded
+
+                checked = check_crc(decoded)
+                if checked is None:
+                    # Drop the frame and keep going with any queued data.
+                    self.crc_errors += 1
+                    logger.warning(f"DEFRAMER: CRC mismatch, dropping "
+                                   f"{len(decoded)} bytes.")
+                    continue
+                return checked
 
 
 if __name__ == "__main__":
@@ -230,3 +272,16 @@ if __name__ == "__main__":
         logger.error(f"dec={list(dec)}")
     else:
         logger.info(f"Pass: msg={msg[:16]}")
+
+    # CRC trailer: a good frame passes, a corrupted one is dropped.
+    msg = [x % 256 for x in range(64)]
+    good = frame(bytearray(msg), crc=True)
+    bad = bytearray(good)
+    bad[10] ^= 0x01 if bad[10] != 0x01 else 0x02
+    deframer = Deframer(crc=True)
+    dec = deframer.process(bad + good)
+    if dec is None or list(dec) != msg or deframer.crc_errors != 1:
+        logger.error("Fail: crc")
+        logger.error(f"dec={dec}; crc_errors={deframer.crc_errors}")
+    else:
+        logger.info(f"Pass: crc msg={msg[:16]}")
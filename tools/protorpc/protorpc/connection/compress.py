@@ -0,0 +1,176 @@
+"""Per-frame LZ4 block compression with a one byte link header, matching the
+FrameCompress C module (eth_serial CONFIG_ETH_SERIAL_COMPRESS, TcpRpcServer
+CONFIG_TCPRPCSERVER_COMPRESS).
+
+Header byte:
+    bit 7  HDR_CAPS  sender can decompress.
+    bit 0  HDR_LZ4   payload is an LZ4 block.
+
+The codec is pure Python. Its blocks can be cross-checked against liblz4 with
+the optional lz4 package (pip install protorpc[lz4]), lz4.block with
+store_size=False.
+"""
+import logging
+import typing as t
+
+logger = logging.getLogger(__name__)
+
+HDR_LZ4 = 0x01
+HDR_CAPS = 0x80
+
+MINMATCH = 4
+LASTLITERALS = 5
+MFLIMIT = 12
+MAX_OFFSET = 0xffff
+RUN_MASK = 15
+
+
+def _put_len(out: bytearray, n: int) -> None:
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def lz4_compress(data: t.ByteString) -> bytearray:
+    """Compresses data into a single LZ4 block (lz4.block, store_size=False).
+    """
+    data = bytes(data)
+    n = len(data)
+    out = bytearray()
+    anchor = 0
+
+    if n > MFLIMIT:
+        table = {}
+        ip = 1
+        table[data[0:4]] = 0
+        mflimit = n - MFLIMIT
+        matchlimit = n - LASTLITERALS
+
+        while ip < mflimit:
+            seq = data[ip:ip + 4]
+            ref = table.get(seq)
+            table[seq] = ip
+            if ref is None or ip - ref > MAX_OFFSET:
+                ip += 1
+                continue
+
+            mp = ip + MINMATCH
+            while mp < matchlimit and data[mp] == data[ref + mp - ip]:
+                mp += 1
+
+            lit = ip - anchor
+            mlen = mp - ip - MINMATCH
+            out.append((min(lit, RUN_MASK) << 4) | min(mlen, RUN_MASK))
+            if lit >= RUN_MASK:
+                _put_len(out, lit - RUN_MASK)
+            out += data[anchor:ip]
+            out += (ip - ref).to_bytes(2, 'little')
+            if mlen >= RUN_MASK:
+                _put_len(out, mlen - RUN_MASK)
+
+            ip = mp
+            anchor = ip
+
+    lit = n - anchor
+    out.append(min(lit, RUN_MASK) << 4)
+    if lit >= RUN_MASK:
+        _put_len(out, lit - RUN_MASK)
+    out += data[anchor:]
+    return out
+
+
+def lz4_decompress(block: t.ByteString, max_size: int = 65536) -> bytearray:
+    """Decompresses a single LZ4 block. Raises ValueError when malformed.
+    """
+    out = bytearray()
+    ip = 0
+    n = len(block)
+
+    def get_len(ip, val):
+        while True:
+            if ip >= n:
+                raise ValueError("LZ4: truncated length")
+            b = block[ip]
+            ip += 1
+            val += b
+            if b != 255:
+                return ip, val
+
+    while ip < n:
+        token = block[ip]
+        ip += 1
+        lit = token >> 4
+        if lit == RUN_MASK:
+            ip, lit = get_len(ip, lit)
+        if ip + lit > n:
+            raise ValueError("LZ4: truncated literals")
+        out += block[ip:ip + lit]
+        ip += lit
+        if ip == n:
+            break
+
+        if ip + 2 > n:
+            raise ValueError("LZ4: truncated offset")
+        offset = block[ip] | (block[ip + 1] << 8)
+        ip += 2
+        if offset == 0 or offset > len(out):
+            raise ValueError("LZ4: bad offset")
+
+        mlen = token & RUN_MASK
+        if mlen == RUN_MASK:
+            ip, mlen = get_len(ip, mlen)
+        mlen += MINMATCH
+        start = len(out) - offset
+        for i in range(mlen):
+            out.append(out[start + i])
+
+        if len(out) > max_size:
+            raise ValueError("LZ4: output overflow")
+
+    return out
+
+
+class CompressLink:
+    """Compression negotiation state for one link.
+    """
+    def __init__(self):
+        self.peer_caps = False
+        self.tx_raw_bytes = 0
+        self.tx_wire_bytes = 0
+        self.rx_errors = 0
+
+    def encode(self, data: t.ByteString) -> bytearray:
+        """Adds the header, compressing when the peer supports it and the
+        block is smaller.
+        """
+        self.tx_raw_bytes += len(data)
+        if self.peer_caps and len(data) > 1:
+            block = lz4_compress(data)
+            if len(block) < len(data):
+                out = bytearray([HDR_CAPS | HDR_LZ4]) + block
+                self.tx_wire_bytes += len(out)
+                return out
+
+        out = bytearray([HDR_CAPS]) + bytearray(data)
+        self.tx_wire_bytes += len(out)
+        return out
+
+    def decode(self, frame: t.ByteString) -> t.Optional[bytearray]:
+        """Strips the header and decompresses. Returns None on error.
+        """
+        if len(frame) < 1 or frame[0] & ~(HDR_CAPS | HDR_LZ4):
+            logger.warning(f"Bad compression header in {len(frame)} bytes.")
+            self.rx_errors += 1
+            return None
+
+        hdr = frame[0]
+        self.peer_caps = bool(hdr & HDR_CAPS)
+        if hdr & HDR_LZ4:
+            try:
+                return lz4_decompress(frame[1:])
+            except ValueError as e:
+                logger.warning(f"{str(e)}")
+                self.rx_errors += 1
+                return None
+        return bytearray(frame[1:])
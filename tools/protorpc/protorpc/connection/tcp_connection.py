@@ -6,6 +6,7 @@ import protorpc.connection.cobs as cobs
 from protorpc.connection import setdefault
 from protorpc.connection import BaseConnection
 from protorpc.connection.cobs import Deframer
+from protorpc.connection.compress import CompressLink
 
 logger = logging.getLogger(__name__)
 
@@ -14,13 +15,18 @@ DEFAULT_PORT = 13001
 
 class TcpConnection(BaseConnection):
     """A connection class using TCP + COBS.
+
+    compress=True adds the FrameCompress header to every frame (server built
+    with CONFIG_TCPRPCSERVER_COMPRESS) and negotiates LZ4 compression.
     """
 
     def __init__(self, **kwargs):
 
         # Set the default port for TCP.
         setdefault(kwargs, 'port', DEFAULT_PORT)
+        compress = kwargs.pop('compress', False)
         super().__init__('tcpconn', **kwargs)
+        self.compress_link = CompressLink() if compress else None
         self.socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
         self.deframer = Deframer()
         self.is_connected = False
@@ -52,6 +58,8 @@ class TcpConnection(BaseConnection):
             if raw_write:
                 self.socket.send(data)
             else:
+                if self.compress_link:
+                    data = self.compress_link.encode(data)
                 # COBS encode and add framing.
                 encoded = self.encode(data)
                 framed = bytearray([0]) + encoded + bytearray([0])
@@ -81,6 +89,8 @@ class TcpConnection(BaseConnection):
                 return None
 
             msg = self.deframer.process(data)
+            if msg and self.compress_link:
+                msg = self.compress_link.decode(msg)
             if msg:
                 logger.debug(f"Received data[{len(data)}]={self.bytes_to_hex(data, 64)}")
                 return msg
@@ -21,5 +21,9 @@ setup(
         ],
     },
     packages=find_packages(),
-    install_requires=required
+    install_requires=required,
+    extras_require={
+        # liblz4 bindings, to cross-check compress.py (lz4.block).
+        'lz4': ['lz4'],
+    },
 )